@@ -12,6 +12,7 @@
 #include <osgDB/ReadFile>
 #include <osgUtil/Optimizer>
 #include <osg/CoordinateSystemNode>
+#include <osg/Profiler>
 
 #include <osg/Switch>
 #include <osg/Types>
@@ -19,6 +20,9 @@
 
 #include <osgViewer/Viewer>
 #include <osgViewer/ViewerEventHandlers>
+#include <osgViewer/Renderer>
+
+#include <osgUtil/NodeCostProfiler>
 
 #include <osgGA/TrackballManipulator>
 #include <osgGA/FlightManipulator>
@@ -49,6 +53,9 @@ int main(int argc, char** argv)
     arguments.getApplicationUsage()->addCommandLineOption("--speed <factor>","Speed factor for animation playing (1 == normal speed).");
     arguments.getApplicationUsage()->addCommandLineOption("--device <device-name>","add named device to the viewer");
     arguments.getApplicationUsage()->addCommandLineOption("--stats","print out load and compile timing stats");
+    arguments.getApplicationUsage()->addCommandLineOption("--profile <filename>","Record profiling zones and write them to filename on exit, as a Chrome trace if its extension is .json, otherwise in binary.");
+    arguments.getApplicationUsage()->addCommandLineOption("--profile-convert <filename> <filename>","Convert a binary profile to a Chrome trace and exit.");
+    arguments.getApplicationUsage()->addCommandLineOption("--node-costs <filename>","Attribute cull and draw costs to named nodes and write them to filename on exit, as a flame graph if its extension is .folded, otherwise as a report.");
 
     osgViewer::Viewer viewer(arguments);
 
@@ -74,6 +81,25 @@ int main(int argc, char** argv)
 
     bool printStats = arguments.read("--stats");
 
+    std::string profileFilename, jsonFilename;
+    if (arguments.read("--profile-convert", profileFilename, jsonFilename))
+    {
+        if (!osg::Profiler::convertToChromeTrace(profileFilename, jsonFilename))
+        {
+            std::cout << arguments.getApplicationName() <<": unable to convert "<<profileFilename<<" to "<<jsonFilename<< std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (arguments.read("--profile", profileFilename))
+    {
+        osg::Profiler::instance()->setEnabled(true);
+    }
+
+    std::string nodeCostsFilename;
+    arguments.read("--node-costs", nodeCostsFilename);
+
     std::string url, username, password;
     while(arguments.read("--login",url, username, password))
     {
@@ -188,6 +214,43 @@ int main(int argc, char** argv)
 
     viewer.realize();
 
-    return viewer.run();
+    osg::ref_ptr<osgUtil::NodeCostProfiler> nodeCostProfiler;
+    if (!nodeCostsFilename.empty())
+    {
+        nodeCostProfiler = new osgUtil::NodeCostProfiler;
+
+        osgViewer::Viewer::Cameras cameras;
+        viewer.getCameras(cameras);
+        for(osgViewer::Viewer::Cameras::iterator itr = cameras.begin();
+            itr != cameras.end();
+            ++itr)
+        {
+            osgViewer::Renderer* renderer = dynamic_cast<osgViewer::Renderer*>((*itr)->getRenderer());
+            if (!renderer) continue;
+
+            for(unsigned int i=0; i<2; ++i)
+            {
+                if (renderer->getSceneView(i)) renderer->getSceneView(i)->setNodeCostProfiler(nodeCostProfiler.get());
+            }
+        }
+    }
+
+    int result = viewer.run();
+
+    if (nodeCostProfiler.valid() && !nodeCostProfiler->write(nodeCostsFilename))
+    {
+        std::cout << arguments.getApplicationName() <<": unable to write node costs "<<nodeCostsFilename<< std::endl;
+    }
+
+    if (!profileFilename.empty())
+    {
+        osg::Profiler::instance()->setEnabled(false);
+        if (!osg::Profiler::instance()->write(profileFilename))
+        {
+            std::cout << arguments.getApplicationName() <<": unable to write profile "<<profileFilename<< std::endl;
+        }
+    }
+
+    return result;
 
 }
@@ -0,0 +1,738 @@
+/* OpenSceneGraph example, osgbenchmark.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+// osgbenchmark renders a set of generated scenes along fixed camera paths, with
+// a fixed simulation time step, so that runs are repeatable from one build to the
+// next, and writes the frame, event, update, cull, draw and GPU timings of each
+// scene and threading model to a JSON file.
+//
+// Rendering is to a pbuffer by default, so on a GPU-less machine it can be run
+// against the Mesa software rasterizer under a virtual X server, e.g.
+//
+//     xvfb-run -a osgbenchmark --output results.json
+
+#include <osg/AnimationPath>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/GL>
+#include <osg/Material>
+#include <osg/MatrixTransform>
+#include <osg/PagedLOD>
+#include <osg/ShapeDrawable>
+#include <osg/Stats>
+#include <osg/Timer>
+
+#include <osgDB/FileNameUtils>
+#include <osgDB/Registry>
+
+#include <osgText/Text>
+
+#include <osgParticle/ModularEmitter>
+#include <osgParticle/ParticleSystem>
+#include <osgParticle/ParticleSystemUpdater>
+#include <osgParticle/RadialShooter>
+#include <osgParticle/RandomRateCounter>
+
+#include <osgViewer/Viewer>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+static const char* s_tileExtension = "osgbenchmark_tile";
+
+// number of tiles along each side of the paged terrain
+static const int s_numTiles = 16;
+static const float s_tileSize = 100.0f;
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Generated scenes
+//
+
+osg::Geode* createBox(float size, const osg::Vec4& colour)
+{
+    osg::ShapeDrawable* shape = new osg::ShapeDrawable(new osg::Box(osg::Vec3(0.0f,0.0f,0.0f), size));
+    shape->setColor(colour);
+
+    osg::Geode* geode = new osg::Geode;
+    geode->addDrawable(shape);
+    return geode;
+}
+
+float random(float min, float max)
+{
+    return min + (max-min)*float(rand())/float(RAND_MAX);
+}
+
+// many transforms sharing the same geometry and state, stressing the cull traversal
+osg::Node* createNodesScene()
+{
+    osg::ref_ptr<osg::Geode> box = createBox(1.0f, osg::Vec4(0.8f,0.8f,0.8f,1.0f));
+
+    osg::Group* group = new osg::Group;
+    const int numRows = 100;
+    for(int r=0; r<numRows; ++r)
+    {
+        osg::Group* row = new osg::Group;
+        for(int c=0; c<numRows; ++c)
+        {
+            osg::MatrixTransform* transform = new osg::MatrixTransform;
+            transform->setMatrix(osg::Matrix::rotate(random(0.0f, osg::PI), osg::Vec3(0.0f,0.0f,1.0f)) *
+                                 osg::Matrix::translate(float(c)*2.0f, float(r)*2.0f, random(0.0f, 2.0f)));
+            transform->addChild(box.get());
+            row->addChild(transform);
+        }
+        group->addChild(row);
+    }
+    return group;
+}
+
+// many drawables each with their own StateSet, stressing state sorting and state changes
+osg::Node* createStateScene()
+{
+    osg::Group* group = new osg::Group;
+    const int numRows = 45;
+    for(int r=0; r<numRows; ++r)
+    {
+        for(int c=0; c<numRows; ++c)
+        {
+            osg::Geode* geode = createBox(1.5f, osg::Vec4(1.0f,1.0f,1.0f,1.0f));
+
+            osg::Material* material = new osg::Material;
+            material->setDiffuse(osg::Material::FRONT_AND_BACK, osg::Vec4(random(0.0f,1.0f), random(0.0f,1.0f), random(0.0f,1.0f), 1.0f));
+            material->setShininess(osg::Material::FRONT_AND_BACK, random(0.0f,128.0f));
+            geode->getOrCreateStateSet()->setAttributeAndModes(material);
+            if ((r+c)%3==0) geode->getOrCreateStateSet()->setMode(GL_CULL_FACE, osg::StateAttribute::ON);
+
+            osg::MatrixTransform* transform = new osg::MatrixTransform(osg::Matrix::translate(float(c)*2.0f, float(r)*2.0f, 0.0f));
+            transform->addChild(geode);
+            group->addChild(transform);
+        }
+    }
+    return group;
+}
+
+// many text labels, stressing glyph layout and the drawing of textured quads
+osg::Node* createTextScene()
+{
+    osg::Geode* geode = new osg::Geode;
+    const int numRows = 32;
+    for(int r=0; r<numRows; ++r)
+    {
+        for(int c=0; c<numRows; ++c)
+        {
+            std::ostringstream str;
+            str<<"Label "<<r<<","<<c<<" "<<rand()%1000;
+
+            osgText::Text* text = new osgText::Text;
+            text->setCharacterSize(0.5f);
+            text->setAxisAlignment(r%2==0 ? osgText::Text::XZ_PLANE : osgText::Text::SCREEN);
+            text->setAlignment(osgText::Text::CENTER_CENTER);
+            text->setPosition(osg::Vec3(float(c)*3.0f, float(r)*3.0f, 0.0f));
+            text->setColor(osg::Vec4(random(0.5f,1.0f), random(0.5f,1.0f), random(0.5f,1.0f), 1.0f));
+            text->setText(str.str());
+            geode->addDrawable(text);
+        }
+    }
+    return geode;
+}
+
+// a grid of particle emitters, stressing the update of dynamic geometry
+osg::Node* createParticlesScene()
+{
+    osg::Group* group = new osg::Group;
+    osgParticle::ParticleSystemUpdater* updater = new osgParticle::ParticleSystemUpdater;
+
+    const int numRows = 5;
+    for(int r=0; r<numRows; ++r)
+    {
+        for(int c=0; c<numRows; ++c)
+        {
+            osgParticle::ParticleSystem* ps = new osgParticle::ParticleSystem;
+            ps->setDefaultAttributes("", false, false);
+            ps->getDefaultParticleTemplate().setLifeTime(3.0);
+            ps->getDefaultParticleTemplate().setSizeRange(osgParticle::rangef(0.2f, 0.5f));
+            ps->getDefaultParticleTemplate().setColorRange(osgParticle::rangev4(osg::Vec4(1.0f,0.5f,0.3f,1.0f), osg::Vec4(0.0f,0.7f,1.0f,0.0f)));
+
+            osgParticle::RandomRateCounter* counter = new osgParticle::RandomRateCounter;
+            counter->setRateRange(200.0f, 400.0f);
+
+            osgParticle::RadialShooter* shooter = new osgParticle::RadialShooter;
+            shooter->setInitialSpeedRange(2.0f, 6.0f);
+
+            osgParticle::ModularEmitter* emitter = new osgParticle::ModularEmitter;
+            emitter->setParticleSystem(ps);
+            emitter->setCounter(counter);
+            emitter->setShooter(shooter);
+
+            osg::MatrixTransform* transform = new osg::MatrixTransform(osg::Matrix::translate(float(c)*10.0f, float(r)*10.0f, 0.0f));
+            transform->addChild(emitter);
+            group->addChild(transform);
+
+            osg::Geode* geode = new osg::Geode;
+            geode->addDrawable(ps);
+            group->addChild(geode);
+
+            updater->addParticleSystem(ps);
+        }
+    }
+
+    group->addChild(updater);
+    return group;
+}
+
+osg::Node* createTile(int x, int y)
+{
+    const unsigned int numSamples = 33;
+
+    osg::HeightField* heightField = new osg::HeightField;
+    heightField->allocate(numSamples, numSamples);
+    heightField->setOrigin(osg::Vec3(float(x)*s_tileSize, float(y)*s_tileSize, 0.0f));
+    heightField->setXInterval(s_tileSize/float(numSamples-1));
+    heightField->setYInterval(s_tileSize/float(numSamples-1));
+
+    for(unsigned int r=0; r<numSamples; ++r)
+    {
+        for(unsigned int c=0; c<numSamples; ++c)
+        {
+            float px = (float(x) + float(c)/float(numSamples-1))*s_tileSize;
+            float py = (float(y) + float(r)/float(numSamples-1))*s_tileSize;
+            heightField->setHeight(c, r, 10.0f*sinf(px*0.02f)*cosf(py*0.03f));
+        }
+    }
+
+    osg::ShapeDrawable* shape = new osg::ShapeDrawable(heightField);
+    shape->setColor(osg::Vec4(0.3f + 0.4f*float((x+y)%2), 0.7f, 0.3f, 1.0f));
+
+    osg::Geode* geode = new osg::Geode;
+    geode->addDrawable(shape);
+    return geode;
+}
+
+// generates the tiles of the paged scene in memory, so that paging runs without disk access
+class TileReadFileCallback : public osgDB::ReadFileCallback
+{
+    public:
+
+        virtual osgDB::ReaderWriter::ReadResult readNode(const std::string& filename, const osgDB::Options* options)
+        {
+            int x, y;
+            if (osgDB::getLowerCaseFileExtension(filename)==s_tileExtension &&
+                sscanf(osgDB::getSimpleFileName(filename).c_str(), "tile_%d_%d", &x, &y)==2)
+            {
+                return createTile(x, y);
+            }
+
+            return osgDB::ReadFileCallback::readNode(filename, options);
+        }
+};
+
+// a grid of PagedLOD tiles, stressing the DatabasePager as the camera moves across it
+osg::Node* createPagingScene()
+{
+    osg::Group* group = new osg::Group;
+    for(int y=0; y<s_numTiles; ++y)
+    {
+        for(int x=0; x<s_numTiles; ++x)
+        {
+            std::ostringstream filename;
+            filename<<"tile_"<<x<<"_"<<y<<"."<<s_tileExtension;
+
+            osg::Vec3 center((float(x)+0.5f)*s_tileSize, (float(y)+0.5f)*s_tileSize, 0.0f);
+
+            osg::PagedLOD* plod = new osg::PagedLOD;
+            plod->setCenterMode(osg::LOD::USER_DEFINED_CENTER);
+            plod->setCenter(center);
+            plod->setRadius(s_tileSize*0.75f);
+            plod->addChild(createBox(s_tileSize*0.9f, osg::Vec4(0.5f,0.5f,0.5f,1.0f)), s_tileSize*3.0f, 1e7f);
+            plod->setFileName(1, filename.str());
+            plod->setRange(1, 0.0f, s_tileSize*3.0f);
+            group->addChild(plod);
+        }
+    }
+    return group;
+}
+
+osg::Node* createScene(const std::string& name)
+{
+    // seed the generator for each scene so that scenes are identical across runs
+    srand(1);
+
+    if (name=="nodes") return createNodesScene();
+    if (name=="state") return createStateScene();
+    if (name=="text") return createTextScene();
+    if (name=="particles") return createParticlesScene();
+    if (name=="paging") return createPagingScene();
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Camera paths
+//
+
+osg::AnimationPath::ControlPoint lookAt(const osg::Vec3d& eye, const osg::Vec3d& center)
+{
+    osg::Matrixd matrix = osg::Matrixd::inverse(osg::Matrixd::lookAt(eye, center, osg::Vec3d(0.0,0.0,1.0)));
+    return osg::AnimationPath::ControlPoint(eye, matrix.getRotate());
+}
+
+// a single orbit around the scene, or a low pass across the paged terrain, lasting duration seconds
+osg::AnimationPath* createCameraPath(const std::string& name, const osg::BoundingSphere& bs, double duration)
+{
+    osg::AnimationPath* path = new osg::AnimationPath;
+    path->setLoopMode(osg::AnimationPath::LOOP);
+
+    const unsigned int numControlPoints = 64;
+    for(unsigned int i=0; i<=numControlPoints; ++i)
+    {
+        double t = double(i)/double(numControlPoints);
+
+        if (name=="paging")
+        {
+            double extent = double(s_numTiles)*s_tileSize;
+            osg::Vec3d eye(extent*(0.1+0.8*t), extent*(0.5+0.3*sin(t*osg::PI*2.0)), s_tileSize*0.5);
+            osg::Vec3d center = eye + osg::Vec3d(s_tileSize, 0.0, -s_tileSize*0.2);
+            path->insert(t*duration, lookAt(eye, center));
+        }
+        else
+        {
+            double angle = t*osg::PI*2.0;
+            double radius = bs.radius()*1.5;
+            osg::Vec3d eye = osg::Vec3d(bs.center()) + osg::Vec3d(cos(angle)*radius, sin(angle)*radius, bs.radius()*0.5);
+            path->insert(t*duration, lookAt(eye, bs.center()));
+        }
+    }
+    return path;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Results
+//
+
+struct Summary
+{
+    Summary(): count(0), mean(0.0), min(0.0), max(0.0), p50(0.0), p95(0.0), p99(0.0) {}
+
+    unsigned int count;
+    double mean, min, max, p50, p95, p99;
+};
+
+Summary summarize(std::vector<double> values)
+{
+    Summary summary;
+    if (values.empty()) return summary;
+
+    std::sort(values.begin(), values.end());
+
+    double total = 0.0;
+    for(std::vector<double>::iterator itr = values.begin(); itr != values.end(); ++itr) total += *itr;
+
+    summary.count = values.size();
+    summary.mean = total/double(values.size());
+    summary.min = values.front();
+    summary.max = values.back();
+    summary.p50 = values[(values.size()-1)*50/100];
+    summary.p95 = values[(values.size()-1)*95/100];
+    summary.p99 = values[(values.size()-1)*99/100];
+    return summary;
+}
+
+struct Timings
+{
+    std::vector<double> frame;
+    std::vector<double> event;
+    std::vector<double> update;
+    std::vector<double> cull;
+    std::vector<double> draw;
+    std::vector<double> gpu;
+};
+
+struct Result
+{
+    Result(): numFrames(0), wallTime(0.0) {}
+
+    std::string     scene;
+    std::string     threading;
+    unsigned int    numFrames;
+    double          wallTime;
+    Timings         timings;
+};
+
+class ContextInfoOperation : public osg::GraphicsOperation
+{
+    public:
+
+        ContextInfoOperation(): osg::GraphicsOperation("ContextInfo", false) {}
+
+        virtual void operator () (osg::GraphicsContext*)
+        {
+            const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+            const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+            if (renderer) _renderer = renderer;
+            if (version) _version = version;
+        }
+
+        std::string _renderer;
+        std::string _version;
+};
+
+std::string jsonString(const std::string& str)
+{
+    std::string result("\"");
+    for(std::string::const_iterator itr = str.begin(); itr != str.end(); ++itr)
+    {
+        if (*itr=='"' || *itr=='\\') result += '\\';
+        if (static_cast<unsigned char>(*itr)>=32) result += *itr;
+    }
+    return result + "\"";
+}
+
+void writeSummary(std::ostream& out, const char* name, const std::vector<double>& values, bool last)
+{
+    Summary summary = summarize(values);
+    out<<"        "<<jsonString(name)<<": { \"count\": "<<summary.count
+       <<", \"mean\": "<<summary.mean<<", \"min\": "<<summary.min<<", \"max\": "<<summary.max
+       <<", \"p50\": "<<summary.p50<<", \"p95\": "<<summary.p95<<", \"p99\": "<<summary.p99<<" }"<<(last ? "" : ",")<<std::endl;
+}
+
+void writeValues(std::ostream& out, const char* name, const std::vector<double>& values, bool last)
+{
+    out<<"        "<<jsonString(name)<<": [";
+    for(std::vector<double>::const_iterator itr = values.begin(); itr != values.end(); ++itr)
+    {
+        if (itr!=values.begin()) out<<", ";
+        out<<*itr;
+    }
+    out<<"]"<<(last ? "" : ",")<<std::endl;
+}
+
+bool writeResults(const std::string& filename, const std::vector<Result>& results, const ContextInfoOperation* info, unsigned int width, unsigned int height, bool perFrame)
+{
+    std::ofstream fout(filename.c_str());
+    if (!fout) return false;
+
+    fout.precision(6);
+    fout<<"{"<<std::endl;
+    fout<<"  \"units\": \"ms\","<<std::endl;
+    fout<<"  \"width\": "<<width<<", \"height\": "<<height<<","<<std::endl;
+    fout<<"  \"renderer\": "<<jsonString(info ? info->_renderer : std::string())<<","<<std::endl;
+    fout<<"  \"version\": "<<jsonString(info ? info->_version : std::string())<<","<<std::endl;
+    fout<<"  \"results\": ["<<std::endl;
+    for(std::vector<Result>::const_iterator itr = results.begin(); itr != results.end(); ++itr)
+    {
+        const Timings& timings = itr->timings;
+
+        fout<<"    {"<<std::endl;
+        fout<<"      \"scene\": "<<jsonString(itr->scene)<<","<<std::endl;
+        fout<<"      \"threading\": "<<jsonString(itr->threading)<<","<<std::endl;
+        fout<<"      \"frames\": "<<itr->numFrames<<","<<std::endl;
+        fout<<"      \"wall_time\": "<<itr->wallTime*1000.0<<","<<std::endl;
+        fout<<"      \"fps\": "<<(itr->wallTime>0.0 ? double(itr->numFrames)/itr->wallTime : 0.0)<<","<<std::endl;
+        fout<<"      \"summary\": {"<<std::endl;
+        writeSummary(fout, "frame", timings.frame, false);
+        writeSummary(fout, "event", timings.event, false);
+        writeSummary(fout, "update", timings.update, false);
+        writeSummary(fout, "cull", timings.cull, false);
+        writeSummary(fout, "draw", timings.draw, false);
+        writeSummary(fout, "gpu", timings.gpu, true);
+        fout<<"      }"<<(perFrame ? "," : "")<<std::endl;
+        if (perFrame)
+        {
+            fout<<"      \"per_frame\": {"<<std::endl;
+            writeValues(fout, "frame", timings.frame, false);
+            writeValues(fout, "event", timings.event, false);
+            writeValues(fout, "update", timings.update, false);
+            writeValues(fout, "cull", timings.cull, false);
+            writeValues(fout, "draw", timings.draw, false);
+            writeValues(fout, "gpu", timings.gpu, true);
+            fout<<"      }"<<std::endl;
+        }
+        fout<<"    }"<<(itr+1!=results.end() ? "," : "")<<std::endl;
+    }
+    fout<<"  ]"<<std::endl;
+    fout<<"}"<<std::endl;
+
+    return !fout.fail();
+}
+
+void printSummary(const Result& result)
+{
+    Summary frame = summarize(result.timings.frame);
+    Summary update = summarize(result.timings.update);
+    Summary cull = summarize(result.timings.cull);
+    Summary draw = summarize(result.timings.draw);
+
+    printf("%-10s %-22s %8.1f fps  frame %7.3f/%7.3f ms (mean/p95)  update %6.3f  cull %6.3f  draw %6.3f\n",
+           result.scene.c_str(), result.threading.c_str(),
+           result.wallTime>0.0 ? double(result.numFrames)/result.wallTime : 0.0,
+           frame.mean, frame.p95, update.mean, cull.mean, draw.mean);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Benchmark run
+//
+
+void appendAttribute(osg::Stats* stats, unsigned int frameNumber, const std::string& name, std::vector<double>& values)
+{
+    double value;
+    if (stats && stats->getAttribute(frameNumber, name, value)) values.push_back(value*1000.0);
+}
+
+bool runBenchmark(const std::string& sceneName, osgViewer::ViewerBase::ThreadingModel threadingModel, const std::string& threadingName,
+                  unsigned int numWarmupFrames, unsigned int numFrames, unsigned int width, unsigned int height, bool pbuffer,
+                  ContextInfoOperation* info, Result& result)
+{
+    osg::ref_ptr<osg::Node> scene = createScene(sceneName);
+    if (!scene)
+    {
+        std::cout<<"Unknown scene \""<<sceneName<<"\""<<std::endl;
+        return false;
+    }
+
+    osg::ref_ptr<osg::GraphicsContext::Traits> traits = new osg::GraphicsContext::Traits;
+    traits->x = 0;
+    traits->y = 0;
+    traits->width = width;
+    traits->height = height;
+    traits->red = 8;
+    traits->green = 8;
+    traits->blue = 8;
+    traits->alpha = 8;
+    traits->depth = 24;
+    traits->doubleBuffer = !pbuffer;
+    traits->pbuffer = pbuffer;
+    traits->windowDecoration = false;
+    traits->vsync = false;
+    traits->sharedContext = 0;
+
+    osg::ref_ptr<osg::GraphicsContext> gc = osg::GraphicsContext::createGraphicsContext(traits.get());
+    if (!gc)
+    {
+        std::cout<<"Unable to create a "<<(pbuffer ? "pbuffer" : "window")<<" graphics context, a headless run needs a virtual X server such as xvfb-run."<<std::endl;
+        return false;
+    }
+
+    unsigned int numFramesTotal = numWarmupFrames + numFrames;
+
+    osgViewer::Viewer viewer;
+    viewer.setThreadingModel(threadingModel);
+    viewer.setRealizeOperation(info);
+    viewer.setSceneData(scene.get());
+
+    osg::Camera* camera = viewer.getCamera();
+    camera->setGraphicsContext(gc.get());
+    camera->setViewport(new osg::Viewport(0, 0, width, height));
+    camera->setProjectionMatrixAsPerspective(45.0, double(width)/double(height), 1.0, 10000.0);
+    camera->setComputeNearFarMode(osg::CullSettings::COMPUTE_NEAR_FAR_USING_BOUNDING_VOLUMES);
+    GLenum buffer = traits->doubleBuffer ? GL_BACK : GL_FRONT;
+    camera->setDrawBuffer(buffer);
+    camera->setReadBuffer(buffer);
+
+    // keep statistics for every frame of the run rather than the default short history
+    unsigned int historySize = numFramesTotal + 10;
+    viewer.setViewerStats(new osg::Stats("Viewer", historySize));
+    camera->setStats(new osg::Stats("Camera", historySize));
+
+    viewer.getViewerStats()->collectStats("frame_rate", true);
+    viewer.getViewerStats()->collectStats("event", true);
+    viewer.getViewerStats()->collectStats("update", true);
+    camera->getStats()->collectStats("rendering", true);
+    camera->getStats()->collectStats("gpu", true);
+
+    viewer.realize();
+    if (!viewer.isRealized())
+    {
+        std::cout<<"Unable to realize the viewer."<<std::endl;
+        return false;
+    }
+
+    // a fixed time step and camera path, so each run renders the same sequence of frames
+    const double timeStep = 1.0/60.0;
+    osg::ref_ptr<osg::AnimationPath> path = createCameraPath(sceneName, scene->getBound(), double(numFramesTotal)*timeStep);
+
+    // frame stats are recorded a frame late, so render one more frame than is measured
+    std::vector<unsigned int> frameNumbers;
+    osg::Timer_t startTick = 0;
+    for(unsigned int i=0; i<=numFramesTotal; ++i)
+    {
+        if (i==numWarmupFrames) startTick = osg::Timer::instance()->tick();
+
+        double simulationTime = double(i)*timeStep;
+
+        osg::Matrixd matrix;
+        path->getMatrix(simulationTime, matrix);
+        camera->setViewMatrix(osg::Matrixd::inverse(matrix));
+
+        viewer.frame(simulationTime);
+
+        if (i>=numWarmupFrames && i<numFramesTotal) frameNumbers.push_back(viewer.getFrameStamp()->getFrameNumber());
+        if (i+1==numFramesTotal) result.wallTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+    }
+
+    // wait for the graphics threads to complete so that all the frames' stats have been recorded
+    viewer.stopThreading();
+
+    result.scene = sceneName;
+    result.threading = threadingName;
+    result.numFrames = frameNumbers.size();
+
+    osg::Stats* viewerStats = viewer.getViewerStats();
+    osg::Stats* cameraStats = camera->getStats();
+    for(std::vector<unsigned int>::iterator itr = frameNumbers.begin(); itr != frameNumbers.end(); ++itr)
+    {
+        appendAttribute(viewerStats, *itr, "Frame duration", result.timings.frame);
+        appendAttribute(viewerStats, *itr, "Event traversal time taken", result.timings.event);
+        appendAttribute(viewerStats, *itr, "Update traversal time taken", result.timings.update);
+        appendAttribute(cameraStats, *itr, "Cull traversal time taken", result.timings.cull);
+        appendAttribute(cameraStats, *itr, "Draw traversal time taken", result.timings.draw);
+        appendAttribute(cameraStats, *itr, "GPU draw time taken", result.timings.gpu);
+    }
+
+    return true;
+}
+
+void split(const std::string& str, std::vector<std::string>& items)
+{
+    std::string::size_type start = 0;
+    while(start<=str.size())
+    {
+        std::string::size_type end = str.find(',', start);
+        if (end==std::string::npos) end = str.size();
+        if (end>start) items.push_back(str.substr(start, end-start));
+        start = end+1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" renders generated scenes along fixed camera paths and records frame timings to JSON.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options]");
+    arguments.getApplicationUsage()->addCommandLineOption("--scene <names>", "Comma separated scenes to run from nodes, state, text, particles, paging and all. Default is all.");
+    arguments.getApplicationUsage()->addCommandLineOption("--threading <names>", "Comma separated threading models to run from SingleThreaded, DrawThreadPerContext and both. Default is both.");
+    arguments.getApplicationUsage()->addCommandLineOption("--frames <num>", "Number of frames measured per run. Default is 300.");
+    arguments.getApplicationUsage()->addCommandLineOption("--warmup <num>", "Number of frames rendered before measuring. Default is 30.");
+    arguments.getApplicationUsage()->addCommandLineOption("--size <width> <height>", "Size of the rendering surface. Default is 640 480.");
+    arguments.getApplicationUsage()->addCommandLineOption("--window", "Render to a window rather than a pbuffer.");
+    arguments.getApplicationUsage()->addCommandLineOption("--output <filename>", "Write the results to a JSON file. Default is osgbenchmark.json.");
+    arguments.getApplicationUsage()->addCommandLineOption("--per-frame", "Include the timings of every frame in the JSON file.");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help", "Display this information.");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    std::string sceneNames("all");
+    while(arguments.read("--scene", sceneNames)) {}
+
+    std::string threadingNames("both");
+    while(arguments.read("--threading", threadingNames)) {}
+
+    unsigned int numFrames = 300;
+    while(arguments.read("--frames", numFrames)) {}
+
+    unsigned int numWarmupFrames = 30;
+    while(arguments.read("--warmup", numWarmupFrames)) {}
+
+    unsigned int width = 640, height = 480;
+    while(arguments.read("--size", width, height)) {}
+
+    bool pbuffer = true;
+    while(arguments.read("--window")) { pbuffer = false; }
+
+    std::string outputFilename("osgbenchmark.json");
+    while(arguments.read("--output", outputFilename)) {}
+
+    bool perFrame = false;
+    while(arguments.read("--per-frame")) { perFrame = true; }
+
+    arguments.reportRemainingOptionsAsUnrecognized();
+    if (arguments.errors())
+    {
+        arguments.writeErrorMessages(std::cout);
+        return 1;
+    }
+
+    std::vector<std::string> scenes;
+    split(sceneNames, scenes);
+    if (std::find(scenes.begin(), scenes.end(), "all")!=scenes.end())
+    {
+        scenes.clear();
+        scenes.push_back("nodes");
+        scenes.push_back("state");
+        scenes.push_back("text");
+        scenes.push_back("particles");
+        scenes.push_back("paging");
+    }
+
+    typedef std::pair<osgViewer::ViewerBase::ThreadingModel, std::string> ThreadingPair;
+    std::vector<ThreadingPair> threadingModels;
+    std::vector<std::string> threadings;
+    split(threadingNames, threadings);
+    for(std::vector<std::string>::iterator itr = threadings.begin(); itr != threadings.end(); ++itr)
+    {
+        if (*itr=="SingleThreaded" || *itr=="both") threadingModels.push_back(ThreadingPair(osgViewer::ViewerBase::SingleThreaded, "SingleThreaded"));
+        if (*itr=="DrawThreadPerContext" || *itr=="both") threadingModels.push_back(ThreadingPair(osgViewer::ViewerBase::DrawThreadPerContext, "DrawThreadPerContext"));
+        if (*itr!="SingleThreaded" && *itr!="DrawThreadPerContext" && *itr!="both")
+        {
+            std::cout<<"Unknown threading model \""<<*itr<<"\""<<std::endl;
+            return 1;
+        }
+    }
+
+    // generate the tiles of the paging scene rather than reading them from disk
+    osgDB::Registry::instance()->setReadFileCallback(new TileReadFileCallback);
+
+    osg::ref_ptr<ContextInfoOperation> info = new ContextInfoOperation;
+
+    std::vector<Result> results;
+    for(std::vector<std::string>::iterator sitr = scenes.begin(); sitr != scenes.end(); ++sitr)
+    {
+        for(std::vector<ThreadingPair>::iterator titr = threadingModels.begin(); titr != threadingModels.end(); ++titr)
+        {
+            Result result;
+            if (!runBenchmark(*sitr, titr->first, titr->second, numWarmupFrames, numFrames, width, height, pbuffer, info.get(), result)) return 1;
+
+            printSummary(result);
+            results.push_back(result);
+        }
+    }
+
+    if (!info->_renderer.empty()) std::cout<<"Renderer: "<<info->_renderer<<", "<<info->_version<<std::endl;
+
+    if (!writeResults(outputFilename, results, info.get(), width, height, perFrame))
+    {
+        std::cout<<"Unable to write results to "<<outputFilename<<std::endl;
+        return 1;
+    }
+
+    std::cout<<"Results written to "<<outputFilename<<std::endl;
+    return 0;
+}
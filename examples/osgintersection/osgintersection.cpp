@@ -31,8 +31,14 @@
 #include <osgSim/LineOfSight>
 #include <osgSim/HeightAboveTerrain>
 #include <osgSim/ElevationSlice>
+#include <osgSim/TerrainQueryService>
+
+#include <osg/Geode>
+#include <osg/ShapeDrawable>
 
 #include <iostream>
+#include <stdlib.h>
+#include <math.h>
 
 struct MyReadCallback : public osgUtil::IntersectionVisitor::ReadCallback
 {
@@ -49,11 +55,142 @@ struct MyReadCallback : public osgUtil::IntersectionVisitor::ReadCallback
 };
 
 
+// synthetic terrain of numTiles x numTiles height field tiles, each of tileSize x tileSize samples 10m apart.
+osg::ref_ptr<osg::Node> createSyntheticTerrain(unsigned int numTiles, unsigned int tileSize)
+{
+    osg::ref_ptr<osg::Group> group = new osg::Group;
+    float spacing = 10.0f;
+    float tileExtent = spacing*float(tileSize-1);
+    for(unsigned int ty=0; ty<numTiles; ++ty)
+    {
+        for(unsigned int tx=0; tx<numTiles; ++tx)
+        {
+            osg::ref_ptr<osg::HeightField> field = new osg::HeightField;
+            field->allocate(tileSize, tileSize);
+            field->setOrigin(osg::Vec3(float(tx)*tileExtent, float(ty)*tileExtent, 0.0f));
+            field->setXInterval(spacing);
+            field->setYInterval(spacing);
+            for(unsigned int r=0; r<tileSize; ++r)
+            {
+                for(unsigned int c=0; c<tileSize; ++c)
+                {
+                    float x = float(tx*(tileSize-1)+c), y = float(ty*(tileSize-1)+r);
+                    field->setHeight(c, r, 300.0f*sinf(x*0.004f)*cosf(y*0.005f) + 50.0f*sinf(x*0.03f+y*0.02f) + 5.0f*sinf(x*0.3f)*cosf(y*0.4f));
+                }
+            }
+
+            osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+            geode->addDrawable(new osg::ShapeDrawable(field.get()));
+            group->addChild(geode.get());
+        }
+    }
+    return group;
+}
+
+// compare computing batches of height above terrain and line of sight queries with HeightAboveTerrain/LineOfSight
+// against osgSim::TerrainQueryService, queries being clustered around a number of moving entities.
+int runQueryBenchmark(osg::Node* scene, unsigned int numQueries, unsigned int numThreads, unsigned int numTicks)
+{
+    osg::BoundingSphere bs = scene->getBound();
+    double extent = bs.radius()*0.7;
+
+    srand(1);
+    unsigned int numEntities = osg::maximum(numQueries/100, 1u);
+    std::vector<osg::Vec3d> entities;
+    for(unsigned int i=0; i<numEntities; ++i)
+    {
+        entities.push_back(bs.center() + osg::Vec3d((double(rand())/RAND_MAX*2.0-1.0)*extent, (double(rand())/RAND_MAX*2.0-1.0)*extent, 1000.0));
+    }
+
+    osg::ref_ptr<osgSim::TerrainQueryService> service = new osgSim::TerrainQueryService(scene, numThreads);
+    service->setTileSize(extent/8.0);
+
+    std::cout<<"Query benchmark, "<<numQueries<<" queries per tick, half height above terrain, half line of sight, "<<service->getNumThreads()<<" threads"<<std::endl;
+
+    double batchTime = 0.0, serviceTime = 0.0, repeatTime = 0.0;
+    unsigned int numMismatches = 0;
+
+    for(unsigned int tick=0; tick<numTicks; ++tick)
+    {
+        std::vector<osg::Vec3d> points;
+        std::vector< std::pair<osg::Vec3d, osg::Vec3d> > lines;
+        for(unsigned int i=0; i<numQueries; ++i)
+        {
+            const osg::Vec3d& entity = entities[i%numEntities];
+            osg::Vec3d offset((double(rand())/RAND_MAX-0.5)*500.0, (double(rand())/RAND_MAX-0.5)*500.0, (double(rand())/RAND_MAX-0.5)*200.0);
+            osg::Vec3d point = entity + offset + osg::Vec3d(double(tick)*20.0, 0.0, 0.0);
+            if (i%2==0) points.push_back(point);
+            else lines.push_back(std::make_pair(point, entities[(i/2)%numEntities] + osg::Vec3d(0.0, 0.0, -900.0)));
+        }
+
+        // all the queries in one HeightAboveTerrain and one LineOfSight batch.
+        osgSim::HeightAboveTerrain hat;
+        osgSim::LineOfSight los;
+        hat.setDatabaseCacheReadCallback(0);
+        los.setDatabaseCacheReadCallback(0);
+        for(unsigned int i=0; i<points.size(); ++i) hat.addPoint(points[i]);
+        for(unsigned int i=0; i<lines.size(); ++i) los.addLOS(lines[i].first, lines[i].second);
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        hat.computeIntersections(scene);
+        los.computeIntersections(scene);
+        batchTime += osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+
+        // the same queries through the service, then submitted again to be served from its cache.
+        for(unsigned int pass=0; pass<2; ++pass)
+        {
+            startTick = osg::Timer::instance()->tick();
+
+            std::vector< osg::ref_ptr<osgSim::TerrainQueryService::Query> > hatQueries, losQueries;
+            for(unsigned int i=0; i<points.size(); ++i) hatQueries.push_back(service->computeHeightAboveTerrain(points[i]));
+            for(unsigned int i=0; i<lines.size(); ++i) losQueries.push_back(service->computeLineOfSight(lines[i].first, lines[i].second));
+            service->flush();
+            service->waitForCompletion();
+
+            double duration = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+            if (pass==0) serviceTime += duration;
+            else repeatTime += duration;
+
+            for(unsigned int i=0; i<points.size(); ++i)
+            {
+                if (hatQueries[i]->getHeightAboveTerrain()!=hat.getHeightAboveTerrain(i)) ++numMismatches;
+            }
+            for(unsigned int i=0; i<lines.size(); ++i)
+            {
+                if (losQueries[i]->getIntersections()!=los.getIntersections(i)) ++numMismatches;
+            }
+        }
+    }
+
+    double totalQueries = double(numQueries)*double(numTicks);
+    std::cout<<"  HeightAboveTerrain/LineOfSight batches : "<<totalQueries/batchTime<<" queries/s"<<std::endl;
+    std::cout<<"  TerrainQueryService                   : "<<totalQueries/serviceTime<<" queries/s, "<<service->getNumTraversals()<<" traversals"<<std::endl;
+    std::cout<<"  TerrainQueryService repeated queries  : "<<totalQueries/repeatTime<<" queries/s, "<<service->getNumQueriesCached()<<" served from cache"<<std::endl;
+    std::cout<<"  results differing from HeightAboveTerrain/LineOfSight : "<<numMismatches<<std::endl;
+
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     // use an ArgumentParser object to manage the program arguments.
     osg::ArgumentParser arguments(&argc,argv);
 
+    if (arguments.read("--query-benchmark"))
+    {
+        unsigned int numQueries = 10000;
+        unsigned int numThreads = 0;
+        unsigned int numTicks = 5;
+        while(arguments.read("--queries", numQueries)) {}
+        while(arguments.read("--threads", numThreads)) {}
+        while(arguments.read("--ticks", numTicks)) {}
+
+        osg::ref_ptr<osg::Node> scene = osgDB::readRefNodeFiles(arguments);
+        if (!scene) scene = createSyntheticTerrain(16, 129);
+
+        return runQueryBenchmark(scene.get(), numQueries, numThreads, numTicks);
+    }
+
     osg::ref_ptr<osg::Node> scene = osgDB::readRefNodeFiles(arguments);
 
     if (!scene)
@@ -38,8 +38,12 @@
 
 #include <osgFX/MultiTextureControl>
 
+#include <osg/Timer>
+
 
 #include <iostream>
+#include <vector>
+#include <string.h>
 
 template<class T>
 class FindTopMostNodeOfTypeVisitor : public osg::NodeVisitor
@@ -268,10 +272,88 @@ class CleanTechniqueReadFileCallback : public osgDB::ReadFileCallback
 };
 
 
+// time the generation of the geometry of synthetic geocentric tiles, with an elevation and a color layer,
+// for increasing numbers of GeometryTechnique generation threads.
+int runGenerationBenchmark(unsigned int tileSize, unsigned int numIterations)
+{
+    osg::ref_ptr<osgTerrain::Terrain> terrain = new osgTerrain::Terrain;
+
+    osg::ref_ptr<osgTerrain::Locator> locator = new osgTerrain::Locator;
+    locator->setCoordinateSystemType(osgTerrain::Locator::GEOCENTRIC);
+    locator->setTransformAsExtents(osg::DegreesToRadians(10.0), osg::DegreesToRadians(45.0), osg::DegreesToRadians(11.0), osg::DegreesToRadians(46.0));
+
+    osg::ref_ptr<osg::HeightField> hf = new osg::HeightField;
+    hf->allocate(tileSize, tileSize);
+    hf->setSkirtHeight(10.0f);
+    for(unsigned int r=0; r<tileSize; ++r)
+    {
+        for(unsigned int c=0; c<tileSize; ++c)
+        {
+            hf->setHeight(c, r, 1000.0f*sinf(float(c)*0.05f)*cosf(float(r)*0.07f));
+        }
+    }
+
+    osg::ref_ptr<osgTerrain::HeightFieldLayer> elevationLayer = new osgTerrain::HeightFieldLayer(hf.get());
+    elevationLayer->setLocator(locator.get());
+
+    osg::ref_ptr<osg::Image> image = new osg::Image;
+    image->allocateImage(256, 256, 1, GL_RGB, GL_UNSIGNED_BYTE);
+    memset(image->data(), 128, image->getTotalSizeInBytes());
+
+    // give the color layer its own locator so that texture coordinates are converted between locators.
+    osg::ref_ptr<osgTerrain::Locator> colorLocator = new osgTerrain::Locator(*locator);
+    colorLocator->setTransformAsExtents(osg::DegreesToRadians(9.5), osg::DegreesToRadians(44.5), osg::DegreesToRadians(11.5), osg::DegreesToRadians(46.5));
+
+    osg::ref_ptr<osgTerrain::ImageLayer> colorLayer = new osgTerrain::ImageLayer(image.get());
+    colorLayer->setLocator(colorLocator.get());
+
+    osg::ref_ptr<osgTerrain::TerrainTile> tile = new osgTerrain::TerrainTile;
+    tile->setTerrain(terrain.get());
+    tile->setLocator(locator.get());
+    tile->setElevationLayer(elevationLayer.get());
+    tile->setColorLayer(0, colorLayer.get());
+
+    unsigned int maxNumThreads = osgTerrain::GeometryTechnique::getNumGenerationThreads();
+
+    std::vector<unsigned int> threadCounts;
+    for(unsigned int numThreads=1; numThreads<maxNumThreads; numThreads*=2) threadCounts.push_back(numThreads);
+    threadCounts.push_back(maxNumThreads);
+
+    std::cout<<"Generating "<<tileSize<<"x"<<tileSize<<" tile "<<numIterations<<" times"<<std::endl;
+    for(std::vector<unsigned int>::iterator itr = threadCounts.begin(); itr != threadCounts.end(); ++itr)
+    {
+        osgTerrain::GeometryTechnique::setNumGenerationThreads(*itr);
+
+        // generate once first so that the generation thread pool is started outside of the timing.
+        tile->init(osgTerrain::TerrainTile::ALL_DIRTY, false);
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        for(unsigned int i=0; i<numIterations; ++i)
+        {
+            tile->init(osgTerrain::TerrainTile::ALL_DIRTY, false);
+        }
+        double duration = osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick());
+
+        std::cout<<"  threads="<<*itr<<"  "<<duration/double(numIterations)<<"ms per tile"<<std::endl;
+    }
+
+    osgTerrain::GeometryTechnique::setNumGenerationThreads(maxNumThreads);
+    return 0;
+}
+
+
 int main(int argc, char** argv)
 {
     osg::ArgumentParser arguments(&argc, argv);
 
+    unsigned int benchmarkTileSize = 0;
+    if (arguments.read("--generation-benchmark", benchmarkTileSize) && benchmarkTileSize>1)
+    {
+        unsigned int numIterations = 20;
+        while(arguments.read("--iterations", numIterations)) {}
+        return runGenerationBenchmark(benchmarkTileSize, numIterations);
+    }
+
     // construct the viewer.
     osgViewer::Viewer viewer(arguments);
 
@@ -388,6 +470,9 @@ int main(int argc, char** argv)
     if (useDisplacementMappingTechnique)
     {
         terrain->setTerrainTechniquePrototype(new osgTerrain::DisplacementMappingTechnique());
+
+        // hold the heights of the tiles as 16 bit quantized heightfields rather than displaced vertices.
+        if (arguments.read("--quantize-heights")) terrain->getGeometryPool()->setUseQuantizedHeights(true);
     }
 
 
@@ -0,0 +1,363 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "HttpLoadBenchmark.h"
+
+#include <osg/Timer>
+#include <osg/Geode>
+#include <osg/Geometry>
+
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+
+#include <OpenThreads/Thread>
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined (WIN32) || defined(__CYGWIN__)
+    #include <sys/types.h>
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+
+    typedef int Socket;
+    static const Socket INVALID_SOCKET_HANDLE = -1;
+    static void closeSocket(Socket s) { close(s); }
+    static void shutdownSocket(Socket s) { shutdown(s, SHUT_RDWR); }
+    typedef socklen_t SocketLength;
+#else
+    #include <winsock2.h>
+
+    typedef SOCKET Socket;
+    static const Socket INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+    static void closeSocket(Socket s) { closesocket(s); }
+    static void shutdownSocket(Socket s) { shutdown(s, SD_BOTH); }
+    typedef int SocketLength;
+#endif
+
+// Serves a single connection of the LoopbackHttpServer, answering each GET with the tile after the configured latency.
+class LoopbackConnection : public OpenThreads::Thread
+{
+public:
+
+    LoopbackConnection(Socket socket, const std::string& tile, unsigned int latency):
+        _socket(socket),
+        _tile(tile),
+        _latency(latency) {}
+
+    ~LoopbackConnection()
+    {
+        closeSocket(_socket);
+    }
+
+    void stop() { shutdownSocket(_socket); }
+
+    virtual void run()
+    {
+        std::string request;
+        char buffer[4096];
+        while(true)
+        {
+            std::string::size_type end = request.find("\r\n\r\n");
+            if (end==std::string::npos)
+            {
+                int numRead = recv(_socket, buffer, sizeof(buffer), 0);
+                if (numRead<=0) return;
+                request.append(buffer, numRead);
+                continue;
+            }
+
+            bool isGet = request.compare(0, 4, "GET ")==0;
+            request.erase(0, end+4);
+
+            if (_latency>0) OpenThreads::Thread::microSleep(_latency*1000);
+
+            std::ostringstream response;
+            if (isGet)
+            {
+                response<<"HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: "<<_tile.size()<<"\r\n\r\n"<<_tile;
+            }
+            else
+            {
+                response<<"HTTP/1.1 405 Method Not Allowed\r\nContent-Length: 0\r\n\r\n";
+            }
+
+            std::string data = response.str();
+            std::string::size_type numSent = 0;
+            while(numSent<data.size())
+            {
+                int numWritten = send(_socket, data.data()+numSent, static_cast<int>(data.size()-numSent), 0);
+                if (numWritten<=0) return;
+                numSent += numWritten;
+            }
+        }
+    }
+
+protected:
+
+    Socket          _socket;
+    std::string     _tile;
+    unsigned int    _latency;
+};
+
+// Minimal HTTP/1.1 server on the loopback interface, so the benchmark can be run without a tile server, serving the same tile for every request.
+class LoopbackHttpServer : public OpenThreads::Thread
+{
+public:
+
+    LoopbackHttpServer():
+        _latency(0),
+        _socket(INVALID_SOCKET_HANDLE),
+        _port(0) {}
+
+    ~LoopbackHttpServer()
+    {
+        stop();
+    }
+
+    /** Open the listening socket on an ephemeral port and start accepting connections, returning false on failure.*/
+    bool start(const std::string& tile, unsigned int latency)
+    {
+        _tile = tile;
+        _latency = latency;
+
+#if defined (WIN32) && !defined(__CYGWIN__)
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2,2), &wsaData)!=0) return false;
+#endif
+
+        _socket = socket(AF_INET, SOCK_STREAM, 0);
+        if (_socket==INVALID_SOCKET_HANDLE) return false;
+
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+
+        SocketLength length = sizeof(address);
+        if (bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address))!=0 ||
+            listen(_socket, 64)!=0 ||
+            getsockname(_socket, reinterpret_cast<sockaddr*>(&address), &length)!=0)
+        {
+            closeSocket(_socket);
+            _socket = INVALID_SOCKET_HANDLE;
+            return false;
+        }
+
+        _port = ntohs(address.sin_port);
+        startThread();
+        return true;
+    }
+
+    void stop()
+    {
+        if (_socket==INVALID_SOCKET_HANDLE) return;
+
+        shutdownSocket(_socket);
+        closeSocket(_socket);
+        join();
+        _socket = INVALID_SOCKET_HANDLE;
+
+        for(Connections::iterator itr = _connections.begin(); itr != _connections.end(); ++itr)
+        {
+            (*itr)->stop();
+            (*itr)->join();
+            delete *itr;
+        }
+        _connections.clear();
+
+#if defined (WIN32) && !defined(__CYGWIN__)
+        WSACleanup();
+#endif
+    }
+
+    unsigned short getPort() const { return _port; }
+
+    virtual void run()
+    {
+        while(true)
+        {
+            Socket connection = accept(_socket, 0, 0);
+            if (connection==INVALID_SOCKET_HANDLE) return;
+
+            _connections.push_back(new LoopbackConnection(connection, _tile, _latency));
+            _connections.back()->startThread();
+        }
+    }
+
+protected:
+
+    typedef std::vector<LoopbackConnection*> Connections;
+
+    std::string     _tile;
+    unsigned int    _latency;
+    Socket          _socket;
+    unsigned short  _port;
+    Connections     _connections;
+};
+
+// Tile of a few thousand points written in the native ascii format, of a similar size to a typical paged terrain or point cloud tile.
+static std::string createTile()
+{
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    for(unsigned int i=0; i<4096; ++i)
+    {
+        vertices->push_back(osg::Vec3(static_cast<float>(i%64), static_cast<float>(i/64), 0.0f));
+    }
+
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(vertices.get());
+    geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertices->size()));
+
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+    geode->addDrawable(geometry.get());
+
+    std::ostringstream tile;
+    osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension("osgt");
+    if (!rw || !rw->writeNode(*geode, tile).success()) return std::string();
+    return tile.str();
+}
+
+// Reads tiles, in the manner of a DatabasePager thread, taking the index of the next tile from a shared counter.
+class HttpLoadThread : public OpenThreads::Thread
+{
+public:
+
+    HttpLoadThread(const std::string& urlPattern, unsigned int numRequests, OpenThreads::Atomic& nextRequest, OpenThreads::Atomic& numFailed, const osgDB::Options* options):
+        _urlPattern(urlPattern),
+        _numRequests(numRequests),
+        _nextRequest(nextRequest),
+        _numFailed(numFailed),
+        _options(options) {}
+
+    virtual void run()
+    {
+        while(true)
+        {
+            unsigned int request = ++_nextRequest - 1;
+            if (request>=_numRequests) break;
+
+            char url[1024];
+            snprintf(url, sizeof(url), _urlPattern.c_str(), request);
+
+            osg::ref_ptr<osg::Object> object = osgDB::readRefObjectFile(url, _options.get());
+            if (!object) ++_numFailed;
+        }
+    }
+
+protected:
+
+    std::string                         _urlPattern;
+    unsigned int                        _numRequests;
+    OpenThreads::Atomic&                _nextRequest;
+    OpenThreads::Atomic&                _numFailed;
+    osg::ref_ptr<const osgDB::Options>  _options;
+};
+
+static double timeHttpLoad(const std::string& urlPattern, unsigned int numThreads, unsigned int numRequests, const osgDB::Options* options, unsigned int& numFailed)
+{
+    OpenThreads::Atomic nextRequest(0);
+    OpenThreads::Atomic failed(0);
+
+    std::vector<HttpLoadThread*> threads;
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    for(unsigned int i=0; i<numThreads; ++i)
+    {
+        threads.push_back(new HttpLoadThread(urlPattern, numRequests, nextRequest, failed, options));
+        threads.back()->startThread();
+    }
+
+    for(std::vector<HttpLoadThread*>::iterator itr = threads.begin(); itr != threads.end(); ++itr)
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+
+    osg::Timer_t endTick = osg::Timer::instance()->tick();
+
+    numFailed = failed;
+    return osg::Timer::instance()->delta_s(startTick, endTick);
+}
+
+void runHttpLoadBenchmark(const std::string& pattern, osg::ArgumentParser& arguments)
+{
+    unsigned int numThreads = 4;
+    while(arguments.read("--threads", numThreads)) {}
+
+    unsigned int numRequests = 200;
+    while(arguments.read("--requests", numRequests)) {}
+
+    unsigned int latency = 20;
+    while(arguments.read("--latency", latency)) {}
+
+    if (numThreads==0) numThreads = 1;
+
+    // without a URL pattern the tiles are served from the loopback interface, with a delay standing in for the network latency.
+    std::string urlPattern = pattern;
+    LoopbackHttpServer server;
+    if (urlPattern.empty())
+    {
+        std::string tile = createTile();
+        if (tile.empty())
+        {
+            std::cout<<"HTTP load benchmark unable to write a tile, osgt plugin not found."<<std::endl;
+            return;
+        }
+
+        if (!server.start(tile, latency))
+        {
+            std::cout<<"HTTP load benchmark unable to open a loopback server socket."<<std::endl;
+            return;
+        }
+
+        std::ostringstream url;
+        url<<"http://127.0.0.1:"<<server.getPort()<<"/tiles/%d.osgt";
+        urlPattern = url.str();
+
+        std::cout<<"Serving "<<tile.size()<<" byte tiles from the loopback interface with "<<latency<<" ms latency"<<std::endl;
+    }
+
+    std::cout<<"**** HTTP load benchmark, "<<urlPattern<<", "<<numRequests<<" requests on "<<numThreads<<" threads ******"<<std::endl;
+
+    // compare a curl easy handle per thread against the shared transfer thread of the curl multi interface.
+    osg::ref_ptr<osgDB::Options> easyOptions = new osgDB::Options("OSG_CURL_MULTI=0");
+    easyOptions->setObjectCacheHint(osgDB::Options::CACHE_NONE);
+
+    osg::ref_ptr<osgDB::Options> multiOptions = new osgDB::Options("OSG_CURL_MULTI=1");
+    multiOptions->setObjectCacheHint(osgDB::Options::CACHE_NONE);
+
+    unsigned int easyFailed = 0;
+    double easyTime = timeHttpLoad(urlPattern, numThreads, numRequests, easyOptions.get(), easyFailed);
+
+    unsigned int multiFailed = 0;
+    double multiTime = timeHttpLoad(urlPattern, numThreads, numRequests, multiOptions.get(), multiFailed);
+
+    std::cout<<"easy handle per thread \t"<<easyTime<<" s\t"<<double(numRequests)/easyTime<<" tiles/s\t"<<easyFailed<<" failed"<<std::endl;
+    std::cout<<"multi interface        \t"<<multiTime<<" s\t"<<double(numRequests)/multiTime<<" tiles/s\t"<<multiFailed<<" failed"<<std::endl;
+}
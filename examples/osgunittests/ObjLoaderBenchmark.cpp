@@ -0,0 +1,151 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "ObjLoaderBenchmark.h"
+
+#include <osg/Timer>
+
+#include <osgDB/Registry>
+#include <osgDB/fstream>
+
+#include <OpenThreads/Thread>
+
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+
+// Time reading the file through the stream interface of the obj plugin, which parses line by line with sscanf.
+static double timeStreamRead(osgDB::ReaderWriter* rw, const std::string& filename, const osgDB::Options* options)
+{
+    osgDB::ifstream fin(filename.c_str());
+    if (!fin) return -1.0;
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    osgDB::ReaderWriter::ReadResult rr = rw->readNode(fin, options);
+    osg::Timer_t endTick = osg::Timer::instance()->tick();
+
+    return rr.validNode() ? osg::Timer::instance()->delta_m(startTick, endTick) : -1.0;
+}
+
+// Time reading the file by name, which memory maps the file and parses it in parallel chunks.
+static double timeMappedRead(osgDB::ReaderWriter* rw, const std::string& filename, const osgDB::Options* options)
+{
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    osgDB::ReaderWriter::ReadResult rr = rw->readNode(filename, options);
+    osg::Timer_t endTick = osg::Timer::instance()->tick();
+
+    return rr.validNode() ? osg::Timer::instance()->delta_m(startTick, endTick) : -1.0;
+}
+
+void runObjLoaderBenchmark(const std::string& filename, osg::ArgumentParser& arguments)
+{
+    unsigned int numRuns = 3;
+    while(arguments.read("--runs", numRuns)) {}
+
+    unsigned int numThreads = OpenThreads::GetNumberOfProcessors();
+    while(arguments.read("--parse-threads", numThreads)) {}
+
+    osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension("obj");
+    if (!rw)
+    {
+        std::cout<<"obj plugin not available."<<std::endl;
+        return;
+    }
+
+    std::cout<<"**** OBJ loader benchmark, "<<filename<<", best of "<<numRuns<<" runs ******"<<std::endl;
+
+    std::stringstream threadsOption;
+    threadsOption<<"parseThreads="<<numThreads;
+
+    osg::ref_ptr<osgDB::Options> singleThreadOptions = new osgDB::Options("noTriStripPolygons parseThreads=1");
+    osg::ref_ptr<osgDB::Options> multiThreadOptions = new osgDB::Options(std::string("noTriStripPolygons ")+threadsOption.str());
+
+    double streamTime = -1.0;
+    double singleThreadTime = -1.0;
+    double multiThreadTime = -1.0;
+    for(unsigned int i=0; i<numRuns; ++i)
+    {
+        double time = timeStreamRead(rw, filename, singleThreadOptions.get());
+        if (time>=0.0 && (streamTime<0.0 || time<streamTime)) streamTime = time;
+
+        time = timeMappedRead(rw, filename, singleThreadOptions.get());
+        if (time>=0.0 && (singleThreadTime<0.0 || time<singleThreadTime)) singleThreadTime = time;
+
+        time = timeMappedRead(rw, filename, multiThreadOptions.get());
+        if (time>=0.0 && (multiThreadTime<0.0 || time<multiThreadTime)) multiThreadTime = time;
+    }
+
+    if (streamTime<0.0 || singleThreadTime<0.0 || multiThreadTime<0.0)
+    {
+        std::cout<<"Failed to load "<<filename<<std::endl;
+        return;
+    }
+
+    std::cout<<"stream parser          \t"<<streamTime<<" ms"<<std::endl;
+    std::cout<<"mapped, 1 thread       \t"<<singleThreadTime<<" ms\t"<<streamTime/singleThreadTime<<"x"<<std::endl;
+    std::cout<<"mapped, "<<numThreads<<" threads      \t"<<multiThreadTime<<" ms\t"<<streamTime/multiThreadTime<<"x"<<std::endl;
+}
+
+void runObjLoaderBenchmark(unsigned int gridSize, osg::ArgumentParser& arguments)
+{
+    std::string filename = "osgunittests_benchmark.obj";
+
+    {
+        // write out a textured grid of quads in the style of a photogrammetry mesh.
+        osgDB::ofstream fout(filename.c_str());
+        if (!fout)
+        {
+            std::cout<<"Unable to write "<<filename<<std::endl;
+            return;
+        }
+
+        fout.precision(7);
+
+        for(unsigned int j=0; j<gridSize; ++j)
+        {
+            for(unsigned int i=0; i<gridSize; ++i)
+            {
+                fout<<"v "<<float(i)*0.25f<<" "<<float(j)*0.25f<<" "<<float((i*7919+j*104729)%1000)*0.001f<<"\n";
+            }
+        }
+
+        for(unsigned int j=0; j<gridSize; ++j)
+        {
+            for(unsigned int i=0; i<gridSize; ++i)
+            {
+                fout<<"vt "<<float(i)/float(gridSize)<<" "<<float(j)/float(gridSize)<<"\n";
+            }
+        }
+
+        for(unsigned int j=0; j+1<gridSize; ++j)
+        {
+            for(unsigned int i=0; i+1<gridSize; ++i)
+            {
+                unsigned int a = j*gridSize+i+1;
+                unsigned int b = a+1;
+                unsigned int c = a+gridSize+1;
+                unsigned int d = a+gridSize;
+                fout<<"f "<<a<<"/"<<a<<" "<<b<<"/"<<b<<" "<<c<<"/"<<c<<" "<<d<<"/"<<d<<"\n";
+            }
+        }
+    }
+
+    runObjLoaderBenchmark(filename, arguments);
+
+    remove(filename.c_str());
+}
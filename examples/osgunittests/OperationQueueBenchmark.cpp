@@ -0,0 +1,170 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "OperationQueueBenchmark.h"
+
+#include <osg/OperationThread>
+#include <osg/Timer>
+
+#include <OpenThreads/Thread>
+#include <OpenThreads/Barrier>
+#include <OpenThreads/ScopedLock>
+
+#include <iostream>
+
+// Operation that just counts how many times it has been run.
+class CountOperation : public osg::Operation
+{
+public:
+
+    CountOperation(OpenThreads::Atomic& count):
+        osg::Operation("Count", false),
+        _count(count) {}
+
+    virtual void operator () (osg::Object*) { ++_count; }
+
+protected:
+
+    OpenThreads::Atomic& _count;
+};
+
+// Reference queue that mirrors the mutex and std::list based OperationQueue that
+// preceded the lock free implementation, used as the baseline for comparison.
+class MutexOperationQueue : public osg::Referenced
+{
+public:
+
+    void add(osg::Operation* operation)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _operations.push_back(operation);
+    }
+
+    void runOperations(osg::Object* callingObject=0)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        for(Operations::iterator itr = _operations.begin();
+            itr != _operations.end();)
+        {
+            osg::ref_ptr<osg::Operation> operation = *itr;
+            if (!operation->getKeep()) itr = _operations.erase(itr);
+            else ++itr;
+
+            (*operation)(callingObject);
+        }
+    }
+
+protected:
+
+    typedef std::list< osg::ref_ptr<osg::Operation> > Operations;
+
+    OpenThreads::Mutex  _mutex;
+    Operations          _operations;
+};
+
+struct RefBarrier : public osg::Referenced, public OpenThreads::Barrier
+{
+    RefBarrier(int numThreads):
+        OpenThreads::Barrier(numThreads) {}
+};
+
+template<class Queue>
+class ProducerThread : public osg::Referenced, public OpenThreads::Thread
+{
+public:
+
+    ProducerThread(Queue* queue, RefBarrier* startBarrier, OpenThreads::Atomic& count, unsigned int numOperations):
+        _queue(queue),
+        _startBarrier(startBarrier),
+        _count(count),
+        _numOperations(numOperations) {}
+
+    virtual void run()
+    {
+        _startBarrier->block();
+
+        for(unsigned int i=0; i<_numOperations; ++i)
+        {
+            _queue->add(new CountOperation(_count));
+        }
+    }
+
+protected:
+
+    osg::ref_ptr<Queue>         _queue;
+    osg::ref_ptr<RefBarrier>    _startBarrier;
+    OpenThreads::Atomic&        _count;
+    unsigned int                _numOperations;
+};
+
+template<class Queue>
+double runQueueBenchmark(Queue* queue, int numProducers, unsigned int numOperationsPerProducer)
+{
+    typedef std::list< osg::ref_ptr< ProducerThread<Queue> > > ProducerThreads;
+
+    OpenThreads::Atomic count;
+    osg::ref_ptr<RefBarrier> startBarrier = new RefBarrier(numProducers+1);
+
+    ProducerThreads producers;
+    for(int i=0; i<numProducers; ++i)
+    {
+        osg::ref_ptr< ProducerThread<Queue> > producer = new ProducerThread<Queue>(queue, startBarrier.get(), count, numOperationsPerProducer);
+        producers.push_back(producer);
+        producer->start();
+    }
+
+    unsigned int totalNumOperations = numProducers*numOperationsPerProducer;
+
+    startBarrier->block();
+
+    // this thread acts as the consumer, running batches of operations as a graphics or update thread would each frame.
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    while(count < totalNumOperations)
+    {
+        queue->runOperations();
+    }
+    osg::Timer_t endTick = osg::Timer::instance()->tick();
+
+    for(typename ProducerThreads::iterator itr = producers.begin();
+        itr != producers.end();
+        ++itr)
+    {
+        (*itr)->join();
+    }
+
+    return osg::Timer::instance()->delta_s(startTick, endTick);
+}
+
+void runOperationQueueBenchmark(int numProducers, osg::ArgumentParser& arguments)
+{
+    unsigned int numOperations = 100000;
+    while(arguments.read("--operations", numOperations)) {}
+
+    std::cout<<"**** OperationQueue benchmark, "<<numProducers<<" producers adding "<<numOperations<<" operations each ******"<<std::endl;
+
+    osg::ref_ptr<MutexOperationQueue> mutexQueue = new MutexOperationQueue;
+    double mutexTime = runQueueBenchmark(mutexQueue.get(), numProducers, numOperations);
+
+    osg::ref_ptr<osg::OperationQueue> lockFreeQueue = new osg::OperationQueue;
+    double lockFreeTime = runQueueBenchmark(lockFreeQueue.get(), numProducers, numOperations);
+
+    double totalNumOperations = static_cast<double>(numProducers)*static_cast<double>(numOperations);
+
+    std::cout<<"mutex queue      \t"<<mutexTime*1000.0<<" ms\t"<<totalNumOperations/mutexTime<<" operations/s"<<std::endl;
+    std::cout<<"osg::OperationQueue\t"<<lockFreeTime*1000.0<<" ms\t"<<totalNumOperations/lockFreeTime<<" operations/s"<<std::endl;
+}
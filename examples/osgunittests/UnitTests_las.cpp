@@ -0,0 +1,291 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "UnitTestFramework.h"
+
+// the octree builder and point budget of the las plugin don't depend on liblas, so are built into osgunittests to test them.
+#include "../../src/osgPlugins/las/LASOctree.h"
+
+#include <osg/Geometry>
+#include <osg/PagedLOD>
+#include <osg/FrameStamp>
+
+#include <osgDB/ReadFile>
+#include <osgDB/FileUtils>
+#include <osgDB/FileNameUtils>
+
+#include <osgUtil/SceneView>
+
+#include <sstream>
+#include <stdio.h>
+
+namespace las
+{
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  LAS octree Tests
+//
+
+/** Collects the points of a tile, and the PagedLODs referring to the tiles beneath it.*/
+class TileVisitor : public osg::NodeVisitor
+{
+public:
+
+    TileVisitor():
+        osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN) {}
+
+    virtual void apply(osg::Geometry& geometry)
+    {
+        const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(geometry.getVertexArray());
+        if (vertices) points.insert(points.end(), vertices->begin(), vertices->end());
+    }
+
+    virtual void apply(osg::PagedLOD& plod)
+    {
+        pagedLODs.push_back(&plod);
+    }
+
+    std::vector<osg::Vec3>                      points;
+    std::vector< osg::ref_ptr<osg::PagedLOD> >  pagedLODs;
+};
+
+/** Records the LOD scale that the subgraph beneath the node is culled with.*/
+class LODScaleCallback : public osg::NodeCallback
+{
+public:
+
+    LODScaleCallback(): lodScale(0.0f) {}
+
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        osg::CullStack* cullStack = nv->asCullStack();
+        if (cullStack) lodScale = cullStack->getLODScale();
+        traverse(node, nv);
+    }
+
+    float lodScale;
+};
+
+class LASOctreeTestFixture
+{
+public:
+
+    LASOctreeTestFixture();
+    ~LASOctreeTestFixture();
+
+    void testBuildInMemory(const osgUtx::TestContext& ctx);
+    void testBuildThroughTemporaryFiles(const osgUtx::TestContext& ctx);
+    void testPointBudget(const osgUtx::TestContext& ctx);
+
+private:
+
+    bool build(double memoryBudget);
+
+    /** Read the tile and those beneath it, returning the number of points found, or 0 if a tile lies outside the bound it was paged in with.*/
+    unsigned int countPoints(const std::string& fileName, const osg::BoundingSphere& bound, unsigned int& numTiles);
+
+    bool hasTemporaryFiles() const;
+
+    std::string     _directory;
+    OctreeSettings  _settings;
+    unsigned int    _numPoints;
+    unsigned int    _numTiles;
+};
+
+LASOctreeTestFixture::LASOctreeTestFixture():
+    _directory("osgunittests_las_octree"),
+    _numPoints(20000),
+    _numTiles(0)
+{
+    _settings.resolution = 8;
+    _settings.maxPointsPerNode = 1000;
+    _settings.numThreads = 2;
+}
+
+LASOctreeTestFixture::~LASOctreeTestFixture()
+{
+    osgDB::DirectoryContents contents = osgDB::getDirectoryContents(_directory);
+    for(osgDB::DirectoryContents::iterator itr = contents.begin();
+        itr != contents.end();
+        ++itr)
+    {
+        if (*itr!="." && *itr!="..") remove(osgDB::concatPaths(_directory, *itr).c_str());
+    }
+    remove(_directory.c_str());
+}
+
+bool LASOctreeTestFixture::build(double memoryBudget)
+{
+    _settings.memoryBudget = memoryBudget;
+
+    OctreeBuilder builder(_directory, _settings, 100.0f);
+
+    // points spread through the cube by a linear congruential generator, so every run builds the same octree.
+    unsigned int seed = 12345;
+    for(unsigned int i=0; i<_numPoints; ++i)
+    {
+        float coords[3];
+        for(unsigned int j=0; j<3; ++j)
+        {
+            seed = seed*1664525u + 1013904223u;
+            coords[j] = (static_cast<float>(seed>>8)/16777216.0f)*199.0f - 99.5f;
+        }
+        builder.addPoint(OctreePoint(osg::Vec3(coords[0], coords[1], coords[2]), osg::Vec4ub(255, i%256, 0, 255)));
+    }
+
+    bool result = builder.finish(osg::Matrixd::identity());
+    _numTiles = builder.getNumTiles();
+    return result && builder.getNumPoints()==_numPoints;
+}
+
+unsigned int LASOctreeTestFixture::countPoints(const std::string& fileName, const osg::BoundingSphere& bound, unsigned int& numTiles)
+{
+    osg::ref_ptr<osg::Node> tile = osgDB::readRefNodeFile(osgDB::concatPaths(_directory, fileName));
+    if (!tile) return 0;
+
+    ++numTiles;
+
+    TileVisitor visitor;
+    tile->accept(visitor);
+
+    unsigned int numPoints = static_cast<unsigned int>(visitor.points.size());
+    for(std::vector<osg::Vec3>::iterator itr = visitor.points.begin();
+        itr != visitor.points.end();
+        ++itr)
+    {
+        if (bound.valid() && (*itr-bound.center()).length()>bound.radius()*1.0001f) return 0;
+    }
+
+    for(std::vector< osg::ref_ptr<osg::PagedLOD> >::iterator itr = visitor.pagedLODs.begin();
+        itr != visitor.pagedLODs.end();
+        ++itr)
+    {
+        osg::PagedLOD* plod = itr->get();
+        unsigned int numChildPoints = countPoints(plod->getFileName(0), osg::BoundingSphere(plod->getCenter(), plod->getRadius()), numTiles);
+        if (numChildPoints==0) return 0;
+
+        numPoints += numChildPoints;
+    }
+
+    return numPoints;
+}
+
+bool LASOctreeTestFixture::hasTemporaryFiles() const
+{
+    osgDB::DirectoryContents contents = osgDB::getDirectoryContents(_directory);
+    for(osgDB::DirectoryContents::iterator itr = contents.begin();
+        itr != contents.end();
+        ++itr)
+    {
+        if (osgDB::getLowerCaseFileExtension(*itr)=="tmp") return true;
+    }
+    return false;
+}
+
+void LASOctreeTestFixture::testBuildInMemory(const osgUtx::TestContext&)
+{
+    OSGUTX_TEST_F( build(64.0*1024.0*1024.0) )
+    OSGUTX_TEST_F( _numTiles>1 )
+
+    // every point ends up in exactly one tile, within the bound of the PagedLOD that pages the tile in.
+    unsigned int numTiles = 0;
+    OSGUTX_TEST_F( countPoints("r.osgb", osg::BoundingSphere(), numTiles)==_numPoints )
+    OSGUTX_TEST_F( numTiles==_numTiles )
+}
+
+void LASOctreeTestFixture::testBuildThroughTemporaryFiles(const osgUtx::TestContext&)
+{
+    // room for 4000 points, so the points are distributed through temporary files twice before the nodes fit in memory.
+    OSGUTX_TEST_F( build(4000.0*2.0*sizeof(OctreePoint)) )
+    OSGUTX_TEST_F( !hasTemporaryFiles() )
+
+    unsigned int numTiles = 0;
+    OSGUTX_TEST_F( countPoints("r.osgb", osg::BoundingSphere(), numTiles)==_numPoints )
+    OSGUTX_TEST_F( numTiles==_numTiles )
+}
+
+void LASOctreeTestFixture::testPointBudget(const osgUtx::TestContext&)
+{
+    OSGUTX_TEST_F( build(64.0*1024.0*1024.0) )
+
+    // without the DatabasePager only the root tile is drawn.
+    TileVisitor rootTile;
+    osgDB::readRefNodeFile(OctreeBuilder::getRootFileName(_directory))->accept(rootTile);
+    unsigned int numRootPoints = static_cast<unsigned int>(rootTile.points.size());
+    OSGUTX_TEST_F( numRootPoints>0 )
+
+    osg::ref_ptr<osg::Node> root = readOctree(OctreeBuilder::getRootFileName(_directory), numRootPoints-1);
+    OSGUTX_TEST_F( root.valid() && root->asGroup() )
+    if (!root || !root->asGroup()) return;
+
+    PointBudgetCallback* pointBudgetCallback = dynamic_cast<PointBudgetCallback*>(root->getCullCallback());
+    OSGUTX_TEST_F( pointBudgetCallback && root->getUpdateCallback()==pointBudgetCallback )
+    if (!pointBudgetCallback) return;
+
+    osg::ref_ptr<LODScaleCallback> lodScaleCallback = new LODScaleCallback;
+    osg::ref_ptr<osg::Group> probe = new osg::Group;
+    probe->setCullingActive(false);
+    probe->setCullCallback(lodScaleCallback.get());
+    root->asGroup()->addChild(probe.get());
+
+    osg::ref_ptr<osg::FrameStamp> frameStamp = new osg::FrameStamp;
+    osg::ref_ptr<osgUtil::SceneView> sceneView = new osgUtil::SceneView;
+    sceneView->setDefaults();
+    sceneView->setSceneData(root.get());
+    sceneView->setFrameStamp(frameStamp.get());
+    sceneView->setViewport(0, 0, 640, 480);
+    sceneView->setProjectionMatrixAsPerspective(30.0, 640.0/480.0, 1.0, 10000.0);
+    sceneView->setViewMatrix(osg::Matrixd::lookAt(osg::Vec3d(0.0,-1000.0,0.0), osg::Vec3d(0.0,0.0,0.0), osg::Vec3d(0.0,0.0,1.0)));
+
+    // the root tile exceeds the budget, so the LOD scale is raised a step each frame to coarsen the octree.
+    float previousLODScale = 0.0f;
+    bool coarsened = true;
+    for(unsigned int i=0; i<5; ++i)
+    {
+        frameStamp->setFrameNumber(i);
+        sceneView->update();
+        sceneView->cull();
+
+        if (lodScaleCallback->lodScale<=previousLODScale) coarsened = false;
+        previousLODScale = lodScaleCallback->lodScale;
+    }
+    OSGUTX_TEST_F( coarsened )
+    OSGUTX_TEST_F( previousLODScale>1.4f )
+    OSGUTX_TEST_F( pointBudgetCallback->getNumPointsSelected()==numRootPoints )
+
+    // and lowered again, back down to the camera's, once the points drawn are comfortably within the budget.
+    pointBudgetCallback->setPointBudget(numRootPoints*2);
+    for(unsigned int i=5; i<20; ++i)
+    {
+        frameStamp->setFrameNumber(i);
+        sceneView->update();
+        sceneView->cull();
+    }
+    OSGUTX_TEST_F( lodScaleCallback->lodScale==sceneView->getLODScale() )
+}
+
+OSGUTX_BEGIN_TESTSUITE(LASOctree)
+    OSGUTX_ADD_TESTCASE(LASOctreeTestFixture, testBuildInMemory)
+    OSGUTX_ADD_TESTCASE(LASOctreeTestFixture, testBuildThroughTemporaryFiles)
+    OSGUTX_ADD_TESTCASE(LASOctreeTestFixture, testPointBudget)
+OSGUTX_END_TESTSUITE
+
+OSGUTX_AUTOREGISTER_TESTSUITE_AT(LASOctree, root.osgPlugins)
+
+}
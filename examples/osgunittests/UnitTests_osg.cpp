@@ -22,7 +22,16 @@
 #include <osg/Matrixf>
 #include <osg/Vec3d>
 #include <osg/Vec3>
+#include <osg/Array>
+#include <osg/DeleteHandler>
+#include <osg/Image>
+#include <osg/ImageUtils>
+#include <osg/Texture>
+#include <osg/Timer>
+#include <OpenThreads/Thread>
+#include <OpenThreads/Atomic>
 #include <sstream>
+#include <math.h>
 
 namespace osg
 {
@@ -380,5 +389,564 @@ OSGUTX_END_TESTSUITE
 
 OSGUTX_AUTOREGISTER_TESTSUITE_AT(Matrix, root.osg)
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  BufferData modified range Tests
+//
+
+// Thread dirtying single elements of an array, as an update thread would while draw threads upload the array.
+class DirtyElementsThread : public OpenThreads::Thread
+{
+public:
+
+    DirtyElementsThread(FloatArray* array, unsigned int numDirties):
+        _array(array),
+        _numDirties(numDirties) {}
+
+    virtual void run()
+    {
+        for(unsigned int i=0; i<_numDirties; ++i)
+        {
+            _array->dirty((i*7)%_array->size(), 1);
+            if (i%500==0) _array->dirty();
+        }
+    }
+
+    ref_ptr<FloatArray> _array;
+    unsigned int _numDirties;
+};
+
+class BufferDataTestFixture
+{
+public:
+
+    BufferDataTestFixture();
+
+    void testMergeRanges(const osgUtx::TestContext& ctx);
+    void testResetByDirty(const osgUtx::TestContext& ctx);
+    void testRangeHistoryLimit(const osgUtx::TestContext& ctx);
+    void testConcurrentDirty(const osgUtx::TestContext& ctx);
+
+private:
+
+    ref_ptr<FloatArray> _array;
+};
+
+BufferDataTestFixture::BufferDataTestFixture():
+    _array(new FloatArray(100))
+{
+}
+
+void BufferDataTestFixture::testMergeRanges(const osgUtx::TestContext&)
+{
+    unsigned int start = _array->getModifiedCount();
+    BufferData::ModifiedRanges ranges;
+
+    // elements 10-14 then 12-21 overlap, so are coalesced into the bytes 40-88.
+    _array->dirty(10, 5);
+    _array->dirty(12, 10);
+    unsigned int afterFirst = _array->getModifiedCount();
+    OSGUTX_TEST_F( afterFirst==start+2 )
+
+    // elements 50-51, then element 0 which is dirtied later but lies before the others.
+    _array->dirty(50, 2);
+    _array->dirty(0, 1);
+
+    OSGUTX_TEST_F( _array->getModifiedRangesSince(start, ranges) )
+    OSGUTX_TEST_F( ranges.size()==3 )
+    OSGUTX_TEST_F( ranges[0].offset==0 && ranges[0].size==4 )
+    OSGUTX_TEST_F( ranges[1].offset==40 && ranges[1].size==48 )
+    OSGUTX_TEST_F( ranges[2].offset==200 && ranges[2].size==8 )
+
+    // only the ranges dirtied since the given count are returned.
+    OSGUTX_TEST_F( _array->getModifiedRangesSince(afterFirst, ranges) )
+    OSGUTX_TEST_F( ranges.size()==2 && ranges[0].offset==0 && ranges[1].offset==200 )
+
+    // ranges dirtied separately are merged where they touch once sorted.
+    _array->dirty(1, 9);
+    OSGUTX_TEST_F( _array->getModifiedRangesSince(afterFirst, ranges) )
+    OSGUTX_TEST_F( ranges.size()==2 && ranges[0].offset==0 && ranges[0].size==40 && ranges[1].offset==200 )
+    OSGUTX_TEST_F( _array->getModifiedRangesSince(start, ranges) )
+    OSGUTX_TEST_F( ranges.size()==2 && ranges[0].offset==0 && ranges[0].size==88 )
+
+    OSGUTX_TEST_F( _array->getModifiedRangesSince(_array->getModifiedCount(), ranges) && ranges.empty() )
+}
+
+void BufferDataTestFixture::testResetByDirty(const osgUtx::TestContext&)
+{
+    BufferData::ModifiedRanges ranges;
+
+    _array->dirty(10, 5);
+    unsigned int beforeDirty = _array->getModifiedCount();
+
+    // a full dirty can't be expressed as ranges, so buffers that uploaded before it must upload everything.
+    _array->dirty();
+    OSGUTX_TEST_F( !_array->getModifiedRangesSince(beforeDirty, ranges) )
+
+    unsigned int afterDirty = _array->getModifiedCount();
+    OSGUTX_TEST_F( _array->getModifiedRangesSince(afterDirty, ranges) && ranges.empty() )
+
+    // the range dirtied before the full dirty isn't merged into the ones dirtied after it.
+    _array->dirty(14, 2);
+    OSGUTX_TEST_F( _array->getModifiedRangesSince(afterDirty, ranges) )
+    OSGUTX_TEST_F( ranges.size()==1 && ranges[0].offset==56 && ranges[0].size==8 )
+
+    _array->setModifiedCount(0);
+    OSGUTX_TEST_F( _array->getModifiedRangesSince(0, ranges) && ranges.empty() )
+}
+
+void BufferDataTestFixture::testRangeHistoryLimit(const osgUtx::TestContext&)
+{
+    unsigned int start = _array->getModifiedCount();
+    BufferData::ModifiedRanges ranges;
+
+    // every other element, so that none of the ranges are coalesced.
+    for(unsigned int i=0; i<50; ++i) _array->dirty(i*2, 1);
+    OSGUTX_TEST_F( _array->getModifiedRangesSince(start, ranges) && ranges.size()==50 )
+
+    // the oldest ranges are discarded once more than 64 are held, so a buffer that uploaded before them uploads everything.
+    for(unsigned int i=0; i<20; ++i) _array->dirty(i*2, 1);
+    OSGUTX_TEST_F( !_array->getModifiedRangesSince(start, ranges) )
+    OSGUTX_TEST_F( _array->getModifiedRangesSince(_array->getModifiedCount()-64, ranges) )
+}
+
+void BufferDataTestFixture::testConcurrentDirty(const osgUtx::TestContext&)
+{
+    DirtyElementsThread thread(_array.get(), 20000);
+    thread.startThread();
+
+    // read the ranges as a draw thread uploading the array would, each read returning sorted disjoint ranges.
+    bool valid = true;
+    BufferData::ModifiedRanges ranges;
+    unsigned int modifiedCount = 0;
+    while(thread.isRunning())
+    {
+        if (_array->getModifiedRangesSince(modifiedCount, ranges))
+        {
+            for(unsigned int i=1; i<ranges.size(); ++i)
+            {
+                if (ranges[i].offset<=ranges[i-1].end()) valid = false;
+            }
+        }
+        modifiedCount = _array->getModifiedCount();
+        OpenThreads::Thread::YieldCurrentThread();
+    }
+    thread.join();
+
+    OSGUTX_TEST_F( valid )
+    OSGUTX_TEST_F( _array->getModifiedCount()==20000+20000/500 )
+}
+
+OSGUTX_BEGIN_TESTSUITE(BufferData)
+    OSGUTX_ADD_TESTCASE(BufferDataTestFixture, testMergeRanges)
+    OSGUTX_ADD_TESTCASE(BufferDataTestFixture, testResetByDirty)
+    OSGUTX_ADD_TESTCASE(BufferDataTestFixture, testRangeHistoryLimit)
+    OSGUTX_ADD_TESTCASE(BufferDataTestFixture, testConcurrentDirty)
+OSGUTX_END_TESTSUITE
+
+OSGUTX_AUTOREGISTER_TESTSUITE_AT(BufferData, root.osg)
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  DeleteHandler Tests
+//
+
+class CountedObject : public Referenced
+{
+public:
+
+    CountedObject(OpenThreads::Atomic& numDeleted):
+        _numDeleted(numDeleted) {}
+
+protected:
+
+    virtual ~CountedObject() { ++_numDeleted; }
+
+    OpenThreads::Atomic& _numDeleted;
+};
+
+class DeleteHandlerTestFixture
+{
+public:
+
+    DeleteHandlerTestFixture();
+    ~DeleteHandlerTestFixture();
+
+    void testRetainFrames(const osgUtx::TestContext& ctx);
+    void testBackgroundDelete(const osgUtx::TestContext& ctx);
+    void testSwitchOffDeletesQueued(const osgUtx::TestContext& ctx);
+    void testDestructorDeletesQueued(const osgUtx::TestContext& ctx);
+
+private:
+
+    void requestDeletes(unsigned int numObjects);
+    bool waitForDeletes(unsigned int numObjects);
+
+    DeleteHandler*      _deleteHandler;
+    OpenThreads::Atomic _numDeleted;
+};
+
+DeleteHandlerTestFixture::DeleteHandlerTestFixture():
+    _deleteHandler(new DeleteHandler(0))
+{
+}
+
+DeleteHandlerTestFixture::~DeleteHandlerTestFixture()
+{
+    delete _deleteHandler;
+}
+
+void DeleteHandlerTestFixture::requestDeletes(unsigned int numObjects)
+{
+    // the objects are never referenced, so are handed straight to the handler as unref() would.
+    for(unsigned int i=0; i<numObjects; ++i)
+    {
+        _deleteHandler->requestDelete(new CountedObject(_numDeleted));
+    }
+}
+
+bool DeleteHandlerTestFixture::waitForDeletes(unsigned int numObjects)
+{
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    while(static_cast<unsigned int>(_numDeleted)<numObjects)
+    {
+        if (osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick())>10.0) return false;
+        OpenThreads::Thread::microSleep(1000);
+    }
+    return true;
+}
+
+void DeleteHandlerTestFixture::testRetainFrames(const osgUtx::TestContext&)
+{
+    _deleteHandler->setNumFramesToRetainObjects(2);
+    _deleteHandler->setFrameNumber(10);
+    requestDeletes(10);
+
+    _deleteHandler->setFrameNumber(11);
+    _deleteHandler->flush();
+    OSGUTX_TEST_F( static_cast<unsigned int>(_numDeleted)==0 )
+
+    _deleteHandler->setFrameNumber(12);
+    _deleteHandler->flush();
+    OSGUTX_TEST_F( static_cast<unsigned int>(_numDeleted)==10 )
+    OSGUTX_TEST_F( _deleteHandler->takeStatistics().numObjectsDeleted==10 )
+}
+
+void DeleteHandlerTestFixture::testBackgroundDelete(const osgUtx::TestContext&)
+{
+    _deleteHandler->setDeleteInBackgroundThread(true);
+    OSGUTX_TEST_F( _deleteHandler->getDeleteInBackgroundThread() )
+
+    // objects are queued until flushed, even when none are being retained.
+    requestDeletes(100);
+    OSGUTX_TEST_F( static_cast<unsigned int>(_numDeleted)==0 )
+
+    _deleteHandler->flush();
+    OSGUTX_TEST_F( waitForDeletes(100) )
+
+    DeleteHandler::Statistics statistics = _deleteHandler->takeStatistics();
+    OSGUTX_TEST_F( statistics.numObjectsDeleted==100 && statistics.numObjectsPending==0 )
+}
+
+void DeleteHandlerTestFixture::testSwitchOffDeletesQueued(const osgUtx::TestContext&)
+{
+    // a tiny budget so that the background thread is still working through the queue when switched off.
+    _deleteHandler->setBackgroundDeleteTimeBudget(1e-9);
+    _deleteHandler->setDeleteInBackgroundThread(true);
+
+    requestDeletes(1000);
+    _deleteHandler->flush();
+
+    _deleteHandler->setDeleteInBackgroundThread(false);
+    OSGUTX_TEST_F( !_deleteHandler->getDeleteInBackgroundThread() )
+    OSGUTX_TEST_F( static_cast<unsigned int>(_numDeleted)==1000 )
+
+    // with the thread off objects are deleted straight away again.
+    requestDeletes(1);
+    OSGUTX_TEST_F( static_cast<unsigned int>(_numDeleted)==1001 )
+}
+
+void DeleteHandlerTestFixture::testDestructorDeletesQueued(const osgUtx::TestContext&)
+{
+    _deleteHandler->setBackgroundDeleteTimeBudget(1e-9);
+    _deleteHandler->setDeleteInBackgroundThread(true);
+
+    requestDeletes(1000);
+    _deleteHandler->flush();
+
+    delete _deleteHandler;
+    _deleteHandler = 0;
+    OSGUTX_TEST_F( static_cast<unsigned int>(_numDeleted)==1000 )
+}
+
+OSGUTX_BEGIN_TESTSUITE(DeleteHandler)
+    OSGUTX_ADD_TESTCASE(DeleteHandlerTestFixture, testRetainFrames)
+    OSGUTX_ADD_TESTCASE(DeleteHandlerTestFixture, testBackgroundDelete)
+    OSGUTX_ADD_TESTCASE(DeleteHandlerTestFixture, testSwitchOffDeletesQueued)
+    OSGUTX_ADD_TESTCASE(DeleteHandlerTestFixture, testDestructorDeletesQueued)
+OSGUTX_END_TESTSUITE
+
+OSGUTX_AUTOREGISTER_TESTSUITE_AT(DeleteHandler, root.osg)
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Block compression Tests
+//
+
+// BC4 end point interpolation, shared by BC3 alpha and the BC4/BC5 channels.
+static void decodeChannelBlock(const unsigned char* block, unsigned char values[16])
+{
+    unsigned int e0 = block[0];
+    unsigned int e1 = block[1];
+    unsigned int palette[8];
+    palette[0] = e0;
+    palette[1] = e1;
+    if (e0>e1)
+    {
+        for(unsigned int i=1; i<7; ++i) palette[i+1] = ((7-i)*e0 + i*e1 + 3)/7;
+    }
+    else
+    {
+        for(unsigned int i=1; i<5; ++i) palette[i+1] = ((5-i)*e0 + i*e1 + 2)/5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    unsigned long long bits = 0;
+    for(int i=0; i<6; ++i) bits |= static_cast<unsigned long long>(block[2+i]) << (8*i);
+    for(int i=0; i<16; ++i) values[i] = static_cast<unsigned char>(palette[(bits>>(3*i))&7]);
+}
+
+static unsigned int readBits(const unsigned char* data, unsigned int& position, unsigned int numBits)
+{
+    unsigned int value = 0;
+    for(unsigned int i=0; i<numBits; ++i, ++position) value |= ((data[position>>3]>>(position&7))&1) << i;
+    return value;
+}
+
+// BC7 mode 6, the only mode written by the compressor, returns false for the other modes.
+static bool decodeBC7Block(const unsigned char* block, unsigned char texels[16][4])
+{
+    static const unsigned int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    unsigned int position = 0;
+
+    if (readBits(block, position, 7)!=(1<<6)) return false;
+
+    unsigned int endPoints[2][4];
+    for(unsigned int c=0; c<4; ++c)
+    {
+        endPoints[0][c] = readBits(block, position, 7) << 1;
+        endPoints[1][c] = readBits(block, position, 7) << 1;
+    }
+    unsigned int pbit0 = readBits(block, position, 1);
+    unsigned int pbit1 = readBits(block, position, 1);
+    for(unsigned int c=0; c<4; ++c)
+    {
+        endPoints[0][c] |= pbit0;
+        endPoints[1][c] |= pbit1;
+    }
+
+    for(unsigned int i=0; i<16; ++i)
+    {
+        unsigned int index = readBits(block, position, i==0 ? 3 : 4);
+        for(unsigned int c=0; c<4; ++c)
+        {
+            texels[i][c] = static_cast<unsigned char>(((64-weights[index])*endPoints[0][c] + weights[index]*endPoints[1][c] + 32) >> 6);
+        }
+    }
+    return true;
+}
+
+class BlockCompressionTestFixture
+{
+public:
+
+    BlockCompressionTestFixture();
+
+    void testBC1(const osgUtx::TestContext& ctx);
+    void testBC2(const osgUtx::TestContext& ctx);
+    void testBC3(const osgUtx::TestContext& ctx);
+    void testBC4(const osgUtx::TestContext& ctx);
+    void testBC5(const osgUtx::TestContext& ctx);
+    void testBC7(const osgUtx::TestContext& ctx);
+    void testUnsupported(const osgUtx::TestContext& ctx);
+
+private:
+
+    /** Compress a copy of the source image at each quality, returning the largest root mean square error of
+      * the channels, or a negative value if the image couldn't be compressed or decoded.*/
+    double computeError(GLenum compressedFormat, unsigned int numChannels);
+
+    /** Decode the texel at s,t of the compressed image.*/
+    bool decode(const Image& image, int s, int t, unsigned char texel[4]);
+
+    ref_ptr<Image> _source;
+};
+
+BlockCompressionTestFixture::BlockCompressionTestFixture():
+    _source(new Image)
+{
+    // smooth gradients with a little noise, and a size that isn't a multiple of the block size.
+    int width = 38;
+    int height = 26;
+    _source->allocateImage(width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+
+    unsigned int seed = 12345;
+    for(int t=0; t<height; ++t)
+    {
+        for(int s=0; s<width; ++s)
+        {
+            seed = seed*1664525u + 1013904223u;
+            int noise = static_cast<int>((seed>>24)&7) - 4;
+
+            unsigned char* texel = _source->data(s, t);
+            texel[0] = static_cast<unsigned char>(osg::clampBetween(s*6 + noise, 0, 255));
+            texel[1] = static_cast<unsigned char>(osg::clampBetween(t*9 - noise, 0, 255));
+            texel[2] = static_cast<unsigned char>(osg::clampBetween((s+t)*4 + noise, 0, 255));
+            texel[3] = static_cast<unsigned char>(osg::clampBetween(255 - s*3 - t*2, 0, 255));
+        }
+    }
+}
+
+bool BlockCompressionTestFixture::decode(const Image& image, int s, int t, unsigned char texel[4])
+{
+    GLenum format = image.getPixelFormat();
+    if (format==GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format==GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ||
+        format==GL_COMPRESSED_RGBA_S3TC_DXT3_EXT || format==GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+    {
+        Vec4 color = image.getColor(s, t);
+        for(int c=0; c<4; ++c) texel[c] = static_cast<unsigned char>(color[c]*255.0f+0.5f);
+        return true;
+    }
+
+    unsigned int blockSize = Image::computeBlockSize(format, 0);
+    unsigned int numBlocksX = (image.s()+3)/4;
+    const unsigned char* block = image.data() + ((t/4)*numBlocksX + s/4)*blockSize;
+    unsigned int i = (t%4)*4 + s%4;
+
+    unsigned char values[16];
+    switch(format)
+    {
+        case(GL_COMPRESSED_RED_RGTC1_EXT):
+            decodeChannelBlock(block, values);
+            texel[0] = values[i];
+            return true;
+        case(GL_COMPRESSED_RED_GREEN_RGTC2_EXT):
+            decodeChannelBlock(block, values);
+            texel[0] = values[i];
+            decodeChannelBlock(block+8, values);
+            texel[1] = values[i];
+            return true;
+        case(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB):
+        {
+            unsigned char texels[16][4];
+            if (!decodeBC7Block(block, texels)) return false;
+            for(int c=0; c<4; ++c) texel[c] = texels[i][c];
+            return true;
+        }
+    }
+    return false;
+}
+
+double BlockCompressionTestFixture::computeError(GLenum compressedFormat, unsigned int numChannels)
+{
+    const BlockCompressionQuality qualities[3] = { BLOCK_COMPRESSION_FAST, BLOCK_COMPRESSION_NORMAL, BLOCK_COMPRESSION_HIGH };
+
+    double maxError = 0.0;
+    for(unsigned int q=0; q<3; ++q)
+    {
+        ref_ptr<Image> image = new Image(*_source, CopyOp::DEEP_COPY_ALL);
+        if (!compressImage(*image, compressedFormat, qualities[q]) || image->getPixelFormat()!=compressedFormat) return -1.0;
+        if (image->s()!=_source->s() || image->t()!=_source->t()) return -1.0;
+
+        double sumSquares[4] = { 0.0, 0.0, 0.0, 0.0 };
+        for(int t=0; t<_source->t(); ++t)
+        {
+            for(int s=0; s<_source->s(); ++s)
+            {
+                unsigned char texel[4];
+                if (!decode(*image, s, t, texel)) return -1.0;
+
+                const unsigned char* original = _source->data(s, t);
+                for(unsigned int c=0; c<numChannels; ++c)
+                {
+                    double difference = double(texel[c]) - double(original[c]);
+                    sumSquares[c] += difference*difference;
+                }
+            }
+        }
+
+        for(unsigned int c=0; c<numChannels; ++c)
+        {
+            maxError = osg::maximum(maxError, sqrt(sumSquares[c]/double(_source->s()*_source->t())));
+        }
+    }
+    return maxError;
+}
+
+void BlockCompressionTestFixture::testBC1(const osgUtx::TestContext&)
+{
+    // red and green vary along different axes of each block, so the colours of a block don't lie on the single line
+    // between the end points that BC1-3 and BC7 interpolate along, leaving an error of several levels.
+    double error = computeError(GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 3);
+    OSGUTX_TEST_F( error>=0.0 && error<8.0 )
+}
+
+void BlockCompressionTestFixture::testBC2(const osgUtx::TestContext&)
+{
+    // the explicit 4 bit alpha alone may be out by up to 8.
+    double error = computeError(GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 4);
+    OSGUTX_TEST_F( error>=0.0 && error<8.0 )
+}
+
+void BlockCompressionTestFixture::testBC3(const osgUtx::TestContext&)
+{
+    double error = computeError(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 4);
+    OSGUTX_TEST_F( error>=0.0 && error<8.0 )
+}
+
+void BlockCompressionTestFixture::testBC4(const osgUtx::TestContext&)
+{
+    // a single channel per end point pair is interpolated along a line, so only quantization and the noise remain.
+    double error = computeError(GL_COMPRESSED_RED_RGTC1_EXT, 1);
+    OSGUTX_TEST_F( error>=0.0 && error<2.0 )
+}
+
+void BlockCompressionTestFixture::testBC5(const osgUtx::TestContext&)
+{
+    double error = computeError(GL_COMPRESSED_RED_GREEN_RGTC2_EXT, 2);
+    OSGUTX_TEST_F( error>=0.0 && error<2.0 )
+}
+
+void BlockCompressionTestFixture::testBC7(const osgUtx::TestContext&)
+{
+    double error = computeError(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB, 4);
+    OSGUTX_TEST_F( error>=0.0 && error<7.0 )
+}
+
+void BlockCompressionTestFixture::testUnsupported(const osgUtx::TestContext&)
+{
+    // unsupported data types leave the image untouched.
+    ref_ptr<Image> image = new Image;
+    image->allocateImage(8, 8, 1, GL_RGBA, GL_FLOAT);
+    OSGUTX_TEST_F( !compressImage(*image, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) )
+    OSGUTX_TEST_F( image->getPixelFormat()==GL_RGBA && image->getDataType()==GL_FLOAT )
+}
+
+OSGUTX_BEGIN_TESTSUITE(BlockCompression)
+    OSGUTX_ADD_TESTCASE(BlockCompressionTestFixture, testBC1)
+    OSGUTX_ADD_TESTCASE(BlockCompressionTestFixture, testBC2)
+    OSGUTX_ADD_TESTCASE(BlockCompressionTestFixture, testBC3)
+    OSGUTX_ADD_TESTCASE(BlockCompressionTestFixture, testBC4)
+    OSGUTX_ADD_TESTCASE(BlockCompressionTestFixture, testBC5)
+    OSGUTX_ADD_TESTCASE(BlockCompressionTestFixture, testBC7)
+    OSGUTX_ADD_TESTCASE(BlockCompressionTestFixture, testUnsupported)
+OSGUTX_END_TESTSUITE
+
+OSGUTX_AUTOREGISTER_TESTSUITE_AT(BlockCompression, root.osg)
+
+
 
 }
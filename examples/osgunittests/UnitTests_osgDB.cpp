@@ -0,0 +1,246 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "UnitTestFramework.h"
+
+#include <osgDB/ImageReader>
+#include <sstream>
+
+namespace osgDB
+{
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ImageReader Tests
+//
+
+// Reader of a generated luminance raster, whose pixels encode their level and position in the file, counting the tiles decoded.
+class MemoryImageReader : public ImageReader
+{
+public:
+
+    MemoryImageReader():
+        _numTilesRead(0) {}
+
+    MemoryImageReader(int width, int height, int tileWidth, int tileHeight):
+        _numTilesRead(0)
+    {
+        _fileName = "memory";
+        _pixelFormat = GL_LUMINANCE;
+        _dataType = GL_UNSIGNED_BYTE;
+        _internalTextureFormat = GL_LUMINANCE;
+        _levels.push_back(Level(width, height, tileWidth, tileHeight));
+        _levels.push_back(Level(width/2, height/2, tileWidth, tileHeight));
+    }
+
+    MemoryImageReader(const MemoryImageReader& reader, const osg::CopyOp& copyop=osg::CopyOp::SHALLOW_COPY):
+        ImageReader(reader, copyop),
+        _numTilesRead(0)
+    {
+        _fileName = reader._fileName;
+        _pixelFormat = reader._pixelFormat;
+        _dataType = reader._dataType;
+        _internalTextureFormat = reader._internalTextureFormat;
+        _levels = reader._levels;
+    }
+
+    META_Object(osgDB, MemoryImageReader)
+
+    static unsigned char value(unsigned int level, int column, int row) { return static_cast<unsigned char>((column + row*7 + level*31) & 0xff); }
+
+    unsigned int getTileSizeInBytes() const { return static_cast<unsigned int>(_levels[0].tileWidth*_levels[0].tileHeight); }
+
+    unsigned int _numTilesRead;
+
+protected:
+
+    virtual bool readTile(unsigned int level, int tileX, int tileY, osg::Image& tile)
+    {
+        ++_numTilesRead;
+
+        const Level& levelInfo = _levels[level];
+        for(int row=0; row<levelInfo.tileHeight; ++row)
+        {
+            unsigned char* dest = tile.data(0, row);
+            for(int column=0; column<levelInfo.tileWidth; ++column)
+            {
+                *dest++ = value(level, tileX*levelInfo.tileWidth+column, tileY*levelInfo.tileHeight+row);
+            }
+        }
+        return true;
+    }
+};
+
+class ImageReaderTestFixture
+{
+public:
+
+    ImageReaderTestFixture();
+
+    void testWindowAssembly(const osgUtx::TestContext& ctx);
+    void testWindowOutsideRaster(const osgUtx::TestContext& ctx);
+    void testCacheHits(const osgUtx::TestContext& ctx);
+    void testCacheLeastRecentlyUsed(const osgUtx::TestContext& ctx);
+    void testClearCache(const osgUtx::TestContext& ctx);
+    void testClone(const osgUtx::TestContext& ctx);
+
+private:
+
+    // Check that each pixel of image matches the window x,y of level, returning false on the first mismatch.
+    bool matchesWindow(const osg::Image* image, unsigned int level, int x, int y) const;
+
+    osg::ref_ptr<MemoryImageReader> _reader;
+};
+
+ImageReaderTestFixture::ImageReaderTestFixture():
+    _reader(new MemoryImageReader(100, 80, 32, 16))
+{
+}
+
+bool ImageReaderTestFixture::matchesWindow(const osg::Image* image, unsigned int level, int x, int y) const
+{
+    int levelHeight = _reader->getHeight(level);
+    for(int t=0; t<image->t(); ++t)
+    {
+        // windows have their origin at the bottom left while file rows run from the top down.
+        int row = levelHeight-1-(y+t);
+        for(int s=0; s<image->s(); ++s)
+        {
+            if (*image->data(s, t)!=MemoryImageReader::value(level, x+s, row)) return false;
+        }
+    }
+    return true;
+}
+
+void ImageReaderTestFixture::testWindowAssembly(const osgUtx::TestContext&)
+{
+    // a window straddling several tiles, including the partial tiles at the right hand edge.
+    osg::ref_ptr<osg::Image> image = _reader->readImage(20, 10, 80, 40, 0);
+    OSGUTX_TEST_F( image.valid() )
+    OSGUTX_TEST_F( image->s()==80 && image->t()==40 )
+    OSGUTX_TEST_F( matchesWindow(image.get(), 0, 20, 10) )
+
+    image = _reader->readImage(5, 3, 40, 30, 1);
+    OSGUTX_TEST_F( image.valid() )
+    OSGUTX_TEST_F( matchesWindow(image.get(), 1, 5, 3) )
+}
+
+void ImageReaderTestFixture::testWindowOutsideRaster(const osgUtx::TestContext&)
+{
+    osg::ref_ptr<osg::Image> image = _reader->readImage(90, 70, 20, 20, 0);
+    OSGUTX_TEST_F( image.valid() )
+
+    // the part of the window beyond the raster is zero filled.
+    OSGUTX_TEST_F( *image->data(0, 0)==MemoryImageReader::value(0, 90, 80-1-70) )
+    OSGUTX_TEST_F( *image->data(15, 0)==0 )
+    OSGUTX_TEST_F( *image->data(0, 15)==0 )
+
+    OSGUTX_TEST_F( !_reader->readImage(0, 0, 10, 10, 2) )
+    OSGUTX_TEST_F( !_reader->readImage(0, 0, 0, 10, 0) )
+}
+
+void ImageReaderTestFixture::testCacheHits(const osgUtx::TestContext&)
+{
+    osg::ref_ptr<osg::Image> image = _reader->readImage(0, 0, 64, 32, 0);
+    OSGUTX_TEST_F( _reader->_numTilesRead==4 )
+    OSGUTX_TEST_F( _reader->getCacheSize()==4*_reader->getTileSizeInBytes() )
+
+    // reading windows that lie within the cached tiles doesn't decode them again.
+    image = _reader->readImage(10, 5, 40, 20, 0);
+    image = _reader->readImage(0, 0, 64, 32, 0);
+    OSGUTX_TEST_F( _reader->_numTilesRead==4 )
+    OSGUTX_TEST_F( matchesWindow(image.get(), 0, 0, 0) )
+}
+
+void ImageReaderTestFixture::testCacheLeastRecentlyUsed(const osgUtx::TestContext&)
+{
+    unsigned int tileSize = _reader->getTileSizeInBytes();
+    _reader->setMaximumCacheSize(2*tileSize);
+
+    // the window 0,64,32,16 is the top left tile, 32,64,32,16 the tile to its right, and 64,64,32,16 the next one along.
+    osg::ref_ptr<osg::Image> image = _reader->readImage(0, 64, 32, 16, 0);
+    image = _reader->readImage(32, 64, 32, 16, 0);
+    OSGUTX_TEST_F( _reader->_numTilesRead==2 )
+
+    // use the first tile again so that the second becomes the least recently used, and is evicted by the third.
+    image = _reader->readImage(0, 64, 32, 16, 0);
+    image = _reader->readImage(64, 64, 32, 16, 0);
+    OSGUTX_TEST_F( _reader->_numTilesRead==3 )
+    OSGUTX_TEST_F( _reader->getCacheSize()==2*tileSize )
+
+    image = _reader->readImage(0, 64, 32, 16, 0);
+    OSGUTX_TEST_F( _reader->_numTilesRead==3 )
+
+    image = _reader->readImage(32, 64, 32, 16, 0);
+    OSGUTX_TEST_F( _reader->_numTilesRead==4 )
+    OSGUTX_TEST_F( matchesWindow(image.get(), 0, 32, 64) )
+
+    // windows needing more tiles than the cache holds are still assembled correctly.
+    image = _reader->readImage(0, 0, 100, 80, 0);
+    OSGUTX_TEST_F( matchesWindow(image.get(), 0, 0, 0) )
+    OSGUTX_TEST_F( _reader->getCacheSize()<=2*tileSize )
+
+    // shrinking the maximum trims the cache straight away.
+    _reader->setMaximumCacheSize(tileSize);
+    OSGUTX_TEST_F( _reader->getCacheSize()==tileSize )
+}
+
+void ImageReaderTestFixture::testClearCache(const osgUtx::TestContext&)
+{
+    osg::ref_ptr<osg::Image> image = _reader->readImage(0, 0, 64, 32, 0);
+    OSGUTX_TEST_F( _reader->getCacheSize()>0 )
+
+    _reader->clearCache();
+    OSGUTX_TEST_F( _reader->getCacheSize()==0 )
+
+    image = _reader->readImage(0, 0, 64, 32, 0);
+    OSGUTX_TEST_F( _reader->_numTilesRead==8 )
+}
+
+void ImageReaderTestFixture::testClone(const osgUtx::TestContext&)
+{
+    _reader->setMaximumCacheSize(1024*1024);
+    osg::ref_ptr<osg::Image> image = _reader->readImage(0, 0, 64, 32, 0);
+
+    osg::ref_ptr<MemoryImageReader> copy = dynamic_cast<MemoryImageReader*>(_reader->clone(osg::CopyOp::SHALLOW_COPY));
+    OSGUTX_TEST_F( copy.valid() )
+    OSGUTX_TEST_F( copy->getNumLevels()==_reader->getNumLevels() )
+    OSGUTX_TEST_F( copy->getMaximumCacheSize()==1024*1024 )
+
+    // the copy has a cache of its own, so decodes the tiles itself.
+    OSGUTX_TEST_F( copy->getCacheSize()==0 )
+    image = copy->readImage(0, 0, 64, 32, 0);
+    OSGUTX_TEST_F( copy->_numTilesRead==4 )
+    OSGUTX_TEST_F( matchesWindow(image.get(), 0, 0, 0) )
+
+    osg::ref_ptr<osg::Object> empty = _reader->cloneType();
+    OSGUTX_TEST_F( dynamic_cast<MemoryImageReader*>(empty.get())!=0 )
+}
+
+OSGUTX_BEGIN_TESTSUITE(ImageReader)
+    OSGUTX_ADD_TESTCASE(ImageReaderTestFixture, testWindowAssembly)
+    OSGUTX_ADD_TESTCASE(ImageReaderTestFixture, testWindowOutsideRaster)
+    OSGUTX_ADD_TESTCASE(ImageReaderTestFixture, testCacheHits)
+    OSGUTX_ADD_TESTCASE(ImageReaderTestFixture, testCacheLeastRecentlyUsed)
+    OSGUTX_ADD_TESTCASE(ImageReaderTestFixture, testClearCache)
+    OSGUTX_ADD_TESTCASE(ImageReaderTestFixture, testClone)
+OSGUTX_END_TESTSUITE
+
+OSGUTX_AUTOREGISTER_TESTSUITE_AT(ImageReader, root.osgDB)
+
+}
@@ -0,0 +1,348 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "UnitTestFramework.h"
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/LOD>
+#include <osg/PagedLOD>
+#include <osg/MatrixTransform>
+#include <osg/FrameStamp>
+
+#include <osgUtil/SceneView>
+#include <osgUtil/SceneSnapshot>
+#include <osgUtil/UpdateVisitor>
+
+#include <sstream>
+#include <vector>
+
+namespace osgUtil
+{
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  SceneSnapshot Tests
+//
+
+// Update callback moving a MatrixTransform, as an application modifying the scene graph while it is being culled would.
+class MoveCallback : public osg::NodeCallback
+{
+public:
+
+    MoveCallback(const osg::Vec3& translation): _translation(translation) {}
+
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        osg::MatrixTransform* transform = static_cast<osg::MatrixTransform*>(node);
+        transform->setMatrix(osg::Matrix::translate(_translation));
+        traverse(node, nv);
+    }
+
+    osg::Vec3 _translation;
+};
+
+class SceneSnapshotTestFixture
+{
+public:
+
+    SceneSnapshotTestFixture();
+
+    void testCaptureEntries(const osgUtx::TestContext& ctx);
+    void testCullUsesSnapshot(const osgUtx::TestContext& ctx);
+    void testLODUsesSnapshotBound(const osgUtx::TestContext& ctx);
+    void testPagedLODUsesSnapshotBound(const osgUtx::TestContext& ctx);
+    void testUpdateVisitorTracking(const osgUtx::TestContext& ctx);
+    void testGeometryCopyReuse(const osgUtx::TestContext& ctx);
+
+private:
+
+    // Cull the scene with the SceneView, returning the RenderLeaf created.
+    void cull(std::vector<RenderLeaf*>& leaves);
+
+    static void collectRenderLeaves(RenderBin* bin, std::vector<RenderLeaf*>& leaves);
+
+    void modifyVertices(float x);
+
+    osg::ref_ptr<osg::Group> _root;
+    osg::ref_ptr<osg::LOD> _lod;
+    osg::ref_ptr<osg::MatrixTransform> _transform;
+    osg::ref_ptr<osg::Geometry> _geometry;
+    osg::ref_ptr<SceneSnapshot> _snapshot;
+    osg::ref_ptr<osg::FrameStamp> _frameStamp;
+    osg::ref_ptr<SceneView> _sceneView;
+};
+
+SceneSnapshotTestFixture::SceneSnapshotTestFixture():
+    _root(new osg::Group),
+    _lod(new osg::LOD),
+    _transform(new osg::MatrixTransform),
+    _geometry(new osg::Geometry),
+    _snapshot(new SceneSnapshot),
+    _frameStamp(new osg::FrameStamp),
+    _sceneView(new SceneView)
+{
+    osg::Vec3Array* vertices = new osg::Vec3Array;
+    vertices->push_back(osg::Vec3(-0.5f,0.0f,-0.5f));
+    vertices->push_back(osg::Vec3( 0.5f,0.0f,-0.5f));
+    vertices->push_back(osg::Vec3( 0.5f,0.0f, 0.5f));
+    vertices->push_back(osg::Vec3(-0.5f,0.0f, 0.5f));
+    _geometry->setVertexArray(vertices);
+    _geometry->addPrimitiveSet(new osg::DrawArrays(GL_QUADS, 0, 4));
+    _geometry->setDataVariance(osg::Object::DYNAMIC);
+
+    osg::Geode* geode = new osg::Geode;
+    geode->addDrawable(_geometry.get());
+
+    _transform->setDataVariance(osg::Object::DYNAMIC);
+    _transform->addChild(geode);
+
+    // the quad is 40 units from the eye, selected up to 100 units away.
+    _lod->addChild(_transform.get(), 0.0f, 100.0f);
+    _root->addChild(_lod.get());
+
+    _sceneView->setDefaults();
+    _sceneView->setSceneData(_root.get());
+    _sceneView->setFrameStamp(_frameStamp.get());
+    _sceneView->setViewport(0, 0, 640, 480);
+    _sceneView->setProjectionMatrixAsPerspective(30.0, 640.0/480.0, 1.0, 1000.0);
+    _sceneView->setViewMatrix(osg::Matrixd::lookAt(osg::Vec3d(0.0,-40.0,0.0), osg::Vec3d(0.0,0.0,0.0), osg::Vec3d(0.0,0.0,1.0)));
+    _sceneView->getCullVisitor()->setSceneSnapshot(_snapshot.get());
+
+    _snapshot->trackDynamicObjects(_root.get());
+}
+
+void SceneSnapshotTestFixture::collectRenderLeaves(RenderBin* bin, std::vector<RenderLeaf*>& leaves)
+{
+    leaves.insert(leaves.end(), bin->getRenderLeafList().begin(), bin->getRenderLeafList().end());
+
+    RenderBin::StateGraphList& stateGraphs = bin->getStateGraphList();
+    for(RenderBin::StateGraphList::iterator itr = stateGraphs.begin();
+        itr != stateGraphs.end();
+        ++itr)
+    {
+        leaves.insert(leaves.end(), (*itr)->_leaves.begin(), (*itr)->_leaves.end());
+    }
+
+    RenderBin::RenderBinList& bins = bin->getRenderBinList();
+    for(RenderBin::RenderBinList::iterator itr = bins.begin();
+        itr != bins.end();
+        ++itr)
+    {
+        collectRenderLeaves(itr->second.get(), leaves);
+    }
+}
+
+void SceneSnapshotTestFixture::cull(std::vector<RenderLeaf*>& leaves)
+{
+    _frameStamp->setFrameNumber(_frameStamp->getFrameNumber()+1);
+    _sceneView->cull();
+
+    leaves.clear();
+    collectRenderLeaves(_sceneView->getRenderStage(), leaves);
+}
+
+void SceneSnapshotTestFixture::modifyVertices(float x)
+{
+    osg::Vec3Array* vertices = static_cast<osg::Vec3Array*>(_geometry->getVertexArray());
+    (*vertices)[0].x() = x;
+    vertices->dirty();
+    _geometry->dirtyBound();
+}
+
+void SceneSnapshotTestFixture::testCaptureEntries(const osgUtx::TestContext&)
+{
+    // nodes are tracked from the next capture on.
+    OSGUTX_TEST_F( _snapshot->getNumTracked()==0 )
+    OSGUTX_TEST_F( !_snapshot->getEntry(_transform.get()) )
+
+    _snapshot->capture();
+    OSGUTX_TEST_F( _snapshot->getNumTracked()==2 )
+
+    // the tracked Transform and Geometry, and the Geode, LOD and Group above them, plus the SceneView's Camera that
+    // setSceneData() made the parent of the Group.
+    OSGUTX_TEST_F( _snapshot->getNumEntries()==6 )
+    OSGUTX_TEST_F( _snapshot->getEntry(_sceneView->getCamera())!=0 )
+    OSGUTX_TEST_F( _snapshot->getEntry(_root.get())!=0 )
+    OSGUTX_TEST_F( _snapshot->getEntry(_lod.get())!=0 )
+
+    const SceneSnapshot::Entry* entry = _snapshot->getEntry(_transform.get());
+    OSGUTX_TEST_F( entry && entry->hasMatrix && entry->matrix.isIdentity() )
+
+    // modifying the scene graph leaves the captured values alone until the next capture.
+    _transform->setMatrix(osg::Matrix::translate(500.0f, 0.0f, 0.0f));
+    entry = _snapshot->getEntry(_transform.get());
+    OSGUTX_TEST_F( entry->matrix.isIdentity() )
+    OSGUTX_TEST_F( osg::equivalent(_snapshot->getEntry(_lod.get())->bound.center().x(), 0.0f) )
+
+    _snapshot->capture();
+    entry = _snapshot->getEntry(_transform.get());
+    OSGUTX_TEST_F( osg::equivalent(entry->matrix.getTrans().x(), 500.0) )
+    OSGUTX_TEST_F( osg::equivalent(_snapshot->getEntry(_lod.get())->bound.center().x(), 500.0f) )
+
+    // nodes removed from the scene graph and released by the application are released by the snapshot.
+    _lod->removeChildren(0, 1);
+    _transform = 0;
+    _geometry = 0;
+    _snapshot->capture();
+    OSGUTX_TEST_F( _snapshot->getNumTracked()==0 )
+    OSGUTX_TEST_F( _snapshot->getNumEntries()==0 )
+}
+
+void SceneSnapshotTestFixture::testCullUsesSnapshot(const osgUtx::TestContext&)
+{
+    _snapshot->capture();
+
+    std::vector<RenderLeaf*> leaves;
+    cull(leaves);
+    OSGUTX_TEST_F( leaves.size()==1 )
+
+    // the Geometry is drawn from the copy captured by the snapshot.
+    const SceneSnapshot::Entry* entry = _snapshot->getEntry(_geometry.get());
+    OSGUTX_TEST_F( entry && entry->drawable.valid() && entry->drawable.get()!=_geometry.get() )
+    OSGUTX_TEST_F( leaves.front()->getDrawable()==entry->drawable.get() )
+
+    // moving the Transform out of view doesn't affect the cull until it has been captured.
+    _transform->setMatrix(osg::Matrix::translate(0.0f, 0.0f, 500.0f));
+    cull(leaves);
+    OSGUTX_TEST_F( leaves.size()==1 )
+    OSGUTX_TEST_F( osg::equivalent(leaves.front()->_modelview->getTrans().y(), _sceneView->getViewMatrix().getTrans().y()) )
+
+    _snapshot->capture();
+    cull(leaves);
+    OSGUTX_TEST_F( leaves.empty() )
+}
+
+void SceneSnapshotTestFixture::testLODUsesSnapshotBound(const osgUtx::TestContext&)
+{
+    _snapshot->capture();
+
+    // moving the Transform beyond the range of the LOD changes its live bound, but not the one it is selected with.
+    _transform->setMatrix(osg::Matrix::translate(0.0f, 2000.0f, 0.0f));
+
+    std::vector<RenderLeaf*> leaves;
+    cull(leaves);
+    OSGUTX_TEST_F( leaves.size()==1 )
+
+    // the captured bound of the quad is around 30 pixels across on screen, the live bound less than a pixel.
+    _lod->setRangeMode(osg::LOD::PIXEL_SIZE_ON_SCREEN);
+    _lod->setRange(0, 1.0f, 100.0f);
+    cull(leaves);
+    OSGUTX_TEST_F( leaves.size()==1 )
+
+    // without the snapshot the live bound and matrix are used.
+    _sceneView->getCullVisitor()->setSceneSnapshot(0);
+    cull(leaves);
+    OSGUTX_TEST_F( leaves.empty() )
+}
+
+void SceneSnapshotTestFixture::testPagedLODUsesSnapshotBound(const osgUtx::TestContext&)
+{
+    osg::ref_ptr<osg::PagedLOD> plod = new osg::PagedLOD;
+    plod->addChild(_transform.get(), 0.0f, 100.0f);
+    _root->replaceChild(_lod.get(), plod.get());
+
+    _snapshot->capture();
+    OSGUTX_TEST_F( _snapshot->getEntry(plod.get())!=0 )
+
+    _transform->setMatrix(osg::Matrix::translate(0.0f, 2000.0f, 0.0f));
+
+    std::vector<RenderLeaf*> leaves;
+    cull(leaves);
+    OSGUTX_TEST_F( leaves.size()==1 )
+
+    // the child is marked as used this frame so that it isn't expired.
+    OSGUTX_TEST_F( plod->getFrameNumberOfLastTraversal()==_frameStamp->getFrameNumber() )
+    OSGUTX_TEST_F( plod->getFrameNumber(0)==_frameStamp->getFrameNumber() )
+
+    _sceneView->getCullVisitor()->setSceneSnapshot(0);
+    cull(leaves);
+    OSGUTX_TEST_F( leaves.empty() )
+}
+
+void SceneSnapshotTestFixture::testUpdateVisitorTracking(const osgUtx::TestContext&)
+{
+    _snapshot->capture();
+
+    // a DYNAMIC Transform added with an update callback is tracked by the update traversal that first visits it.
+    osg::ref_ptr<osg::MatrixTransform> added = new osg::MatrixTransform;
+    added->setDataVariance(osg::Object::DYNAMIC);
+    added->setUpdateCallback(new MoveCallback(osg::Vec3(10.0f, 0.0f, 0.0f)));
+    added->addChild(new osg::Geode);
+    _root->addChild(added.get());
+
+    osg::ref_ptr<UpdateVisitor> updateVisitor = new UpdateVisitor;
+    updateVisitor->setFrameStamp(_frameStamp.get());
+    updateVisitor->setSceneSnapshot(_snapshot.get());
+    _root->accept(*updateVisitor);
+
+    OSGUTX_TEST_F( !_snapshot->getEntry(added.get()) )
+
+    _snapshot->capture();
+    const SceneSnapshot::Entry* entry = _snapshot->getEntry(added.get());
+    OSGUTX_TEST_F( entry && entry->hasMatrix )
+    OSGUTX_TEST_F( osg::equivalent(entry->matrix.getTrans().x(), 10.0) )
+    OSGUTX_TEST_F( _snapshot->getNumTracked()==3 )
+}
+
+void SceneSnapshotTestFixture::testGeometryCopyReuse(const osgUtx::TestContext&)
+{
+    _snapshot->capture();
+    const osg::Drawable* first = _snapshot->getEntry(_geometry.get())->drawable.get();
+    const osg::Array* firstVertices = first->asGeometry()->getVertexArray();
+
+    // the copy is only replaced once the Geometry is modified.
+    _snapshot->capture();
+    OSGUTX_TEST_F( _snapshot->getEntry(_geometry.get())->drawable.get()==first )
+
+    modifyVertices(-2.0f);
+    _snapshot->capture();
+    osg::ref_ptr<osg::Drawable> second = _snapshot->getEntry(_geometry.get())->drawable;
+    OSGUTX_TEST_F( second.get()!=first )
+    OSGUTX_TEST_F( osg::equivalent((*static_cast<const osg::Vec3Array*>(second->asGeometry()->getVertexArray()))[0].x(), -2.0f) )
+
+    // with nothing else referencing it, the first copy is refilled in place rather than the Geometry cloned again.
+    modifyVertices(-3.0f);
+    _snapshot->capture();
+    const osg::Drawable* third = _snapshot->getEntry(_geometry.get())->drawable.get();
+    OSGUTX_TEST_F( third==first )
+    OSGUTX_TEST_F( third->asGeometry()->getVertexArray()==firstVertices )
+    OSGUTX_TEST_F( osg::equivalent((*static_cast<const osg::Vec3Array*>(firstVertices))[0].x(), -3.0f) )
+    OSGUTX_TEST_F( osg::equivalent(third->getBoundingBox().xMin(), -3.0f) )
+
+    // a copy still referenced, as by the RenderLeaf of a frame being drawn, isn't modified.
+    modifyVertices(-4.0f);
+    _snapshot->capture();
+    const osg::Drawable* fourth = _snapshot->getEntry(_geometry.get())->drawable.get();
+    OSGUTX_TEST_F( fourth!=first && fourth!=second.get() )
+    OSGUTX_TEST_F( osg::equivalent((*static_cast<const osg::Vec3Array*>(second->asGeometry()->getVertexArray()))[0].x(), -2.0f) )
+    OSGUTX_TEST_F( osg::equivalent((*static_cast<const osg::Vec3Array*>(fourth->asGeometry()->getVertexArray()))[0].x(), -4.0f) )
+}
+
+OSGUTX_BEGIN_TESTSUITE(SceneSnapshot)
+    OSGUTX_ADD_TESTCASE(SceneSnapshotTestFixture, testCaptureEntries)
+    OSGUTX_ADD_TESTCASE(SceneSnapshotTestFixture, testCullUsesSnapshot)
+    OSGUTX_ADD_TESTCASE(SceneSnapshotTestFixture, testLODUsesSnapshotBound)
+    OSGUTX_ADD_TESTCASE(SceneSnapshotTestFixture, testPagedLODUsesSnapshotBound)
+    OSGUTX_ADD_TESTCASE(SceneSnapshotTestFixture, testUpdateVisitorTracking)
+    OSGUTX_ADD_TESTCASE(SceneSnapshotTestFixture, testGeometryCopyReuse)
+OSGUTX_END_TESTSUITE
+
+OSGUTX_AUTOREGISTER_TESTSUITE_AT(SceneSnapshot, root.osgUtil)
+
+}
@@ -0,0 +1,277 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "UnitTestFramework.h"
+
+#include <osgViewer/Viewer>
+#include <osgViewer/CompositeViewer>
+#include <osgViewer/AdaptiveThreadingModel>
+
+#include <osg/DeleteHandler>
+#include <osg/Timer>
+
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Thread>
+
+#include <sstream>
+
+namespace osgViewer
+{
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  AdaptiveThreadingModel Tests
+//
+
+class AdaptiveThreadingModelTestFixture
+{
+public:
+
+    AdaptiveThreadingModelTestFixture();
+
+    void testSwitchToFasterModel(const osgUtx::TestContext& ctx);
+    void testRevertFailedSwitch(const osgUtx::TestContext& ctx);
+    void testPauseOnceSettled(const osgUtx::TestContext& ctx);
+    void testStatsCollection(const osgUtx::TestContext& ctx);
+
+private:
+
+    // Feed numFrames frames of frameTime and stageTimes, run with the threading model selected for each, returning the last model selected.
+    ViewerBase::ThreadingModel runFrames(ViewerBase::ThreadingModel threadingModel, unsigned int numFrames, double frameTime, const AdaptiveThreadingModel::Sample& stageTimes);
+
+    static AdaptiveThreadingModel::Sample stageTimes(double updateTime, double cullTime, double drawTime);
+
+    osg::ref_ptr<AdaptiveThreadingModel> _atm;
+    unsigned int _frameNumber;
+};
+
+AdaptiveThreadingModelTestFixture::AdaptiveThreadingModelTestFixture():
+    _atm(new AdaptiveThreadingModel),
+    _frameNumber(0)
+{
+    _atm->setNumProcessors(4);
+    _atm->setNumWindowFrames(10);
+    _atm->setNumSettleFrames(2);
+    _atm->setNumConfirmingWindows(2);
+    _atm->setNumRetryFrames(100);
+    _atm->setNumSettledWindows(3);
+}
+
+AdaptiveThreadingModel::Sample AdaptiveThreadingModelTestFixture::stageTimes(double updateTime, double cullTime, double drawTime)
+{
+    // a single camera on a single context, so the maximum stage times are the totals.
+    AdaptiveThreadingModel::Sample sample;
+    sample.updateTime = updateTime;
+    sample.cullTime = cullTime;
+    sample.maxCullTime = cullTime;
+    sample.drawTime = drawTime;
+    sample.maxDrawTime = drawTime;
+    sample.numCameras = 1;
+    sample.numContexts = 1;
+    return sample;
+}
+
+ViewerBase::ThreadingModel AdaptiveThreadingModelTestFixture::runFrames(ViewerBase::ThreadingModel threadingModel, unsigned int numFrames, double frameTime, const AdaptiveThreadingModel::Sample& stageTimes)
+{
+    for(unsigned int i=0; i<numFrames; ++i)
+    {
+        threadingModel = _atm->addFrame(threadingModel, _frameNumber++, frameTime, &stageTimes);
+    }
+    return threadingModel;
+}
+
+void AdaptiveThreadingModelTestFixture::testSwitchToFasterModel(const osgUtx::TestContext&)
+{
+    // draw bound, so overlapping the draw with the next frame's update and cull saves a third of the frame.
+    AdaptiveThreadingModel::Sample stages = stageTimes(0.002, 0.003, 0.010);
+
+    // the first window predicts the gain, the second confirms it.
+    ViewerBase::ThreadingModel threadingModel = runFrames(ViewerBase::SingleThreaded, 1+2+10, 0.015, stages);
+    OSGUTX_TEST_F( threadingModel==ViewerBase::SingleThreaded )
+
+    threadingModel = runFrames(threadingModel, 10, 0.015, stages);
+    OSGUTX_TEST_F( threadingModel==ViewerBase::DrawThreadPerContext )
+
+    // the trial delivers the predicted frame time, so the switch is kept.
+    threadingModel = runFrames(threadingModel, 2+10+1, 0.010, stages);
+    OSGUTX_TEST_F( threadingModel==ViewerBase::DrawThreadPerContext )
+    OSGUTX_TEST_F( osg::equivalent(_atm->getMeasuredFrameTime(ViewerBase::DrawThreadPerContext), 0.010) )
+}
+
+void AdaptiveThreadingModelTestFixture::testRevertFailedSwitch(const osgUtx::TestContext&)
+{
+    AdaptiveThreadingModel::ThreadingModels threadingModels;
+    threadingModels.push_back(ViewerBase::SingleThreaded);
+    threadingModels.push_back(ViewerBase::DrawThreadPerContext);
+    _atm->setThreadingModels(threadingModels);
+
+    AdaptiveThreadingModel::Sample stages = stageTimes(0.002, 0.003, 0.010);
+
+    ViewerBase::ThreadingModel threadingModel = runFrames(ViewerBase::SingleThreaded, 1+2+10+10, 0.015, stages);
+    OSGUTX_TEST_F( threadingModel==ViewerBase::DrawThreadPerContext )
+
+    // the trial runs no faster, so is reverted at the end of its window.
+    threadingModel = runFrames(threadingModel, 2+10, 0.015, stages);
+    OSGUTX_TEST_F( threadingModel==ViewerBase::SingleThreaded )
+
+    // and isn't retried until the retry interval has passed, despite still being predicted to be faster.
+    bool retried = false;
+    for(unsigned int i=0; i<80; ++i)
+    {
+        threadingModel = runFrames(threadingModel, 1, 0.015, stages);
+        if (threadingModel!=ViewerBase::SingleThreaded) retried = true;
+    }
+    OSGUTX_TEST_F( !retried )
+}
+
+void AdaptiveThreadingModelTestFixture::testPauseOnceSettled(const osgUtx::TestContext&)
+{
+    // update and cull bound, so no other model is predicted to be enough faster to switch to.
+    AdaptiveThreadingModel::Sample stages = stageTimes(0.005, 0.005, 0.0005);
+
+    ViewerBase::ThreadingModel threadingModel = runFrames(ViewerBase::SingleThreaded, 1+2+10+10, 0.0105, stages);
+    OSGUTX_TEST_F( threadingModel==ViewerBase::SingleThreaded )
+    OSGUTX_TEST_F( _atm->isSampling() )
+
+    threadingModel = runFrames(threadingModel, 10, 0.0105, stages);
+    OSGUTX_TEST_F( threadingModel==ViewerBase::SingleThreaded )
+    OSGUTX_TEST_F( !_atm->isSampling() )
+
+    // sampling resumes once the retry interval has passed.
+    threadingModel = runFrames(threadingModel, 98, 0.0105, stages);
+    OSGUTX_TEST_F( !_atm->isSampling() )
+
+    threadingModel = runFrames(threadingModel, 1, 0.0105, stages);
+    OSGUTX_TEST_F( _atm->isSampling() )
+}
+
+void AdaptiveThreadingModelTestFixture::testStatsCollection(const osgUtx::TestContext&)
+{
+    osg::ref_ptr<Viewer> viewer = new Viewer;
+    viewer->setThreadingModel(ViewerBase::SingleThreaded);
+
+    // stats that were already being collected are left alone.
+    osg::Stats* stats = viewer->getViewerStats();
+    stats->collectStats("event", true);
+
+    viewer->getViewerFrameStamp()->setFrameNumber(0);
+    _atm->selectThreadingModel(*viewer);
+    OSGUTX_TEST_F( stats->collectStats("event") && stats->collectStats("update") )
+
+    // without stage times the current model is kept, so it settles after the settle frames and three windows.
+    for(unsigned int frameNumber=1; frameNumber<=2+30; ++frameNumber)
+    {
+        viewer->getViewerFrameStamp()->setFrameNumber(frameNumber);
+        _atm->selectThreadingModel(*viewer);
+    }
+    OSGUTX_TEST_F( !_atm->isSampling() )
+    OSGUTX_TEST_F( stats->collectStats("event") )
+    OSGUTX_TEST_F( !stats->collectStats("update") )
+
+    // collection is enabled again when sampling resumes.
+    viewer->getViewerFrameStamp()->setFrameNumber(2+30+100);
+    _atm->selectThreadingModel(*viewer);
+    OSGUTX_TEST_F( _atm->isSampling() )
+    OSGUTX_TEST_F( stats->collectStats("update") )
+}
+
+OSGUTX_BEGIN_TESTSUITE(AdaptiveThreadingModel)
+    OSGUTX_ADD_TESTCASE(AdaptiveThreadingModelTestFixture, testSwitchToFasterModel)
+    OSGUTX_ADD_TESTCASE(AdaptiveThreadingModelTestFixture, testRevertFailedSwitch)
+    OSGUTX_ADD_TESTCASE(AdaptiveThreadingModelTestFixture, testPauseOnceSettled)
+    OSGUTX_ADD_TESTCASE(AdaptiveThreadingModelTestFixture, testStatsCollection)
+OSGUTX_END_TESTSUITE
+
+OSGUTX_AUTOREGISTER_TESTSUITE_AT(AdaptiveThreadingModel, root.osgViewer)
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  CompositeViewer Tests
+//
+
+class DeleteCountingObject : public osg::Referenced
+{
+public:
+
+    DeleteCountingObject(OpenThreads::Atomic& numDeleted):
+        _numDeleted(numDeleted) {}
+
+protected:
+
+    virtual ~DeleteCountingObject() { ++_numDeleted; }
+
+    OpenThreads::Atomic& _numDeleted;
+};
+
+class CompositeViewerTestFixture
+{
+public:
+
+    void testAdvanceFlushesBackgroundDeleteHandler(const osgUtx::TestContext& ctx);
+};
+
+void CompositeViewerTestFixture::testAdvanceFlushesBackgroundDeleteHandler(const osgUtx::TestContext&)
+{
+    OSGUTX_TEST_F( osg::Referenced::getDeleteHandler()==0 )
+
+    osg::DeleteHandler* deleteHandler = new osg::DeleteHandler(1);
+    osg::Referenced::setDeleteHandler(deleteHandler);
+
+    OpenThreads::Atomic numDeleted;
+    bool flushedInForeground = false;
+    bool flushedInBackground = false;
+    {
+        osg::ref_ptr<CompositeViewer> viewer = new CompositeViewer;
+        viewer->getViewerFrameStamp()->setFrameNumber(20);
+
+        deleteHandler->setFrameNumber(10);
+        osg::ref_ptr<DeleteCountingObject> object = new DeleteCountingObject(numDeleted);
+        object = 0;
+
+        // an application flushing the DeleteHandler itself is left to do so.
+        viewer->advance();
+        viewer->advance();
+        flushedInForeground = deleteHandler->getFrameNumber()!=10 || numDeleted!=0;
+
+        // once deleting in the background the viewer flushes it, handing the object over after retaining it for a frame.
+        deleteHandler->setDeleteInBackgroundThread(true);
+        viewer->advance();
+        viewer->advance();
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        while(numDeleted==0 && osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick())<10.0)
+        {
+            OpenThreads::Thread::microSleep(1000);
+        }
+        flushedInBackground = deleteHandler->getFrameNumber()==viewer->getViewerFrameStamp()->getFrameNumber() && numDeleted==1;
+    }
+
+    deleteHandler->flushAll();
+    osg::Referenced::setDeleteHandler(0);
+
+    OSGUTX_TEST_F( !flushedInForeground )
+    OSGUTX_TEST_F( flushedInBackground )
+}
+
+OSGUTX_BEGIN_TESTSUITE(CompositeViewer)
+    OSGUTX_ADD_TESTCASE(CompositeViewerTestFixture, testAdvanceFlushesBackgroundDeleteHandler)
+OSGUTX_END_TESTSUITE
+
+OSGUTX_AUTOREGISTER_TESTSUITE_AT(CompositeViewer, root.osgViewer)
+
+}
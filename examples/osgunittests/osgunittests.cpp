@@ -30,6 +30,9 @@
 #include "UnitTestFramework.h"
 #include "performance.h"
 #include "MultiThreadRead.h"
+#include "OperationQueueBenchmark.h"
+#include "ObjLoaderBenchmark.h"
+#include "HttpLoadBenchmark.h"
 
 #include <iostream>
 
@@ -572,6 +575,17 @@ int main( int argc, char** argv )
     arguments.getApplicationUsage()->addCommandLineOption("matrix","Display qualified tests.");
     arguments.getApplicationUsage()->addCommandLineOption("performance","Display qualified tests.");
     arguments.getApplicationUsage()->addCommandLineOption("read-threads <numthreads>","Run multi-thread reading test.");
+    arguments.getApplicationUsage()->addCommandLineOption("operation-queue <numproducers>","Run OperationQueue throughput benchmark with the specified number of producer threads.");
+    arguments.getApplicationUsage()->addCommandLineOption("--operations <num>","Set the number of operations added by each producer thread of the OperationQueue benchmark.");
+    arguments.getApplicationUsage()->addCommandLineOption("obj-load <filename>","Run OBJ loader benchmark, comparing the stream and memory mapped parsers on the specified file.");
+    arguments.getApplicationUsage()->addCommandLineOption("obj-load-grid <size>","Run OBJ loader benchmark on a generated grid mesh with size x size vertices.");
+    arguments.getApplicationUsage()->addCommandLineOption("--runs <num>","Set the number of times each parser reads the file in the OBJ loader benchmark.");
+    arguments.getApplicationUsage()->addCommandLineOption("--parse-threads <num>","Set the number of threads used by the memory mapped parser of the OBJ loader benchmark.");
+    arguments.getApplicationUsage()->addCommandLineOption("http-load <url-pattern>","Run HTTP tile load benchmark, reading tiles whose URL is given by a printf pattern of the tile index, e.g. http://server/tiles/%d.osgb. Use --threads and --requests to set the number of reading threads and tiles.");
+    arguments.getApplicationUsage()->addCommandLineOption("http-load-loopback","Run HTTP tile load benchmark on tiles served from the loopback interface, so no tile server or network is required. Use --latency to set the delay before each response.");
+    arguments.getApplicationUsage()->addCommandLineOption("--threads <num>","Set the number of reading threads of the HTTP tile load benchmark.");
+    arguments.getApplicationUsage()->addCommandLineOption("--requests <num>","Set the number of tiles read by the HTTP tile load benchmark.");
+    arguments.getApplicationUsage()->addCommandLineOption("--latency <ms>","Set the delay before each response of the HTTP tile load benchmark's loopback server, default 20.");
 
 
     if (arguments.argc()<=1)
@@ -598,6 +612,21 @@ int main( int argc, char** argv )
     int numReadThreads = 0;
     while (arguments.read("read-threads", numReadThreads)) {}
 
+    int numOperationQueueProducers = 0;
+    while (arguments.read("operation-queue", numOperationQueueProducers)) {}
+
+    std::string objBenchmarkFile;
+    while (arguments.read("obj-load", objBenchmarkFile)) {}
+
+    unsigned int objBenchmarkGridSize = 0;
+    while (arguments.read("obj-load-grid", objBenchmarkGridSize)) {}
+
+    std::string httpBenchmarkURLPattern;
+    while (arguments.read("http-load", httpBenchmarkURLPattern)) {}
+
+    bool httpBenchmarkLoopback = false;
+    while (arguments.read("http-load-loopback")) httpBenchmarkLoopback = true;
+
     bool printPolytopeTest = false;
     while (arguments.read("polytope")) printPolytopeTest = true;
 
@@ -686,6 +715,30 @@ int main( int argc, char** argv )
         return 0;
     }
 
+    if (numOperationQueueProducers>0)
+    {
+        runOperationQueueBenchmark(numOperationQueueProducers, arguments);
+        return 0;
+    }
+
+    if (!objBenchmarkFile.empty())
+    {
+        runObjLoaderBenchmark(objBenchmarkFile, arguments);
+        return 0;
+    }
+
+    if (objBenchmarkGridSize>0)
+    {
+        runObjLoaderBenchmark(objBenchmarkGridSize, arguments);
+        return 0;
+    }
+
+    if (!httpBenchmarkURLPattern.empty() || httpBenchmarkLoopback)
+    {
+        runHttpLoadBenchmark(httpBenchmarkURLPattern, arguments);
+        return 0;
+    }
+
 
     if (printPolytopeTest)
     {
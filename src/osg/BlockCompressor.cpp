@@ -0,0 +1,884 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/ImageUtils>
+#include <osg/Texture>
+#include <osg/Math>
+#include <osg/Notify>
+
+#include <OpenThreads/Thread>
+
+#include <float.h>
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+using namespace osg;
+
+namespace
+{
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Block fetch, all encoders work on 4x4 blocks of 8 bit RGBA, missing channels are set to 0 and alpha to 255.
+//
+struct PixelLayout
+{
+    PixelLayout(GLenum pixelFormat): supported(true)
+    {
+        switch(pixelFormat)
+        {
+            case(GL_RGBA):              set(4, 0, 1, 2, 3); break;
+            case(GL_BGRA):              set(4, 2, 1, 0, 3); break;
+            case(GL_RGB):               set(3, 0, 1, 2, -1); break;
+            case(GL_BGR):               set(3, 2, 1, 0, -1); break;
+            case(GL_LUMINANCE):         set(1, 0, 0, 0, -1); break;
+            case(GL_LUMINANCE_ALPHA):   set(2, 0, 0, 0, 1); break;
+            case(GL_RED):               set(1, 0, -1, -1, -1); break;
+            case(GL_RG):                set(2, 0, 1, -1, -1); break;
+            default:                    supported = false; set(0, -1, -1, -1, -1); break;
+        }
+    }
+
+    void set(unsigned int num, int r, int g, int b, int a)
+    {
+        numComponents = num;
+        offsets[0] = r; offsets[1] = g; offsets[2] = b; offsets[3] = a;
+    }
+
+    bool            supported;
+    unsigned int    numComponents;
+    int             offsets[4];
+};
+
+typedef unsigned char Block[16][4];
+
+void fetchBlock(const PixelLayout& layout, const unsigned char* data, unsigned int rowStep, int width, int height, int bx, int by, Block& block)
+{
+    static const unsigned char defaults[4] = { 0, 0, 0, 255 };
+    for(int y=0; y<4; ++y)
+    {
+        // replicate the edge pixels of partial blocks
+        int py = osg::minimum(by*4+y, height-1);
+        const unsigned char* row = data + py*rowStep;
+        for(int x=0; x<4; ++x)
+        {
+            int px = osg::minimum(bx*4+x, width-1);
+            const unsigned char* pixel = row + px*layout.numComponents;
+            unsigned char* texel = block[y*4+x];
+            for(int c=0; c<4; ++c)
+            {
+                texel[c] = layout.offsets[c]>=0 ? pixel[layout.offsets[c]] : defaults[c];
+            }
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Endpoint fitting, shared by the BC1 and BC7 encoders
+//
+typedef float Point[4];
+
+/** Find the end points of the line through the points along their principal axis, using the bounding box for the fastest quality.*/
+void estimateEndPoints(const Point* points, unsigned int numPoints, unsigned int numChannels, BlockCompressionQuality quality, Point& start, Point& end)
+{
+    Point minimum, maximum, mean;
+    for(unsigned int c=0; c<4; ++c)
+    {
+        minimum[c] = FLT_MAX;
+        maximum[c] = -FLT_MAX;
+        mean[c] = 0.0f;
+        start[c] = end[c] = 0.0f;
+    }
+
+    for(unsigned int i=0; i<numPoints; ++i)
+    {
+        for(unsigned int c=0; c<numChannels; ++c)
+        {
+            minimum[c] = osg::minimum(minimum[c], points[i][c]);
+            maximum[c] = osg::maximum(maximum[c], points[i][c]);
+            mean[c] += points[i][c];
+        }
+    }
+
+    if (quality==BLOCK_COMPRESSION_FAST)
+    {
+        // inset the bounding box to reduce the error of the interpolated colours.
+        for(unsigned int c=0; c<numChannels; ++c)
+        {
+            float inset = (maximum[c]-minimum[c])/16.0f;
+            start[c] = maximum[c]-inset;
+            end[c] = minimum[c]+inset;
+        }
+        return;
+    }
+
+    for(unsigned int c=0; c<numChannels; ++c) mean[c] /= float(numPoints);
+
+    float covariance[4][4];
+    for(unsigned int r=0; r<4; ++r)
+        for(unsigned int c=0; c<4; ++c)
+            covariance[r][c] = 0.0f;
+
+    for(unsigned int i=0; i<numPoints; ++i)
+    {
+        Point delta;
+        for(unsigned int c=0; c<numChannels; ++c) delta[c] = points[i][c]-mean[c];
+        for(unsigned int r=0; r<numChannels; ++r)
+            for(unsigned int c=0; c<numChannels; ++c)
+                covariance[r][c] += delta[r]*delta[c];
+    }
+
+    // power iteration, starting from the diagonal of the bounding box
+    Point axis;
+    for(unsigned int c=0; c<4; ++c) axis[c] = c<numChannels ? maximum[c]-minimum[c] : 0.0f;
+
+    for(unsigned int iteration=0; iteration<8; ++iteration)
+    {
+        Point next;
+        float largest = 0.0f;
+        for(unsigned int r=0; r<numChannels; ++r)
+        {
+            next[r] = 0.0f;
+            for(unsigned int c=0; c<numChannels; ++c) next[r] += covariance[r][c]*axis[c];
+            largest = osg::maximum(largest, fabsf(next[r]));
+        }
+
+        if (largest==0.0f) break;
+
+        for(unsigned int c=0; c<numChannels; ++c) axis[c] = next[c]/largest;
+    }
+
+    float length2 = 0.0f;
+    for(unsigned int c=0; c<numChannels; ++c) length2 += axis[c]*axis[c];
+
+    if (length2==0.0f)
+    {
+        for(unsigned int c=0; c<numChannels; ++c) start[c] = end[c] = mean[c];
+        return;
+    }
+
+    float minT = FLT_MAX;
+    float maxT = -FLT_MAX;
+    for(unsigned int i=0; i<numPoints; ++i)
+    {
+        float t = 0.0f;
+        for(unsigned int c=0; c<numChannels; ++c) t += (points[i][c]-mean[c])*axis[c];
+        minT = osg::minimum(minT, t);
+        maxT = osg::maximum(maxT, t);
+    }
+
+    for(unsigned int c=0; c<numChannels; ++c)
+    {
+        start[c] = mean[c] + axis[c]*maxT/length2;
+        end[c] = mean[c] + axis[c]*minT/length2;
+    }
+}
+
+/** Least squares fit of the end points given the interpolation weight of the end point for each point.
+  * Returns false if the system is degenerate, i.e. all points use the same weight.*/
+bool fitEndPoints(const Point* points, const float* weights, unsigned int numPoints, unsigned int numChannels, Point& start, Point& end)
+{
+    float alpha2 = 0.0f, beta2 = 0.0f, alphaBeta = 0.0f;
+    Point alphaX, betaX;
+    for(unsigned int c=0; c<4; ++c) alphaX[c] = betaX[c] = 0.0f;
+
+    for(unsigned int i=0; i<numPoints; ++i)
+    {
+        float beta = weights[i];
+        float alpha = 1.0f-beta;
+        alpha2 += alpha*alpha;
+        beta2 += beta*beta;
+        alphaBeta += alpha*beta;
+        for(unsigned int c=0; c<numChannels; ++c)
+        {
+            alphaX[c] += alpha*points[i][c];
+            betaX[c] += beta*points[i][c];
+        }
+    }
+
+    float determinant = alpha2*beta2 - alphaBeta*alphaBeta;
+    if (fabsf(determinant)<1e-6f) return false;
+
+    float inverse = 1.0f/determinant;
+    for(unsigned int c=0; c<numChannels; ++c)
+    {
+        start[c] = osg::clampBetween((alphaX[c]*beta2 - betaX[c]*alphaBeta)*inverse, 0.0f, 255.0f);
+        end[c] = osg::clampBetween((betaX[c]*alpha2 - alphaX[c]*alphaBeta)*inverse, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+inline int squared(int v) { return v*v; }
+
+unsigned int numberOfRefinements(BlockCompressionQuality quality)
+{
+    switch(quality)
+    {
+        case(BLOCK_COMPRESSION_FAST):   return 0;
+        case(BLOCK_COMPRESSION_NORMAL): return 1;
+        case(BLOCK_COMPRESSION_HIGH):   return 4;
+    }
+    return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// BC1 colour block, also used for the colour part of BC2 and BC3
+//
+inline unsigned short quantize565(const Point& c)
+{
+    int r = static_cast<int>(c[0]*31.0f/255.0f+0.5f);
+    int g = static_cast<int>(c[1]*63.0f/255.0f+0.5f);
+    int b = static_cast<int>(c[2]*31.0f/255.0f+0.5f);
+    return static_cast<unsigned short>((osg::clampBetween(r,0,31)<<11) | (osg::clampBetween(g,0,63)<<5) | osg::clampBetween(b,0,31));
+}
+
+inline void expand565(unsigned short c, int rgb[3])
+{
+    int r = (c>>11)&31, g = (c>>5)&63, b = c&31;
+    rgb[0] = (r<<3)|(r>>2);
+    rgb[1] = (g<<2)|(g>>4);
+    rgb[2] = (b<<3)|(b>>2);
+}
+
+struct ColorBlockResult
+{
+    unsigned short  color0;
+    unsigned short  color1;
+    unsigned char   indices[16];
+    int             error;
+};
+
+/** Assign the palette indices for the given quantized end points and return the total squared error. In three colour mode
+  * index 3 is reserved for transparent pixels.*/
+int evaluateColorBlock(const Block& block, const bool* transparent, bool threeColorMode, unsigned short color0, unsigned short color1, unsigned char* indices)
+{
+    int palette[4][3];
+    expand565(color0, palette[0]);
+    expand565(color1, palette[1]);
+    for(int c=0; c<3; ++c)
+    {
+        if (threeColorMode)
+        {
+            palette[2][c] = (palette[0][c]+palette[1][c])/2;
+            palette[3][c] = 0;
+        }
+        else
+        {
+            palette[2][c] = (2*palette[0][c]+palette[1][c])/3;
+            palette[3][c] = (palette[0][c]+2*palette[1][c])/3;
+        }
+    }
+
+    int numColors = threeColorMode ? 3 : 4;
+    int totalError = 0;
+    for(int i=0; i<16; ++i)
+    {
+        if (transparent && transparent[i])
+        {
+            indices[i] = 3;
+            continue;
+        }
+
+        int bestError = INT_MAX;
+        for(int p=0; p<numColors; ++p)
+        {
+            int error = squared(block[i][0]-palette[p][0]) + squared(block[i][1]-palette[p][1]) + squared(block[i][2]-palette[p][2]);
+            if (error<bestError)
+            {
+                bestError = error;
+                indices[i] = static_cast<unsigned char>(p);
+            }
+        }
+        totalError += bestError;
+    }
+    return totalError;
+}
+
+void encodeColorBlock(const Block& block, bool allowTransparency, BlockCompressionQuality quality, unsigned char* output)
+{
+    bool transparent[16];
+    bool threeColorMode = false;
+
+    Point points[16];
+    unsigned int numPoints = 0;
+    for(int i=0; i<16; ++i)
+    {
+        transparent[i] = allowTransparency && block[i][3]<128;
+        if (transparent[i])
+        {
+            threeColorMode = true;
+            continue;
+        }
+
+        for(int c=0; c<4; ++c) points[numPoints][c] = block[i][c];
+        ++numPoints;
+    }
+
+    ColorBlockResult best;
+    best.color0 = best.color1 = 0;
+    best.error = 0;
+
+    if (numPoints==0)
+    {
+        // fully transparent block
+        for(int i=0; i<16; ++i) best.indices[i] = 3;
+    }
+    else
+    {
+        // gather the points being encoded so the index assignment maps straight onto them
+        unsigned int pointIndices[16];
+        for(unsigned int i=0, p=0; i<16; ++i)
+        {
+            if (!transparent[i]) pointIndices[p++] = i;
+        }
+
+        Point start, end;
+        estimateEndPoints(points, numPoints, 3, quality, start, end);
+
+        best.color0 = quantize565(start);
+        best.color1 = quantize565(end);
+        best.error = evaluateColorBlock(block, transparent, threeColorMode, best.color0, best.color1, best.indices);
+
+        // the interpolation weight of the second end point for each palette index
+        static const float fourColorWeights[4] = { 0.0f, 1.0f, 1.0f/3.0f, 2.0f/3.0f };
+        static const float threeColorWeights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+        const float* paletteWeights = threeColorMode ? threeColorWeights : fourColorWeights;
+
+        unsigned int numRefinements = numberOfRefinements(quality);
+        for(unsigned int iteration=0; iteration<numRefinements && best.error>0; ++iteration)
+        {
+            float weights[16];
+            for(unsigned int p=0; p<numPoints; ++p) weights[p] = paletteWeights[best.indices[pointIndices[p]]];
+
+            if (!fitEndPoints(points, weights, numPoints, 3, start, end)) break;
+
+            ColorBlockResult candidate;
+            candidate.color0 = quantize565(start);
+            candidate.color1 = quantize565(end);
+            candidate.error = evaluateColorBlock(block, transparent, threeColorMode, candidate.color0, candidate.color1, candidate.indices);
+
+            if (candidate.error>=best.error) break;
+            best = candidate;
+        }
+    }
+
+    // order the end points to select the palette mode, remapping the indices to match.
+    unsigned short color0 = best.color0;
+    unsigned short color1 = best.color1;
+    if ((threeColorMode && color0>color1) || (!threeColorMode && color0<color1))
+    {
+        std::swap(color0, color1);
+
+        static const unsigned char fourColorRemap[4] = { 1, 0, 3, 2 };
+        static const unsigned char threeColorRemap[4] = { 1, 0, 2, 3 };
+        const unsigned char* remap = threeColorMode ? threeColorRemap : fourColorRemap;
+        for(int i=0; i<16; ++i) best.indices[i] = remap[best.indices[i]];
+    }
+    else if (!threeColorMode && color0==color1)
+    {
+        // equal end points select the three colour mode, in which only index 0 is certain to be the end point colour.
+        for(int i=0; i<16; ++i) best.indices[i] = 0;
+    }
+
+    output[0] = static_cast<unsigned char>(color0 & 0xff);
+    output[1] = static_cast<unsigned char>(color0 >> 8);
+    output[2] = static_cast<unsigned char>(color1 & 0xff);
+    output[3] = static_cast<unsigned char>(color1 >> 8);
+    for(int row=0; row<4; ++row)
+    {
+        output[4+row] = static_cast<unsigned char>(best.indices[row*4] | (best.indices[row*4+1]<<2) | (best.indices[row*4+2]<<4) | (best.indices[row*4+3]<<6));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// BC4 single channel block, also used for the alpha of BC3 and the two channels of BC5
+//
+int evaluateChannelBlock(const unsigned char* values, int value0, int value1, unsigned char* indices)
+{
+    int palette[8];
+    palette[0] = value0;
+    palette[1] = value1;
+    if (value0>value1)
+    {
+        for(int i=1; i<7; ++i) palette[i+1] = ((7-i)*value0 + i*value1)/7;
+    }
+    else
+    {
+        for(int i=1; i<5; ++i) palette[i+1] = ((5-i)*value0 + i*value1)/5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    int totalError = 0;
+    for(int i=0; i<16; ++i)
+    {
+        int bestError = INT_MAX;
+        for(int p=0; p<8; ++p)
+        {
+            int error = squared(values[i]-palette[p]);
+            if (error<bestError)
+            {
+                bestError = error;
+                indices[i] = static_cast<unsigned char>(p);
+            }
+        }
+        totalError += bestError;
+    }
+    return totalError;
+}
+
+void encodeChannelBlock(const Block& block, unsigned int channel, BlockCompressionQuality quality, unsigned char* output)
+{
+    unsigned char values[16];
+    int minimum = 255, maximum = 0;
+    int innerMinimum = 255, innerMaximum = 0;
+    for(int i=0; i<16; ++i)
+    {
+        int v = block[i][channel];
+        values[i] = static_cast<unsigned char>(v);
+        minimum = osg::minimum(minimum, v);
+        maximum = osg::maximum(maximum, v);
+        if (v!=0 && v!=255)
+        {
+            innerMinimum = osg::minimum(innerMinimum, v);
+            innerMaximum = osg::maximum(innerMaximum, v);
+        }
+    }
+
+    int bestValue0 = maximum, bestValue1 = minimum;
+    unsigned char bestIndices[16];
+    int bestError = evaluateChannelBlock(values, bestValue0, bestValue1, bestIndices);
+
+    if (quality!=BLOCK_COMPRESSION_FAST && bestError>0)
+    {
+        // try the six value mode which has exact 0 and 255 entries, using the range of the remaining values.
+        if (innerMinimum>innerMaximum) innerMinimum = innerMaximum = 0;
+
+        // search end points inset from the range, more widely for the high quality setting.
+        int range = quality==BLOCK_COMPRESSION_HIGH ? 2 : 1;
+        unsigned char indices[16];
+        for(int i0=0; i0<=range; ++i0)
+        {
+            for(int i1=0; i1<=range; ++i1)
+            {
+                int value0 = maximum-i0, value1 = minimum+i1;
+                if (value0>value1)
+                {
+                    int error = evaluateChannelBlock(values, value0, value1, indices);
+                    if (error<bestError) { bestError = error; bestValue0 = value0; bestValue1 = value1; memcpy(bestIndices, indices, 16); }
+                }
+
+                value0 = innerMinimum+i1; value1 = innerMaximum-i0;
+                if (value0<=value1)
+                {
+                    int error = evaluateChannelBlock(values, value0, value1, indices);
+                    if (error<bestError) { bestError = error; bestValue0 = value0; bestValue1 = value1; memcpy(bestIndices, indices, 16); }
+                }
+            }
+        }
+    }
+
+    output[0] = static_cast<unsigned char>(bestValue0);
+    output[1] = static_cast<unsigned char>(bestValue1);
+
+    // 16 3 bit indices packed into 48 bits
+    unsigned int bits = 0;
+    int numBits = 0;
+    unsigned char* ptr = output+2;
+    for(int i=0; i<16; ++i)
+    {
+        bits |= (bestIndices[i] << numBits);
+        numBits += 3;
+        if (numBits>=8)
+        {
+            *(ptr++) = static_cast<unsigned char>(bits & 0xff);
+            bits >>= 8;
+            numBits -= 8;
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// BC2 explicit 4 bit alpha
+//
+void encodeExplicitAlphaBlock(const Block& block, unsigned char* output)
+{
+    for(int i=0; i<8; ++i)
+    {
+        int a0 = (block[i*2][3]*15+127)/255;
+        int a1 = (block[i*2+1][3]*15+127)/255;
+        output[i] = static_cast<unsigned char>(a0 | (a1<<4));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// BC7, encoded using mode 6 : a single subset of RGBA end points with 7 bits per channel plus a shared
+// lowest bit per end point, and 4 bit indices.
+//
+static const int bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BC7EndPoint
+{
+    int value[4]; // 7 bit channels
+    int pbit;
+
+    int decoded(unsigned int c) const { return (value[c]<<1) | pbit; }
+};
+
+void quantizeBC7EndPoint(const Point& p, BC7EndPoint& endPoint)
+{
+    float bestError = FLT_MAX;
+    for(int pbit=0; pbit<2; ++pbit)
+    {
+        BC7EndPoint candidate;
+        candidate.pbit = pbit;
+        float error = 0.0f;
+        for(unsigned int c=0; c<4; ++c)
+        {
+            candidate.value[c] = osg::clampBetween(static_cast<int>((p[c]-float(pbit))*0.5f+0.5f), 0, 127);
+            float delta = float(candidate.decoded(c))-p[c];
+            error += delta*delta;
+        }
+        if (error<bestError)
+        {
+            bestError = error;
+            endPoint = candidate;
+        }
+    }
+}
+
+int evaluateBC7Block(const Block& block, const BC7EndPoint& endPoint0, const BC7EndPoint& endPoint1, unsigned char* indices)
+{
+    int palette[16][4];
+    for(unsigned int c=0; c<4; ++c)
+    {
+        int e0 = endPoint0.decoded(c);
+        int e1 = endPoint1.decoded(c);
+        for(int p=0; p<16; ++p)
+        {
+            palette[p][c] = ((64-bc7Weights4[p])*e0 + bc7Weights4[p]*e1 + 32) >> 6;
+        }
+    }
+
+    int totalError = 0;
+    for(int i=0; i<16; ++i)
+    {
+        int bestError = INT_MAX;
+        for(int p=0; p<16; ++p)
+        {
+            int error = squared(block[i][0]-palette[p][0]) + squared(block[i][1]-palette[p][1]) +
+                        squared(block[i][2]-palette[p][2]) + squared(block[i][3]-palette[p][3]);
+            if (error<bestError)
+            {
+                bestError = error;
+                indices[i] = static_cast<unsigned char>(p);
+            }
+        }
+        totalError += bestError;
+    }
+    return totalError;
+}
+
+struct BitWriter
+{
+    BitWriter(unsigned char* output, unsigned int numBytes): _output(output), _position(0) { memset(output, 0, numBytes); }
+
+    void write(unsigned int value, unsigned int numBits)
+    {
+        for(unsigned int i=0; i<numBits; ++i, ++_position)
+        {
+            _output[_position>>3] |= static_cast<unsigned char>(((value>>i)&1) << (_position&7));
+        }
+    }
+
+    unsigned char*  _output;
+    unsigned int    _position;
+};
+
+void encodeBC7Block(const Block& block, BlockCompressionQuality quality, unsigned char* output)
+{
+    Point points[16];
+    for(int i=0; i<16; ++i)
+        for(int c=0; c<4; ++c)
+            points[i][c] = block[i][c];
+
+    Point start, end;
+    estimateEndPoints(points, 16, 4, quality, start, end);
+
+    BC7EndPoint bestEndPoint0, bestEndPoint1;
+    quantizeBC7EndPoint(start, bestEndPoint0);
+    quantizeBC7EndPoint(end, bestEndPoint1);
+
+    unsigned char bestIndices[16];
+    int bestError = evaluateBC7Block(block, bestEndPoint0, bestEndPoint1, bestIndices);
+
+    unsigned int numRefinements = numberOfRefinements(quality);
+    for(unsigned int iteration=0; iteration<numRefinements && bestError>0; ++iteration)
+    {
+        float weights[16];
+        for(int i=0; i<16; ++i) weights[i] = float(bc7Weights4[bestIndices[i]])/64.0f;
+
+        if (!fitEndPoints(points, weights, 16, 4, start, end)) break;
+
+        BC7EndPoint endPoint0, endPoint1;
+        quantizeBC7EndPoint(start, endPoint0);
+        quantizeBC7EndPoint(end, endPoint1);
+
+        unsigned char indices[16];
+        int error = evaluateBC7Block(block, endPoint0, endPoint1, indices);
+        if (error>=bestError) break;
+
+        bestError = error;
+        bestEndPoint0 = endPoint0;
+        bestEndPoint1 = endPoint1;
+        memcpy(bestIndices, indices, 16);
+    }
+
+    // the most significant bit of the anchor index, pixel 0, is implicitly zero so swap the end points if required.
+    if (bestIndices[0]>=8)
+    {
+        std::swap(bestEndPoint0, bestEndPoint1);
+        for(int i=0; i<16; ++i) bestIndices[i] = static_cast<unsigned char>(15-bestIndices[i]);
+    }
+
+    BitWriter writer(output, 16);
+    writer.write(1<<6, 7); // mode 6
+    for(unsigned int c=0; c<4; ++c)
+    {
+        writer.write(bestEndPoint0.value[c], 7);
+        writer.write(bestEndPoint1.value[c], 7);
+    }
+    writer.write(bestEndPoint0.pbit, 1);
+    writer.write(bestEndPoint1.pbit, 1);
+    writer.write(bestIndices[0], 3);
+    for(int i=1; i<16; ++i) writer.write(bestIndices[i], 4);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Image level compression
+//
+struct CompressLevelOperation
+{
+    CompressLevelOperation(GLenum pixelFormat, GLenum compressedFormat, BlockCompressionQuality blockQuality,
+                           const unsigned char* src, unsigned int srcRowStep, int w, int h, unsigned char* dst):
+        layout(pixelFormat),
+        format(compressedFormat),
+        quality(blockQuality),
+        srcData(src),
+        rowStep(srcRowStep),
+        width(w),
+        height(h),
+        dstData(dst)
+    {
+        blockSize = osg::Image::computeBlockSize(format, 0);
+        numBlocksX = (width+3)/4;
+        numBlocksY = (height+3)/4;
+    }
+
+    void compressBlockRows(int beginRow, int endRow) const
+    {
+        Block block;
+        for(int by=beginRow; by<endRow; ++by)
+        {
+            unsigned char* output = dstData + by*numBlocksX*blockSize;
+            for(int bx=0; bx<numBlocksX; ++bx, output+=blockSize)
+            {
+                fetchBlock(layout, srcData, rowStep, width, height, bx, by, block);
+                switch(format)
+                {
+                    case(GL_COMPRESSED_RGB_S3TC_DXT1_EXT):
+                        encodeColorBlock(block, false, quality, output);
+                        break;
+                    case(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT):
+                        encodeColorBlock(block, true, quality, output);
+                        break;
+                    case(GL_COMPRESSED_RGBA_S3TC_DXT3_EXT):
+                        encodeExplicitAlphaBlock(block, output);
+                        encodeColorBlock(block, false, quality, output+8);
+                        break;
+                    case(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT):
+                        encodeChannelBlock(block, 3, quality, output);
+                        encodeColorBlock(block, false, quality, output+8);
+                        break;
+                    case(GL_COMPRESSED_RED_RGTC1_EXT):
+                        encodeChannelBlock(block, 0, quality, output);
+                        break;
+                    case(GL_COMPRESSED_RED_GREEN_RGTC2_EXT):
+                        encodeChannelBlock(block, 0, quality, output);
+                        encodeChannelBlock(block, 1, quality, output+8);
+                        break;
+                    case(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB):
+                    case(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB):
+                        encodeBC7Block(block, quality, output);
+                        break;
+                }
+            }
+        }
+    }
+
+    PixelLayout             layout;
+    GLenum                  format;
+    BlockCompressionQuality quality;
+    const unsigned char*    srcData;
+    unsigned int            rowStep;
+    int                     width;
+    int                     height;
+    unsigned char*          dstData;
+    int                     blockSize;
+    int                     numBlocksX;
+    int                     numBlocksY;
+};
+
+class CompressThread : public OpenThreads::Thread
+{
+public:
+    CompressThread(const CompressLevelOperation& operation, int beginRow, int endRow):
+        _operation(operation),
+        _beginRow(beginRow),
+        _endRow(endRow) {}
+
+    virtual void run() { _operation.compressBlockRows(_beginRow, _endRow); }
+
+protected:
+    const CompressLevelOperation&   _operation;
+    int                             _beginRow;
+    int                             _endRow;
+};
+
+void compressLevel(const CompressLevelOperation& operation, unsigned int numThreads)
+{
+    int numBlockRows = operation.numBlocksY;
+    if (numThreads==0)
+    {
+        // BC7 and the higher quality settings are costly enough to warrant threads for modest image sizes.
+        int numBlocks = operation.numBlocksX*numBlockRows;
+        numThreads = numBlocks<1024 ? 1 : static_cast<unsigned int>(OpenThreads::GetNumberOfProcessors());
+    }
+    numThreads = osg::clampBetween(numThreads, 1u, static_cast<unsigned int>(numBlockRows));
+
+    if (numThreads<=1)
+    {
+        operation.compressBlockRows(0, numBlockRows);
+        return;
+    }
+
+    int rowsPerThread = (numBlockRows+numThreads-1)/numThreads;
+
+    std::vector<CompressThread*> threads;
+    for(int beginRow=rowsPerThread; beginRow<numBlockRows; beginRow+=rowsPerThread)
+    {
+        CompressThread* thread = new CompressThread(operation, beginRow, osg::minimum(beginRow+rowsPerThread, numBlockRows));
+        thread->start();
+        threads.push_back(thread);
+    }
+
+    operation.compressBlockRows(0, osg::minimum(rowsPerThread, numBlockRows));
+
+    for(std::vector<CompressThread*>::iterator itr = threads.begin();
+        itr != threads.end();
+        ++itr)
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+}
+
+}
+
+bool osg::isBlockCompressionSupported(GLenum pixelFormat, GLenum dataType, GLenum compressedFormat)
+{
+    if (dataType!=GL_UNSIGNED_BYTE || !PixelLayout(pixelFormat).supported) return false;
+
+    switch(compressedFormat)
+    {
+        case(GL_COMPRESSED_RGB_S3TC_DXT1_EXT):
+        case(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT):
+        case(GL_COMPRESSED_RGBA_S3TC_DXT3_EXT):
+        case(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT):
+        case(GL_COMPRESSED_RED_RGTC1_EXT):
+        case(GL_COMPRESSED_RED_GREEN_RGTC2_EXT):
+        case(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB):
+        case(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB):
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool osg::compressImage(osg::Image& image, GLenum compressedFormat, BlockCompressionQuality quality, unsigned int numThreads)
+{
+    if (!image.data() || image.r()!=1) return false;
+
+    GLenum pixelFormat = image.getPixelFormat();
+    GLenum dataType = image.getDataType();
+    if (!isBlockCompressionSupported(pixelFormat, dataType, compressedFormat))
+    {
+        OSG_INFO<<"osg::compressImage(..) compression of pixel format 0x"<<std::hex<<pixelFormat<<" into 0x"<<compressedFormat<<std::dec<<" not supported."<<std::endl;
+        return false;
+    }
+
+    unsigned int numLevels = image.getNumMipmapLevels();
+
+    // compute the compressed level offsets
+    std::vector<unsigned int> offsets(numLevels);
+    unsigned int totalSize = 0;
+    int width = image.s();
+    int height = image.t();
+    for(unsigned int level=0; level<numLevels; ++level)
+    {
+        offsets[level] = totalSize;
+        totalSize += osg::Image::computeImageSizeInBytes(width, height, 1, compressedFormat, GL_UNSIGNED_BYTE);
+
+        width = osg::maximum(width>>1, 1);
+        height = osg::maximum(height>>1, 1);
+    }
+
+    unsigned char* data = new unsigned char[totalSize];
+
+    width = image.s();
+    height = image.t();
+    for(unsigned int level=0; level<numLevels; ++level)
+    {
+        // mipmap levels are tightly packed apart from the row alignment, only the base level may use a row length.
+        unsigned int rowStep = level==0 ? image.getRowStepInBytes() :
+                               osg::Image::computeRowWidthInBytes(width, pixelFormat, dataType, image.getPacking());
+
+        CompressLevelOperation operation(pixelFormat, compressedFormat, quality,
+                                         image.getMipmapData(level), rowStep, width, height,
+                                         data + offsets[level]);
+        compressLevel(operation, numThreads);
+
+        width = osg::maximum(width>>1, 1);
+        height = osg::maximum(height>>1, 1);
+    }
+
+    image.setImage(image.s(), image.t(), 1,
+                   compressedFormat, compressedFormat, GL_UNSIGNED_BYTE,
+                   data, osg::Image::USE_NEW_DELETE, 1);
+
+    if (numLevels>1)
+    {
+        osg::Image::MipmapDataType mipmapData(offsets.begin()+1, offsets.end());
+        image.setMipmapLevels(mipmapData);
+    }
+
+    return true;
+}
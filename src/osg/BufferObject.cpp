@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <float.h>
+#include <algorithm>
 
 #include <osg/BufferObject>
 #include <osg/Notify>
@@ -236,6 +237,8 @@ void GLBufferObject::compileBuffer()
         compileAll = true;
     }
 
+    BufferData::ModifiedRanges ranges;
+
     for(BufferEntries::iterator itr = _bufferEntries.begin();
         itr != _bufferEntries.end();
         ++itr)
@@ -244,6 +247,8 @@ void GLBufferObject::compileBuffer()
         if (entry.dataSource && (compileAll || entry.modifiedCount != entry.dataSource->getModifiedCount()))
         {
             // OSG_NOTICE<<"GLBufferObject::compileBuffer(..) downloading BufferEntry "<<&entry<<std::endl;
+            unsigned int previousModifiedCount = entry.modifiedCount;
+
             entry.numRead = 0;
             entry.modifiedCount = entry.dataSource->getModifiedCount();
 
@@ -259,35 +264,60 @@ void GLBufferObject::compileBuffer()
             }
             else
             {
-                if(_profile._mappingbitfield != 0 )
+                // only upload the sub ranges that have been dirtied since the last upload when this is possible
+                ranges.clear();
+                if (compileAll ||
+                    previousModifiedCount==0xffffff ||
+                    !entry.dataSource->getModifiedRangesSince(previousModifiedCount, ranges) ||
+                    ranges.empty())
                 {
-                    if(_profile._mappingbitfield & GL_MAP_PERSISTENT_BIT)
-                    {
-                        if(_persistentDMA)
-                        {
-                            GLvoid* src = const_cast<GLvoid*>(entry.dataSource->getDataPointer());
-                            memcpy((unsigned char*)_persistentDMA + entry.offset, src, entry.dataSize);
-                            _extensions->glFlushMappedBufferRange(_profile._target, (GLintptr)entry.offset, (GLsizeiptr)entry.dataSize);
-                        }
-                        else OSG_WARN<<" GL_MAP_PERSISTENT_BIT problem"<<std::endl;
-                    }
-                    else if(_profile._mappingbitfield & GL_MAP_WRITE_BIT)
-                    {
-                        GLvoid *src = const_cast<GLvoid*>(entry.dataSource->getDataPointer()),
-                               *dst = _extensions->glMapBufferRange( _profile._target, (GLintptr)entry.offset,  (GLsizeiptr)entry.dataSize, _profile._mappingbitfield);
-                        memcpy(dst, src, entry.dataSize);
-                        _extensions->glUnmapBuffer(_profile._target);
-                    }
+                    ranges.clear();
+                    ranges.push_back(BufferData::ModifiedRange(entry.modifiedCount, 0, entry.dataSize));
                 }
-                else
+
+                for(BufferData::ModifiedRanges::const_iterator r_itr = ranges.begin();
+                    r_itr != ranges.end();
+                    ++r_itr)
                 {
-                    _extensions->glBufferSubData(_profile._target, (GLintptr)entry.offset, (GLsizeiptr)entry.dataSize, entry.dataSource->getDataPointer());
+                    if (r_itr->offset>=entry.dataSize) break;
+
+                    unsigned int size = osg::minimum(r_itr->size, entry.dataSize - r_itr->offset);
+                    uploadBufferEntry(entry, r_itr->offset, size);
                 }
             }
         }
     }
 }
 
+void GLBufferObject::uploadBufferEntry(const BufferEntry& entry, unsigned int offset, unsigned int size)
+{
+    const unsigned char* src = static_cast<const unsigned char*>(entry.dataSource->getDataPointer()) + offset;
+    GLintptr dstOffset = (GLintptr)(entry.offset + offset);
+
+    if(_profile._mappingbitfield != 0 )
+    {
+        if(_profile._mappingbitfield & GL_MAP_PERSISTENT_BIT)
+        {
+            if(_persistentDMA)
+            {
+                memcpy((unsigned char*)_persistentDMA + dstOffset, src, size);
+                _extensions->glFlushMappedBufferRange(_profile._target, dstOffset, (GLsizeiptr)size);
+            }
+            else OSG_WARN<<" GL_MAP_PERSISTENT_BIT problem"<<std::endl;
+        }
+        else if(_profile._mappingbitfield & GL_MAP_WRITE_BIT)
+        {
+            GLvoid *dst = _extensions->glMapBufferRange( _profile._target, dstOffset,  (GLsizeiptr)size, _profile._mappingbitfield);
+            memcpy(dst, src, size);
+            _extensions->glUnmapBuffer(_profile._target);
+        }
+    }
+    else
+    {
+        _extensions->glBufferSubData(_profile._target, dstOffset, (GLsizeiptr)size, src);
+    }
+}
+
 void GLBufferObject::commitDMA(unsigned int entryidx)
 {
     if( !(_profile._mappingbitfield & GL_MAP_PERSISTENT_BIT) ) return;
@@ -664,6 +694,51 @@ bool GLBufferObjectSet::makeSpace(unsigned int& size)
     return size==0;
 }
 
+void GLBufferObjectSet::collectLeastRecentlyUsed(unsigned int frameNumber, std::vector<GLBufferObject*>& glBufferObjects) const
+{
+    // the active list is kept in least recently used order, so stop at the first object used since frameNumber.
+    for(GLBufferObject* glbo = _head;
+        glbo != 0 && glbo->_frameLastUsed < frameNumber;
+        glbo = glbo->_next)
+    {
+        glBufferObjects.push_back(glbo);
+    }
+}
+
+bool GLBufferObjectSet::evict(GLBufferObject* glbo)
+{
+    ref_ptr<BufferObject> bufferObject = glbo->getBufferObject();
+    if (!bufferObject || bufferObject->getGLBufferObject(_contextID)!=glbo) return false;
+
+    // only vertex and element data can be recompiled from the BufferData, other buffer
+    // objects may hold results written on the GPU or be persistently mapped.
+    if (!dynamic_cast<VertexBufferObject*>(bufferObject.get()) && !dynamic_cast<ElementBufferObject*>(bufferObject.get())) return false;
+    if (bufferObject->getProfile()._mappingbitfield!=0) return false;
+
+    OSG_INFO<<"GLBufferObjectSet="<<this<<": Evicting GLBufferObject "<<glbo<<" last used in frame "<<glbo->_frameLastUsed<<std::endl;
+
+    // keep a reference so the GLBufferObject survives the BufferObject letting go of it.
+    ref_ptr<GLBufferObject> keep = glbo;
+
+    bufferObject->setGLBufferObject(_contextID, 0);
+    glbo->setBufferObject(0);
+
+    // delete straight away rather than orphaning, as orphans are only deleted once the pool exceeds the max buffer object pool size.
+    remove(glbo);
+
+    glbo->deleteGLObject();
+
+    --_numOfGLBufferObjects;
+
+    _parent->setCurrGLBufferObjectPoolSize( _parent->getCurrGLBufferObjectPoolSize() - _profile._size );
+    _parent->getNumberActiveGLBufferObjects() -= 1;
+    _parent->getNumberDeleted() += 1;
+
+    CHECK_CONSISTENCY
+
+    return true;
+}
+
 osg::ref_ptr<GLBufferObject> GLBufferObjectSet::takeFromOrphans(BufferObject* bufferObject)
 {
     // take front of orphaned list.
@@ -970,6 +1045,16 @@ bool GLBufferObjectManager::makeSpace(unsigned int size)
 }
 
 
+void GLBufferObjectManager::collectLeastRecentlyUsed(unsigned int frameNumber, std::vector<GLBufferObject*>& glBufferObjects) const
+{
+    for(GLBufferObjectSetMap::const_iterator itr = _glBufferObjectSetMap.begin();
+        itr != _glBufferObjectSetMap.end();
+        ++itr)
+    {
+        (*itr).second->collectLeastRecentlyUsed(frameNumber, glBufferObjects);
+    }
+}
+
 osg::ref_ptr<GLBufferObject> GLBufferObjectManager::generateGLBufferObject(const BufferObject* bufferObject)
 {
     ElapsedTime elapsedTime(&(getGenerateTime()));
@@ -1309,6 +1394,123 @@ BufferData::~BufferData()
     setBufferObject(0);
 }
 
+namespace
+{
+    // guards the modified ranges of all BufferData, as the update thread dirties them while draw threads upload them.
+    OpenThreads::Mutex& getModifiedRangesMutex()
+    {
+        static OpenThreads::Mutex s_modifiedRangesMutex;
+        return s_modifiedRangesMutex;
+    }
+}
+
+void BufferData::setModifiedCount(unsigned int value)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(getModifiedRangesMutex());
+
+    _modifiedCount = value;
+    _modifiedRangesBaseCount = value;
+    _modifiedRanges.clear();
+}
+
+void BufferData::dirtyRange(unsigned int offset, unsigned int size)
+{
+    // cap on the number of distinct ranges held before the oldest are discarded.
+    static const unsigned int s_maxNumModifiedRanges = 64;
+
+    if (size==0) return;
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(getModifiedRangesMutex());
+
+        // discard the ranges superseded by a full dirty() since they were recorded, the ranges being ordered by modified count.
+        ModifiedRanges::iterator firstCurrent = _modifiedRanges.begin();
+        while(firstCurrent!=_modifiedRanges.end() && firstCurrent->modifiedCount<=_modifiedRangesBaseCount) ++firstCurrent;
+        _modifiedRanges.erase(_modifiedRanges.begin(), firstCurrent);
+
+        ++_modifiedCount;
+
+        // coalesce with the most recently dirtied range if the two overlap or are adjacent,
+        // the merged range takes the new modified count as it now covers the latest modification.
+        if (!_modifiedRanges.empty() &&
+            offset <= _modifiedRanges.back().end() &&
+            _modifiedRanges.back().offset <= offset+size)
+        {
+            ModifiedRange& last = _modifiedRanges.back();
+            unsigned int end = osg::maximum(last.end(), offset+size);
+            last.offset = osg::minimum(last.offset, offset);
+            last.size = end - last.offset;
+            last.modifiedCount = _modifiedCount;
+        }
+        else
+        {
+            _modifiedRanges.push_back(ModifiedRange(_modifiedCount, offset, size));
+        }
+
+        if (_modifiedRanges.size()>s_maxNumModifiedRanges)
+        {
+            // modifications up to the oldest range are no longer tracked, so anything older has to do a full update
+            _modifiedRangesBaseCount = _modifiedRanges.front().modifiedCount;
+            _modifiedRanges.erase(_modifiedRanges.begin());
+        }
+    }
+
+    if (_modifiedCallback.valid()) _modifiedCallback->modified(this);
+    if (_bufferObject.valid()) _bufferObject->dirty();
+}
+
+namespace
+{
+    struct LessModifiedRangeOffset
+    {
+        bool operator() (const BufferData::ModifiedRange& lhs, const BufferData::ModifiedRange& rhs) const { return lhs.offset < rhs.offset; }
+    };
+}
+
+bool BufferData::getModifiedRangesSince(unsigned int modifiedCount, ModifiedRanges& ranges) const
+{
+    ranges.clear();
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(getModifiedRangesMutex());
+
+        if (modifiedCount==_modifiedCount) return true;
+        if (modifiedCount<_modifiedRangesBaseCount || modifiedCount>_modifiedCount) return false;
+
+        for(ModifiedRanges::const_iterator itr = _modifiedRanges.begin();
+            itr != _modifiedRanges.end();
+            ++itr)
+        {
+            if (itr->modifiedCount>modifiedCount) ranges.push_back(*itr);
+        }
+    }
+
+    if (ranges.size()<2) return true;
+
+    std::sort(ranges.begin(), ranges.end(), LessModifiedRangeOffset());
+
+    // merge overlapping and adjacent ranges in place
+    ModifiedRanges::iterator merged = ranges.begin();
+    for(ModifiedRanges::iterator itr = ranges.begin()+1;
+        itr != ranges.end();
+        ++itr)
+    {
+        if (itr->offset <= merged->end())
+        {
+            unsigned int end = osg::maximum(merged->end(), itr->end());
+            merged->size = end - merged->offset;
+            merged->modifiedCount = osg::maximum(merged->modifiedCount, itr->modifiedCount);
+        }
+        else
+        {
+            *(++merged) = *itr;
+        }
+    }
+    ranges.erase(merged+1, ranges.end());
+
+    return true;
+}
+
 void BufferData::setBufferObject(BufferObject* bufferObject)
 {
     if (_bufferObject==bufferObject) return;
@@ -12,31 +12,298 @@
 */
 #include <osg/DeleteHandler>
 #include <osg/Notify>
+#include <osg/BufferObject>
+
+#include <OpenThreads/Thread>
+#include <OpenThreads/Condition>
+#include <OpenThreads/ScopedLock>
 
 namespace osg
 {
 
+/////////////////////////////////////////////////////////////////////////////
+//
+//  DeleteThread
+//
+class DeleteHandler::DeleteThread : public OpenThreads::Thread
+{
+    public:
+
+        DeleteThread(DeleteHandler* deleteHandler):
+            _deleteHandler(deleteHandler),
+            _done(false),
+            _numObjectsPending(0) {}
+
+        virtual ~DeleteThread()
+        {
+            setDone();
+            join();
+        }
+
+        void setDone()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+            _done = true;
+            _queueCondition.signal();
+        }
+
+        /** Add the objects in deletionList to the end of the queue, leaving deletionList empty.*/
+        void add(DeletionList& deletionList)
+        {
+            if (deletionList.empty()) return;
+
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+
+            _numObjectsPending += static_cast<unsigned int>(deletionList.size());
+
+            _batches.push_back(Batch());
+            _batches.back().releaseTick = osg::Timer::instance()->tick();
+            _batches.back().objects.swap(deletionList);
+
+            _queueCondition.signal();
+        }
+
+        /** Delete all queued objects in the calling thread, waiting for any slice the background thread is running to complete.*/
+        void deleteAll()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> sliceLock(_sliceMutex);
+
+            Batches batches;
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+                batches.swap(_batches);
+                _numObjectsPending = 0;
+            }
+
+            for(Batches::iterator itr = batches.begin();
+                itr != batches.end();
+                ++itr)
+            {
+                _deleteHandler->deleteObjects(itr->objects, itr->releaseTick);
+            }
+        }
+
+        unsigned int getNumObjectsPending()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+            return _numObjectsPending;
+        }
+
+        virtual void run()
+        {
+            while(true)
+            {
+                Batch batch;
+                {
+                    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+                    while(_batches.empty() && !_done)
+                    {
+                        _queueCondition.wait(&_queueMutex);
+                    }
+
+                    if (_done) break;
+
+                    batch.releaseTick = _batches.front().releaseTick;
+                    batch.objects.swap(_batches.front().objects);
+                    _batches.pop_front();
+                }
+
+                unsigned int numObjects = static_cast<unsigned int>(batch.objects.size());
+                {
+                    OpenThreads::ScopedLock<OpenThreads::Mutex> sliceLock(_sliceMutex);
+                    _deleteHandler->deleteObjects(batch.objects, batch.releaseTick, _deleteHandler->getBackgroundDeleteTimeBudget());
+                }
+                unsigned int numDeleted = numObjects - static_cast<unsigned int>(batch.objects.size());
+
+                bool budgetExhausted = !batch.objects.empty();
+                {
+                    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_queueMutex);
+
+                    _numObjectsPending -= numDeleted;
+
+                    // return the objects that didn't fit in this slice to the front of the queue.
+                    if (budgetExhausted)
+                    {
+                        _batches.push_front(Batch());
+                        _batches.front().releaseTick = batch.releaseTick;
+                        _batches.front().objects.swap(batch.objects);
+                    }
+                }
+
+                // give the frame threads a chance to run before starting on the next slice.
+                if (budgetExhausted) OpenThreads::Thread::microSleep(1000);
+            }
+        }
+
+    protected:
+
+        struct Batch
+        {
+            Batch(): releaseTick(0) {}
+
+            osg::Timer_t releaseTick;
+            DeletionList objects;
+        };
+
+        typedef std::list<Batch> Batches;
+
+        DeleteHandler*              _deleteHandler;
+
+        OpenThreads::Mutex          _queueMutex;
+        OpenThreads::Condition      _queueCondition;
+        bool                        _done;
+        Batches                     _batches;
+        unsigned int                _numObjectsPending;
+
+        OpenThreads::Mutex          _sliceMutex;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  DeleteHandler
+//
 DeleteHandler::DeleteHandler(int numberOfFramesToRetainObjects):
     _numFramesToRetainObjects(numberOfFramesToRetainObjects),
-    _currentFrameNumber(0)
+    _currentFrameNumber(0),
+    _backgroundDeleteTimeBudget(0.002),
+    _backgroundThread(0)
 {
 }
 
 DeleteHandler::~DeleteHandler()
 {
     // flushAll();
+
+    // stop the background thread and delete the objects it still had queued, deleting any children they release straight away.
+    _numFramesToRetainObjects = 0;
+    setDeleteInBackgroundThread(false);
+
+    // free the pending requests, the objects they refer to being left as they were before.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    takePendingDeletes();
+}
+
+void DeleteHandler::setDeleteInBackgroundThread(bool flag)
+{
+    if (flag)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        if (_backgroundThread) return;
+
+        _backgroundThread = new DeleteThread(this);
+        _backgroundThread->setSchedulePriority(OpenThreads::Thread::THREAD_PRIORITY_LOW);
+        _backgroundThread->start();
+    }
+    else
+    {
+        DeleteThread* backgroundThread = 0;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            backgroundThread = _backgroundThread;
+            _backgroundThread = 0;
+        }
+
+        if (!backgroundThread) return;
+
+        // stop the thread outside the lock, as the objects it deletes may request the deletion of their children.
+        backgroundThread->setDone();
+        backgroundThread->join();
+
+        // delete anything the background thread still had queued.
+        backgroundThread->deleteAll();
+        delete backgroundThread;
+    }
+}
+
+bool DeleteHandler::getDeleteInBackgroundThread() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _backgroundThread!=0;
+}
+
+void DeleteHandler::takePendingDeletes()
+{
+    // detach the whole pending stack in one go, only threads holding _mutex take from the stack so there is no ABA problem.
+    void* head = 0;
+    do
+    {
+        head = _pendingDeletes.get();
+    } while(head && !_pendingDeletes.assign(0, head));
+
+    // the stack holds the most recent request first, so insert each entry at the same position to restore the order of the requests.
+    ObjectsToDeleteList::iterator insertPosition = _objectsToDelete.end();
+    PendingDelete* pending = static_cast<PendingDelete*>(head);
+    while(pending)
+    {
+        insertPosition = _objectsToDelete.insert(insertPosition, FrameNumberObjectPair(pending->frameNumber, pending->object));
+
+        PendingDelete* next = pending->next;
+        delete pending;
+        pending = next;
+    }
+}
+
+void DeleteHandler::deleteObjects(DeletionList& deletionList, osg::Timer_t releaseTick, double timeBudget)
+{
+    const osg::Timer* timer = osg::Timer::instance();
+    osg::Timer_t startTick = timer->tick();
+
+    unsigned int numObjectsDeleted = 0;
+    double numBytesReclaimed = 0.0;
+
+    while(!deletionList.empty())
+    {
+        const osg::Referenced* object = deletionList.front();
+        deletionList.pop_front();
+
+        const osg::BufferData* bufferData = dynamic_cast<const osg::BufferData*>(object);
+        if (bufferData) numBytesReclaimed += static_cast<double>(bufferData->getTotalDataSize());
+
+        doDelete(object);
+        ++numObjectsDeleted;
+
+        if (timeBudget>0.0 && timer->delta_s(startTick, timer->tick())>timeBudget) break;
+    }
+
+    if (numObjectsDeleted==0) return;
+
+    double latency = timer->delta_s(releaseTick, timer->tick());
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statisticsMutex);
+    _statistics.numObjectsDeleted += numObjectsDeleted;
+    _statistics.numBytesReclaimed += numBytesReclaimed;
+    _statistics.totalLatency += latency*static_cast<double>(numObjectsDeleted);
+    if (latency>_statistics.maximumLatency) _statistics.maximumLatency = latency;
+}
+
+DeleteHandler::Statistics DeleteHandler::takeStatistics()
+{
+    Statistics statistics;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statisticsMutex);
+        statistics = _statistics;
+        _statistics = Statistics();
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    if (_backgroundThread) statistics.numObjectsPending = _backgroundThread->getNumObjectsPending();
+
+    return statistics;
 }
 
 void DeleteHandler::flush()
 {
-    typedef std::list<const osg::Referenced*> DeletionList;
     DeletionList deletionList;
+    DeleteThread* backgroundThread = 0;
 
     {
         // gather all the objects to delete whilst holding the mutex to the _objectsToDelete
         // list, but delete the objects outside this scoped lock so that if any objects deleted
         // unref their children then no deadlock happens.
         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+        takePendingDeletes();
+
         unsigned int frameNumberToClearTo = _currentFrameNumber - _numFramesToRetainObjects;
 
         ObjectsToDeleteList::iterator itr;
@@ -52,15 +319,18 @@ void DeleteHandler::flush()
         }
 
         _objectsToDelete.erase( _objectsToDelete.begin(), itr);
+
+        backgroundThread = _backgroundThread;
     }
 
-    for(DeletionList::iterator ditr = deletionList.begin();
-        ditr != deletionList.end();
-        ++ditr)
+    if (backgroundThread)
     {
-        doDelete(*ditr);
+        backgroundThread->add(deletionList);
+    }
+    else if (!deletionList.empty())
+    {
+        deleteObjects(deletionList, osg::Timer::instance()->tick());
     }
-
 }
 
 void DeleteHandler::flushAll()
@@ -68,31 +338,41 @@ void DeleteHandler::flushAll()
     unsigned int temp_numFramesToRetainObjects = _numFramesToRetainObjects;
     _numFramesToRetainObjects = 0;
 
-    typedef std::list<const osg::Referenced*> DeletionList;
-    DeletionList deletionList;
-
+    DeleteThread* backgroundThread = 0;
     {
-        // gather all the objects to delete whilst holding the mutex to the _objectsToDelete
-        // list, but delete the objects outside this scoped lock so that if any objects deleted
-        // unref their children then no deadlock happens.
         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
-        ObjectsToDeleteList::iterator itr;
-        for(itr = _objectsToDelete.begin();
-            itr != _objectsToDelete.end();
-            ++itr)
+        backgroundThread = _backgroundThread;
+    }
+    if (backgroundThread) backgroundThread->deleteAll();
+
+    // deleting objects may request the deletion of their children, so repeat until nothing is left.
+    while(true)
+    {
+        DeletionList deletionList;
+
         {
-            deletionList.push_back(itr->second);
-            itr->second = 0;
+            // gather all the objects to delete whilst holding the mutex to the _objectsToDelete
+            // list, but delete the objects outside this scoped lock so that if any objects deleted
+            // unref their children then no deadlock happens.
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+            takePendingDeletes();
+
+            ObjectsToDeleteList::iterator itr;
+            for(itr = _objectsToDelete.begin();
+                itr != _objectsToDelete.end();
+                ++itr)
+            {
+                deletionList.push_back(itr->second);
+                itr->second = 0;
+            }
+
+            _objectsToDelete.erase( _objectsToDelete.begin(), _objectsToDelete.end());
         }
 
-        _objectsToDelete.erase( _objectsToDelete.begin(), _objectsToDelete.end());
-    }
+        if (deletionList.empty()) break;
 
-    for(DeletionList::iterator ditr = deletionList.begin();
-        ditr != deletionList.end();
-        ++ditr)
-    {
-        doDelete(*ditr);
+        deleteObjects(deletionList, osg::Timer::instance()->tick());
     }
 
     _numFramesToRetainObjects = temp_numFramesToRetainObjects;
@@ -100,11 +380,25 @@ void DeleteHandler::flushAll()
 
 void DeleteHandler::requestDelete(const osg::Referenced* object)
 {
-    if (_numFramesToRetainObjects==0) doDelete(object);
-    else
+    bool deleteLater = _numFramesToRetainObjects!=0;
+    if (!deleteLater)
     {
         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
-        _objectsToDelete.push_back(FrameNumberObjectPair(_currentFrameNumber,object));
+        deleteLater = _backgroundThread!=0;
+    }
+
+    if (!deleteLater) doDelete(object);
+    else
+    {
+        PendingDelete* pending = new PendingDelete(_currentFrameNumber, object);
+
+        // push onto the head of the pending stack without taking any locks.
+        void* head = 0;
+        do
+        {
+            head = _pendingDeletes.get();
+            pending->next = static_cast<PendingDelete*>(head);
+        } while(!_pendingDeletes.assign(pending, head));
     }
 }
 
@@ -109,6 +109,7 @@ void DisplaySettings::setDisplaySettings(const DisplaySettings& vs)
 
     _maxTexturePoolSize = vs._maxTexturePoolSize;
     _maxBufferObjectPoolSize = vs._maxBufferObjectPoolSize;
+    _glObjectPoolBudget = vs._glObjectPoolBudget;
 
     _implicitBufferAttachmentRenderMask = vs._implicitBufferAttachmentRenderMask;
     _implicitBufferAttachmentResolveMask = vs._implicitBufferAttachmentResolveMask;
@@ -156,6 +157,7 @@ void DisplaySettings::merge(const DisplaySettings& vs)
 
     if (vs._maxTexturePoolSize>_maxTexturePoolSize) _maxTexturePoolSize = vs._maxTexturePoolSize;
     if (vs._maxBufferObjectPoolSize>_maxBufferObjectPoolSize) _maxBufferObjectPoolSize = vs._maxBufferObjectPoolSize;
+    if (vs._glObjectPoolBudget>_glObjectPoolBudget) _glObjectPoolBudget = vs._glObjectPoolBudget;
 
     // these are bit masks so merging them is like logical or
     _implicitBufferAttachmentRenderMask |= vs._implicitBufferAttachmentRenderMask;
@@ -237,6 +239,7 @@ void DisplaySettings::setDefaults()
 
     _maxTexturePoolSize = 0;
     _maxBufferObjectPoolSize = 0;
+    _glObjectPoolBudget = 0;
 
     _implicitBufferAttachmentRenderMask = DEFAULT_IMPLICIT_BUFFER_ATTACHMENT;
     _implicitBufferAttachmentResolveMask = DEFAULT_IMPLICIT_BUFFER_ATTACHMENT;
@@ -403,6 +406,9 @@ static ApplicationUsageProxy DisplaySetting_e35(ApplicationUsage::ENVIRONMENTAL_
 static ApplicationUsageProxy DisplaySetting_e36(ApplicationUsage::ENVIRONMENTAL_VARIABLE,
         "OSG_TEXT_SHADER_TECHNIQUE <value>",
         "Set the defafult osgText::ShaderTechnique. ALL_FEATURES | ALL | GREYSCALE | SIGNED_DISTANCE_FIELD | SDF | NO_TEXT_SHADER | NONE");
+static ApplicationUsageProxy DisplaySetting_e37(ApplicationUsage::ENVIRONMENTAL_VARIABLE,
+        "OSG_GL_OBJECT_POOL_BUDGET <int>",
+        "Set the budget in bytes for the combined texture and buffer object pools, least recently used objects are evicted when exceeded.");
 
 void DisplaySettings::readEnvironmentalVariables()
 {
@@ -583,6 +589,8 @@ void DisplaySettings::readEnvironmentalVariables()
 
     getEnvVar("OSG_BUFFER_OBJECT_POOL_SIZE", _maxBufferObjectPoolSize);
 
+    getEnvVar("OSG_GL_OBJECT_POOL_BUDGET", _glObjectPoolBudget);
+
 
     {  // Read implicit buffer attachments combinations for both render and resolve mask
         const char * variable[] = {
@@ -858,6 +866,7 @@ void DisplaySettings::readCommandLine(ArgumentParser& arguments)
         arguments.getApplicationUsage()->addCommandLineOption("--keystone-off","Set the keystone hint to false.");
         arguments.getApplicationUsage()->addCommandLineOption("--menubar-behavior <behavior>","Set the menubar behavior (AUTO_HIDE | FORCE_HIDE | FORCE_SHOW)");
         arguments.getApplicationUsage()->addCommandLineOption("--sync","Enable sync of swap buffers");
+        arguments.getApplicationUsage()->addCommandLineOption("--gl-object-pool-budget <bytes>","Set the budget for the combined texture and buffer object pools, least recently used objects are evicted when exceeded.");
     }
 
     std::string str;
@@ -956,6 +965,7 @@ void DisplaySettings::readCommandLine(ArgumentParser& arguments)
 
     while(arguments.read("--texture-pool-size",_maxTexturePoolSize)) {}
     while(arguments.read("--buffer-object-pool-size",_maxBufferObjectPoolSize)) {}
+    while(arguments.read("--gl-object-pool-budget",_glObjectPoolBudget)) {}
 
     {  // Read implicit buffer attachments combinations for both render and resolve mask
         const char* option[] = {
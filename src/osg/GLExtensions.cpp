@@ -859,6 +859,7 @@ GLExtensions::GLExtensions(unsigned int in_contextID):
     isTextureCompressionETCSupported = validContext && isGLExtensionSupported(contextID,"GL_OES_compressed_ETC1_RGB8_texture");
     isTextureCompressionETC2Supported = validContext && isGLExtensionSupported(contextID,"GL_ARB_ES3_compatibility");
     isTextureCompressionRGTCSupported = validContext && isGLExtensionSupported(contextID,"GL_EXT_texture_compression_rgtc");
+    isTextureCompressionBPTCSupported = validContext && isGLExtensionOrVersionSupported(contextID,"GL_ARB_texture_compression_bptc", 4.2f);
     isTextureCompressionPVRTCSupported = validContext && isGLExtensionSupported(contextID,"GL_IMG_texture_compression_pvrtc");
 
     isTextureMirroredRepeatSupported = validContext &&
@@ -0,0 +1,159 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+#include <osg/GLObjectBudgetManager>
+#include <osg/ContextData>
+#include <osg/Texture>
+#include <osg/BufferObject>
+#include <osg/FrameStamp>
+#include <osg/Timer>
+#include <osg/Notify>
+
+#include <algorithm>
+
+using namespace osg;
+
+namespace
+{
+
+struct EvictionCandidate
+{
+    EvictionCandidate(Texture::TextureObject* to):
+        frameLastUsed(to->_frameLastUsed), size(to->size()), textureObject(to), glBufferObject(0) {}
+
+    EvictionCandidate(GLBufferObject* glbo):
+        frameLastUsed(glbo->_frameLastUsed), size(glbo->getProfile()._size), textureObject(0), glBufferObject(glbo) {}
+
+    bool operator < (const EvictionCandidate& rhs) const { return frameLastUsed < rhs.frameLastUsed; }
+
+    unsigned int            frameLastUsed;
+    unsigned int            size;
+    Texture::TextureObject* textureObject;
+    GLBufferObject*         glBufferObject;
+};
+
+typedef std::vector<EvictionCandidate> EvictionCandidates;
+
+}
+
+GLObjectBudgetManager::GLObjectBudgetManager(unsigned int contextID):
+    GraphicsObjectManager("GLObjectBudgetManager", contextID),
+    _budget(0),
+    _minimumFramesUnused(60),
+    _evictGLBufferObjects(true),
+    _frameNumber(0),
+    _numEvictedLastFrame(0),
+    _sizeEvictedLastFrame(0),
+    _numEvicted(0),
+    _sizeEvicted(0.0)
+{
+}
+
+GLObjectBudgetManager::~GLObjectBudgetManager()
+{
+}
+
+unsigned int GLObjectBudgetManager::getCurrentPoolSize() const
+{
+    return osg::get<TextureObjectManager>(_contextID)->getCurrTexturePoolSize() +
+           osg::get<GLBufferObjectManager>(_contextID)->getCurrGLBufferObjectPoolSize();
+}
+
+void GLObjectBudgetManager::newFrame(osg::FrameStamp* fs)
+{
+    if (fs) _frameNumber = fs->getFrameNumber();
+    else ++_frameNumber;
+
+    _numEvictedLastFrame = 0;
+    _sizeEvictedLastFrame = 0;
+}
+
+void GLObjectBudgetManager::resetStats()
+{
+    _numEvicted = 0;
+    _sizeEvicted = 0.0;
+}
+
+void GLObjectBudgetManager::reportStats(std::ostream& out)
+{
+    out<<"GLObjectBudgetManager::reportStats()"<<std::endl;
+    out<<"   _budget="<<_budget<<", currentPoolSize="<<getCurrentPoolSize()<<std::endl;
+    out<<"   total _numEvicted="<<_numEvicted<<", _sizeEvicted="<<_sizeEvicted<<std::endl;
+}
+
+void GLObjectBudgetManager::flushDeletedGLObjects(double /*currentTime*/, double& availableTime)
+{
+    if (_budget==0) return;
+
+    unsigned int currentSize = getCurrentPoolSize();
+    if (currentSize<=_budget) return;
+
+    // no time left to delete the evicted objects in.
+    if (availableTime<=0.0) return;
+
+    if (_frameNumber<_minimumFramesUnused) return;
+
+    unsigned int frameThreshold = _frameNumber - _minimumFramesUnused;
+
+    TextureObjectManager* tom = osg::get<TextureObjectManager>(_contextID);
+    GLBufferObjectManager* bom = osg::get<GLBufferObjectManager>(_contextID);
+
+    std::vector<Texture::TextureObject*> textureObjects;
+    tom->collectLeastRecentlyUsed(frameThreshold, textureObjects);
+
+    std::vector<GLBufferObject*> glBufferObjects;
+    if (_evictGLBufferObjects) bom->collectLeastRecentlyUsed(frameThreshold, glBufferObjects);
+
+    if (textureObjects.empty() && glBufferObjects.empty()) return;
+
+    EvictionCandidates candidates;
+    candidates.reserve(textureObjects.size()+glBufferObjects.size());
+    candidates.insert(candidates.end(), textureObjects.begin(), textureObjects.end());
+    candidates.insert(candidates.end(), glBufferObjects.begin(), glBufferObjects.end());
+
+    // merge the per set least recently used lists into a single ordering across all sets.
+    std::stable_sort(candidates.begin(), candidates.end());
+
+    unsigned int sizeRequired = currentSize - _budget;
+    unsigned int sizeEvicted = 0;
+    unsigned int numEvicted = 0;
+
+    // the sets delete the evicted objects straight away, so stop once the time available has been used up,
+    // leaving the rest for the following frames.
+    ElapsedTime timer;
+
+    for(EvictionCandidates::iterator itr = candidates.begin();
+        itr != candidates.end() && sizeEvicted<sizeRequired && timer.elapsedTime()<availableTime;
+        ++itr)
+    {
+        bool evicted = itr->textureObject ?
+            itr->textureObject->_set->evict(itr->textureObject) :
+            itr->glBufferObject->_set->evict(itr->glBufferObject);
+
+        if (evicted)
+        {
+            sizeEvicted += itr->size;
+            ++numEvicted;
+        }
+    }
+
+    availableTime -= timer.elapsedTime();
+
+    if (numEvicted==0) return;
+
+    OSG_INFO<<"GLObjectBudgetManager::flushDeletedGLObjects() evicted "<<numEvicted<<" objects, "<<sizeEvicted<<" bytes, budget="<<_budget<<std::endl;
+
+    _numEvictedLastFrame += numEvicted;
+    _sizeEvictedLastFrame += sizeEvicted;
+    _numEvicted += numEvicted;
+    _sizeEvicted += double(sizeEvicted);
+}
@@ -43,6 +43,9 @@ void GeometryCostEstimator::setDefaults()
 
     _displayListCompileConstant = 0.0;
     _displayListCompileFactor = 10.0;
+
+    _cpuCompileCorrection.reset();
+    _gpuCompileCorrection.reset();
 }
 
 void GeometryCostEstimator::calibrate(osg::RenderInfo& /*renderInfo*/)
@@ -83,7 +86,7 @@ CostPair GeometryCostEstimator::estimateCompileCost(const osg::Geometry* geometr
             cost.first = _displayListCompileConstant + _displayListCompileFactor * cost.first ;
         }
 
-        return cost;
+        return CostPair(_cpuCompileCorrection(cost.first), _gpuCompileCorrection(cost.second));
     }
     else
     {
@@ -96,6 +99,12 @@ CostPair GeometryCostEstimator::estimateDrawCost(const osg::Geometry* /*geometry
     return CostPair(0.0,0.0);
 }
 
+void GeometryCostEstimator::refineCompileCost(const CostPair& estimatedCost, const CostPair& measuredCost)
+{
+    _cpuCompileCorrection.refine(estimatedCost.first, measuredCost.first);
+    _gpuCompileCorrection.refine(estimatedCost.second, measuredCost.second);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 //
 // TextureCostEstimator
@@ -112,6 +121,9 @@ void TextureCostEstimator::setDefaults()
     double min_time = 0.00001; // 10 nano seconds.
     _compileCost.set(min_time, 1.0/transfer_bandwidth, 256); // min time 1/10th of millisecond, min size 256
     _drawCost.set(min_time, 1.0/gpu_bandwidth, 256); // min time 1/10th of millisecond, min size 256
+
+    _cpuCompileCorrection.reset();
+    _gpuCompileCorrection.reset();
 }
 
 void TextureCostEstimator::calibrate(osg::RenderInfo& /*renderInfo*/)
@@ -126,8 +138,8 @@ CostPair TextureCostEstimator::estimateCompileCost(const osg::Texture* texture)
         const osg::Image* image = texture->getImage(i);
         if (image) cost.first += _compileCost(image->getTotalDataSize());
     }
-    OSG_NOTICE<<"TextureCostEstimator::estimateCompileCost(), size="<<cost.first<<std::endl;
-    return cost;
+    OSG_DEBUG<<"TextureCostEstimator::estimateCompileCost(), size="<<cost.first<<std::endl;
+    return CostPair(_cpuCompileCorrection(cost.first), _gpuCompileCorrection(cost.second));
 }
 
 CostPair TextureCostEstimator::estimateDrawCost(const osg::Texture* /*texture*/) const
@@ -135,25 +147,56 @@ CostPair TextureCostEstimator::estimateDrawCost(const osg::Texture* /*texture*/)
     return CostPair(0.0,0.0);
 }
 
+void TextureCostEstimator::refineCompileCost(const CostPair& estimatedCost, const CostPair& measuredCost)
+{
+    _cpuCompileCorrection.refine(estimatedCost.first, measuredCost.first);
+    _gpuCompileCorrection.refine(estimatedCost.second, measuredCost.second);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 //
 // ProgramCostEstimator
 //
 ProgramCostEstimator::ProgramCostEstimator()
 {
+    setDefaults();
 }
 
 void ProgramCostEstimator::setDefaults()
 {
+    double shader_compile_rate = 10000000.0; // 10 million characters/second
+    double min_time = 0.0005; // half a millisecond per shader, drivers have a high fixed cost to shader compiles.
+    _shaderCompileCost.set(min_time, 1.0/shader_compile_rate, 1024); // min size 1024 characters
+    _linkCost.set(min_time, min_time, 1); // half a millisecond for the first shader, then another half per additional shader
+    _drawCost.set(0.0, 0.0, 0);
+
+    _cpuCompileCorrection.reset();
+    _gpuCompileCorrection.reset();
 }
 
 void ProgramCostEstimator::calibrate(osg::RenderInfo& /*renderInfo*/)
 {
 }
 
-CostPair ProgramCostEstimator::estimateCompileCost(const osg::Program* /*program*/) const
+CostPair ProgramCostEstimator::estimateCompileCost(const osg::Program* program) const
 {
-    return CostPair(0.0,0.0);
+    CostPair cost(0.0, 0.0);
+    if (!program || program->getNumShaders()==0) return cost;
+
+    for(unsigned int i=0; i<program->getNumShaders(); ++i)
+    {
+        const osg::Shader* shader = program->getShader(i);
+        if (shader) cost.first += _shaderCompileCost(static_cast<unsigned int>(shader->getShaderSource().size()));
+    }
+    cost.first += _linkCost(program->getNumShaders());
+
+    return CostPair(_cpuCompileCorrection(cost.first), _gpuCompileCorrection(cost.second));
+}
+
+void ProgramCostEstimator::refineCompileCost(const CostPair& estimatedCost, const CostPair& measuredCost)
+{
+    _cpuCompileCorrection.refine(estimatedCost.first, measuredCost.first);
+    _gpuCompileCorrection.refine(estimatedCost.second, measuredCost.second);
 }
 
 CostPair ProgramCostEstimator::estimateDrawCost(const osg::Program* /*program*/) const
@@ -16,6 +16,9 @@
 #include <osg/GraphicsContext>
 #include <osg/GLObjects>
 #include <osg/Notify>
+#include <osg/Profiler>
+
+#include <sstream>
 
 using namespace osg;
 using namespace OpenThreads;
@@ -33,6 +36,10 @@ void GraphicsThread::run()
         graphicsContext->makeCurrent();
 
         graphicsContext->getState()->initializeExtensionProcs();
+
+        std::ostringstream name;
+        name<<"GraphicsThread "<<graphicsContext->getState()->getContextID();
+        Profiler::instance()->setThreadName(name.str());
     }
 
     OperationThread::run();
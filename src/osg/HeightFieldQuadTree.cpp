@@ -0,0 +1,220 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/HeightFieldQuadTree>
+
+using namespace osg;
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// HeightFieldQuadTree
+//
+HeightFieldQuadTree::HeightFieldQuadTree():
+    _numColumns(0),
+    _numRows(0),
+    _skirtHeight(0.0f),
+    _modifiedCount(0)
+{
+}
+
+HeightFieldQuadTree::~HeightFieldQuadTree()
+{
+}
+
+bool HeightFieldQuadTree::build(const HeightField* field)
+{
+    _levels.clear();
+    _heights = 0;
+
+    if (!field || !field->getFloatArray()) return false;
+
+    _numColumns = field->getNumColumns();
+    _numRows = field->getNumRows();
+    _skirtHeight = field->getSkirtHeight();
+    _modifiedCount = field->getFloatArray()->getModifiedCount();
+
+    if (_numColumns<2 || _numRows<2 || field->getFloatArray()->size()<_numColumns*_numRows) return false;
+
+    _heights = field->getFloatArray();
+
+    const unsigned int numCellColumns = getNumCellColumns();
+    const unsigned int numCellRows = getNumCellRows();
+
+    // level 0 holds the range of the samples at the corners of each block's cells.
+    Level level0;
+    level0.blockSize = LEAF_SIZE;
+    level0.numColumns = (numCellColumns+LEAF_SIZE-1)/LEAF_SIZE;
+    level0.numRows = (numCellRows+LEAF_SIZE-1)/LEAF_SIZE;
+    level0.blocks.resize(level0.numColumns*level0.numRows);
+
+    for(unsigned int br=0; br<level0.numRows; ++br)
+    {
+        unsigned int r0 = br*LEAF_SIZE;
+        unsigned int r1 = osg::minimum(r0+LEAF_SIZE, numCellRows);
+        for(unsigned int bc=0; bc<level0.numColumns; ++bc)
+        {
+            unsigned int c0 = bc*LEAF_SIZE;
+            unsigned int c1 = osg::minimum(c0+LEAF_SIZE, numCellColumns);
+
+            MinMax& mm = level0.blocks[bc + br*level0.numColumns];
+            for(unsigned int r=r0; r<=r1; ++r)
+            {
+                const float* h = &(*_heights)[r*_numColumns];
+                for(unsigned int c=c0; c<=c1; ++c)
+                {
+                    mm.expandBy(h[c]);
+                }
+            }
+
+            if (c0==0 || r0==0 || c1==numCellColumns || r1==numCellRows) addSkirt(mm);
+        }
+    }
+
+    _levels.push_back(level0);
+
+    // each level above merges 2x2 blocks of the level beneath until a single block remains.
+    while(_levels.back().numColumns>1 || _levels.back().numRows>1)
+    {
+        const Level& below = _levels.back();
+
+        Level level;
+        level.blockSize = below.blockSize*2;
+        level.numColumns = (below.numColumns+1)/2;
+        level.numRows = (below.numRows+1)/2;
+        level.blocks.resize(level.numColumns*level.numRows);
+
+        for(unsigned int r=0; r<below.numRows; ++r)
+        {
+            for(unsigned int c=0; c<below.numColumns; ++c)
+            {
+                const MinMax& child = below.blocks[c + r*below.numColumns];
+                MinMax& mm = level.blocks[c/2 + (r/2)*level.numColumns];
+                mm.expandBy(child.minimum);
+                mm.expandBy(child.maximum);
+            }
+        }
+
+        _levels.push_back(level);
+    }
+
+    return true;
+}
+
+bool HeightFieldQuadTree::valid(const HeightField* field) const
+{
+    return field && !_levels.empty() &&
+           field->getFloatArray()==_heights.get() &&
+           field->getFloatArray()->getModifiedCount()==_modifiedCount &&
+           field->getNumColumns()==_numColumns &&
+           field->getNumRows()==_numRows &&
+           field->getSkirtHeight()==_skirtHeight;
+}
+
+Matrixd HeightFieldQuadTree::computeGridMatrix(const HeightField& field)
+{
+    return Matrixd::scale(field.getXInterval(), field.getYInterval(), 1.0) *
+           field.computeRotationMatrix() *
+           Matrixd::translate(field.getOrigin());
+}
+
+unsigned int HeightFieldQuadTree::getSizeInBytes() const
+{
+    unsigned int size = sizeof(HeightFieldQuadTree);
+    for(Levels::const_iterator itr = _levels.begin();
+        itr != _levels.end();
+        ++itr)
+    {
+        size += sizeof(Level) + static_cast<unsigned int>(itr->blocks.size()*sizeof(MinMax));
+    }
+    return size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// HeightFieldGeometryLayout
+//
+HeightFieldGeometryLayout::HeightFieldGeometryLayout():
+    _numColumns(0),
+    _numRows(0),
+    _skirt(false),
+    _firstRowVertex(0),
+    _firstRowTriangle(0),
+    _rowVertices(0),
+    _rowTriangles(0)
+{
+}
+
+bool HeightFieldGeometryLayout::set(const HeightField& field, const Geometry& geometry)
+{
+    _numColumns = field.getNumColumns();
+    _numRows = field.getNumRows();
+    if (_numColumns<2 || _numRows<2) return false;
+
+    // BuildShapeGeometryVisitor::apply(const HeightField&) emits the bottom and top skirts as quad strips of
+    // 2*numColumns vertices, then each row of cells as a quad strip, with a quad of skirt at either end, each
+    // quad strip then being converted to pairs of triangles.
+    _skirt = field.getSkirtHeight()!=0.0f;
+    _firstRowVertex = _skirt ? 4*_numColumns : 0;
+    _firstRowTriangle = _skirt ? 4*(_numColumns-1) : 0;
+    _rowVertices = 2*_numColumns + (_skirt ? 4 : 0);
+    _rowTriangles = 2*(_numColumns-1) + (_skirt ? 4 : 0);
+
+    const Array* vertices = geometry.getVertexArray();
+    return vertices && vertices->getNumElements()==_firstRowVertex + (_numRows-1)*_rowVertices;
+}
+
+// quad p0 p1 p2 p3 of a strip is drawn as the triangles p0 p1 p2 and p1 p3 p2.
+static inline unsigned int addQuad(unsigned int p0, unsigned int p1, unsigned int p2, unsigned int p3, unsigned int triangle,
+                                   unsigned int* vertexIndices, unsigned int* primitiveIndices)
+{
+    vertexIndices[0] = p0; vertexIndices[1] = p1; vertexIndices[2] = p2;
+    vertexIndices[3] = p1; vertexIndices[4] = p3; vertexIndices[5] = p2;
+    primitiveIndices[0] = triangle;
+    primitiveIndices[1] = triangle+1;
+    return 2;
+}
+
+unsigned int HeightFieldGeometryLayout::getCellTriangles(unsigned int c, unsigned int r, unsigned int* vertexIndices, unsigned int* primitiveIndices) const
+{
+    unsigned int rowVertex = _firstRowVertex + r*_rowVertices;
+    unsigned int rowTriangle = _firstRowTriangle + r*_rowTriangles;
+    unsigned int skirtOffset = _skirt ? 2 : 0;
+
+    // each column of a row's strip holds the vertex on row r+1 followed by the one on row r.
+    unsigned int top = rowVertex + skirtOffset + 2*c;
+    unsigned int n = addQuad(top, top+1, top+2, top+3, rowTriangle + skirtOffset + 2*c, vertexIndices, primitiveIndices);
+
+    if (_skirt)
+    {
+        if (c==0)
+        {
+            n += addQuad(rowVertex, rowVertex+1, rowVertex+2, rowVertex+3, rowTriangle, vertexIndices+n*3, primitiveIndices+n);
+        }
+        if (c+2==_numColumns)
+        {
+            unsigned int last = rowVertex + skirtOffset + 2*(_numColumns-1);
+            n += addQuad(last, last+1, last+2, last+3, rowTriangle + skirtOffset + 2*(_numColumns-1), vertexIndices+n*3, primitiveIndices+n);
+        }
+        if (r==0)
+        {
+            n += addQuad(2*c, 2*c+1, 2*c+2, 2*c+3, 2*c, vertexIndices+n*3, primitiveIndices+n);
+        }
+        if (r+2==_numRows)
+        {
+            unsigned int first = 2*_numColumns + 2*c;
+            n += addQuad(first, first+1, first+2, first+3, 2*(_numColumns-1) + 2*c, vertexIndices+n*3, primitiveIndices+n);
+        }
+    }
+
+    return n;
+}
@@ -14,6 +14,7 @@
 #include <osg/GLU>
 
 #include <osg/Image>
+#include <osg/ImageUtils>
 #include <osg/Notify>
 #include <osg/io_utils>
 
@@ -544,6 +545,8 @@ unsigned int Image::computeNumComponents(GLenum pixelFormat)
         case(GL_COMPRESSED_RED_RGTC1_EXT):   return 1;
         case(GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT): return 2;
         case(GL_COMPRESSED_RED_GREEN_RGTC2_EXT): return 2;
+        case(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB): return 4;
+        case(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB): return 4;
         case(GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG): return 3;
         case(GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG): return 3;
         case(GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG): return 4;
@@ -726,6 +729,8 @@ unsigned int Image::computePixelSizeInBits(GLenum format,GLenum type)
         case(GL_COMPRESSED_RED_RGTC1_EXT):   return 4;
         case(GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT): return 8;
         case(GL_COMPRESSED_RED_GREEN_RGTC2_EXT): return 8;
+        case(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB): return 8;
+        case(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB): return 8;
         case(GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG): return 4;
         case(GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG): return 2;
         case(GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG): return 4;
@@ -885,6 +890,8 @@ osg::Vec3i Image::computeBlockFootprint(GLenum pixelFormat)
         case(GL_COMPRESSED_RED_RGTC1_EXT) :
         case(GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT) :
         case(GL_COMPRESSED_RED_GREEN_RGTC2_EXT) :
+        case(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB) :
+        case(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB) :
         case(GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG) :
         case(GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG) :
         case(GL_ETC1_RGB8_OES) :
@@ -958,6 +965,8 @@ unsigned int Image::computeBlockSize(GLenum pixelFormat, GLenum packing)
             break;
         case(GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT):
         case(GL_COMPRESSED_RED_GREEN_RGTC2_EXT):
+        case(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB):
+        case(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB):
             return osg::maximum(16u,packing); // block size of 16
 
         case(GL_COMPRESSED_RGB8_ETC2):
@@ -1102,6 +1111,8 @@ bool Image::isCompressed() const
         case(GL_COMPRESSED_RED_RGTC1_EXT):
         case(GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT):
         case(GL_COMPRESSED_RED_GREEN_RGTC2_EXT):
+        case(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB):
+        case(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB):
         case(GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG):
         case(GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG):
         case(GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG):
@@ -1609,20 +1620,31 @@ void Image::scaleImage(int s,int t,int r, GLenum newDataType)
         return;
     }
 
-    PixelStorageModes psm;
-    psm.pack_alignment = _packing;
-    psm.pack_row_length = _rowLength;
-    psm.unpack_alignment = _packing;
+    GLint status = 0;
+    bool resampled = isResampleSupported(_pixelFormat, _dataType) && isResampleSupported(_pixelFormat, newDataType) &&
+                     resampleImageData(_pixelFormat,
+                        _s, _t, _dataType, _data, getRowStepInBytes(),
+                        s, t, newDataType, newData, computeRowWidthInBytes(s,_pixelFormat,newDataType,_packing),
+                        RESAMPLE_BILINEAR);
 
-    GLint status = gluScaleImage(&psm, _pixelFormat,
-        _s,
-        _t,
-        _dataType,
-        _data,
-        s,
-        t,
-        newDataType,
-        newData);
+    // fall back to gluScaleImage when the formats can't be resampled directly.
+    if (!resampled)
+    {
+        PixelStorageModes psm;
+        psm.pack_alignment = _packing;
+        psm.pack_row_length = _rowLength;
+        psm.unpack_alignment = _packing;
+
+        status = gluScaleImage(&psm, _pixelFormat,
+            _s,
+            _t,
+            _dataType,
+            _data,
+            s,
+            t,
+            newDataType,
+            newData);
+    }
 
     if (status==0)
     {
@@ -1709,6 +1731,18 @@ void Image::copySubImage(int s_offset, int t_offset, int r_offset, const osg::Im
         }
         return;
     }
+
+    if (isResampleSupported(_pixelFormat, source->getDataType()) && isResampleSupported(_pixelFormat, _dataType))
+    {
+        // same sized box filtered resample is a straight copy with data type conversion, clipped to the destination.
+        int copy_width = osg::minimum(source->s(), _s - s_offset);
+        int copy_height = osg::minimum(source->t(), _t - t_offset);
+        if (resampleImageData(_pixelFormat,
+            copy_width, copy_height, source->getDataType(), source->data(), source->getRowStepInBytes(),
+            copy_width, copy_height, _dataType, data_destination, getRowStepInBytes(),
+            RESAMPLE_BOX)) return;
+    }
+
     PixelStorageModes psm;
     psm.pack_alignment = _packing;
     psm.pack_row_length = _rowLength!=0 ? _rowLength : _s;
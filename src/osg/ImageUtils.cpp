@@ -13,6 +13,8 @@
 
 #include <float.h>
 #include <string.h>
+#include <algorithm>
+#include <vector>
 
 #include <osg/Math>
 #include <osg/ImageUtils>
@@ -20,6 +22,10 @@
 
 #include <osg/Notify>
 #include <osg/io_utils>
+#include <osg/OperationThread>
+
+#include <OpenThreads/Thread>
+#include <OpenThreads/ScopedLock>
 #include "dxtctool.h"
 
 namespace osg
@@ -797,5 +803,547 @@ OSG_EXPORT osg::Image* createImageWithOrientationConversion(const osg::Image* sr
     return dstImage.release();
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Image resampling
+//
+namespace
+{
+
+float resampleFilterSupport(ResampleFilter filter)
+{
+    switch(filter)
+    {
+        case(RESAMPLE_BOX):      return 0.5f;
+        case(RESAMPLE_BILINEAR): return 1.0f;
+        case(RESAMPLE_LANCZOS):  return 3.0f;
+    }
+    return 1.0f;
+}
+
+float resampleFilterWeight(ResampleFilter filter, float x)
+{
+    switch(filter)
+    {
+        case(RESAMPLE_BOX):
+        {
+            return (x>-0.5f && x<=0.5f) ? 1.0f : 0.0f;
+        }
+        case(RESAMPLE_BILINEAR):
+        {
+            x = fabsf(x);
+            return x<1.0f ? 1.0f-x : 0.0f;
+        }
+        case(RESAMPLE_LANCZOS):
+        {
+            x = fabsf(x);
+            if (x<1e-5f) return 1.0f;
+            if (x>=3.0f) return 0.0f;
+            float pix = osg::PIf*x;
+            return 3.0f*sinf(pix)*sinf(pix/3.0f)/(pix*pix);
+        }
+    }
+    return 0.0f;
+}
+
+/** Normalized filter weights for each destination pixel along one axis, the source positions
+  * outside of the image are clamped to the edge pixels.*/
+struct ResampleContributions
+{
+    ResampleContributions(int srcSize, int dstSize, ResampleFilter filter)
+    {
+        float scale = float(dstSize)/float(srcSize);
+        float filterScale = scale<1.0f ? 1.0f/scale : 1.0f;
+        float radius = resampleFilterSupport(filter)*filterScale;
+
+        maxTaps = static_cast<int>(ceilf(radius*2.0f))+2;
+        first.resize(dstSize);
+        numTaps.resize(dstSize);
+        weights.resize(dstSize*maxTaps, 0.0f);
+
+        for(int i=0; i<dstSize; ++i)
+        {
+            float center = (float(i)+0.5f)/scale;
+            int start = static_cast<int>(floorf(center-radius));
+            int end = static_cast<int>(ceilf(center+radius));
+
+            int lo = osg::clampBetween(start, 0, srcSize-1);
+            int hi = osg::clampBetween(end-1, 0, srcSize-1);
+
+            float* w = &weights[i*maxTaps];
+            float total = 0.0f;
+            for(int j=start; j<end; ++j)
+            {
+                float weight = resampleFilterWeight(filter, (float(j)+0.5f-center)/filterScale);
+                if (weight==0.0f) continue;
+
+                w[osg::clampBetween(j, 0, srcSize-1)-lo] += weight;
+                total += weight;
+            }
+
+            if (total>0.0f)
+            {
+                float inv_total = 1.0f/total;
+                for(int k=0; k<=hi-lo; ++k) w[k] *= inv_total;
+            }
+            else
+            {
+                // fallback to nearest neighbour
+                w[osg::clampBetween(static_cast<int>(center), lo, hi)-lo] = 1.0f;
+            }
+
+            first[i] = lo;
+            numTaps[i] = hi-lo+1;
+        }
+    }
+
+    int                 maxTaps;
+    std::vector<int>    first;
+    std::vector<int>    numTaps;
+    std::vector<float>  weights;
+};
+
+struct ResampleDataType
+{
+    ResampleDataType(): supported(false), toFloat(1.0f), fromFloat(1.0f), minValue(-FLT_MAX), maxValue(FLT_MAX) {}
+
+    ResampleDataType(GLenum dataType): supported(true), toFloat(1.0f), fromFloat(1.0f), minValue(-FLT_MAX), maxValue(FLT_MAX)
+    {
+        // the scale factors match those of CastAndScaleToFloatOperation, the maximum values of the 32bit types are clamped
+        // to the largest floats that are exactly representable in them.
+        switch(dataType)
+        {
+            case(GL_BYTE):              set(128.0f, -128.0f, 127.0f); break;
+            case(GL_UNSIGNED_BYTE):     set(255.0f, 0.0f, 255.0f); break;
+            case(GL_SHORT):             set(32768.0f, -32768.0f, 32767.0f); break;
+            case(GL_UNSIGNED_SHORT):    set(65535.0f, 0.0f, 65535.0f); break;
+            case(GL_INT):               set(2147483648.0f, -2147483648.0f, 2147483520.0f); break;
+            case(GL_UNSIGNED_INT):      set(4294967295.0f, 0.0f, 4294967040.0f); break;
+            case(GL_FLOAT):             break;
+            default:                    supported = false; break;
+        }
+    }
+
+    void set(float scale, float minV, float maxV)
+    {
+        toFloat = 1.0f/scale;
+        fromFloat = scale;
+        minValue = minV;
+        maxValue = maxV;
+    }
+
+    bool    supported;
+    float   toFloat;
+    float   fromFloat;
+    float   minValue;
+    float   maxValue;
+};
+
+template<typename T>
+void readResampleRow(const unsigned char* src, float* dst, unsigned int num, float scale)
+{
+    const T* ptr = reinterpret_cast<const T*>(src);
+    for(unsigned int i=0; i<num; ++i)
+    {
+        dst[i] = static_cast<float>(ptr[i])*scale;
+    }
+}
+
+template<typename T>
+void writeResampleRow(const float* src, unsigned char* dst, unsigned int num, float scale, float minValue, float maxValue)
+{
+    T* ptr = reinterpret_cast<T*>(dst);
+    for(unsigned int i=0; i<num; ++i)
+    {
+        float v = src[i]*scale;
+        v = v<minValue ? minValue : (v>maxValue ? maxValue : v);
+        ptr[i] = static_cast<T>(v>=0.0f ? v+0.5f : v-0.5f);
+    }
+}
+
+template<>
+void writeResampleRow<float>(const float* src, unsigned char* dst, unsigned int num, float scale, float /*minValue*/, float /*maxValue*/)
+{
+    float* ptr = reinterpret_cast<float*>(dst);
+    for(unsigned int i=0; i<num; ++i)
+    {
+        ptr[i] = src[i]*scale;
+    }
+}
+
+typedef void (*ReadResampleRowFunc)(const unsigned char* src, float* dst, unsigned int num, float scale);
+typedef void (*WriteResampleRowFunc)(const float* src, unsigned char* dst, unsigned int num, float scale, float minValue, float maxValue);
+
+ReadResampleRowFunc getReadResampleRowFunc(GLenum dataType)
+{
+    switch(dataType)
+    {
+        case(GL_BYTE):              return &readResampleRow<signed char>;
+        case(GL_UNSIGNED_BYTE):     return &readResampleRow<unsigned char>;
+        case(GL_SHORT):             return &readResampleRow<short>;
+        case(GL_UNSIGNED_SHORT):    return &readResampleRow<unsigned short>;
+        case(GL_INT):               return &readResampleRow<int>;
+        case(GL_UNSIGNED_INT):      return &readResampleRow<unsigned int>;
+        case(GL_FLOAT):             return &readResampleRow<float>;
+    }
+    return 0;
+}
+
+WriteResampleRowFunc getWriteResampleRowFunc(GLenum dataType)
+{
+    switch(dataType)
+    {
+        case(GL_BYTE):              return &writeResampleRow<signed char>;
+        case(GL_UNSIGNED_BYTE):     return &writeResampleRow<unsigned char>;
+        case(GL_SHORT):             return &writeResampleRow<short>;
+        case(GL_UNSIGNED_SHORT):    return &writeResampleRow<unsigned short>;
+        case(GL_INT):               return &writeResampleRow<int>;
+        case(GL_UNSIGNED_INT):      return &writeResampleRow<unsigned int>;
+        case(GL_FLOAT):             return &writeResampleRow<float>;
+    }
+    return 0;
+}
+
+// the number of components is a template parameter so that the compiler fully unrolls and vectorizes the per pixel loops.
+template<unsigned int N>
+void filterResampleRow(const float* src, float* dst, const ResampleContributions& contributions, int dstWidth)
+{
+    for(int x=0; x<dstWidth; ++x)
+    {
+        const float* weights = &contributions.weights[x*contributions.maxTaps];
+        const float* ptr = src + contributions.first[x]*N;
+        int numTaps = contributions.numTaps[x];
+
+        float sum[N];
+        for(unsigned int c=0; c<N; ++c) sum[c] = 0.0f;
+
+        for(int k=0; k<numTaps; ++k, ptr+=N)
+        {
+            float w = weights[k];
+            for(unsigned int c=0; c<N; ++c) sum[c] += w*ptr[c];
+        }
+
+        for(unsigned int c=0; c<N; ++c) *(dst++) = sum[c];
+    }
+}
+
+typedef void (*FilterResampleRowFunc)(const float* src, float* dst, const ResampleContributions& contributions, int dstWidth);
+
+struct ResampleOperation
+{
+    ResampleOperation(unsigned int numComponents,
+                      int sw, int sh, GLenum srcDataType, const unsigned char* src, unsigned int srcStep,
+                      int dw, int dh, GLenum dstDataType, unsigned char* dst, unsigned int dstStep,
+                      ResampleFilter filter):
+        srcWidth(sw), srcHeight(sh), srcData(src), srcRowStep(srcStep),
+        dstWidth(dw), dstHeight(dh), dstData(dst), dstRowStep(dstStep),
+        components(numComponents),
+        horizontal(sw, dw, filter),
+        vertical(sh, dh, filter)
+    {
+        ResampleDataType srcType(srcDataType);
+        ResampleDataType dstType(dstDataType);
+
+        readRow = getReadResampleRowFunc(srcDataType);
+        writeRow = getWriteResampleRowFunc(dstDataType);
+
+        // avoid any scaling when the data types match to retain full precision
+        readScale = srcDataType==dstDataType ? 1.0f : srcType.toFloat;
+        writeScale = srcDataType==dstDataType ? 1.0f : dstType.fromFloat;
+        minValue = dstType.minValue;
+        maxValue = dstType.maxValue;
+
+        switch(components)
+        {
+            case(1): filterRow = &filterResampleRow<1>; break;
+            case(2): filterRow = &filterResampleRow<2>; break;
+            case(3): filterRow = &filterResampleRow<3>; break;
+            default: filterRow = &filterResampleRow<4>; break;
+        }
+    }
+
+    void resampleRows(int beginRow, int endRow) const
+    {
+        unsigned int srcRowSize = srcWidth*components;
+        unsigned int dstRowSize = dstWidth*components;
+
+        std::vector<float> sourceRow(srcRowSize);
+        std::vector<float> accumulatedRow(srcRowSize);
+        std::vector<float> filteredRow(dstRowSize);
+
+        for(int y=beginRow; y<endRow; ++y)
+        {
+            // vertical pass, accumulate the weighted source rows at full source width.
+            const float* weights = &vertical.weights[y*vertical.maxTaps];
+            int firstRow = vertical.first[y];
+            int numTaps = vertical.numTaps[y];
+
+            std::fill(accumulatedRow.begin(), accumulatedRow.end(), 0.0f);
+            for(int k=0; k<numTaps; ++k)
+            {
+                float w = weights[k];
+                if (w==0.0f) continue;
+
+                readRow(srcData + (firstRow+k)*srcRowStep, &sourceRow[0], srcRowSize, readScale);
+
+                const float* in = &sourceRow[0];
+                float* out = &accumulatedRow[0];
+                for(unsigned int i=0; i<srcRowSize; ++i) out[i] += w*in[i];
+            }
+
+            // horizontal pass
+            filterRow(&accumulatedRow[0], &filteredRow[0], horizontal, dstWidth);
+
+            writeRow(&filteredRow[0], dstData + y*dstRowStep, dstRowSize, writeScale, minValue, maxValue);
+        }
+    }
+
+    int                     srcWidth;
+    int                     srcHeight;
+    const unsigned char*    srcData;
+    unsigned int            srcRowStep;
+
+    int                     dstWidth;
+    int                     dstHeight;
+    unsigned char*          dstData;
+    unsigned int            dstRowStep;
+
+    unsigned int            components;
+    ResampleContributions   horizontal;
+    ResampleContributions   vertical;
+
+    ReadResampleRowFunc     readRow;
+    WriteResampleRowFunc    writeRow;
+    FilterResampleRowFunc   filterRow;
+    float                   readScale;
+    float                   writeScale;
+    float                   minValue;
+    float                   maxValue;
+};
+
+class ResampleRowsOperation : public osg::Operation
+{
+public:
+    ResampleRowsOperation(const ResampleOperation& operation, int beginRow, int endRow, osg::RefBlockCount* blockCount):
+        osg::Operation("ResampleRowsOperation", false),
+        _operation(operation),
+        _beginRow(beginRow),
+        _endRow(endRow),
+        _blockCount(blockCount) {}
+
+    virtual void operator () (osg::Object*)
+    {
+        _operation.resampleRows(_beginRow, _endRow);
+        _blockCount->completed();
+    }
+
+protected:
+    const ResampleOperation&            _operation;
+    int                                 _beginRow;
+    int                                 _endRow;
+    osg::ref_ptr<osg::RefBlockCount>    _blockCount;
+};
+
+/** Pool of threads, shared by all resamples, servicing a single queue of row bands so that the threads
+  * are started once rather than on every call.*/
+class ResampleThreadPool : public osg::Referenced
+{
+public:
+    ResampleThreadPool():
+        _queue(new osg::OperationQueue) {}
+
+    /** Split the destination rows into numBands bands, resampling the first band on the calling thread
+      * and the remaining bands on the pool's threads, returning once all the bands have been resampled.*/
+    void apply(const ResampleOperation& operation, int numRows, unsigned int numBands)
+    {
+        ensureNumThreads(numBands-1);
+
+        osg::ref_ptr<osg::RefBlockCount> blockCount = new osg::RefBlockCount(numBands-1);
+        blockCount->reset();
+        for(unsigned int b=1; b<numBands; ++b)
+        {
+            _queue->add(new ResampleRowsOperation(operation, (numRows*b)/numBands, (numRows*(b+1))/numBands, blockCount.get()));
+        }
+
+        operation.resampleRows(0, numRows/numBands);
+
+        blockCount->block();
+    }
+
+protected:
+    virtual ~ResampleThreadPool()
+    {
+        for(Threads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+        {
+            (*itr)->setDone(true);
+        }
+        _queue->releaseOperationsBlock();
+        for(Threads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+        {
+            (*itr)->join();
+        }
+    }
+
+    void ensureNumThreads(unsigned int numThreads)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadsMutex);
+        while(_threads.size()<numThreads)
+        {
+            osg::ref_ptr<osg::OperationThread> thread = new osg::OperationThread;
+            thread->setOperationQueue(_queue.get());
+            thread->startThread();
+            _threads.push_back(thread);
+        }
+    }
+
+    typedef std::vector< osg::ref_ptr<osg::OperationThread> > Threads;
+
+    osg::ref_ptr<osg::OperationQueue>   _queue;
+    OpenThreads::Mutex                  _threadsMutex;
+    Threads                             _threads;
+};
+
+}
+
+bool isResampleSupported(GLenum pixelFormat, GLenum dataType)
+{
+    if (osg::Texture::isCompressedInternalFormat(pixelFormat)) return false;
+
+    unsigned int numComponents = osg::Image::computeNumComponents(pixelFormat);
+    if (numComponents<1 || numComponents>4) return false;
+
+    return ResampleDataType(dataType).supported;
+}
+
+bool resampleImageData(GLenum pixelFormat,
+                       int srcWidth, int srcHeight, GLenum srcDataType, const unsigned char* srcData, unsigned int srcRowStep,
+                       int dstWidth, int dstHeight, GLenum dstDataType, unsigned char* dstData, unsigned int dstRowStep,
+                       ResampleFilter filter, unsigned int numThreads)
+{
+    if (!srcData || !dstData || srcWidth<=0 || srcHeight<=0 || dstWidth<=0 || dstHeight<=0) return false;
+
+    if (!isResampleSupported(pixelFormat, srcDataType) || !isResampleSupported(pixelFormat, dstDataType)) return false;
+
+    ResampleOperation operation(osg::Image::computeNumComponents(pixelFormat),
+                                srcWidth, srcHeight, srcDataType, srcData, srcRowStep,
+                                dstWidth, dstHeight, dstDataType, dstData, dstRowStep,
+                                filter);
+
+    if (numThreads==0)
+    {
+        // only split up the work when there is enough of it to amortize the cost of starting threads.
+        double numPixels = double(srcWidth)*double(srcHeight) + double(dstWidth)*double(dstHeight);
+        numThreads = numPixels < 512.0*512.0 ? 1 : static_cast<unsigned int>(OpenThreads::GetNumberOfProcessors());
+    }
+    numThreads = osg::clampBetween(numThreads, 1u, static_cast<unsigned int>((dstHeight+15)/16));
+
+    if (numThreads<=1)
+    {
+        operation.resampleRows(0, dstHeight);
+        return true;
+    }
+
+    static osg::ref_ptr<ResampleThreadPool> s_resampleThreadPool = new ResampleThreadPool;
+    s_resampleThreadPool->apply(operation, dstHeight, numThreads);
+
+    return true;
+}
+
+bool resampleImage(const osg::Image* srcImage, osg::Image* destImage, ResampleFilter filter, unsigned int numThreads)
+{
+    if (!srcImage || !destImage || !srcImage->data() || !destImage->data()) return false;
+
+    if (srcImage->getPixelFormat()!=destImage->getPixelFormat())
+    {
+        OSG_NOTICE<<"osg::resampleImage(..) pixel formats of source and destination images must match."<<std::endl;
+        return false;
+    }
+
+    if (srcImage->r()!=destImage->r())
+    {
+        OSG_NOTICE<<"osg::resampleImage(..) resampling of volumes not implemented."<<std::endl;
+        return false;
+    }
+
+    for(int r=0; r<srcImage->r(); ++r)
+    {
+        if (!resampleImageData(srcImage->getPixelFormat(),
+                               srcImage->s(), srcImage->t(), srcImage->getDataType(), srcImage->data(0,0,r), srcImage->getRowStepInBytes(),
+                               destImage->s(), destImage->t(), destImage->getDataType(), destImage->data(0,0,r), destImage->getRowStepInBytes(),
+                               filter, numThreads))
+        {
+            return false;
+        }
+    }
+
+    destImage->dirty();
+
+    return true;
+}
+
+bool generateMipmaps(osg::Image* image, ResampleFilter filter, unsigned int numThreads)
+{
+    if (!image || !image->data() || image->r()!=1) return false;
+
+    GLenum pixelFormat = image->getPixelFormat();
+    GLenum dataType = image->getDataType();
+    int packing = image->getPacking();
+
+    if (!isResampleSupported(pixelFormat, dataType)) return false;
+
+    int numLevels = osg::Image::computeNumberOfMipmapLevels(image->s(), image->t(), 1);
+    if (numLevels<=1) return true;
+
+    // compute the offsets of each level, matching the layout assumed by Image::getMipmapData(..)
+    std::vector<unsigned int> offsets(numLevels);
+    unsigned int totalSize = 0;
+    int width = image->s();
+    int height = image->t();
+    for(int level=0; level<numLevels; ++level)
+    {
+        offsets[level] = totalSize;
+        totalSize += osg::Image::computeImageSizeInBytes(width, height, 1, pixelFormat, dataType, packing);
+
+        width = osg::maximum(width>>1, 1);
+        height = osg::maximum(height>>1, 1);
+    }
+
+    unsigned char* data = new unsigned char[totalSize];
+
+    // copy the base level, removing any row length padding.
+    unsigned int rowSize = image->getRowSizeInBytes();
+    unsigned int rowStep = osg::Image::computeRowWidthInBytes(image->s(), pixelFormat, dataType, packing);
+    for(int t=0; t<image->t(); ++t)
+    {
+        memcpy(data + t*rowStep, image->data(0,t), rowSize);
+    }
+
+    width = image->s();
+    height = image->t();
+    for(int level=1; level<numLevels; ++level)
+    {
+        int levelWidth = osg::maximum(width>>1, 1);
+        int levelHeight = osg::maximum(height>>1, 1);
+        unsigned int levelRowStep = osg::Image::computeRowWidthInBytes(levelWidth, pixelFormat, dataType, packing);
+
+        resampleImageData(pixelFormat,
+                          width, height, dataType, data + offsets[level-1], rowStep,
+                          levelWidth, levelHeight, dataType, data + offsets[level], levelRowStep,
+                          filter, numThreads);
+
+        width = levelWidth;
+        height = levelHeight;
+        rowStep = levelRowStep;
+    }
+
+    image->setImage(image->s(), image->t(), 1,
+                    image->getInternalTextureFormat(), pixelFormat, dataType,
+                    data, osg::Image::USE_NEW_DELETE, packing);
+
+    osg::Image::MipmapDataType mipmapData(offsets.begin()+1, offsets.end());
+    image->setMipmapLevels(mipmapData);
+
+    return true;
 }
 
+}
@@ -13,6 +13,8 @@
 
 #include <osg/KdTree>
 #include <osg/Geode>
+#include <osg/HeightFieldQuadTree>
+#include <osg/ShapeDrawable>
 #include <osg/TriangleIndexFunctor>
 #include <osg/TemplatePrimitiveIndexFunctor>
 #include <osg/Timer>
@@ -523,6 +525,14 @@ KdTreeBuilder::KdTreeBuilder(const KdTreeBuilder& rhs):
 
 void KdTreeBuilder::apply(osg::Geometry& geometry)
 {
+    // height fields drawn by a ShapeDrawable are intersected using the HeightField's own quadtree.
+    osg::HeightField* field = dynamic_cast<osg::HeightField*>(geometry.getShape());
+    if (field && dynamic_cast<osg::ShapeDrawable*>(&geometry))
+    {
+        field->getOrCreateQuadTree();
+        return;
+    }
+
     osg::KdTree* previous = dynamic_cast<osg::KdTree*>(geometry.getShape());
     if (previous) return;
 
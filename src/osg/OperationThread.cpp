@@ -54,30 +54,87 @@ OperationQueue::OperationQueue():
 
 OperationQueue::~OperationQueue()
 {
+    // delete any operations that were added but never taken by a consumer.
+    PendingOperation* pending = static_cast<PendingOperation*>(_pendingOperations.get());
+    while(pending)
+    {
+        PendingOperation* next = pending->next;
+        delete pending;
+        pending = next;
+    }
+}
+
+void OperationQueue::takePendingOperations()
+{
+    // detach the whole pending stack in one go, producers only ever push and the consumers
+    // are serialized by _operationsMutex, so the compare and swap can't suffer from ABA.
+    void* head = 0;
+    do
+    {
+        head = _pendingOperations.get();
+    } while(head && !_pendingOperations.assign(0, head));
+
+    if (!head) return;
+
+    // the stack holds the most recent operation first, so reverse it to restore the order of addition.
+    PendingOperation* reversed = 0;
+    PendingOperation* pending = static_cast<PendingOperation*>(head);
+    while(pending)
+    {
+        PendingOperation* next = pending->next;
+        pending->next = reversed;
+        reversed = pending;
+        pending = next;
+    }
+
+    while(reversed)
+    {
+        PendingOperation* next = reversed->next;
+        _operations.push_back(reversed->operation);
+        delete reversed;
+        reversed = next;
+    }
+}
+
+void OperationQueue::updateOperationsBlock()
+{
+    if (_operations.empty())
+    {
+        _operationsBlock->set(false);
+
+        // an operation may have been added since the pending operations were taken, in which case
+        // its producer may have already released the block before it was reset above.
+        if (_pendingOperations.get()) _operationsBlock->set(true);
+    }
 }
 
 bool OperationQueue::empty()
 {
+    if (_pendingOperations.get()) return false;
 
-  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
-  return _operations.empty();
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
+    return _operations.empty();
 }
 
 unsigned int OperationQueue::getNumOperationsInQueue()
 {
-  OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
-  return static_cast<unsigned int>(_operations.size());
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
+    takePendingOperations();
+    return static_cast<unsigned int>(_operations.size());
 }
 
 ref_ptr<Operation> OperationQueue::getNextOperation(bool blockIfEmpty)
 {
-    if (blockIfEmpty && _operations.empty())
+    if (blockIfEmpty)
     {
+        // the block is only set while there are operations in the queue, so this returns immediately when it isn't empty.
         _operationsBlock->block();
     }
 
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
 
+    takePendingOperations();
+
     if (_operations.empty()) return osg::ref_ptr<Operation>();
 
     if (_currentOperationIterator == _operations.end())
@@ -97,11 +154,7 @@ ref_ptr<Operation> OperationQueue::getNextOperation(bool blockIfEmpty)
 
         // OSG_INFO<<"size "<<_operations.size()<<std::endl;
 
-        if (_operations.empty())
-        {
-           // OSG_INFO<<"setting block "<<_operations.size()<<std::endl;
-           _operationsBlock->set(false);
-        }
+        updateOperationsBlock();
     }
     else
     {
@@ -118,13 +171,18 @@ void OperationQueue::add(Operation* operation)
 {
     OSG_INFO<<"Doing add"<<std::endl;
 
-    // acquire the lock on the operations queue to prevent anyone else for modifying it at the same time
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
+    PendingOperation* pending = new PendingOperation(operation);
 
-    // add the operation to the end of the list
-    _operations.push_back(operation);
+    // push onto the head of the pending stack without taking any locks.
+    void* head = 0;
+    do
+    {
+        head = _pendingOperations.get();
+        pending->next = static_cast<PendingOperation*>(head);
+    } while(!_pendingOperations.assign(pending, head));
 
-    _operationsBlock->set(true);
+    // only the transition from an empty pending stack needs to release any waiting threads.
+    if (!head) _operationsBlock->set(true);
 }
 
 void OperationQueue::remove(Operation* operation)
@@ -134,6 +192,8 @@ void OperationQueue::remove(Operation* operation)
     // acquire the lock on the operations queue to prevent anyone else for modifying it at the same time
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
 
+    takePendingOperations();
+
     for(Operations::iterator itr = _operations.begin();
         itr!=_operations.end();)
     {
@@ -151,6 +211,8 @@ void OperationQueue::remove(Operation* operation)
         }
         else ++itr;
     }
+
+    updateOperationsBlock();
 }
 
 void OperationQueue::remove(const std::string& name)
@@ -160,6 +222,8 @@ void OperationQueue::remove(const std::string& name)
     // acquire the lock on the operations queue to prevent anyone else for modifying it at the same time
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
 
+    takePendingOperations();
+
     // find the remove all operations with specified name
     for(Operations::iterator itr = _operations.begin();
         itr!=_operations.end();)
@@ -178,10 +242,7 @@ void OperationQueue::remove(const std::string& name)
         else ++itr;
     }
 
-    if (_operations.empty())
-    {
-        _operationsBlock->set(false);
-    }
+    updateOperationsBlock();
 }
 
 void OperationQueue::removeAllOperations()
@@ -190,21 +251,24 @@ void OperationQueue::removeAllOperations()
 
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
 
+    takePendingOperations();
+
     _operations.clear();
 
     // reset current operator.
     _currentOperationIterator = _operations.begin();
 
-    if (_operations.empty())
-    {
-        _operationsBlock->set(false);
-    }
+    updateOperationsBlock();
 }
 
 void OperationQueue::runOperations(Object* callingObject)
 {
+    // the operations are run with the lock held so that each one is only run by one thread at a time,
+    // and can't be run once it has been removed. add() doesn't take the lock so producers aren't held up.
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
 
+    takePendingOperations();
+
     // reset current operation iterator to beginning if at end.
     if (_currentOperationIterator==_operations.end()) _currentOperationIterator = _operations.begin();
 
@@ -229,10 +293,7 @@ void OperationQueue::runOperations(Object* callingObject)
         (*operation)(callingObject);
     }
 
-    if (_operations.empty())
-    {
-        _operationsBlock->set(false);
-    }
+    updateOperationsBlock();
 }
 
 void OperationQueue::releaseOperationsBlock()
@@ -244,6 +305,8 @@ void OperationQueue::releaseOperationsBlock()
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationsMutex);
 
+    takePendingOperations();
+
     for(Operations::iterator itr = _operations.begin();
         itr!=_operations.end();
         ++itr)
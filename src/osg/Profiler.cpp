@@ -0,0 +1,478 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/Profiler>
+#include <osg/ApplicationUsage>
+#include <osg/Object>
+#include <osg/Notify>
+
+#include <OpenThreads/ScopedLock>
+
+#include <fstream>
+#include <sstream>
+#include <map>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+using namespace osg;
+
+static ApplicationUsageProxy Profiler_e0(ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_PROFILE_FILE <filename>","Record profiling zones and write them to filename on exit, as a Chrome trace if its extension is .json, otherwise in binary.");
+
+bool Profiler::s_enabled = false;
+
+// thread local storage of each thread's ThreadBuffer.
+#if defined(_WIN32) && !defined(__CYGWIN__)
+struct Profiler::ThreadKey
+{
+    ThreadKey(): key(TlsAlloc()) {}
+    ~ThreadKey() { TlsFree(key); }
+
+    ThreadBuffer* get() const { return static_cast<ThreadBuffer*>(TlsGetValue(key)); }
+    void set(ThreadBuffer* buffer) { TlsSetValue(key, buffer); }
+
+    DWORD key;
+};
+#else
+struct Profiler::ThreadKey
+{
+    ThreadKey() { pthread_key_create(&key, 0); }
+    ~ThreadKey() { pthread_key_delete(key); }
+
+    ThreadBuffer* get() const { return static_cast<ThreadBuffer*>(pthread_getspecific(key)); }
+    void set(ThreadBuffer* buffer) { pthread_setspecific(key, buffer); }
+
+    pthread_key_t key;
+};
+#endif
+
+ref_ptr<Profiler>& Profiler::instance()
+{
+    static ref_ptr<Profiler> s_profiler = new Profiler;
+    return s_profiler;
+}
+
+OSG_INIT_SINGLETON_PROXY(ProfilerSingletonProxy, Profiler::instance())
+
+Profiler::Profiler():
+    _numEventsPerThread(65536),
+    _threadKey(new ThreadKey)
+{
+    const char* ptr = getenv("OSG_PROFILE_FILE");
+    if (ptr && *ptr)
+    {
+        _filename = ptr;
+        s_enabled = true;
+    }
+}
+
+Profiler::~Profiler()
+{
+    // stop zones from recording into the buffers being destroyed, however recording was enabled.
+    s_enabled = false;
+
+    if (!_filename.empty())
+    {
+        if (write(_filename)) { OSG_NOTICE<<"Profiler: written "<<_filename<<std::endl; }
+        else { OSG_WARN<<"Profiler: unable to write "<<_filename<<std::endl; }
+    }
+
+    delete _threadKey;
+}
+
+void Profiler::setNumEventsPerThread(unsigned int num)
+{
+    unsigned int size = 1;
+    while(size<num && size<0x80000000u) size <<= 1;
+    _numEventsPerThread = size;
+}
+
+Profiler::ThreadBuffer* Profiler::getThreadBuffer()
+{
+    ThreadBuffer* buffer = _threadKey->get();
+    if (buffer) return buffer;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    buffer = new ThreadBuffer;
+    std::ostringstream str;
+    str<<"Thread "<<_threadBuffers.size()+1;
+    buffer->name = str.str();
+
+    _threadBuffers.push_back(buffer);
+    _threadKey->set(buffer);
+    return buffer;
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    buffer->name = name;
+}
+
+void Profiler::record(const char* name, Timer_t beginTick, Timer_t endTick, unsigned int flags)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+
+    if (buffer->events.empty())
+    {
+        // allocated on first use, so naming a thread that never records costs no more than the name.
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        buffer->events.resize(_numEventsPerThread);
+        buffer->mask = _numEventsPerThread-1;
+    }
+
+    unsigned int index = buffer->numRecorded;
+    Event& event = buffer->events[index & buffer->mask];
+    event.name = name;
+    event.beginTick = beginTick;
+    event.endTick = endTick;
+    event.flags = flags;
+
+    // publishes the event to capture(), which only reads events below numRecorded.
+    ++(buffer->numRecorded);
+    if ((index & buffer->mask)==buffer->mask) buffer->full = true;
+}
+
+void Profiler::clear()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    for(ThreadBuffers::iterator itr = _threadBuffers.begin();
+        itr != _threadBuffers.end();
+        ++itr)
+    {
+        (*itr)->numCleared = (*itr)->numRecorded;
+    }
+}
+
+namespace
+{
+    struct StringTable
+    {
+        StringTable(Profiler::Capture::Strings& strings): _strings(strings) {}
+
+        unsigned int get(const char* name)
+        {
+            NameIndices::iterator itr = _nameIndices.find(name);
+            if (itr!=_nameIndices.end()) return itr->second;
+
+            unsigned int index = get(std::string(name));
+            _nameIndices[name] = index;
+            return index;
+        }
+
+        unsigned int get(const std::string& str)
+        {
+            StringIndices::iterator itr = _stringIndices.find(str);
+            if (itr!=_stringIndices.end()) return itr->second;
+
+            unsigned int index = static_cast<unsigned int>(_strings.size());
+            _strings.push_back(str);
+            _stringIndices[str] = index;
+            return index;
+        }
+
+        typedef std::map<const char*, unsigned int> NameIndices;
+        typedef std::map<std::string, unsigned int> StringIndices;
+
+        Profiler::Capture::Strings& _strings;
+        NameIndices                 _nameIndices;
+        StringIndices               _stringIndices;
+    };
+
+    unsigned long long toNanoseconds(Timer_t tick)
+    {
+        double ns = Timer::instance()->delta_n(Timer::instance()->getStartTick(), tick);
+        return ns>0.0 ? static_cast<unsigned long long>(ns) : 0;
+    }
+}
+
+void Profiler::capture(Capture& capture) const
+{
+    capture.strings.clear();
+    capture.tracks.clear();
+    capture.events.clear();
+
+    StringTable strings(capture.strings);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    for(ThreadBuffers::const_iterator itr = _threadBuffers.begin();
+        itr != _threadBuffers.end();
+        ++itr)
+    {
+        ThreadBuffer* buffer = itr->get();
+        if (buffer->events.empty()) continue;
+
+        unsigned int capacity = buffer->mask+1;
+        bool full = buffer->full;
+        unsigned int end = buffer->numRecorded;
+        unsigned int numAvailable = full ? capacity : end;
+        unsigned int numSinceCleared = end - buffer->numCleared;
+        if (numSinceCleared<numAvailable) numAvailable = numSinceCleared;
+
+        std::vector<Event> events;
+        events.reserve(numAvailable);
+        for(unsigned int i=0; i<numAvailable; ++i)
+        {
+            events.push_back(buffer->events[(end-numAvailable+i) & buffer->mask]);
+        }
+
+        // events the thread recorded while copying, and the one it may be recording, have overwritten the oldest slots
+        // once its buffer has wrapped around.
+        unsigned int start = end - numAvailable;
+        unsigned int firstValid = static_cast<unsigned int>(buffer->numRecorded) + 1 - capacity;
+        unsigned int numOverwritten = firstValid - start;
+        unsigned int numDiscarded = 0;
+        if (numOverwritten<0x80000000u) numDiscarded = numOverwritten<numAvailable ? numOverwritten : numAvailable;
+
+        unsigned int cpuTrack = static_cast<unsigned int>(capture.tracks.size());
+        capture.tracks.push_back(strings.get(buffer->name));
+        unsigned int gpuTrack = 0;
+
+        for(unsigned int i=numDiscarded; i<events.size(); ++i)
+        {
+            const Event& event = events[i];
+
+            Capture::Event ce;
+            ce.name = strings.get(event.name);
+            ce.track = cpuTrack;
+            if (event.flags & GPU_EVENT)
+            {
+                if (gpuTrack==0)
+                {
+                    gpuTrack = static_cast<unsigned int>(capture.tracks.size());
+                    capture.tracks.push_back(strings.get(buffer->name+" GPU"));
+                }
+                ce.track = gpuTrack;
+            }
+            ce.begin = toNanoseconds(event.beginTick);
+            unsigned long long endTime = toNanoseconds(event.endTick);
+            ce.duration = endTime>ce.begin ? endTime-ce.begin : 0;
+            capture.events.push_back(ce);
+        }
+    }
+}
+
+static void writeJSONString(std::ostream& out, const std::string& str)
+{
+    out<<'"';
+    for(std::string::const_iterator itr = str.begin(); itr != str.end(); ++itr)
+    {
+        unsigned char c = static_cast<unsigned char>(*itr);
+        if (c=='"' || c=='\\') out<<'\\'<<*itr;
+        else if (c<0x20)
+        {
+            static const char* hex = "0123456789abcdef";
+            out<<"\\u00"<<hex[c>>4]<<hex[c&0xf];
+        }
+        else out<<*itr;
+    }
+    out<<'"';
+}
+
+bool Profiler::Capture::writeChromeTrace(std::ostream& out) const
+{
+    out<<"{\"displayTimeUnit\":\"ms\",\"traceEvents\":["<<std::endl;
+
+    bool first = true;
+    for(unsigned int i=0; i<tracks.size(); ++i)
+    {
+        if (tracks[i]>=strings.size()) return false;
+
+        if (!first) out<<","<<std::endl;
+        first = false;
+
+        out<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"<<i+1<<",\"args\":{\"name\":";
+        writeJSONString(out, strings[tracks[i]]);
+        out<<"}}";
+    }
+
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out.setf(std::ios::fixed, std::ios::floatfield);
+    out.precision(3);
+
+    for(Events::const_iterator itr = events.begin();
+        itr != events.end();
+        ++itr)
+    {
+        if (itr->name>=strings.size() || itr->track>=tracks.size()) return false;
+
+        if (!first) out<<","<<std::endl;
+        first = false;
+
+        out<<"{\"name\":";
+        writeJSONString(out, strings[itr->name]);
+        out<<",\"ph\":\"X\",\"ts\":"<<double(itr->begin)*1e-3<<",\"dur\":"<<double(itr->duration)*1e-3<<",\"pid\":1,\"tid\":"<<itr->track+1<<"}";
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+
+    out<<std::endl<<"]}"<<std::endl;
+    return !out.fail();
+}
+
+static void writeUInt(std::ostream& out, unsigned long long value, unsigned int numBytes)
+{
+    char bytes[8];
+    for(unsigned int i=0; i<numBytes; ++i) bytes[i] = static_cast<char>((value >> (i*8)) & 0xff);
+    out.write(bytes, numBytes);
+}
+
+static bool readUInt(std::istream& in, unsigned long long& value, unsigned int numBytes)
+{
+    unsigned char bytes[8];
+    if (!in.read(reinterpret_cast<char*>(bytes), numBytes)) return false;
+
+    value = 0;
+    for(unsigned int i=0; i<numBytes; ++i) value |= static_cast<unsigned long long>(bytes[i]) << (i*8);
+    return true;
+}
+
+static const char s_binaryHeader[8] = { 'O', 'S', 'G', 'P', 'R', 'O', 'F', 0 };
+static const unsigned int s_binaryVersion = 1;
+
+bool Profiler::Capture::writeBinary(std::ostream& out) const
+{
+    out.write(s_binaryHeader, 8);
+    writeUInt(out, s_binaryVersion, 4);
+
+    writeUInt(out, strings.size(), 4);
+    for(Strings::const_iterator itr = strings.begin();
+        itr != strings.end();
+        ++itr)
+    {
+        writeUInt(out, itr->size(), 4);
+        out.write(itr->data(), itr->size());
+    }
+
+    writeUInt(out, tracks.size(), 4);
+    for(Tracks::const_iterator itr = tracks.begin();
+        itr != tracks.end();
+        ++itr)
+    {
+        writeUInt(out, *itr, 4);
+    }
+
+    writeUInt(out, events.size(), 4);
+    for(Events::const_iterator itr = events.begin();
+        itr != events.end();
+        ++itr)
+    {
+        writeUInt(out, itr->name, 4);
+        writeUInt(out, itr->track, 4);
+        writeUInt(out, itr->begin, 8);
+        writeUInt(out, itr->duration, 8);
+    }
+
+    return !out.fail();
+}
+
+bool Profiler::Capture::readBinary(std::istream& in)
+{
+    strings.clear();
+    tracks.clear();
+    events.clear();
+
+    char header[8];
+    if (!in.read(header, 8) || memcmp(header, s_binaryHeader, 8)!=0) return false;
+
+    unsigned long long value = 0;
+    if (!readUInt(in, value, 4) || value!=s_binaryVersion) return false;
+
+    if (!readUInt(in, value, 4)) return false;
+    strings.resize(static_cast<unsigned int>(value));
+    for(Strings::iterator itr = strings.begin();
+        itr != strings.end();
+        ++itr)
+    {
+        if (!readUInt(in, value, 4)) return false;
+        std::vector<char> chars(static_cast<unsigned int>(value));
+        if (!chars.empty() && !in.read(&chars.front(), chars.size())) return false;
+        itr->assign(chars.begin(), chars.end());
+    }
+
+    if (!readUInt(in, value, 4)) return false;
+    tracks.resize(static_cast<unsigned int>(value));
+    for(Tracks::iterator itr = tracks.begin();
+        itr != tracks.end();
+        ++itr)
+    {
+        if (!readUInt(in, value, 4)) return false;
+        *itr = static_cast<unsigned int>(value);
+    }
+
+    if (!readUInt(in, value, 4)) return false;
+    events.resize(static_cast<unsigned int>(value));
+    for(Events::iterator itr = events.begin();
+        itr != events.end();
+        ++itr)
+    {
+        if (!readUInt(in, value, 4)) return false;
+        itr->name = static_cast<unsigned int>(value);
+        if (!readUInt(in, value, 4)) return false;
+        itr->track = static_cast<unsigned int>(value);
+        if (!readUInt(in, itr->begin, 8) || !readUInt(in, itr->duration, 8)) return false;
+    }
+
+    return true;
+}
+
+static bool hasJSONExtension(const std::string& filename)
+{
+    std::string::size_type dot = filename.find_last_of('.');
+    if (dot==std::string::npos) return false;
+
+    std::string ext = filename.substr(dot+1);
+    for(std::string::iterator itr = ext.begin(); itr != ext.end(); ++itr) *itr = static_cast<char>(tolower(*itr));
+    return ext=="json";
+}
+
+bool Profiler::write(const std::string& filename) const
+{
+    Capture c;
+    capture(c);
+
+    if (hasJSONExtension(filename))
+    {
+        std::ofstream fout(filename.c_str());
+        return fout && c.writeChromeTrace(fout);
+    }
+    else
+    {
+        std::ofstream fout(filename.c_str(), std::ios::out | std::ios::binary);
+        return fout && c.writeBinary(fout);
+    }
+}
+
+bool Profiler::convertToChromeTrace(const std::string& binaryFilename, const std::string& jsonFilename)
+{
+    std::ifstream fin(binaryFilename.c_str(), std::ios::in | std::ios::binary);
+    if (!fin) return false;
+
+    Capture c;
+    if (!c.readBinary(fin)) return false;
+
+    std::ofstream fout(jsonFilename.c_str());
+    return fout && c.writeChromeTrace(fout);
+}
@@ -11,8 +11,11 @@
  * OpenSceneGraph Public License for more details.
 */
 #include <osg/Shape>
+#include <osg/HeightFieldQuadTree>
 #include <osg/Geometry>
 
+#include <OpenThreads/ScopedLock>
+
 #include <algorithm>
 
 using namespace osg;
@@ -61,6 +64,14 @@ ConvexHull::~ConvexHull()
 {
 }
 
+HeightFieldQuadTreeHolder::HeightFieldQuadTreeHolder()
+{
+}
+
+HeightFieldQuadTreeHolder::~HeightFieldQuadTreeHolder()
+{
+}
+
 HeightField::HeightField():
     _columns(0),
     _rows(0),
@@ -68,7 +79,8 @@ HeightField::HeightField():
     _dx(1.0f),
     _dy(1.0f),
     _skirtHeight(0.0f),
-    _borderWidth(0)
+    _borderWidth(0),
+    _quadTreeHolder(new HeightFieldQuadTreeHolder)
 {
     _heights = new FloatArray;
 }
@@ -82,7 +94,8 @@ HeightField::HeightField(const HeightField& mesh,const CopyOp& copyop):
     _dy(mesh._dy),
     _skirtHeight(mesh._skirtHeight),
     _borderWidth(mesh._borderWidth),
-    _heights(new FloatArray(*mesh._heights))
+    _heights(new FloatArray(*mesh._heights)),
+    _quadTreeHolder(new HeightFieldQuadTreeHolder)
 {
 }
 
@@ -90,6 +103,39 @@ HeightField::~HeightField()
 {
 }
 
+void HeightField::setQuadTree(HeightFieldQuadTree* quadTree)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_quadTreeHolder->mutex);
+    _quadTreeHolder->quadTree = quadTree;
+}
+
+HeightFieldQuadTree* HeightField::getQuadTree()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_quadTreeHolder->mutex);
+    return _quadTreeHolder->quadTree.get();
+}
+
+const HeightFieldQuadTree* HeightField::getQuadTree() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_quadTreeHolder->mutex);
+    return _quadTreeHolder->quadTree.get();
+}
+
+ref_ptr<HeightFieldQuadTree> HeightField::getOrCreateQuadTree()
+{
+    // the lock is per height field, so building the quadtree of one height field doesn't hold up intersections with others.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_quadTreeHolder->mutex);
+
+    ref_ptr<HeightFieldQuadTree>& quadTree = _quadTreeHolder->quadTree;
+    if (!quadTree || !quadTree->valid(this))
+    {
+        ref_ptr<HeightFieldQuadTree> newQuadTree = new HeightFieldQuadTree;
+        quadTree = newQuadTree->build(this) ? newQuadTree.get() : 0;
+    }
+
+    return quadTree;
+}
+
 
 void HeightField::allocate(unsigned int numColumns,unsigned int numRows)
 {
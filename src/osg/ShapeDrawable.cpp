@@ -90,6 +90,10 @@ void ShapeDrawable::build()
     getVertexAttribArrayList().clear();
     getPrimitiveSetList().clear();
 
+    // the geometry of a height field is rebuilt after its heights change, so also discard its quadtree.
+    HeightField* field = dynamic_cast<HeightField*>(_shape.get());
+    if (field) field->setQuadTree(0);
+
     if (_shape)
     {
         BuildShapeGeometryVisitor dsv(this, _tessellationHints.get());
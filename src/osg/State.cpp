@@ -18,6 +18,7 @@
 #include <osg/Drawable>
 #include <osg/ApplicationUsage>
 #include <osg/ContextData>
+#include <osg/GLObjectBudgetManager>
 #include <osg/os_utils>
 
 // for includes for GLES
@@ -163,6 +164,7 @@ State::State():
 
     _maxTexturePoolSize = 0;
     _maxBufferObjectPoolSize = 0;
+    _glObjectPoolBudget = 0;
 
     _arrayDispatchers.setState(this);
 
@@ -645,6 +647,20 @@ void State::setMaxBufferObjectPoolSize(unsigned int size)
     OSG_INFO<<"osg::State::_maxBufferObjectPoolSize="<<_maxBufferObjectPoolSize<<std::endl;
 }
 
+void State::setGLObjectPoolBudget(unsigned int size)
+{
+    _glObjectPoolBudget = size;
+
+    GLObjectBudgetManager* budgetManager = osg::get<GLObjectBudgetManager>(_contextID);
+    budgetManager->setBudget(_glObjectPoolBudget);
+
+    // vertex array objects keep the buffer objects bound when they were set up so can't have them evicted from under them.
+    bool usingVAO = _forceVertexArrayObject || getActiveDisplaySettings()->getVertexBufferHint()==DisplaySettings::VERTEX_ARRAY_OBJECT;
+    budgetManager->setEvictGLBufferObjects(!usingVAO);
+
+    OSG_INFO<<"osg::State::_glObjectPoolBudget="<<_glObjectPoolBudget<<std::endl;
+}
+
 void State::setRootStateSet(osg::StateSet* stateset)
 {
     if (_rootStateSet == stateset) return;
@@ -12,6 +12,7 @@
 */
 #include <osg/GLExtensions>
 #include <osg/Image>
+#include <osg/ImageUtils>
 #include <osg/Texture>
 #include <osg/State>
 #include <osg/Notify>
@@ -321,6 +322,9 @@ void Texture::TextureProfile::computeSize()
         case(GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT): numBitsPerTexel = 8; break;
         case(GL_COMPRESSED_RED_GREEN_RGTC2_EXT):        numBitsPerTexel = 8; break;
 
+        case(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB):        numBitsPerTexel = 8; break;
+        case(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB):  numBitsPerTexel = 8; break;
+
         case(GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG):  numBitsPerTexel = 2; break;
         case(GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG): numBitsPerTexel = 2; break;
         case(GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG):  numBitsPerTexel = 4; break;
@@ -692,6 +696,56 @@ bool TextureObjectSet::makeSpace(unsigned int& size)
     return size==0;
 }
 
+void TextureObjectSet::collectLeastRecentlyUsed(unsigned int frameNumber, std::vector<Texture::TextureObject*>& textureObjects) const
+{
+    // the active list is kept in least recently used order, so stop at the first object used since frameNumber.
+    for(Texture::TextureObject* to = _head;
+        to != 0 && to->_frameLastUsed < frameNumber;
+        to = to->_next)
+    {
+        textureObjects.push_back(to);
+    }
+}
+
+bool TextureObjectSet::evict(Texture::TextureObject* to)
+{
+    ref_ptr<Texture> texture = to->getTexture();
+    if (!texture || texture->getTextureObject(_contextID)!=to) return false;
+
+    // only evict textures that can be recompiled from their images, so render targets and textures
+    // whose image data has been unreferenced after apply are left resident.
+    if (texture->getNumImages()==0) return false;
+    for(unsigned int i=0; i<texture->getNumImages(); ++i)
+    {
+        const osg::Image* image = texture->getImage(i);
+        if (!image || !image->data()) return false;
+    }
+
+    OSG_INFO<<"TextureObjectSet="<<this<<": Evicting TextureObject "<<to<<" last used in frame "<<to->_frameLastUsed<<std::endl;
+
+    // keep a reference so the TextureObject survives the Texture letting go of it.
+    ref_ptr<Texture::TextureObject> keep = to;
+
+    texture->setTextureObject(_contextID, 0);
+    to->setTexture(0);
+
+    // delete straight away rather than orphaning, as orphans are only deleted once the pool exceeds the max texture pool size.
+    remove(to);
+
+    GLuint id = to->id();
+    glDeleteTextures( 1L, &id);
+
+    --_numOfTextureObjects;
+
+    _parent->getCurrTexturePoolSize() -= _profile._size;
+    _parent->getNumberActiveTextureObjects() -= 1;
+    _parent->getNumberDeleted() += 1;
+
+    CHECK_CONSISTENCY
+
+    return true;
+}
+
 osg::ref_ptr<Texture::TextureObject> TextureObjectSet::takeFromOrphans(Texture* texture)
 {
     // take front of orphaned list.
@@ -1005,6 +1059,16 @@ bool TextureObjectManager::makeSpace(unsigned int size)
 }
 
 
+void TextureObjectManager::collectLeastRecentlyUsed(unsigned int frameNumber, std::vector<Texture::TextureObject*>& textureObjects) const
+{
+    for(TextureSetMap::const_iterator itr = _textureSetMap.begin();
+        itr != _textureSetMap.end();
+        ++itr)
+    {
+        (*itr).second->collectLeastRecentlyUsed(frameNumber, textureObjects);
+    }
+}
+
 osg::ref_ptr<Texture::TextureObject> TextureObjectManager::generateTextureObject(const Texture* texture, GLenum target)
 {
     return generateTextureObject(texture, target, 0, 0, 0, 0, 0, 0);
@@ -1644,6 +1708,20 @@ void Texture::computeInternalFormatWithImage(const osg::Image& image) const
             }
             break;
 
+        case(USE_BPTC_COMPRESSION):
+            if (extensions->isTextureCompressionBPTCSupported)
+            {
+                switch(image.getPixelFormat())
+                {
+                    case(3):
+                    case(GL_RGB):
+                    case(4):
+                    case(GL_RGBA):  internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB; break;
+                    default:        internalFormat = image.getInternalTextureFormat(); break;
+                }
+            }
+            break;
+
         default:
             break;
         }
@@ -1806,6 +1884,8 @@ bool Texture::isCompressedInternalFormat(GLint internalFormat)
         case(GL_COMPRESSED_RED_RGTC1_EXT):
         case(GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT):
         case(GL_COMPRESSED_RED_GREEN_RGTC2_EXT):
+        case(GL_COMPRESSED_RGBA_BPTC_UNORM_ARB):
+        case(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB):
         case(GL_ETC1_RGB8_OES):
         case(GL_COMPRESSED_RGB8_ETC2):
         case(GL_COMPRESSED_SRGB8_ETC2):
@@ -1849,6 +1929,8 @@ void Texture::getCompressedSize(GLenum internalFormat, GLint width, GLint height
         blockSize = 8;
     else if (internalFormat == GL_COMPRESSED_RED_GREEN_RGTC2_EXT || internalFormat == GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT)
         blockSize = 16;
+    else if (internalFormat == GL_COMPRESSED_RGBA_BPTC_UNORM_ARB || internalFormat == GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB)
+        blockSize = 16;
     else if (internalFormat == GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG || internalFormat == GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG)
     {
          blockSize = 8 * 4; // Pixel by pixel block size for 2bpp
@@ -2187,6 +2269,8 @@ void Texture::applyTexImage2D_load(State& state, GLenum target, const Image* ima
             case(GL_COMPRESSED_SIGNED_RG11_EAC):
             case GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT:
             case GL_COMPRESSED_RED_GREEN_RGTC2_EXT: _internalFormat = GL_RG; break;
+            case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB:
+            case GL_COMPRESSED_RGBA_BPTC_UNORM_ARB: _internalFormat = GL_RGBA; break;
         }
     }
 
@@ -2239,16 +2323,22 @@ void Texture::applyTexImage2D_load(State& state, GLenum target, const Image* ima
         if (!image->getFileName().empty()) { OSG_NOTICE << "Scaling image '"<<image->getFileName()<<"' from ("<<image->s()<<","<<image->t()<<") to ("<<inwidth<<","<<inheight<<")"<<std::endl; }
         else { OSG_NOTICE << "Scaling image from ("<<image->s()<<","<<image->t()<<") to ("<<inwidth<<","<<inheight<<")"<<std::endl; }
 
-        PixelStorageModes psm;
-        psm.pack_alignment = image->getPacking();
-        psm.pack_row_length = image->getRowLength();
-        psm.unpack_alignment = image->getPacking();
-
         // rescale the image to the correct size.
-        gluScaleImage(&psm, image->getPixelFormat(),
-                        image->s(),image->t(),image->getDataType(),image->data(),
-                        inwidth,inheight,image->getDataType(),
-                        dataPtr);
+        if (!osg::resampleImageData(image->getPixelFormat(),
+                                    image->s(), image->t(), image->getDataType(), image->data(), image->getRowStepInBytes(),
+                                    inwidth, inheight, image->getDataType(), dataPtr,
+                                    osg::Image::computeRowWidthInBytes(inwidth,image->getPixelFormat(),image->getDataType(),image->getPacking())))
+        {
+            PixelStorageModes psm;
+            psm.pack_alignment = image->getPacking();
+            psm.pack_row_length = image->getRowLength();
+            psm.unpack_alignment = image->getPacking();
+
+            gluScaleImage(&psm, image->getPixelFormat(),
+                            image->s(),image->t(),image->getDataType(),image->data(),
+                            inwidth,inheight,image->getDataType(),
+                            dataPtr);
+        }
 
         rowLength = 0;
     }
@@ -2433,17 +2523,48 @@ void Texture::applyTexImage2D_load(State& state, GLenum target, const Image* ima
             {
                 numMipmapLevels = 0;
 
-                gluBuild2DMipmaps( target, _internalFormat,
-                    inwidth,inheight,
-                    (GLenum)image->getPixelFormat(), (GLenum)image->getDataType(),
-                    dataPtr);
+                // generate the mipmap chain on the CPU with the native resampler, keeping GLU as the fallback
+                // for the packed pixel formats it doesn't handle.
+                osg::ref_ptr<osg::Image> mipmappedImage = new osg::Image;
+                mipmappedImage->setImage(inwidth, inheight, 1, _internalFormat,
+                                         image->getPixelFormat(), image->getDataType(),
+                                         dataPtr, osg::Image::NO_DELETE, image->getPacking(), rowLength);
 
-                int width  = image->s();
-                int height = image->t();
-                for( numMipmapLevels = 0 ; (width || height) ; ++numMipmapLevels)
+                if (osg::generateMipmaps(mipmappedImage.get()))
                 {
-                    width >>= 1;
-                    height >>= 1;
+#if !defined(OSG_GLES1_AVAILABLE) && !defined(OSG_GLES2_AVAILABLE) && !defined(OSG_GLES3_AVAILABLE)
+                    glPixelStorei(GL_UNPACK_ROW_LENGTH,0);
+#endif
+                    numMipmapLevels = mipmappedImage->getNumMipmapLevels();
+
+                    int width  = inwidth;
+                    int height = inheight;
+                    for( GLsizei k = 0 ; k < numMipmapLevels ;k++)
+                    {
+                        glTexImage2D( target, k, _internalFormat,
+                             width, height, _borderWidth,
+                            (GLenum)image->getPixelFormat(),
+                            (GLenum)image->getDataType(),
+                            mipmappedImage->getMipmapData(k));
+
+                        width = osg::maximum(width>>1, 1);
+                        height = osg::maximum(height>>1, 1);
+                    }
+                }
+                else
+                {
+                    gluBuild2DMipmaps( target, _internalFormat,
+                        inwidth,inheight,
+                        (GLenum)image->getPixelFormat(), (GLenum)image->getDataType(),
+                        dataPtr);
+
+                    int width  = image->s();
+                    int height = image->t();
+                    for( numMipmapLevels = 0 ; (width || height) ; ++numMipmapLevels)
+                    {
+                        width >>= 1;
+                        height >>= 1;
+                    }
                 }
             }
             else
@@ -2566,14 +2687,20 @@ void Texture::applyTexImage2D_subload(State& state, GLenum target, const Image*
         else { OSG_NOTICE << "Scaling image from ("<<image->s()<<","<<image->t()<<") to ("<<inwidth<<","<<inheight<<")"<<std::endl; }
 
         // rescale the image to the correct size.
-        PixelStorageModes psm;
-        psm.pack_alignment = image->getPacking();
-        psm.unpack_alignment = image->getPacking();
-
-        gluScaleImage(&psm, image->getPixelFormat(),
-                      image->s(),image->t(),image->getDataType(),image->data(),
-                      inwidth,inheight,image->getDataType(),
-                      dataPtr);
+        if (!osg::resampleImageData(image->getPixelFormat(),
+                                    image->s(), image->t(), image->getDataType(), image->data(), image->getRowStepInBytes(),
+                                    inwidth, inheight, image->getDataType(), dataPtr,
+                                    osg::Image::computeRowWidthInBytes(inwidth,image->getPixelFormat(),image->getDataType(),image->getPacking())))
+        {
+            PixelStorageModes psm;
+            psm.pack_alignment = image->getPacking();
+            psm.unpack_alignment = image->getPacking();
+
+            gluScaleImage(&psm, image->getPixelFormat(),
+                          image->s(),image->t(),image->getDataType(),image->data(),
+                          inwidth,inheight,image->getDataType(),
+                          dataPtr);
+        }
 
         rowLength = 0;
     }
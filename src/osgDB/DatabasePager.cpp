@@ -22,6 +22,7 @@
 #include <osg/Texture>
 #include <osg/Notify>
 #include <osg/ProxyNode>
+#include <osg/Profiler>
 #include <osg/ApplicationUsage>
 
 #include <OpenThreads/ScopedLock>
@@ -47,6 +48,7 @@ static osg::ApplicationUsageProxy DatabasePager_e0(osg::ApplicationUsage::ENVIRO
 static osg::ApplicationUsageProxy DatabasePager_e3(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_DATABASE_PAGER_DRAWABLE <mode>","Set the drawable policy for setting of loaded drawable to specified type.  mode can be one of DoNotModify, DisplayList, VBO or VertexArrays>.");
 static osg::ApplicationUsageProxy DatabasePager_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_DATABASE_PAGER_PRIORITY <mode>", "Set the thread priority to DEFAULT, MIN, LOW, NOMINAL, HIGH or MAX.");
 static osg::ApplicationUsageProxy DatabasePager_e11(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_MAX_PAGEDLOD <num>","Set the target maximum number of PagedLOD to maintain.");
+static osg::ApplicationUsageProxy DatabasePager_e13(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_DATABASE_PAGER_TEXTURE_COMPRESSION <mode>","Compress the images of loaded textures on the CPU. mode can be one of OFF, DXT1, DXT3, DXT5, RGTC1, RGTC2 or BPTC.");
 static osg::ApplicationUsageProxy DatabasePager_e12(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_ASSIGN_PBO_TO_IMAGES <ON/OFF>","Set whether PixelBufferObjects should be assigned to Images to aid download to the GPU.");
 
 
@@ -247,7 +249,9 @@ public:
             osgUtil::StateToCompile(osgUtil::GLObjectsVisitor::COMPILE_DISPLAY_LISTS|osgUtil::GLObjectsVisitor::COMPILE_STATE_ATTRIBUTES, markerObject),
             _pager(pager),
             _changeAutoUnRef(false), _valueAutoUnRef(false),
-            _changeAnisotropy(false), _valueAnisotropy(1.0)
+            _changeAnisotropy(false), _valueAnisotropy(1.0),
+            _textureCompressionFormat(osg::Texture::USE_IMAGE_DATA_FORMAT),
+            _textureCompressionQuality(ImageProcessor::FASTEST)
     {
         _assignPBOToImages = _pager->_assignPBOToImages;
 
@@ -255,6 +259,14 @@ public:
         _valueAutoUnRef = _pager->_valueAutoUnRef;
         _changeAnisotropy = _pager->_changeAnisotropy;
         _valueAnisotropy = _pager->_valueAnisotropy;
+        _textureCompressionFormat = _pager->_textureCompressionFormat;
+        _textureCompressionQuality = _pager->_textureCompressionQuality;
+
+        if (_textureCompressionFormat!=osg::Texture::USE_IMAGE_DATA_FORMAT)
+        {
+            _imageProcessor = osgDB::Registry::instance()->getImageProcessor();
+            if (!_imageProcessor) _imageProcessor = new DefaultImageProcessor;
+        }
 
         switch(_pager->_drawablePolicy)
         {
@@ -320,6 +332,11 @@ public:
             {
                 texture.setMaxAnisotropy(_valueAnisotropy);
             }
+
+            if (_imageProcessor.valid())
+            {
+                compressImages(texture);
+            }
         }
 
         StateToCompile::apply(texture);
@@ -331,11 +348,37 @@ public:
 
     }
 
+    void compressImages(osg::Texture& texture)
+    {
+        osg::Texture::FilterMode minFilter = texture.getFilter(osg::Texture::MIN_FILTER);
+        bool mipmapped = minFilter!=osg::Texture::LINEAR && minFilter!=osg::Texture::NEAREST;
+
+        for(unsigned int i=0; i<texture.getNumImages(); ++i)
+        {
+            osg::ref_ptr<osg::Image> image = texture.getImage(i);
+            if (!image || !image->data() || image->isCompressed() || image->getDataVariance()==osg::Object::DYNAMIC) continue;
+
+            // referenced by more than the texture and the ref_ptr above, the image is shared, such as through the Registry's
+            // object cache, so compress a copy of it rather than changing it under the other users.
+            if (image->referenceCount()>2)
+            {
+                image = new osg::Image(*image, osg::CopyOp::DEEP_COPY_ALL);
+            }
+
+            _imageProcessor->compress(*image, _textureCompressionFormat, mipmapped && !image->isMipmap(), false, ImageProcessor::USE_CPU, _textureCompressionQuality);
+
+            if (image.get()!=texture.getImage(i)) texture.setImage(i, image.get());
+        }
+    }
+
     const DatabasePager*                    _pager;
     bool                                    _changeAutoUnRef;
     bool                                    _valueAutoUnRef;
     bool                                    _changeAnisotropy;
     float                                   _valueAnisotropy;
+    osg::Texture::InternalFormatMode        _textureCompressionFormat;
+    ImageProcessor::CompressionQuality      _textureCompressionQuality;
+    osg::ref_ptr<ImageProcessor>            _imageProcessor;
     osg::ref_ptr<osg::KdTreeBuilder>        _kdTreeBuilder;
 
 protected:
@@ -643,6 +686,7 @@ void DatabasePager::DatabaseThread::run()
 {
     OSG_INFO<<_name<<": DatabasePager::DatabaseThread::run"<<std::endl;
 
+    osg::Profiler::instance()->setThreadName(_name);
 
     bool firstTime = true;
 
@@ -854,6 +898,8 @@ void DatabasePager::DatabaseThread::run()
             //osg::Timer_t before = osg::Timer::instance()->tick();
 
 
+            osg::ProfileZone zone("DatabasePager read");
+
             // assume that readNode is thread safe...
             ReaderWriter::ReadResult rr = readFromFileCache ?
                         fileCache->readNode(fileName, dr_loadOptions.get(), false) :
@@ -1023,6 +1069,20 @@ DatabasePager::DatabasePager()
     _changeAnisotropy = false;
     _valueAnisotropy = 1.0f;
 
+    _textureCompressionFormat = osg::Texture::USE_IMAGE_DATA_FORMAT;
+    _textureCompressionQuality = ImageProcessor::FASTEST;
+    if( (str = getenv("OSG_DATABASE_PAGER_TEXTURE_COMPRESSION")) != 0)
+    {
+        if (strcmp(str,"DXT1")==0)       _textureCompressionFormat = osg::Texture::USE_S3TC_DXT1_COMPRESSION;
+        else if (strcmp(str,"DXT3")==0)  _textureCompressionFormat = osg::Texture::USE_S3TC_DXT3_COMPRESSION;
+        else if (strcmp(str,"DXT5")==0)  _textureCompressionFormat = osg::Texture::USE_S3TC_DXT5_COMPRESSION;
+        else if (strcmp(str,"RGTC1")==0) _textureCompressionFormat = osg::Texture::USE_RGTC1_COMPRESSION;
+        else if (strcmp(str,"RGTC2")==0) _textureCompressionFormat = osg::Texture::USE_RGTC2_COMPRESSION;
+        else if (strcmp(str,"BPTC")==0)  _textureCompressionFormat = osg::Texture::USE_BPTC_COMPRESSION;
+
+        OSG_NOTICE<<"OSG_DATABASE_PAGER_TEXTURE_COMPRESSION set to "<<str<<std::endl;
+    }
+
 
     _deleteRemovedSubgraphsInDatabaseThread = true;
     if( (str = getenv("OSG_DELETE_IN_DATABASE_THREAD")) != 0)
@@ -1116,6 +1176,9 @@ DatabasePager::DatabasePager(const DatabasePager& rhs)
     _changeAnisotropy = rhs._changeAnisotropy;
     _valueAnisotropy = rhs._valueAnisotropy;
 
+    _textureCompressionFormat = rhs._textureCompressionFormat;
+    _textureCompressionQuality = rhs._textureCompressionQuality;
+
     _deleteRemovedSubgraphsInDatabaseThread = rhs._deleteRemovedSubgraphsInDatabaseThread;
 
     _targetMaximumNumberOfPageLOD = rhs._targetMaximumNumberOfPageLOD;
@@ -1563,6 +1626,7 @@ bool DatabasePager::requiresUpdateSceneGraph() const
 
 void DatabasePager::updateSceneGraph(const osg::FrameStamp& frameStamp)
 {
+    osg::ProfileZone zone("DatabasePager merge");
 
 #define UPDATE_TIMING 0
 #if UPDATE_TIMING
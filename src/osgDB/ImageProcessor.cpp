@@ -0,0 +1,114 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgDB/ImageProcessor>
+#include <osg/ImageUtils>
+#include <osg/Notify>
+
+using namespace osgDB;
+
+static bool hasAlpha(GLenum pixelFormat)
+{
+    return pixelFormat==GL_RGBA || pixelFormat==GL_BGRA || pixelFormat==GL_LUMINANCE_ALPHA;
+}
+
+void DefaultImageProcessor::compress(osg::Image& image, osg::Texture::InternalFormatMode compressedFormat, bool generateMipMap, bool resizeToPOT, CompressionMethod /*method*/, CompressionQuality quality)
+{
+    if (image.isCompressed()) return;
+
+    GLenum format = 0;
+    switch(compressedFormat)
+    {
+        case(osg::Texture::USE_S3TC_DXT1_COMPRESSION):
+            format = hasAlpha(image.getPixelFormat()) ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            break;
+        case(osg::Texture::USE_S3TC_DXT1c_COMPRESSION):
+            format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            break;
+        case(osg::Texture::USE_S3TC_DXT1a_COMPRESSION):
+            format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            break;
+        case(osg::Texture::USE_S3TC_DXT3_COMPRESSION):
+            format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+            break;
+        case(osg::Texture::USE_S3TC_DXT5_COMPRESSION):
+            format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            break;
+        case(osg::Texture::USE_RGTC1_COMPRESSION):
+            format = GL_COMPRESSED_RED_RGTC1_EXT;
+            break;
+        case(osg::Texture::USE_RGTC2_COMPRESSION):
+            format = GL_COMPRESSED_RED_GREEN_RGTC2_EXT;
+            break;
+        case(osg::Texture::USE_BPTC_COMPRESSION):
+            format = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+            break;
+        default:
+            OSG_WARN<<"DefaultImageProcessor::compress(..) Invalid or not supported compress format"<<std::endl;
+            return;
+    }
+
+    if (!osg::isBlockCompressionSupported(image.getPixelFormat(), image.getDataType(), format))
+    {
+        OSG_WARN<<"DefaultImageProcessor::compress(..) image pixel format or data type not supported"<<std::endl;
+        return;
+    }
+
+    osg::BlockCompressionQuality blockQuality = osg::BLOCK_COMPRESSION_NORMAL;
+    switch(quality)
+    {
+        case(FASTEST):      blockQuality = osg::BLOCK_COMPRESSION_FAST; break;
+        case(NORMAL):       blockQuality = osg::BLOCK_COMPRESSION_NORMAL; break;
+        case(PRODUCTION):
+        case(HIGHEST):      blockQuality = osg::BLOCK_COMPRESSION_HIGH; break;
+    }
+
+    if (resizeToPOT) resizeToPowerOfTwo(image);
+
+    if (generateMipMap && !image.isMipmap()) osg::generateMipmaps(&image);
+
+    osg::compressImage(image, format, blockQuality);
+}
+
+void DefaultImageProcessor::generateMipMap(osg::Image& image, bool resizeToPOT, CompressionMethod /*method*/)
+{
+    if (image.isCompressed()) return;
+
+    if (resizeToPOT) resizeToPowerOfTwo(image);
+
+    if (!osg::generateMipmaps(&image))
+    {
+        OSG_WARN<<"DefaultImageProcessor::generateMipMap(..) image pixel format or data type not supported"<<std::endl;
+    }
+}
+
+void DefaultImageProcessor::resizeToPowerOfTwo(osg::Image& image)
+{
+    int s = osg::Image::computeNearestPowerOfTwo(image.s());
+    int t = osg::Image::computeNearestPowerOfTwo(image.t());
+    if (s==image.s() && t==image.t()) return;
+
+    if (!osg::isResampleSupported(image.getPixelFormat(), image.getDataType()) || image.r()!=1) return;
+
+    // resampling only uses the base level, so any existing mipmaps are discarded.
+    osg::ref_ptr<osg::Image> resized = new osg::Image;
+    resized->allocateImage(s, t, 1, image.getPixelFormat(), image.getDataType(), image.getPacking());
+    if (!osg::resampleImage(&image, resized.get(), osg::RESAMPLE_BILINEAR)) return;
+
+    image.setImage(s, t, 1,
+                   image.getInternalTextureFormat(), image.getPixelFormat(), image.getDataType(),
+                   resized->data(), osg::Image::USE_NEW_DELETE, image.getPacking());
+
+    // ownership of the data has passed to image
+    resized->setAllocationMode(osg::Image::NO_DELETE);
+}
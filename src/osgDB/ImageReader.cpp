@@ -0,0 +1,263 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+#include <osgDB/ImageReader>
+#include <osgDB/Registry>
+#include <osgDB/FileNameUtils>
+
+#include <osg/ImageUtils>
+#include <osg/Notify>
+
+#include <OpenThreads/ScopedLock>
+
+#include <string.h>
+#include <math.h>
+
+using namespace osgDB;
+
+ImageReader::ImageReader():
+    osg::Object(true),
+    _internalTextureFormat(0),
+    _pixelFormat(0),
+    _dataType(0),
+    _cacheSize(0),
+    _maximumCacheSize(64*1024*1024)
+{
+}
+
+ImageReader::ImageReader(const ImageReader& reader, const osg::CopyOp& copyop):
+    osg::Object(reader, copyop),
+    _internalTextureFormat(0),
+    _pixelFormat(0),
+    _dataType(0),
+    _cacheSize(0),
+    _maximumCacheSize(reader.getMaximumCacheSize())
+{
+}
+
+ImageReader::~ImageReader()
+{
+}
+
+void ImageReader::setMaximumCacheSize(unsigned int size)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+    _maximumCacheSize = size;
+    trimCache(_maximumCacheSize);
+}
+
+unsigned int ImageReader::getCacheSize() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+    return _cacheSize;
+}
+
+void ImageReader::clearCache()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+    trimCache(0);
+}
+
+void ImageReader::trimCache(unsigned int size)
+{
+    // remove the least recently used tiles, which are kept at the back of the list.
+    while(_cacheSize>size && !_lruList.empty())
+    {
+        TileCache::iterator itr = _tileCache.find(_lruList.back());
+        if (itr!=_tileCache.end())
+        {
+            _cacheSize -= itr->second.image->getTotalSizeInBytes();
+            _tileCache.erase(itr);
+        }
+        _lruList.pop_back();
+    }
+}
+
+osg::ref_ptr<osg::Image> ImageReader::getTile(unsigned int level, int tileX, int tileY)
+{
+    TileKey key(level, tileX, tileY);
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+        TileCache::iterator itr = _tileCache.find(key);
+        if (itr!=_tileCache.end())
+        {
+            _lruList.splice(_lruList.begin(), _lruList, itr->second.lruPosition);
+            return itr->second.image;
+        }
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> readLock(_readMutex);
+
+    {
+        // another thread may have decoded the tile while we were waiting on the read mutex.
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+        TileCache::iterator itr = _tileCache.find(key);
+        if (itr!=_tileCache.end()) return itr->second.image;
+    }
+
+    const Level& levelInfo = _levels[level];
+
+    osg::ref_ptr<osg::Image> tile = new osg::Image;
+    tile->allocateImage(levelInfo.tileWidth, levelInfo.tileHeight, 1, _pixelFormat, _dataType, 1);
+    if (!tile->data()) return 0;
+
+    if (!readTile(level, tileX, tileY, *tile))
+    {
+        OSG_NOTICE<<"ImageReader::getTile("<<level<<", "<<tileX<<", "<<tileY<<") failed to decode tile of "<<_fileName<<std::endl;
+        return 0;
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+
+    _lruList.push_front(key);
+
+    CachedTile& cachedTile = _tileCache[key];
+    cachedTile.image = tile;
+    cachedTile.lruPosition = _lruList.begin();
+
+    _cacheSize += tile->getTotalSizeInBytes();
+
+    trimCache(_maximumCacheSize);
+
+    return tile;
+}
+
+osg::Image* ImageReader::readImage(int x, int y, int width, int height, unsigned int level)
+{
+    if (level>=_levels.size() || width<=0 || height<=0) return 0;
+
+    const Level& levelInfo = _levels[level];
+    if (levelInfo.tileWidth<=0 || levelInfo.tileHeight<=0) return 0;
+
+    osg::ref_ptr<osg::Image> image = new osg::Image;
+    image->allocateImage(width, height, 1, _pixelFormat, _dataType, 1);
+    if (!image->data()) return 0;
+
+    image->setInternalTextureFormat(_internalTextureFormat);
+    image->setFileName(_fileName);
+    memset(image->data(), 0, image->getTotalSizeInBytes());
+
+    unsigned int pixelSize = osg::Image::computePixelSizeInBits(_pixelFormat, _dataType)/8;
+
+    // clip the window against the level, converting to file rows which run from the top of the raster down.
+    int columnBegin = osg::maximum(x, 0);
+    int columnEnd = osg::minimum(x+width, levelInfo.width);
+    int rowBegin = osg::maximum(levelInfo.height-(y+height), 0);
+    int rowEnd = osg::minimum(levelInfo.height-y, levelInfo.height);
+
+    if (columnBegin>=columnEnd || rowBegin>=rowEnd) return image.release();
+
+    int tw = levelInfo.tileWidth;
+    int th = levelInfo.tileHeight;
+
+    for(int ty = rowBegin/th; ty <= (rowEnd-1)/th; ++ty)
+    {
+        int tileRowBegin = osg::maximum(rowBegin, ty*th);
+        int tileRowEnd = osg::minimum(rowEnd, (ty+1)*th);
+
+        for(int tx = columnBegin/tw; tx <= (columnEnd-1)/tw; ++tx)
+        {
+            osg::ref_ptr<osg::Image> tile = getTile(level, tx, ty);
+            if (!tile) continue;
+
+            int tileColumnBegin = osg::maximum(columnBegin, tx*tw);
+            int tileColumnEnd = osg::minimum(columnEnd, (tx+1)*tw);
+            unsigned int rowSize = (tileColumnEnd-tileColumnBegin)*pixelSize;
+
+            for(int row = tileRowBegin; row < tileRowEnd; ++row)
+            {
+                int imageRow = (levelInfo.height-1-row) - y;
+                memcpy(image->data(tileColumnBegin-x, imageRow), tile->data(tileColumnBegin-tx*tw, row-ty*th), rowSize);
+            }
+        }
+    }
+
+    return image.release();
+}
+
+unsigned int ImageReader::getLevelForResolution(int width, int height, int destWidth, int destHeight) const
+{
+    if (_levels.empty() || _levels[0].width<=0 || _levels[0].height<=0) return 0;
+
+    for(unsigned int level = static_cast<unsigned int>(_levels.size())-1; level>0; --level)
+    {
+        double scaleX = double(_levels[level].width)/double(_levels[0].width);
+        double scaleY = double(_levels[level].height)/double(_levels[0].height);
+        if (double(width)*scaleX>=double(destWidth) && double(height)*scaleY>=double(destHeight)) return level;
+    }
+
+    return 0;
+}
+
+osg::Image* ImageReader::readImage(int x, int y, int width, int height, int destWidth, int destHeight)
+{
+    if (_levels.empty() || width<=0 || height<=0 || destWidth<=0 || destHeight<=0) return 0;
+
+    unsigned int level = getLevelForResolution(width, height, destWidth, destHeight);
+
+    double scaleX = double(_levels[level].width)/double(_levels[0].width);
+    double scaleY = double(_levels[level].height)/double(_levels[0].height);
+
+    // snap the window to whole pixels of the chosen level.
+    int levelX = int(floor(double(x)*scaleX));
+    int levelY = int(floor(double(y)*scaleY));
+    int levelWidth = osg::maximum(int(ceil(double(x+width)*scaleX))-levelX, 1);
+    int levelHeight = osg::maximum(int(ceil(double(y+height)*scaleY))-levelY, 1);
+
+    osg::ref_ptr<osg::Image> image = readImage(levelX, levelY, levelWidth, levelHeight, level);
+    if (!image) return 0;
+
+    if (image->s()==destWidth && image->t()==destHeight) return image.release();
+
+    osg::ref_ptr<osg::Image> destImage = new osg::Image;
+    destImage->allocateImage(destWidth, destHeight, 1, _pixelFormat, _dataType, 1);
+    if (!destImage->data()) return 0;
+
+    destImage->setInternalTextureFormat(_internalTextureFormat);
+    destImage->setFileName(_fileName);
+
+    if (!osg::resampleImage(image.get(), destImage.get(), osg::RESAMPLE_BILINEAR))
+    {
+        OSG_NOTICE<<"ImageReader::readImage() unable to resample "<<_fileName<<" level "<<level<<" to "<<destWidth<<"x"<<destHeight<<std::endl;
+        return 0;
+    }
+
+    return destImage.release();
+}
+
+ImageReader* osgDB::openImageReader(const std::string& filename)
+{
+    return openImageReader(filename, Registry::instance()->getOptions());
+}
+
+ImageReader* osgDB::openImageReader(const std::string& filename, const Options* options)
+{
+    std::string ext = getLowerCaseFileExtension(filename);
+
+    ReaderWriter* rw = Registry::instance()->getReaderWriterForExtension(ext);
+    if (!rw)
+    {
+        OSG_NOTICE<<"openImageReader("<<filename<<") no ReaderWriter available for extension '"<<ext<<"'"<<std::endl;
+        return 0;
+    }
+
+    ReaderWriter::ReadResult rr = rw->openImageReader(filename, options);
+    if (rr.error()) OSG_NOTICE<<"openImageReader("<<filename<<") "<<rr.message()<<std::endl;
+
+    osg::ref_ptr<ImageReader> reader = dynamic_cast<ImageReader*>(rr.getObject());
+
+    // release the ReadResult's reference so that the reader can be handed back to the caller.
+    rr = ReaderWriter::ReadResult();
+
+    return reader.release();
+}
@@ -0,0 +1,191 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+#include <osgDB/MappedFile>
+#include <osgDB/fstream>
+#include <osgDB/ConvertUTF>
+
+#include <osg/Notify>
+
+#if defined(WIN32) && !defined(__CYGWIN__)
+    #include <windows.h>
+#else
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace osgDB;
+
+MappedFile::MappedFile():
+    _data(0),
+    _size(0),
+    _mapped(false)
+#if defined(WIN32) && !defined(__CYGWIN__)
+    ,_fileHandle(INVALID_HANDLE_VALUE),
+    _mappingHandle(0)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    if (map(filename)) return true;
+
+    // mapping isn't available, or failed, so fall back to reading the whole file into memory.
+    return read(filename);
+}
+
+#if defined(WIN32) && !defined(__CYGWIN__)
+
+bool MappedFile::map(const std::string& filename)
+{
+#ifdef OSG_USE_UTF8_FILENAME
+    HANDLE fileHandle = CreateFileW(convertUTF8toUTF16(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+#else
+    HANDLE fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+#endif
+    if (fileHandle==INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart==0 || static_cast<unsigned long long>(fileSize.QuadPart)>static_cast<size_t>(-1))
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mappingHandle)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    _fileHandle = fileHandle;
+    _mappingHandle = mappingHandle;
+    _data = static_cast<const char*>(data);
+    _size = static_cast<size_t>(fileSize.QuadPart);
+    _mapped = true;
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_mapped)
+    {
+        UnmapViewOfFile(_data);
+        CloseHandle(_mappingHandle);
+        CloseHandle(_fileHandle);
+        _fileHandle = INVALID_HANDLE_VALUE;
+        _mappingHandle = 0;
+    }
+
+    _data = 0;
+    _size = 0;
+    _mapped = false;
+    std::vector<char>().swap(_buffer);
+}
+
+#else
+
+bool MappedFile::map(const std::string& filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd<0) return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat)!=0 || fileStat.st_size==0 || !S_ISREG(fileStat.st_mode))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(fileStat.st_size);
+    void* data = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping holds its own reference to the file so the descriptor is no longer needed.
+    ::close(fd);
+
+    if (data==MAP_FAILED) return false;
+
+#if defined(MADV_SEQUENTIAL)
+    madvise(data, size, MADV_SEQUENTIAL);
+#endif
+
+    _data = static_cast<const char*>(data);
+    _size = size;
+    _mapped = true;
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_mapped)
+    {
+        munmap(const_cast<char*>(_data), _size);
+    }
+
+    _data = 0;
+    _size = 0;
+    _mapped = false;
+    std::vector<char>().swap(_buffer);
+}
+
+#endif
+
+bool MappedFile::read(const std::string& filename)
+{
+    osgDB::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!fin) return false;
+
+    fin.seekg(0, std::ios::end);
+    std::streamoff size = fin.tellg();
+    fin.seekg(0, std::ios::beg);
+    if (size<0) return false;
+
+    // keep a valid, if empty, pointer for empty files so that valid() reports the file as opened.
+    _buffer.resize(static_cast<size_t>(size)+1);
+    if (size>0) fin.read(&_buffer[0], size);
+    if (!fin)
+    {
+        OSG_NOTICE<<"MappedFile::read("<<filename<<") failed to read file."<<std::endl;
+        std::vector<char>().swap(_buffer);
+        return false;
+    }
+
+    _buffer[static_cast<size_t>(size)] = 0;
+
+    _data = &_buffer[0];
+    _size = static_cast<size_t>(size);
+    _mapped = false;
+
+    return true;
+}
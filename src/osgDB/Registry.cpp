@@ -22,6 +22,7 @@
 #include <osg/Group>
 #include <osg/Geode>
 #include <osg/ApplicationUsage>
+#include <osg/Profiler>
 #include <osg/Version>
 #include <osg/Timer>
 
@@ -1138,6 +1139,8 @@ std::string Registry::findLibraryFileImplementation(const std::string& filename,
 
 ReaderWriter::ReadResult Registry::read(const ReadFunctor& readFunctor)
 {
+    osg::ProfileZone zone("osgDB read");
+
     for(ArchiveExtensionList::iterator aitr=_archiveExtList.begin();
         aitr!=_archiveExtList.end();
         ++aitr)
@@ -16,11 +16,18 @@
 #include <osgDB/WriteFile>
 #include <osgDB/Registry>
 
+#include <osg/ApplicationUsage>
+
+#include <OpenThreads/ScopedLock>
+
 #include <iostream>
 #include <sstream>
 #include <fstream>
 
 #include <string.h>
+#include <stdlib.h>
+
+#include <algorithm>
 
 #include <curl/curl.h>
 
@@ -36,6 +43,9 @@
 
 using namespace osg_curl;
 
+static osg::ApplicationUsageProxy CURL_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_CURL_MULTI <mode>","ON | OFF - perform reads on a single transfer thread through the curl multi interface, default OFF.");
+static osg::ApplicationUsageProxy CURL_e1(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_CURL_MAX_HOST_CONNECTIONS <num>","Maximum number of connections to a single host opened by the curl multi interface, default 0 = no limit.");
+
 
 //
 //  StreamObject
@@ -167,7 +177,7 @@ osgDB::ReaderWriter::ReadResult EasyCurl::read(const std::string& proxyAddress,
     CURLcode responseCode = curl_easy_perform(_curl);
     curl_easy_setopt(_curl, CURLOPT_WRITEDATA, (void *)0);
 
-    return processResponse(responseCode, proxyAddress, fileName, sp);
+    return processResponse(_curl, responseCode, proxyAddress, fileName, sp);
 }
 
 osgDB::ReaderWriter::WriteResult EasyCurl::write(const std::string& proxyAddress, const std::string& fileName, StreamObject& sp, const osgDB::ReaderWriter::Options *options)
@@ -215,7 +225,7 @@ osgDB::ReaderWriter::WriteResult EasyCurl::write(const std::string& proxyAddress
 
     curl_easy_setopt(_curl, CURLOPT_WRITEDATA, (void *)0);
 
-    if (processResponse(responseCode, proxyAddress, fileName, sp).success())
+    if (processResponse(_curl, responseCode, proxyAddress, fileName, sp).success())
     {
         osgDB::ReaderWriter::WriteResult result(osgDB::ReaderWriter::WriteResult::FILE_SAVED);
         std::stringstream* ss = dynamic_cast<std::stringstream*>(sp._outputStream);
@@ -302,7 +312,7 @@ void EasyCurl::setOptions(const std::string& proxyAddress, const std::string& fi
     curl_easy_setopt(_curl, CURLOPT_WRITEDATA, (void *)&sp);
 }
 
-osgDB::ReaderWriter::ReadResult EasyCurl::processResponse(CURLcode res, const std::string& proxyAddress, const std::string& fileName, StreamObject& sp)
+osgDB::ReaderWriter::ReadResult EasyCurl::processResponse(CURL* curl, CURLcode res, const std::string& proxyAddress, const std::string& fileName, StreamObject& sp)
 {
     if (res==0)
     {
@@ -311,11 +321,11 @@ osgDB::ReaderWriter::ReadResult EasyCurl::processResponse(CURLcode res, const st
         long code;
         if(!proxyAddress.empty())
         {
-            curl_easy_getinfo(_curl, CURLINFO_HTTP_CONNECTCODE, &code);
+            curl_easy_getinfo(curl, CURLINFO_HTTP_CONNECTCODE, &code);
         }
         else
         {
-            curl_easy_getinfo(_curl, CURLINFO_RESPONSE_CODE, &code);
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
         }
 
         //If the code is greater than 400, there was an error
@@ -350,7 +360,7 @@ osgDB::ReaderWriter::ReadResult EasyCurl::processResponse(CURLcode res, const st
         // Store the mime-type, if any. (Note: CURL manages the buffer returned by
         // this call.)
         char* ctbuf = NULL;
-        if ( curl_easy_getinfo(_curl, CURLINFO_CONTENT_TYPE, &ctbuf) == 0 && ctbuf )
+        if ( curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &ctbuf) == 0 && ctbuf )
         {
             sp._resultMimeType = ctbuf;
         }
@@ -371,12 +381,266 @@ osgDB::ReaderWriter::ReadResult EasyCurl::processResponse(CURLcode res, const st
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  MultiCurl
+//
+void MultiCurl::Request::complete(const osgDB::ReaderWriter::ReadResult& rr)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex);
+    result = rr;
+    completed = true;
+    condition.broadcast();
+}
+
+osgDB::ReaderWriter::ReadResult MultiCurl::Request::wait()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex);
+    while(!completed) condition.wait(&mutex);
+    return result;
+}
+
+MultiCurl::MultiCurl():
+    _multi(0),
+    _maxHostConnections(0),
+    _started(false),
+    _done(false)
+{
+    OSG_INFO<<"MultiCurl::MultiCurl()"<<std::endl;
+
+    _multi = curl_multi_init();
+
+#if LIBCURL_VERSION_NUM >= 0x072b00
+    // multiplex the requests to a host over a single HTTP/2 connection where the server supports it.
+    curl_multi_setopt(_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+}
+
+MultiCurl::~MultiCurl()
+{
+    OSG_INFO<<"MultiCurl::~MultiCurl()"<<std::endl;
+
+    cancel();
+
+    for(std::vector<CURL*>::iterator itr = _idleHandles.begin(); itr != _idleHandles.end(); ++itr)
+    {
+        curl_easy_cleanup(*itr);
+    }
+
+    if (_multi) curl_multi_cleanup(_multi);
+    _multi = 0;
+}
+
+int MultiCurl::cancel()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _done = true;
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    if (_multi) curl_multi_wakeup(_multi);
+#endif
+
+    if (isRunning()) join();
+
+    // requests that were submitted too late for the transfer thread to pick up.
+    Requests pending;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        pending.swap(_pending);
+    }
+    failAll(pending);
+
+    return 0;
+}
+
+osgDB::ReaderWriter::ReadResult MultiCurl::read(const std::string& proxyAddress, const std::string& fileName, EasyCurl::StreamObject& sp, const osgDB::ReaderWriter::Options *options,
+                                                long connectTimeout, long timeout, long sslVerifyPeer)
+{
+    osg::ref_ptr<Request> request = new Request;
+    request->fileName = fileName;
+    request->proxyAddress = proxyAddress;
+    request->sp = &sp;
+    request->connectTimeout = connectTimeout;
+    request->timeout = timeout;
+    request->sslVerifyPeer = sslVerifyPeer;
+
+    // the options are only valid in this thread, so resolve the authentication details before submitting the request.
+    const osgDB::AuthenticationMap* authenticationMap = (options && options->getAuthenticationMap()) ?
+            options->getAuthenticationMap() :
+            osgDB::Registry::instance()->getAuthenticationMap();
+
+    const osgDB::AuthenticationDetails* details = authenticationMap ?
+        authenticationMap->getAuthenticationDetails(fileName) :
+        0;
+
+    if (details)
+    {
+        request->userPassword = details->username + ":" + details->password;
+        request->httpAuthentication = details->httpAuthentication;
+    }
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+        if (_done) return osgDB::ReaderWriter::ReadResult::FILE_NOT_HANDLED;
+
+        if (!_started)
+        {
+#if LIBCURL_VERSION_NUM >= 0x071e00
+            if (_maxHostConnections>0) curl_multi_setopt(_multi, CURLMOPT_MAX_HOST_CONNECTIONS, _maxHostConnections);
+#endif
+            _started = true;
+            startThread();
+        }
+
+        _pending.push_back(request);
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_wakeup(_multi);
+#endif
+
+    return request->wait();
+}
+
+void MultiCurl::run()
+{
+    while(true)
+    {
+        Requests requests;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            if (_done) break;
+            requests.swap(_pending);
+        }
+
+        startTransfers(requests);
+
+        int numRunning = 0;
+        curl_multi_perform(_multi, &numRunning);
+
+        completeTransfers();
+
+        // wait for socket activity, a transfer timeout or a new request to be submitted.
+#if LIBCURL_VERSION_NUM >= 0x074400
+        curl_multi_poll(_multi, NULL, 0, 1000, NULL);
+#else
+        curl_multi_wait(_multi, NULL, 0, 10, NULL);
+#endif
+    }
+
+    for(Requests::iterator itr = _active.begin(); itr != _active.end(); ++itr)
+    {
+        curl_multi_remove_handle(_multi, (*itr)->handle);
+        _idleHandles.push_back((*itr)->handle);
+        (*itr)->handle = 0;
+    }
+
+    Requests active;
+    active.swap(_active);
+    failAll(active);
+}
+
+void MultiCurl::startTransfers(Requests& requests)
+{
+    for(Requests::iterator itr = requests.begin(); itr != requests.end(); ++itr)
+    {
+        Request* request = itr->get();
+
+        CURL* curl = 0;
+        if (!_idleHandles.empty())
+        {
+            curl = _idleHandles.back();
+            _idleHandles.pop_back();
+        }
+        else
+        {
+            curl = curl_easy_init();
+        }
+
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, EasyCurl::StreamMemoryCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)request->sp);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_URL, request->fileName.c_str());
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, (void *)request);
+
+        if (request->connectTimeout > 0) curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, request->connectTimeout);
+        if (request->timeout > 0) curl_easy_setopt(curl, CURLOPT_TIMEOUT, request->timeout);
+        if (!request->proxyAddress.empty()) curl_easy_setopt(curl, CURLOPT_PROXY, request->proxyAddress.c_str());
+
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, request->sslVerifyPeer);
+
+        if (!request->userPassword.empty())
+        {
+            curl_easy_setopt(curl, CURLOPT_USERPWD, request->userPassword.c_str());
+#if LIBCURL_VERSION_NUM >= 0x070a07
+            curl_easy_setopt(curl, CURLOPT_HTTPAUTH, request->httpAuthentication);
+#endif
+        }
+
+#if LIBCURL_VERSION_NUM >= 0x072f00
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072b00
+        // wait for a connection that can be multiplexed rather than opening another one.
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+#endif
+
+        request->handle = curl;
+        curl_multi_add_handle(_multi, curl);
+        _active.push_back(request);
+    }
+}
+
+void MultiCurl::completeTransfers()
+{
+    int numMessages = 0;
+    while(CURLMsg* message = curl_multi_info_read(_multi, &numMessages))
+    {
+        if (message->msg!=CURLMSG_DONE) continue;
+
+        // the message is invalidated by removing its handle, so copy what's needed first.
+        CURL* curl = message->easy_handle;
+        CURLcode responseCode = message->data.result;
+
+        char* privateData = 0;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, &privateData);
+        osg::ref_ptr<Request> request = reinterpret_cast<Request*>(privateData);
+
+        osgDB::ReaderWriter::ReadResult rr = EasyCurl::processResponse(curl, responseCode, request->proxyAddress, request->fileName, *(request->sp));
+
+        curl_multi_remove_handle(_multi, curl);
+        curl_easy_reset(curl);
+        _idleHandles.push_back(curl);
+        request->handle = 0;
+
+        Requests::iterator itr = std::find(_active.begin(), _active.end(), request);
+        if (itr != _active.end()) _active.erase(itr);
+
+        request->complete(rr);
+    }
+}
+
+void MultiCurl::failAll(Requests& requests)
+{
+    for(Requests::iterator itr = requests.begin(); itr != requests.end(); ++itr)
+    {
+        (*itr)->complete(osgDB::ReaderWriter::ReadResult(osgDB::ReaderWriter::ReadResult::FILE_NOT_HANDLED));
+    }
+    requests.clear();
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //  ReaderWriterCURL
 //
 
-ReaderWriterCURL::ReaderWriterCURL()
+ReaderWriterCURL::ReaderWriterCURL():
+    _useMultiCurl(false)
 {
     // initialize curl to ensure it's done single threaded
     curl_global_init(CURL_GLOBAL_ALL);
@@ -393,6 +657,16 @@ ReaderWriterCURL::ReaderWriterCURL()
     supportsOption("OSG_CURL_CONNECTTIMEOUT","Specify the connection timeout duration in seconds [default = 0 = not set].");
     supportsOption("OSG_CURL_TIMEOUT","Specify the timeout duration of the whole transfer in seconds [default = 0 = not set].");
     supportsOption("OSG_CURL_SSL_VERIFYPEER","Specify ssl verification peer [default = 1 = set].");
+    supportsOption("OSG_CURL_MULTI","Specify whether reads are performed on the shared curl multi transfer thread [default = 0 = not set, unless enabled by the OSG_CURL_MULTI environment variable].");
+
+    // the transfer thread of the MultiCurl is only started by the first read made through it.
+    _multiCurl = new MultiCurl;
+
+    const char* maxHostConnectionsEnv = getenv("OSG_CURL_MAX_HOST_CONNECTIONS");
+    if (maxHostConnectionsEnv) _multiCurl->setMaxHostConnections(atol(maxHostConnectionsEnv));
+
+    const char* multiEnv = getenv("OSG_CURL_MULTI");
+    _useMultiCurl = multiEnv && (strcmp(multiEnv,"ON")==0 || strcmp(multiEnv,"on")==0 || strcmp(multiEnv,"1")==0);
 }
 
 ReaderWriterCURL::~ReaderWriterCURL()
@@ -401,6 +675,9 @@ ReaderWriterCURL::~ReaderWriterCURL()
 
     _threadCurlMap.clear();
 
+    // stop the transfer thread before curl is cleaned up.
+    _multiCurl = 0;
+
     // clean up curl
     curl_global_cleanup();
 }
@@ -448,7 +725,8 @@ osgDB::ReaderWriter::WriteResult ReaderWriterCURL::writeFile(const osg::Object&
     long connectTimeout = 0;
     long timeout = 0;
     long sslVerifyPeer = 1;
-    getConnectionOptions(options, proxyAddress, connectTimeout, timeout, sslVerifyPeer);
+    bool useMultiCurl = _useMultiCurl;
+    getConnectionOptions(options, proxyAddress, connectTimeout, timeout, sslVerifyPeer, useMultiCurl);
     EasyCurl::StreamObject sp(&responseBuffer, &requestBuffer, std::string());
     EasyCurl& easyCurl = getEasyCurl();
     easyCurl.setConnectionTimeout(connectTimeout);
@@ -477,7 +755,8 @@ void ReaderWriterCURL::getConnectionOptions(const osgDB::ReaderWriter::Options *
     std::string& proxyAddress,
     long& connectTimeout,
     long& timeout,
-    long& sslVerifyPeer) const
+    long& sslVerifyPeer,
+    bool& useMultiCurl) const
 {
     if (options)
     {
@@ -496,6 +775,8 @@ void ReaderWriterCURL::getConnectionOptions(const osgDB::ReaderWriter::Options *
                 timeout = atol(opt.substr( index+1 ).c_str()); // this will return 0 in case of improper format.
             else if( opt.substr(0, index) == "OSG_CURL_SSL_VERIFYPEER" )
                 sslVerifyPeer = atol(opt.substr( index+1 ).c_str()); // this will return 0 in case of improper format.
+            else if( opt.substr(0, index) == "OSG_CURL_MULTI" )
+                useMultiCurl = atol(opt.substr( index+1 ).c_str())!=0;
         }
 
 
@@ -558,7 +839,8 @@ osgDB::ReaderWriter::ReadResult ReaderWriterCURL::readFile(ObjectType objectType
     long connectTimeout = 0;
     long timeout = 0;
     long sslVerifyPeer = 1;
-    getConnectionOptions(options, proxyAddress, connectTimeout, timeout, sslVerifyPeer);
+    bool useMultiCurl = _useMultiCurl;
+    getConnectionOptions(options, proxyAddress, connectTimeout, timeout, sslVerifyPeer, useMultiCurl);
 
     bool uncompress = false;
 
@@ -592,14 +874,23 @@ osgDB::ReaderWriter::ReadResult ReaderWriterCURL::readFile(ObjectType objectType
     std::stringstream buffer;
 
     EasyCurl::StreamObject sp(&buffer, NULL, std::string());
-    EasyCurl& easyCurl = getEasyCurl();
 
-    // setup the timeouts:
-    easyCurl.setConnectionTimeout(connectTimeout);
-    easyCurl.setTimeout(timeout);
-    easyCurl.setSSLVerifyPeer(sslVerifyPeer);
+    ReadResult curlResult;
+    if (useMultiCurl && _multiCurl.valid())
+    {
+        curlResult = _multiCurl->read(proxyAddress, fileName, sp, options, connectTimeout, timeout, sslVerifyPeer);
+    }
+    else
+    {
+        EasyCurl& easyCurl = getEasyCurl();
 
-    ReadResult curlResult = easyCurl.read(proxyAddress, fileName, sp, options);
+        // setup the timeouts:
+        easyCurl.setConnectionTimeout(connectTimeout);
+        easyCurl.setTimeout(timeout);
+        easyCurl.setSSLVerifyPeer(sslVerifyPeer);
+
+        curlResult = easyCurl.read(proxyAddress, fileName, sp, options);
+    }
 
     if (curlResult.status()==ReadResult::FILE_LOADED)
     {
@@ -614,7 +905,7 @@ osgDB::ReaderWriter::ReadResult ReaderWriterCURL::readFile(ObjectType objectType
         // mime-type:
         if ( !reader )
         {
-            std::string mimeType = easyCurl.getResultMimeType(sp);
+            std::string mimeType = sp._resultMimeType;
             OSG_INFO << "CURL: Looking up extension for mime-type " << mimeType << std::endl;
             if ( mimeType.length() > 0 )
             {
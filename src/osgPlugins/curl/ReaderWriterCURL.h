@@ -17,6 +17,12 @@
 #include <osgDB/ReaderWriter>
 #include <osgDB/FileNameUtils>
 
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+
+#include <vector>
+
 namespace osg_curl
 {
 
@@ -85,7 +91,13 @@ class EasyCurl : public osg::Referenced
         EasyCurl& operator = (const EasyCurl&) { return *this; }
 
         void setOptions(const std::string& proxyAddress, const std::string& fileName, StreamObject& sp, const osgDB::ReaderWriter::Options *options);
-        osgDB::ReaderWriter::ReadResult processResponse(CURLcode responseCode, const std::string& proxyAddress, const std::string& fileName, StreamObject& sp);
+
+    public:
+
+        /** Convert the result of a completed transfer on the specified handle into a ReadResult, storing the mime type in sp.*/
+        static osgDB::ReaderWriter::ReadResult processResponse(CURL* curl, CURLcode responseCode, const std::string& proxyAddress, const std::string& fileName, StreamObject& sp);
+
+    protected:
 
         CURL* _curl;
 
@@ -97,6 +109,79 @@ class EasyCurl : public osg::Referenced
 };
 
 
+/** MultiCurl performs HTTP GET requests from any number of threads on a single transfer thread driven by the
+  * curl multi interface. All transfers share one connection cache, so connections are reused across threads,
+  * and requests to servers that support HTTP/2 are multiplexed over a shared connection rather than each
+  * opening their own. Reading threads submit a request and wait for its result, so while the number of
+  * requests in flight is still the number of threads reading, the threads hold no connection of their own. */
+class MultiCurl : public osg::Referenced, public OpenThreads::Thread
+{
+    public:
+
+        MultiCurl();
+
+        /** Set the maximum number of connections opened to a single host, 0 for no limit. Must be called before the first read().*/
+        void setMaxHostConnections(long maxConnections) { _maxHostConnections = maxConnections; }
+        long getMaxHostConnections() const { return _maxHostConnections; }
+
+        /** Perform HTTP GET to download data from web server, blocking until the transfer has completed.*/
+        osgDB::ReaderWriter::ReadResult read(const std::string& proxyAddress, const std::string& fileName, EasyCurl::StreamObject& sp, const osgDB::ReaderWriter::Options *options,
+                                             long connectTimeout, long timeout, long sslVerifyPeer);
+
+        /** Stop the transfer thread, failing any requests still outstanding.*/
+        virtual int cancel();
+
+        virtual void run();
+
+    protected:
+
+        virtual ~MultiCurl();
+
+        /** Request submitted to the transfer thread, the submitting thread waits on it like a future until the transfer thread completes it.*/
+        struct Request : public osg::Referenced
+        {
+            Request(): sp(0), connectTimeout(0), timeout(0), sslVerifyPeer(1), httpAuthentication(0), handle(0), completed(false) {}
+
+            void complete(const osgDB::ReaderWriter::ReadResult& rr);
+            osgDB::ReaderWriter::ReadResult wait();
+
+            std::string                         fileName;
+            std::string                         proxyAddress;
+            EasyCurl::StreamObject*             sp;
+            long                                connectTimeout;
+            long                                timeout;
+            long                                sslVerifyPeer;
+            std::string                         userPassword;
+            long                                httpAuthentication;
+
+            // easy handle performing the transfer, only accessed from the transfer thread.
+            CURL*                               handle;
+
+            OpenThreads::Mutex                  mutex;
+            OpenThreads::Condition              condition;
+            bool                                completed;
+            osgDB::ReaderWriter::ReadResult     result;
+        };
+
+        typedef std::vector< osg::ref_ptr<Request> > Requests;
+
+        void startTransfers(Requests& requests);
+        void completeTransfers();
+        void failAll(Requests& requests);
+
+        CURLM*                  _multi;
+        long                    _maxHostConnections;
+
+        OpenThreads::Mutex      _mutex;
+        bool                    _started;
+        bool                    _done;
+        Requests                _pending;
+
+        // only accessed from the transfer thread.
+        Requests                _active;
+        std::vector<CURL*>      _idleHandles;
+};
+
 class ReaderWriterCURL : public osgDB::ReaderWriter
 {
     public:
@@ -171,15 +256,24 @@ class ReaderWriterCURL : public osgDB::ReaderWriter
             return *ec;
         }
 
+        /** Get the shared MultiCurl that reads are performed on when enabled by the OSG_CURL_MULTI option or environment variable.*/
+        MultiCurl* getMultiCurl() const { return _multiCurl.get(); }
+
+        /** Get whether reads are performed on the MultiCurl by default, rather than on a per thread EasyCurl.*/
+        bool getUseMultiCurl() const { return _useMultiCurl; }
+
         bool read(std::istream& fin, std::string& destination) const;
 
     protected:
-        void getConnectionOptions(const osgDB::ReaderWriter::Options *options, std::string& proxyAddress, long& connectTimeout, long& timeout, long& sslVerifyPeer) const;
+        void getConnectionOptions(const osgDB::ReaderWriter::Options *options, std::string& proxyAddress, long& connectTimeout, long& timeout, long& sslVerifyPeer, bool& useMultiCurl) const;
 
         typedef std::map< size_t, osg::ref_ptr<EasyCurl> >    ThreadCurlMap;
 
         mutable OpenThreads::Mutex          _threadCurlMapMutex;
         mutable ThreadCurlMap               _threadCurlMap;
+
+        osg::ref_ptr<MultiCurl>             _multiCurl;
+        bool                                _useMultiCurl;
 };
 
 }
@@ -0,0 +1,696 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include "LASOctree.h"
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/PagedLOD>
+#include <osg/CullStack>
+#include <osg/Notify>
+
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+#include <osgDB/fstream>
+
+#include <OpenThreads/Thread>
+#include <OpenThreads/ScopedLock>
+
+#include <float.h>
+#include <stdio.h>
+
+using namespace las;
+
+namespace
+{
+    // number of points appended to, or read from, the temporary files at a time.
+    const unsigned int POINT_FILE_BLOCK_SIZE = 65536;
+}
+
+OctreeSettings::OctreeSettings():
+    resolution(128),
+    maxPointsPerNode(50000),
+    maxDepth(20),
+    numThreads(0),
+    memoryBudget(1024.0*1024.0*1024.0),
+    lodPixelSize(128.0f)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Subsampler
+//
+OctreeBuilder::Subsampler::Subsampler(const Box& box, unsigned int resolution):
+    _origin(box.center - osg::Vec3(box.halfSize, box.halfSize, box.halfSize)),
+    _scale(box.halfSize>0.0f ? float(resolution)/(2.0f*box.halfSize) : 0.0f),
+    _resolution(resolution),
+    _occupied(resolution*resolution*resolution, false)
+{
+}
+
+bool OctreeBuilder::Subsampler::select(const osg::Vec3& p)
+{
+    osg::Vec3 cell = (p-_origin)*_scale;
+    unsigned int ix = static_cast<unsigned int>(osg::clampBetween(cell.x(), 0.0f, float(_resolution-1)));
+    unsigned int iy = static_cast<unsigned int>(osg::clampBetween(cell.y(), 0.0f, float(_resolution-1)));
+    unsigned int iz = static_cast<unsigned int>(osg::clampBetween(cell.z(), 0.0f, float(_resolution-1)));
+
+    std::vector<bool>::reference occupied = _occupied[ix + _resolution*(iy + _resolution*iz)];
+    if (occupied) return false;
+
+    occupied = true;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+// PointFile
+//
+bool OctreeBuilder::PointFile::append(const OctreePoint& point)
+{
+    buffer.push_back(point);
+    if (buffer.size()<POINT_FILE_BLOCK_SIZE) return true;
+    return flush();
+}
+
+bool OctreeBuilder::PointFile::flush()
+{
+    if (buffer.empty()) return true;
+
+    osgDB::ofstream fout(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+    fout.write(reinterpret_cast<const char*>(&buffer.front()), buffer.size()*sizeof(OctreePoint));
+    bool result = !fout.fail();
+
+    numPoints += static_cast<unsigned int>(buffer.size());
+    buffer.clear();
+
+    if (!result) OSG_WARN<<"LAS octree: unable to write temporary file "<<fileName<<std::endl;
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+// WorkerThread
+//
+class OctreeBuilder::WorkerThread : public OpenThreads::Thread
+{
+    public:
+        WorkerThread(OctreeBuilder* builder): _builder(builder) {}
+
+        virtual void run() { _builder->processTasks(); }
+
+    protected:
+        OctreeBuilder* _builder;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+// OctreeBuilder
+//
+OctreeBuilder::OctreeBuilder(const std::string& directory, const OctreeSettings& settings, float halfSize):
+    _directory(directory),
+    _settings(settings),
+    _rootBox(osg::Vec3(0.0f, 0.0f, 0.0f), halfSize),
+    _numPoints(0),
+    _rootSpilled(false),
+    _rootSubsampler(0),
+    _rootWriteOk(true),
+    _numActiveTasks(0),
+    _numTiles(0),
+    _ok(true)
+{
+    if (_settings.resolution<1) _settings.resolution = 1;
+    if (_settings.numThreads==0) _settings.numThreads = osg::maximum(OpenThreads::GetNumberOfProcessors(), 1);
+
+    // a node being split needs room for its points and for the lists they are split into.
+    _maxPointsInMemory = static_cast<unsigned int>(osg::minimum(_settings.memoryBudget/double(2*sizeof(OctreePoint)), 4.0e9));
+    if (_maxPointsInMemory<_settings.maxPointsPerNode) _maxPointsInMemory = _settings.maxPointsPerNode;
+
+    osgDB::makeDirectory(_directory);
+}
+
+OctreeBuilder::~OctreeBuilder()
+{
+    delete _rootSubsampler;
+
+    for(std::deque<Task*>::iterator itr = _tasks.begin(); itr != _tasks.end(); ++itr)
+    {
+        delete *itr;
+    }
+}
+
+std::string OctreeBuilder::getRootFileName(const std::string& directory)
+{
+    return osgDB::concatPaths(directory, "r.osgb");
+}
+
+void OctreeBuilder::addPoint(const OctreePoint& point)
+{
+    ++_numPoints;
+
+    if (!_rootSpilled)
+    {
+        _rootPoints.push_back(point);
+        if (_rootPoints.size()<=_maxPointsInMemory) return;
+
+        // the points no longer fit in memory, so subsample the root node from them and move the rest out to the files of its children.
+        OSG_INFO<<"LAS octree: more than "<<_maxPointsInMemory<<" points, distributing points to temporary files."<<std::endl;
+
+        _rootSpilled = true;
+        _rootSubsampler = new Subsampler(_rootBox, _settings.resolution);
+        for(unsigned int i=0; i<8; ++i)
+        {
+            _rootFiles[i].fileName = osgDB::concatPaths(_directory, std::string("r") + char('0'+i) + ".tmp");
+            remove(_rootFiles[i].fileName.c_str());
+        }
+
+        OctreePoints points;
+        points.swap(_rootPoints);
+
+        for(OctreePoints::iterator itr = points.begin(); itr != points.end(); ++itr)
+        {
+            if (_rootSubsampler->select(itr->position)) _rootSelected.push_back(*itr);
+            else if (!_rootFiles[_rootBox.getOctant(itr->position)].append(*itr)) _rootWriteOk = false;
+        }
+        return;
+    }
+
+    if (_rootSubsampler->select(point.position)) _rootSelected.push_back(point);
+    else if (!_rootFiles[_rootBox.getOctant(point.position)].append(point)) _rootWriteOk = false;
+}
+
+bool OctreeBuilder::finish(const osg::Matrixd& transform)
+{
+    _rootTransform = transform;
+
+    if (!_rootSpilled)
+    {
+        Task* task = new Task;
+        task->name = "r";
+        task->box = _rootBox;
+        task->points.swap(_rootPoints);
+        task->numPoints = static_cast<unsigned int>(task->points.size());
+        pushTask(task, true);
+    }
+    else
+    {
+        unsigned int childMask = 0;
+        for(unsigned int i=0; i<8; ++i)
+        {
+            if (!_rootFiles[i].flush()) _rootWriteOk = false;
+            if (_rootFiles[i].numPoints>0) childMask |= (1<<i);
+        }
+
+        if (!_rootWriteOk || !writeTile("r", _rootBox, 0, _rootSelected, childMask)) return false;
+
+        OctreePoints().swap(_rootSelected);
+
+        for(unsigned int i=0; i<8; ++i)
+        {
+            if (_rootFiles[i].numPoints==0) continue;
+
+            Task* task = new Task;
+            task->name = std::string("r") + char('0'+i);
+            task->box = _rootBox.getChild(i);
+            task->depth = 1;
+            task->fileName = _rootFiles[i].fileName;
+            task->numPoints = _rootFiles[i].numPoints;
+            pushTask(task, false);
+        }
+    }
+
+    std::vector<WorkerThread*> threads;
+    for(unsigned int i=1; i<_settings.numThreads; ++i)
+    {
+        WorkerThread* thread = new WorkerThread(this);
+        thread->startThread();
+        threads.push_back(thread);
+    }
+
+    processTasks();
+
+    for(std::vector<WorkerThread*>::iterator itr = threads.begin(); itr != threads.end(); ++itr)
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+
+    OSG_INFO<<"LAS octree: written "<<_numTiles<<" tiles of "<<_numPoints<<" points to "<<_directory<<std::endl;
+
+    return _ok;
+}
+
+void OctreeBuilder::pushTask(Task* task, bool inMemory)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_taskMutex);
+
+    // tasks whose points are already in memory are processed first, so that memory is released before further files are loaded.
+    if (inMemory) _tasks.push_front(task);
+    else _tasks.push_back(task);
+
+    _taskCondition.signal();
+}
+
+void OctreeBuilder::processTasks()
+{
+    while(true)
+    {
+        Task* task = 0;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_taskMutex);
+
+            // wait while there are no tasks queued but other threads may still produce more.
+            while(_tasks.empty() && _numActiveTasks>0) _taskCondition.wait(&_taskMutex);
+
+            if (_tasks.empty()) return;
+
+            task = _tasks.front();
+            _tasks.pop_front();
+            ++_numActiveTasks;
+        }
+
+        bool result = task->fileName.empty() ? buildInMemory(*task) : buildFromFile(*task);
+        delete task;
+
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_taskMutex);
+            if (!result) _ok = false;
+            --_numActiveTasks;
+            _taskCondition.broadcast();
+        }
+    }
+}
+
+bool OctreeBuilder::buildInMemory(Task& task)
+{
+    if (task.points.size()<=_settings.maxPointsPerNode || task.depth>=_settings.maxDepth)
+    {
+        return writeTile(task.name, task.box, task.depth, task.points, 0);
+    }
+
+    OctreePoints selected;
+    OctreePoints children[8];
+
+    {
+        Subsampler subsampler(task.box, _settings.resolution);
+        for(OctreePoints::iterator itr = task.points.begin(); itr != task.points.end(); ++itr)
+        {
+            if (subsampler.select(itr->position)) selected.push_back(*itr);
+            else children[task.box.getOctant(itr->position)].push_back(*itr);
+        }
+        OctreePoints().swap(task.points);
+    }
+
+    unsigned int childMask = 0;
+    for(unsigned int i=0; i<8; ++i)
+    {
+        if (!children[i].empty()) childMask |= (1<<i);
+    }
+
+    if (!writeTile(task.name, task.box, task.depth, selected, childMask)) return false;
+
+    for(unsigned int i=0; i<8; ++i)
+    {
+        if (children[i].empty()) continue;
+
+        Task* child = new Task;
+        child->name = task.name + char('0'+i);
+        child->box = task.box.getChild(i);
+        child->depth = task.depth+1;
+        child->points.swap(children[i]);
+        child->numPoints = static_cast<unsigned int>(child->points.size());
+        pushTask(child, true);
+    }
+
+    return true;
+}
+
+bool OctreeBuilder::buildFromFile(Task& task)
+{
+    osgDB::ifstream fin(task.fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!fin)
+    {
+        OSG_WARN<<"LAS octree: unable to open temporary file "<<task.fileName<<std::endl;
+        return false;
+    }
+
+    unsigned int maxPointsInMemory = osg::maximum(_maxPointsInMemory/_settings.numThreads, _settings.maxPointsPerNode);
+
+    if (task.numPoints<=maxPointsInMemory || task.depth>=_settings.maxDepth)
+    {
+        task.points.resize(task.numPoints);
+        fin.read(reinterpret_cast<char*>(&task.points.front()), task.points.size()*sizeof(OctreePoint));
+        bool readOk = !fin.fail();
+        fin.close();
+        remove(task.fileName.c_str());
+
+        if (!readOk)
+        {
+            OSG_WARN<<"LAS octree: unable to read temporary file "<<task.fileName<<std::endl;
+            return false;
+        }
+
+        task.fileName.clear();
+        return buildInMemory(task);
+    }
+
+    // the node's points don't fit in memory so stream them from its file to those of its children, keeping only the node's subsample.
+    Subsampler subsampler(task.box, _settings.resolution);
+    OctreePoints selected;
+    PointFile children[8];
+    for(unsigned int i=0; i<8; ++i)
+    {
+        children[i].fileName = osgDB::concatPaths(_directory, task.name + char('0'+i) + ".tmp");
+        remove(children[i].fileName.c_str());
+    }
+
+    bool ok = true;
+    OctreePoints block(POINT_FILE_BLOCK_SIZE);
+    unsigned int numRemaining = task.numPoints;
+    while(numRemaining>0 && ok)
+    {
+        unsigned int numToRead = osg::minimum(numRemaining, POINT_FILE_BLOCK_SIZE);
+        if (!fin.read(reinterpret_cast<char*>(&block.front()), numToRead*sizeof(OctreePoint)))
+        {
+            OSG_WARN<<"LAS octree: unable to read temporary file "<<task.fileName<<std::endl;
+            ok = false;
+            break;
+        }
+
+        for(unsigned int i=0; i<numToRead; ++i)
+        {
+            const OctreePoint& point = block[i];
+            if (subsampler.select(point.position)) selected.push_back(point);
+            else if (!children[task.box.getOctant(point.position)].append(point)) ok = false;
+        }
+
+        numRemaining -= numToRead;
+    }
+
+    fin.close();
+    remove(task.fileName.c_str());
+
+    unsigned int childMask = 0;
+    for(unsigned int i=0; i<8; ++i)
+    {
+        if (!children[i].flush()) ok = false;
+        if (children[i].numPoints>0) childMask |= (1<<i);
+    }
+
+    if (!ok || !writeTile(task.name, task.box, task.depth, selected, childMask))
+    {
+        for(unsigned int i=0; i<8; ++i) remove(children[i].fileName.c_str());
+        return false;
+    }
+
+    for(unsigned int i=0; i<8; ++i)
+    {
+        if (children[i].numPoints==0) continue;
+
+        Task* child = new Task;
+        child->name = task.name + char('0'+i);
+        child->box = task.box.getChild(i);
+        child->depth = task.depth+1;
+        child->fileName = children[i].fileName;
+        child->numPoints = children[i].numPoints;
+        pushTask(child, false);
+    }
+
+    return true;
+}
+
+bool OctreeBuilder::writeTile(const std::string& name, const Box& box, unsigned int depth, const OctreePoints& points, unsigned int childMask)
+{
+    osg::ref_ptr<osg::Group> group = new osg::Group;
+
+    if (!points.empty())
+    {
+        osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+        osg::ref_ptr<osg::Vec4ubArray> colours = new osg::Vec4ubArray;
+        vertices->reserve(points.size());
+        colours->reserve(points.size());
+
+        bool singleColour = true;
+        for(OctreePoints::const_iterator itr = points.begin(); itr != points.end(); ++itr)
+        {
+            vertices->push_back(itr->position);
+            colours->push_back(itr->colour);
+            if (singleColour && itr->colour!=points.front().colour) singleColour = false;
+        }
+
+        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+        geometry->setUseDisplayList(false);
+        geometry->setUseVertexBufferObjects(true);
+        geometry->setVertexArray(vertices.get());
+        if (singleColour)
+        {
+            colours->resize(1);
+            geometry->setColorArray(colours.get(), osg::Array::BIND_OVERALL);
+        }
+        else
+        {
+            geometry->setColorArray(colours.get(), osg::Array::BIND_PER_VERTEX);
+        }
+        geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertices->size()));
+
+        osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+        geode->addDrawable(geometry.get());
+        group->addChild(geode.get());
+    }
+
+    for(unsigned int i=0; i<8; ++i)
+    {
+        if ((childMask & (1<<i))==0) continue;
+
+        Box childBox = box.getChild(i);
+
+        // the centre and radius are set explicitly so the child can be culled and ranged before it has been loaded.
+        osg::ref_ptr<osg::PagedLOD> plod = new osg::PagedLOD;
+        plod->setCenter(childBox.center);
+        plod->setRadius(childBox.halfSize*sqrtf(3.0f));
+        plod->setRangeMode(osg::LOD::PIXEL_SIZE_ON_SCREEN);
+        plod->setFileName(0, name + char('0'+i) + ".osgb");
+        plod->setRange(0, _settings.lodPixelSize, FLT_MAX);
+        group->addChild(plod.get());
+    }
+
+    osg::ref_ptr<osg::Node> node = group.get();
+    if (depth==0)
+    {
+        osg::ref_ptr<osg::MatrixTransform> transform = new osg::MatrixTransform(_rootTransform);
+        transform->setDataVariance(osg::Object::STATIC);
+        transform->addChild(group.get());
+        node = transform.get();
+    }
+
+    std::string fileName = osgDB::concatPaths(_directory, name + ".osgb");
+    if (!osgDB::writeNodeFile(*node, fileName))
+    {
+        OSG_WARN<<"LAS octree: unable to write tile "<<fileName<<std::endl;
+        return false;
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_taskMutex);
+    ++_numTiles;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+// PointBudgetCallback
+//
+PointBudgetCallback::PointBudgetCallback(unsigned int pointBudget):
+    _pointBudget(pointBudget),
+    _numPointsCounted(0),
+    _numPointsSelected(0),
+    _lodScaleMultiplier(1.0f)
+{
+}
+
+void PointBudgetCallback::setPointBudget(unsigned int pointBudget)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _pointBudget = pointBudget;
+}
+
+unsigned int PointBudgetCallback::getPointBudget() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _pointBudget;
+}
+
+unsigned int PointBudgetCallback::getNumPointsSelected() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _numPointsSelected;
+}
+
+void PointBudgetCallback::addPoints(unsigned int numPoints)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _numPointsCounted += numPoints;
+}
+
+void PointBudgetCallback::updateLODScaleMultiplier()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    _numPointsSelected = _numPointsCounted;
+    _numPointsCounted = 0;
+
+    if (_pointBudget==0)
+    {
+        _lodScaleMultiplier = 1.0f;
+        return;
+    }
+
+    // coarsen quickly when over budget, refine slowly once comfortably below it to avoid oscillating between levels.
+    if (_numPointsSelected>_pointBudget)
+    {
+        _lodScaleMultiplier = osg::minimum(_lodScaleMultiplier*1.1f, 1000.0f);
+    }
+    else if (_numPointsSelected<_pointBudget-_pointBudget/4)
+    {
+        _lodScaleMultiplier = osg::maximum(_lodScaleMultiplier/1.05f, 1.0f);
+    }
+}
+
+void PointBudgetCallback::operator()(osg::Node* node, osg::NodeVisitor* nv)
+{
+    if (nv->getVisitorType()==osg::NodeVisitor::UPDATE_VISITOR)
+    {
+        updateLODScaleMultiplier();
+        traverse(node, nv);
+        return;
+    }
+
+    osg::CullStack* cullStack = nv->asCullStack();
+    if (!cullStack)
+    {
+        traverse(node, nv);
+        return;
+    }
+
+    float lodScaleMultiplier;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        lodScaleMultiplier = _lodScaleMultiplier;
+    }
+
+    // setLODScale() disables the inheritance of the LOD scale from the camera, so restore the inheritance mask as well as the scale.
+    unsigned int inheritanceMask = cullStack->getInheritanceMask();
+    float lodScale = cullStack->getLODScale();
+
+    cullStack->setLODScale(lodScale*lodScaleMultiplier);
+    traverse(node, nv);
+    cullStack->setLODScale(lodScale);
+    cullStack->setInheritanceMask(inheritanceMask);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+// PointCountCallback
+//
+PointCountCallback::PointCountCallback(PointBudgetCallback* pointBudgetCallback, unsigned int numPoints):
+    _pointBudgetCallback(pointBudgetCallback),
+    _numPoints(numPoints)
+{
+}
+
+bool PointCountCallback::cull(osg::NodeVisitor* nv, osg::Drawable* drawable, osg::RenderInfo*) const
+{
+    // the cull callback is called ahead of the CullVisitor's own view frustum test, so only count the tile if it passes it.
+    osg::CullStack* cullStack = nv ? nv->asCullStack() : 0;
+    if (cullStack && drawable->isCullingActive() && cullStack->isCulled(drawable->getBoundingBox())) return true;
+
+    _pointBudgetCallback->addPoints(_numPoints);
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+// PointBudgetReadFileCallback
+//
+namespace
+{
+    class AddPointCountCallbacksVisitor : public osg::NodeVisitor
+    {
+    public:
+        AddPointCountCallbacksVisitor(PointBudgetCallback* pointBudgetCallback, const osgDB::Options* options):
+            osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+            _pointBudgetCallback(pointBudgetCallback),
+            _options(options) {}
+
+        virtual void apply(osg::Geometry& geometry)
+        {
+            unsigned int numPoints = geometry.getVertexArray() ? geometry.getVertexArray()->getNumElements() : 0;
+            geometry.setCullCallback(new PointCountCallback(_pointBudgetCallback, numPoints));
+        }
+
+        virtual void apply(osg::PagedLOD& plod)
+        {
+            plod.setDatabaseOptions(const_cast<osgDB::Options*>(_options));
+            traverse(plod);
+        }
+
+        PointBudgetCallback*    _pointBudgetCallback;
+        const osgDB::Options*   _options;
+    };
+}
+
+PointBudgetReadFileCallback::PointBudgetReadFileCallback(PointBudgetCallback* pointBudgetCallback):
+    _pointBudgetCallback(pointBudgetCallback)
+{
+}
+
+osgDB::ReaderWriter::ReadResult PointBudgetReadFileCallback::readNode(const std::string& filename, const osgDB::Options* options)
+{
+    osgDB::ReaderWriter::ReadResult result = osgDB::ReadFileCallback::readNode(filename, options);
+    if (result.validNode())
+    {
+        AddPointCountCallbacksVisitor visitor(_pointBudgetCallback.get(), options);
+        result.getNode()->accept(visitor);
+    }
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+// readOctree
+//
+osg::ref_ptr<osg::Node> las::readOctree(const std::string& rootFileName, unsigned int pointBudget)
+{
+    // the tiles are read with a callback that has each of them count the points it draws towards the budget.
+    osg::ref_ptr<PointBudgetCallback> pointBudgetCallback;
+    osg::ref_ptr<osgDB::Options> tileOptions;
+    if (pointBudget>0)
+    {
+        pointBudgetCallback = new PointBudgetCallback(pointBudget);
+        tileOptions = new osgDB::Options;
+        tileOptions->setReadFileCallback(new PointBudgetReadFileCallback(pointBudgetCallback.get()));
+    }
+
+    osg::ref_ptr<osg::Node> root = osgDB::readRefNodeFile(rootFileName, tileOptions.get());
+    if (root.valid() && pointBudgetCallback.valid())
+    {
+        root->addCullCallback(pointBudgetCallback.get());
+        root->addUpdateCallback(pointBudgetCallback.get());
+    }
+
+    return root;
+}
@@ -0,0 +1,261 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#ifndef LAS_OCTREE_H
+#define LAS_OCTREE_H 1
+
+#include <osg/Vec3>
+#include <osg/Vec4ub>
+#include <osg/Matrixd>
+#include <osg/Node>
+#include <osg/NodeCallback>
+#include <osg/Drawable>
+
+#include <osgDB/Callbacks>
+
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace las
+{
+
+/** Point as stored in the octree, with its position relative to the centre of the root node.*/
+struct OctreePoint
+{
+    OctreePoint() {}
+    OctreePoint(const osg::Vec3& p, const osg::Vec4ub& c): position(p), colour(c) {}
+
+    osg::Vec3   position;
+    osg::Vec4ub colour;
+};
+
+typedef std::vector<OctreePoint> OctreePoints;
+
+struct OctreeSettings
+{
+    OctreeSettings();
+
+    /** Number of subsampling cells along each axis of a node, each cell contributes at most one point to the node.*/
+    unsigned int    resolution;
+
+    /** Nodes with no more than this number of points keep all of them and become leaves.*/
+    unsigned int    maxPointsPerNode;
+
+    unsigned int    maxDepth;
+
+    /** Number of threads used to build the nodes, 0 uses the number of processors.*/
+    unsigned int    numThreads;
+
+    /** Upper bound, in bytes, on the memory used to hold points while building.*/
+    double          memoryBudget;
+
+    /** Size in pixels of a node's bounding sphere radius at which its children are paged in.*/
+    float           lodPixelSize;
+};
+
+/** OctreeBuilder builds a paged octree of point tiles from a stream of points in bounded memory.
+  * Each node keeps a spatially uniform subsample of the points that reach it, one point per cell of a
+  * resolution^3 grid, passing the remaining points on to its children. Nodes are written as .osgb tiles
+  * named after their path from the root ("r", "r0", "r07" ...), each holding the node's points and a PagedLOD
+  * for every non empty child, so that the points of a node add to those of its ancestors as the children are
+  * paged in by the DatabasePager.
+  *
+  * Points are held in memory until they exceed the memory budget, after which they are distributed to
+  * temporary files, one per child node, that are in turn split in the same way until they fit in memory.
+  * Nodes are built by a pool of threads, each processing a pending node from memory or from its file.*/
+class OctreeBuilder
+{
+    public:
+
+        /** Create a builder writing tiles to directory for an octree whose root node is the cube centred on the origin with the specified half size.*/
+        OctreeBuilder(const std::string& directory, const OctreeSettings& settings, float halfSize);
+        ~OctreeBuilder();
+
+        static std::string getRootFileName(const std::string& directory);
+
+        void addPoint(const OctreePoint& point);
+
+        /** Build and write all the nodes, the root tile being placed beneath a MatrixTransform with the specified matrix.
+          * Returns false if any of the tiles or temporary files could not be written.*/
+        bool finish(const osg::Matrixd& transform);
+
+        unsigned int getNumPoints() const { return _numPoints; }
+        unsigned int getNumTiles() const { return _numTiles; }
+
+    protected:
+
+        struct Box
+        {
+            Box(): halfSize(0.0f) {}
+            Box(const osg::Vec3& c, float hs): center(c), halfSize(hs) {}
+
+            unsigned int getOctant(const osg::Vec3& p) const
+            {
+                return (p.x()>=center.x() ? 1 : 0) | (p.y()>=center.y() ? 2 : 0) | (p.z()>=center.z() ? 4 : 0);
+            }
+
+            Box getChild(unsigned int octant) const
+            {
+                float hs = halfSize*0.5f;
+                return Box(center + osg::Vec3((octant&1) ? hs : -hs, (octant&2) ? hs : -hs, (octant&4) ? hs : -hs), hs);
+            }
+
+            osg::Vec3   center;
+            float       halfSize;
+        };
+
+        /** Selects at most one point per cell of a node's subsampling grid.*/
+        class Subsampler
+        {
+            public:
+                Subsampler(const Box& box, unsigned int resolution);
+
+                bool select(const osg::Vec3& p);
+
+            protected:
+                osg::Vec3           _origin;
+                float               _scale;
+                unsigned int        _resolution;
+                std::vector<bool>   _occupied;
+        };
+
+        /** Temporary file of points, buffered in memory and appended to the file in blocks.*/
+        struct PointFile
+        {
+            PointFile(): numPoints(0) {}
+
+            bool append(const OctreePoint& point);
+            bool flush();
+
+            std::string     fileName;
+            unsigned int    numPoints;
+            OctreePoints    buffer;
+        };
+
+        struct Task
+        {
+            Task(): depth(0), numPoints(0) {}
+
+            std::string     name;
+            Box             box;
+            unsigned int    depth;
+
+            // the points of the node are either held in memory or in the temporary file.
+            OctreePoints    points;
+            std::string     fileName;
+            unsigned int    numPoints;
+        };
+
+        class WorkerThread;
+        friend class WorkerThread;
+
+        void pushTask(Task* task, bool inMemory);
+        void processTasks();
+
+        bool buildInMemory(Task& task);
+        bool buildFromFile(Task& task);
+        bool writeTile(const std::string& name, const Box& box, unsigned int depth, const OctreePoints& points, unsigned int childMask);
+
+        std::string             _directory;
+        OctreeSettings          _settings;
+        Box                     _rootBox;
+        unsigned int            _maxPointsInMemory;
+        osg::Matrixd            _rootTransform;
+
+        unsigned int            _numPoints;
+        OctreePoints            _rootPoints;
+        bool                    _rootSpilled;
+        Subsampler*             _rootSubsampler;
+        PointFile               _rootFiles[8];
+        OctreePoints            _rootSelected;
+        bool                    _rootWriteOk;
+
+        OpenThreads::Mutex      _taskMutex;
+        OpenThreads::Condition  _taskCondition;
+        std::deque<Task*>       _tasks;
+        unsigned int            _numActiveTasks;
+        unsigned int            _numTiles;
+        bool                    _ok;
+};
+
+/** Callback that keeps the number of points drawn beneath a paged octree within a budget, by scaling the LOD scale of
+  * the subgraph whenever the points drawn in the previous frame exceeded, or fell well below, the budget.
+  *
+  * Add it as both the cull and the update callback of the octree root, and read the tiles with a PointBudgetReadFileCallback
+  * so that each visible tile adds its points to the count as it is culled. The count is accumulated across all the views,
+  * and the cull threads, drawing the octree during a frame, and the LOD scale is adjusted once per frame by the update traversal.*/
+class PointBudgetCallback : public osg::NodeCallback
+{
+    public:
+        PointBudgetCallback(unsigned int pointBudget);
+
+        void setPointBudget(unsigned int pointBudget);
+        unsigned int getPointBudget() const;
+
+        /** Get the number of points drawn during the last frame.*/
+        unsigned int getNumPointsSelected() const;
+
+        /** Add the points of a tile drawn during the current frame, called by the cull threads.*/
+        void addPoints(unsigned int numPoints);
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+
+    protected:
+
+        /** Take the count of the points drawn since the last update, and adjust the LOD scale multiplier to match the budget.*/
+        void updateLODScaleMultiplier();
+
+        mutable OpenThreads::Mutex  _mutex;
+        unsigned int                _pointBudget;
+        unsigned int                _numPointsCounted;
+        unsigned int                _numPointsSelected;
+        float                       _lodScaleMultiplier;
+};
+
+/** Drawable cull callback that adds the points of a tile Geometry to a PointBudgetCallback when the Geometry is visible.*/
+class PointCountCallback : public osg::DrawableCullCallback
+{
+    public:
+        PointCountCallback(PointBudgetCallback* pointBudgetCallback, unsigned int numPoints);
+
+        virtual bool cull(osg::NodeVisitor* nv, osg::Drawable* drawable, osg::RenderInfo* renderInfo) const;
+
+    protected:
+        osg::ref_ptr<PointBudgetCallback>   _pointBudgetCallback;
+        unsigned int                        _numPoints;
+};
+
+/** Read file callback that attaches a PointCountCallback to the Geometry of each tile read, and passes the options it was
+  * called with on to the PagedLODs of the tile so that the tiles beneath them are decorated in turn.*/
+class PointBudgetReadFileCallback : public osgDB::ReadFileCallback
+{
+    public:
+        PointBudgetReadFileCallback(PointBudgetCallback* pointBudgetCallback);
+
+        virtual osgDB::ReaderWriter::ReadResult readNode(const std::string& filename, const osgDB::Options* options);
+
+    protected:
+        osg::ref_ptr<PointBudgetCallback>   _pointBudgetCallback;
+};
+
+/** Read the root tile of an octree written by OctreeBuilder. When pointBudget is non zero a PointBudgetCallback is added as the
+  * root's cull and update callback, with the tiles read through a PointBudgetReadFileCallback. Returns NULL if the root can't be read.*/
+osg::ref_ptr<osg::Node> readOctree(const std::string& rootFileName, unsigned int pointBudget);
+
+}
+
+#endif
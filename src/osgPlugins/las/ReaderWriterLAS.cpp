@@ -3,6 +3,7 @@
 #include <osg/Geometry>
 #include <osg/Matrix>
 #include <osg/MatrixTransform>
+#include <osg/Math>
 
 #include <osgDB/FileNameUtils>
 #include <osgDB/FileUtils>
@@ -13,12 +14,15 @@
 #include <iomanip>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 
 #include <liblas/liblas.hpp>
 #include <liblas/reader.hpp>
 #include <liblas/point.hpp>
 #include <liblas/detail/timer.hpp>
 
+#include "LASOctree.h"
+
 class ReaderWriterLAS : public osgDB::ReaderWriter
 {
     public:
@@ -30,6 +34,15 @@ class ReaderWriterLAS : public osgDB::ReaderWriter
             supportsOption("v", "Verbose output");
             supportsOption("noScale", "don't scale vertices according to las haeder - put schale in matixTransform");
             supportsOption("noReCenter", "don't transform vertex coords to re-center the pointcloud");
+            supportsOption("octree", "Build, or reuse, an out of core octree of paged .osgb tiles for the point cloud and return its root");
+            supportsOption("octreeDirectory=<path>", "Directory of the octree tiles, defaults to the file name without extension followed by _octree");
+            supportsOption("octreeRebuild", "Rebuild the octree tiles even if they already exist");
+            supportsOption("octreeResolution=<num>", "Number of subsampling cells along each axis of an octree node, default 128");
+            supportsOption("octreeMaxPoints=<num>", "Maximum number of points in an octree leaf node, default 50000");
+            supportsOption("octreeThreads=<num>", "Number of threads used to build the octree, default is the number of processors");
+            supportsOption("octreeMemory=<MB>", "Memory budget used to build the octree, points beyond it are distributed through temporary files, default 1024");
+            supportsOption("octreeLODPixelSize=<num>", "Screen size in pixels of an octree node's radius at which its children are paged in, default 128");
+            supportsOption("pointBudget=<num>", "Maximum number of octree points selected for drawing each frame, 0 for no limit, default 10000000");
         }
 
         virtual const char* className() const { return "LAS point cloud reader"; }
@@ -47,6 +60,8 @@ class ReaderWriterLAS : public osgDB::ReaderWriter
             std::string fileName = osgDB::findDataFile(file, options);
             if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
 
+            if (options && hasOctreeOption(options->getOptionString())) return readOctree(fileName, options);
+
             OSG_INFO << "Reading file " << fileName << std::endl;
             std::ifstream ifs;
             if (!liblas::Open(ifs, file))
@@ -56,6 +71,103 @@ class ReaderWriterLAS : public osgDB::ReaderWriter
             return readNode(ifs, options);
         }
 
+        static bool hasOctreeOption(const std::string& optionString)
+        {
+            std::istringstream iss(optionString);
+            std::string opt;
+            while (iss >> opt)
+            {
+                if (opt == "octree") return true;
+            }
+            return false;
+        }
+
+        ReadResult readOctree(const std::string& fileName, const Options* options) const
+        {
+            las::OctreeSettings settings;
+            std::string directory = osgDB::getNameLessExtension(fileName) + "_octree";
+            bool rebuild = false;
+            unsigned int pointBudget = 10000000;
+
+            std::istringstream iss(options->getOptionString());
+            std::string opt;
+            while (iss >> opt)
+            {
+                std::string::size_type pos = opt.find('=');
+                std::string key = opt.substr(0, pos);
+                std::string value = pos != std::string::npos ? opt.substr(pos+1) : std::string();
+
+                if (key == "octreeDirectory") directory = value;
+                else if (key == "octreeRebuild") rebuild = true;
+                else if (key == "octreeResolution") settings.resolution = osg::clampBetween(atoi(value.c_str()), 1, 512);
+                else if (key == "octreeMaxPoints") settings.maxPointsPerNode = atoi(value.c_str());
+                else if (key == "octreeThreads") settings.numThreads = atoi(value.c_str());
+                else if (key == "octreeMemory") settings.memoryBudget = osg::asciiToDouble(value.c_str())*1024.0*1024.0;
+                else if (key == "octreeLODPixelSize") settings.lodPixelSize = osg::asciiToFloat(value.c_str());
+                else if (key == "pointBudget") pointBudget = atoi(value.c_str());
+            }
+
+            std::string rootFileName = las::OctreeBuilder::getRootFileName(directory);
+            if (rebuild || !osgDB::fileExists(rootFileName))
+            {
+                ReadResult result = buildOctree(fileName, directory, settings);
+                if (!result.success()) return result;
+            }
+
+            osg::ref_ptr<osg::Node> root = las::readOctree(rootFileName, pointBudget);
+            if (!root) return ReadResult(std::string("Unable to read octree root ") + rootFileName);
+
+            return root.release();
+        }
+
+        ReadResult buildOctree(const std::string& fileName, const std::string& directory, const las::OctreeSettings& settings) const
+        {
+            std::ifstream ifs;
+            if (!liblas::Open(ifs, fileName))
+            {
+                return ReadResult::ERROR_IN_READING_FILE;
+            }
+
+            liblas::ReaderFactory f;
+            liblas::Reader reader = f.CreateWithStream(ifs);
+            liblas::Header const& h = reader.GetHeader();
+
+            if (h.GetPointRecordsCount()==0) return ReadResult(std::string("No points in ") + fileName);
+
+            // the header bounds include the offset, which is carried by the root transform to keep the tile vertices small.
+            osg::Vec3d offset(h.GetOffsetX(), h.GetOffsetY(), h.GetOffsetZ());
+            osg::Vec3d minimum(h.GetMinX(), h.GetMinY(), h.GetMinZ());
+            osg::Vec3d maximum(h.GetMaxX(), h.GetMaxY(), h.GetMaxZ());
+            osg::Vec3d center = (minimum + maximum)*0.5 - offset;
+            osg::Vec3d extents = maximum - minimum;
+            double halfSize = osg::maximum(osg::maximum(extents.x(), extents.y()), osg::maximum(extents.z(), 1.0))*0.5*1.001;
+
+            OSG_NOTICE << "Building octree of " << h.GetPointRecordsCount() << " points from " << fileName << " in " << directory << std::endl;
+
+            liblas::detail::Timer t;
+            t.start();
+
+            las::OctreeBuilder builder(directory, settings, static_cast<float>(halfSize));
+            while (reader.ReadNextPoint())
+            {
+                liblas::Point const& p = reader.GetPoint();
+                liblas::Color c = p.GetColor();
+
+                osg::Vec3d position(p.GetRawX()*h.GetScaleX(), p.GetRawY()*h.GetScaleY(), p.GetRawZ()*h.GetScaleZ());
+                builder.addPoint(las::OctreePoint(osg::Vec3(position - center),
+                                                  osg::Vec4ub(c.GetRed() >> 8, c.GetGreen() >> 8, c.GetBlue() >> 8, 255)));
+            }
+
+            if (!builder.finish(osg::Matrixd::translate(offset + center)))
+            {
+                return ReadResult(std::string("Unable to write octree tiles to ") + directory);
+            }
+
+            OSG_NOTICE << "Built octree of " << builder.getNumTiles() << " tiles in " << t.stop() << "s" << std::endl;
+
+            return ReadResult::FILE_LOADED;
+        }
+
         virtual ReadResult readObject(std::istream& fin, const osgDB::ReaderWriter::Options* options) const
         {
             return readNode(fin, options);
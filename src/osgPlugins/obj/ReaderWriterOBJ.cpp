@@ -41,6 +41,7 @@
 #include <osgDB/ReadFile>
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
+#include <osgDB/MappedFile>
 
 #include <osgUtil/MeshOptimizers>
 #include <osgUtil/SmoothingVisitor>
@@ -63,6 +64,7 @@ public:
         supportsOption("noTriStripPolygons","Do not do the default tri stripping of polygons");
         supportsOption("generateFacetNormals","generate facet normals for vertices without normals");
         supportsOption("noReverseFaces","avoid to reverse faces when normals and triangles orientation are reversed");
+        supportsOption("parseThreads=<num>","Set the number of threads used to parse files, 0 (the default) uses one per processor");
 
         supportsOption("DIFFUSE=<unit>", "Set texture unit for diffuse texture");
         supportsOption("AMBIENT=<unit>", "Set texture unit for ambient texture");
@@ -170,6 +172,7 @@ protected:
         int precision;
         bool outputTextureFiles;
         int specularExponent;
+        unsigned int parseThreads;
 
         ObjOptionsStruct()
         {
@@ -182,6 +185,7 @@ protected:
             precision = std::numeric_limits<double>::digits10 + 2;
             outputTextureFiles = false;
             specularExponent = -1;
+            parseThreads = 0;
         }
     };
 
@@ -908,6 +912,16 @@ ReaderWriterOBJ::ObjOptionsStruct ReaderWriterOBJ::parseOptions(const osgDB::Rea
                     localOptions.precision = val;
                 }
             }
+            else if (pre_equals == "parseThreads")
+            {
+                int val = std::atoi(post_equals.c_str());
+                if (val < 0) {
+                    OSG_NOTICE << "Warning: invalid parseThreads value: " << post_equals << std::endl;
+                }
+                else {
+                    localOptions.parseThreads = val;
+                }
+            }
             else if (pre_equals == "NsIfNotPresent")
             {
                 int value = atoi(post_equals.c_str());
@@ -948,18 +962,21 @@ osgDB::ReaderWriter::ReadResult ReaderWriterOBJ::readNode(const std::string& fil
     std::string fileName = osgDB::findDataFile( file, options );
     if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
 
-    osgDB::ifstream fin(fileName.c_str());
-    if (fin)
+    // map the file so that it can be parsed in place, in parallel chunks.
+    osg::ref_ptr<osgDB::MappedFile> mappedFile = new osgDB::MappedFile;
+    if (mappedFile->open(fileName))
     {
         // code for setting up the database path so that internally referenced file are searched for on relative paths.
         osg::ref_ptr<Options> local_opt = options ? static_cast<Options*>(options->clone(osg::CopyOp::SHALLOW_COPY)) : new Options;
         local_opt->getDatabasePathList().push_front(osgDB::getFilePath(fileName));
 
+        ObjOptionsStruct localOptions = parseOptions(options);
+
         obj::Model model;
         model.setDatabasePath(osgDB::getFilePath(fileName.c_str()));
-        model.readOBJ(fin, local_opt.get());
+        model.readOBJ(mappedFile->begin(), mappedFile->end(), local_opt.get(), localOptions.parseThreads);
 
-        ObjOptionsStruct localOptions = parseOptions(options);
+        mappedFile->close();
 
         osg::Node* node = convertModelToSceneGraph(model, localOptions, local_opt.get());
         return node;
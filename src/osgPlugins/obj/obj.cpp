@@ -21,11 +21,15 @@
 #include "obj.h"
 
 #include <osg/Notify>
+#include <osg/Timer>
+
+#include <OpenThreads/Thread>
 
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
 
 #include <string.h>
+#include <math.h>
 
 using namespace obj;
 
@@ -725,70 +729,27 @@ bool Model::readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* optio
             }
             else if (strncmp(line,"usemtl ",7)==0)
             {
-                std::string materialName( line+7 );
-                if (currentElementState.materialName != materialName)
-                {
-                    currentElementState.materialName = materialName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                setMaterialName(line+7);
             }
             else if (strncmp(line,"mtllib ",7)==0)
             {
-                std::string materialFileName = trim( line+7 );
-                std::string fullPathFileName = osgDB::findDataFile( materialFileName, options );
-                if (!fullPathFileName.empty())
-                {
-                    osgDB::ifstream mfin( fullPathFileName.c_str() );
-                    if (mfin)
-                    {
-                        OSG_INFO << "Obj reading mtllib '" << fullPathFileName << "'\n";
-                        readMTL(mfin);
-                    }
-                    else
-                    {
-                        OSG_WARN << "Obj unable to load mtllib '" << fullPathFileName << "'\n";
-                    }
-                }
-                else
-                {
-                    OSG_WARN << "Obj unable to find mtllib '" << materialFileName << "'\n";
-                }
+                readMaterialLibrary(trim( line+7 ), options);
             }
             else if (strncmp(line,"o ",2)==0)
             {
-                std::string objectName(line+2);
-                if (currentElementState.objectName != objectName)
-                {
-                    currentElementState.objectName = objectName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                setObjectName(line+2);
             }
             else if (strcmp(line,"o")==0)
             {
-                std::string objectName(""); // empty name
-                if (currentElementState.objectName != objectName)
-                {
-                    currentElementState.objectName = objectName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                setObjectName(""); // empty name
             }
             else if (strncmp(line,"g ",2)==0)
             {
-                std::string groupName(line+2);
-                if (currentElementState.groupName != groupName)
-                {
-                    currentElementState.groupName = groupName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                setGroupName(line+2);
             }
             else if (strcmp(line,"g")==0)
             {
-                std::string groupName(""); // empty name
-                if (currentElementState.groupName != groupName)
-                {
-                    currentElementState.groupName = groupName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                setGroupName(""); // empty name
             }
             else if (strncmp(line,"s ",2)==0)
             {
@@ -803,11 +764,7 @@ bool Model::readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* optio
                     }
                 }
 
-                if (currentElementState.smoothingGroup != smoothingGroup)
-                {
-                    currentElementState.smoothingGroup = smoothingGroup;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                setSmoothingGroup(smoothingGroup);
             }
             else
             {
@@ -844,6 +801,672 @@ bool Model::readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* optio
 }
 
 
+void Model::readMaterialLibrary(const std::string& materialFileName, const osgDB::ReaderWriter::Options* options)
+{
+    std::string fullPathFileName = osgDB::findDataFile( materialFileName, options );
+    if (!fullPathFileName.empty())
+    {
+        osgDB::ifstream mfin( fullPathFileName.c_str() );
+        if (mfin)
+        {
+            OSG_INFO << "Obj reading mtllib '" << fullPathFileName << "'\n";
+            readMTL(mfin);
+        }
+        else
+        {
+            OSG_WARN << "Obj unable to load mtllib '" << fullPathFileName << "'\n";
+        }
+    }
+    else
+    {
+        OSG_WARN << "Obj unable to find mtllib '" << materialFileName << "'\n";
+    }
+}
+
+void Model::setMaterialName(const std::string& materialName)
+{
+    if (currentElementState.materialName != materialName)
+    {
+        currentElementState.materialName = materialName;
+        currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+    }
+}
+
+void Model::setObjectName(const std::string& objectName)
+{
+    if (currentElementState.objectName != objectName)
+    {
+        currentElementState.objectName = objectName;
+        currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+    }
+}
+
+void Model::setGroupName(const std::string& groupName)
+{
+    if (currentElementState.groupName != groupName)
+    {
+        currentElementState.groupName = groupName;
+        currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+    }
+}
+
+void Model::setSmoothingGroup(int smoothingGroup)
+{
+    if (currentElementState.smoothingGroup != smoothingGroup)
+    {
+        currentElementState.smoothingGroup = smoothingGroup;
+        currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+    }
+}
+
+namespace
+{
+
+//
+// Parsing of OBJ data held in memory, split into chunks at line boundaries that are parsed in parallel.
+// Each chunk collects its own vertex data along with an ordered list of the elements and state changes
+// found, with face indices left as they appear in the file. Once all chunks have been parsed the indices
+// are remapped using the number of vertices in the preceding chunks, again in parallel, and finally the
+// state changes and elements are replayed into the Model in file order.
+//
+
+inline bool isBlank(char c) { return c==' ' || c=='\t'; }
+
+inline const char* skipBlanks(const char* ptr, const char* end)
+{
+    while(ptr<end && isBlank(*ptr)) ++ptr;
+    return ptr;
+}
+
+inline bool isDigit(char c) { return c>='0' && c<='9'; }
+
+// Locale independent float parser, returns 0 if no number could be parsed.
+const char* parseFloat(const char* ptr, const char* end, float& value)
+{
+    static const double powersOf10[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    ptr = skipBlanks(ptr, end);
+    if (ptr>=end) return 0;
+
+    bool negative = false;
+    if (*ptr=='-') { negative = true; ++ptr; }
+    else if (*ptr=='+') ++ptr;
+
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    int numSignificantDigits = 0;
+    bool hasDigits = false;
+
+    for(; ptr<end && isDigit(*ptr); ++ptr)
+    {
+        hasDigits = true;
+        if (numSignificantDigits<19)
+        {
+            mantissa = mantissa*10 + (*ptr-'0');
+            if (mantissa>0) ++numSignificantDigits;
+        }
+        else ++exponent;
+    }
+
+    if (ptr<end && *ptr=='.')
+    {
+        for(++ptr; ptr<end && isDigit(*ptr); ++ptr)
+        {
+            hasDigits = true;
+            if (numSignificantDigits<19)
+            {
+                mantissa = mantissa*10 + (*ptr-'0');
+                if (mantissa>0) ++numSignificantDigits;
+                --exponent;
+            }
+        }
+    }
+
+    if (!hasDigits) return 0;
+
+    if (ptr<end && (*ptr=='e' || *ptr=='E'))
+    {
+        const char* exponentPtr = ptr+1;
+        bool negativeExponent = false;
+        if (exponentPtr<end && (*exponentPtr=='-' || *exponentPtr=='+')) { negativeExponent = (*exponentPtr=='-'); ++exponentPtr; }
+
+        if (exponentPtr<end && isDigit(*exponentPtr))
+        {
+            int explicitExponent = 0;
+            for(; exponentPtr<end && isDigit(*exponentPtr); ++exponentPtr)
+            {
+                if (explicitExponent<10000) explicitExponent = explicitExponent*10 + (*exponentPtr-'0');
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            ptr = exponentPtr;
+        }
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (mantissa!=0 && exponent!=0)
+    {
+        if (exponent>=-22 && exponent<=22)
+        {
+            result = (exponent<0) ? result/powersOf10[-exponent] : result*powersOf10[exponent];
+        }
+        else
+        {
+            result *= pow(10.0, static_cast<double>(exponent));
+        }
+    }
+
+    value = static_cast<float>(negative ? -result : result);
+    return ptr;
+}
+
+// returns 0 if no integer could be parsed.
+inline const char* parseInt(const char* ptr, const char* end, int& value)
+{
+    bool negative = false;
+    if (ptr<end && (*ptr=='-' || *ptr=='+')) { negative = (*ptr=='-'); ++ptr; }
+
+    if (ptr>=end || !isDigit(*ptr)) return 0;
+
+    int result = 0;
+    for(; ptr<end && isDigit(*ptr); ++ptr) result = result*10 + (*ptr-'0');
+
+    value = negative ? -result : result;
+    return ptr;
+}
+
+inline unsigned int parseHexPair(const char* ptr, const char* end)
+{
+    unsigned int result = 0;
+    for(const char* last = osg::minimum(ptr+2, end); ptr<last; ++ptr)
+    {
+        char c = *ptr;
+        if (c>='0' && c<='9') result = result*16 + (c-'0');
+        else if (c>='a' && c<='f') result = result*16 + (c-'a'+10);
+        else if (c>='A' && c<='F') result = result*16 + (c-'A'+10);
+        else break;
+    }
+    return result;
+}
+
+inline bool matchKeyword(const char* ptr, const char* end, const char* keyword, bool allowBare=false)
+{
+    for(; *keyword!=0; ++keyword, ++ptr)
+    {
+        if (ptr>=end || *ptr!=*keyword) return false;
+    }
+    return (ptr<end) ? isBlank(*ptr) : allowBare;
+}
+
+// names are taken verbatim after the single separator that follows the keyword, with tabs converted to spaces.
+inline std::string toName(const char* ptr, const char* end)
+{
+    std::string name(ptr, end);
+    for(std::string::iterator itr = name.begin(); itr != name.end(); ++itr)
+    {
+        if (*itr=='\t') *itr = ' ';
+    }
+    return name;
+}
+
+struct ParsedChunk
+{
+    struct Command
+    {
+        enum Type
+        {
+            ELEMENT,
+            MATERIAL,
+            OBJECT,
+            GROUP,
+            SMOOTHING_GROUP,
+            MATERIAL_LIBRARY
+        };
+
+        Command(Type t): type(t), value(0), numVertices(0), numNormals(0), numTexCoords(0) {}
+
+        Type                    type;
+        osg::ref_ptr<Element>   element;
+        std::string             name;
+        int                     value;
+
+        // number of vertices, normals and texcoords read in the chunk before the element, used to resolve relative indices.
+        unsigned int            numVertices;
+        unsigned int            numNormals;
+        unsigned int            numTexCoords;
+    };
+
+    typedef std::vector<Command> Commands;
+
+    ParsedChunk(): begin(0), end(0), vertexOffset(0), normalOffset(0), texCoordOffset(0) {}
+
+    const char*         begin;
+    const char*         end;
+
+    Model::Vec3Array    vertices;
+    Model::Vec4Array    colors;
+    Model::Vec3Array    normals;
+    Model::Vec2Array    texcoords;
+    Commands            commands;
+
+    unsigned int        vertexOffset;
+    unsigned int        normalOffset;
+    unsigned int        texCoordOffset;
+};
+
+typedef std::vector<ParsedChunk> ParsedChunks;
+
+void parseElement(const char* ptr, const char* end, Element::DataType dataType, ParsedChunk& chunk)
+{
+    osg::ref_ptr<Element> element = new Element(dataType);
+
+    while(ptr<end)
+    {
+        ptr = skipBlanks(ptr, end);
+        if (ptr>=end) break;
+
+        int vi=0, ti=0, ni=0;
+        const char* next = parseInt(ptr, end, vi);
+        if (next)
+        {
+            element->vertexIndices.push_back(vi);
+
+            if (next<end && *next=='/')
+            {
+                if (next+1<end && next[1]=='/')
+                {
+                    // v//n
+                    if (parseInt(next+2, end, ni)) element->normalIndices.push_back(ni);
+                }
+                else if (const char* afterTexCoord = parseInt(next+1, end, ti))
+                {
+                    // v/t or v/t/n
+                    element->texCoordIndices.push_back(ti);
+                    if (afterTexCoord<end && *afterTexCoord=='/' && parseInt(afterTexCoord+1, end, ni)) element->normalIndices.push_back(ni);
+                }
+            }
+        }
+
+        // skip to white space or end of line
+        while(ptr<end && !isBlank(*ptr)) ++ptr;
+    }
+
+    ParsedChunk::Command command(ParsedChunk::Command::ELEMENT);
+    command.element = element;
+    command.numVertices = chunk.vertices.size();
+    command.numNormals = chunk.normals.size();
+    command.numTexCoords = chunk.texcoords.size();
+    chunk.commands.push_back(command);
+}
+
+void parseLine(const char* line, const char* end, ParsedChunk& chunk)
+{
+    line = skipBlanks(line, end);
+    while(end>line && isBlank(*(end-1))) --end;
+
+    if (line>=end) return;
+
+    if (*line=='#')
+    {
+        if (end-line>=5 && strncmp(line, "#MRGB", 5)==0)
+        {
+            // Get the zBrush vertex colors given in comments under the form :
+            // * #MRGB MMRRGGBB MMRRGGBB ... (up to 64 hexadecimal color fields)
+            for(const char* ptr = line+6; end-ptr>=8; ptr+=8)
+            {
+                // Skipping the MM component
+                float r = static_cast<float>(parseHexPair(ptr+2, end)) / 255.0f;
+                float g = static_cast<float>(parseHexPair(ptr+4, end)) / 255.0f;
+                float b = static_cast<float>(parseHexPair(ptr+6, end)) / 255.0f;
+                chunk.colors.push_back(osg::Vec4(r, g, b, 1.0f));
+            }
+        }
+        return;
+    }
+
+    if (*line=='$') return;
+
+    if (matchKeyword(line, end, "v"))
+    {
+        float values[7];
+        unsigned int fieldsRead = 0;
+        for(const char* ptr = line+2; fieldsRead<7 && (ptr = parseFloat(ptr, end, values[fieldsRead]))!=0; ++fieldsRead) {}
+
+        const float& x = values[0];
+        const float& y = values[1];
+        const float& z = values[2];
+        const float& w = values[3];
+
+        if (fieldsRead==1)
+            chunk.vertices.push_back(osg::Vec3(x,0.0f,0.0f));
+        else if (fieldsRead==2)
+            chunk.vertices.push_back(osg::Vec3(x,y,0.0f));
+        else if (fieldsRead==3)
+            chunk.vertices.push_back(osg::Vec3(x,y,z));
+        else if (fieldsRead==4)
+            chunk.vertices.push_back(osg::Vec3(x/w,y/w,z/w));
+        else if (fieldsRead==6)
+        {
+            chunk.vertices.push_back(osg::Vec3(x,y,z));
+            chunk.colors.push_back(osg::Vec4(values[3], values[4], values[5], 1.0f));
+        }
+        else if (fieldsRead==7)
+        {
+            chunk.vertices.push_back(osg::Vec3(x,y,z));
+            chunk.colors.push_back(osg::Vec4(values[3], values[4], values[5], values[6]));
+        }
+    }
+    else if (matchKeyword(line, end, "vn"))
+    {
+        float values[3];
+        unsigned int fieldsRead = 0;
+        for(const char* ptr = line+3; fieldsRead<3 && (ptr = parseFloat(ptr, end, values[fieldsRead]))!=0; ++fieldsRead) {}
+
+        if (fieldsRead==1) chunk.normals.push_back(osg::Vec3(values[0],0.0f,0.0f));
+        else if (fieldsRead==2) chunk.normals.push_back(osg::Vec3(values[0],values[1],0.0f));
+        else if (fieldsRead==3) chunk.normals.push_back(osg::Vec3(values[0],values[1],values[2]));
+    }
+    else if (matchKeyword(line, end, "vt"))
+    {
+        float values[3];
+        unsigned int fieldsRead = 0;
+        for(const char* ptr = line+3; fieldsRead<3 && (ptr = parseFloat(ptr, end, values[fieldsRead]))!=0; ++fieldsRead) {}
+
+        if (fieldsRead==1) chunk.texcoords.push_back(osg::Vec2(values[0],0.0f));
+        else if (fieldsRead>=2) chunk.texcoords.push_back(osg::Vec2(values[0],values[1]));
+    }
+    else if (matchKeyword(line, end, "f"))
+    {
+        parseElement(line+2, end, Element::POLYGON, chunk);
+    }
+    else if (matchKeyword(line, end, "l"))
+    {
+        parseElement(line+2, end, Element::POLYLINE, chunk);
+    }
+    else if (matchKeyword(line, end, "p"))
+    {
+        parseElement(line+2, end, Element::POINTS, chunk);
+    }
+    else if (matchKeyword(line, end, "usemtl"))
+    {
+        ParsedChunk::Command command(ParsedChunk::Command::MATERIAL);
+        command.name = toName(line+7, end);
+        chunk.commands.push_back(command);
+    }
+    else if (matchKeyword(line, end, "mtllib"))
+    {
+        ParsedChunk::Command command(ParsedChunk::Command::MATERIAL_LIBRARY);
+        command.name = trim(toName(line+7, end));
+        chunk.commands.push_back(command);
+    }
+    else if (matchKeyword(line, end, "o", true))
+    {
+        ParsedChunk::Command command(ParsedChunk::Command::OBJECT);
+        if (end-line>2) command.name = toName(line+2, end);
+        chunk.commands.push_back(command);
+    }
+    else if (matchKeyword(line, end, "g", true))
+    {
+        ParsedChunk::Command command(ParsedChunk::Command::GROUP);
+        if (end-line>2) command.name = toName(line+2, end);
+        chunk.commands.push_back(command);
+    }
+    else if (matchKeyword(line, end, "s"))
+    {
+        ParsedChunk::Command command(ParsedChunk::Command::SMOOTHING_GROUP);
+        const char* ptr = skipBlanks(line+2, end);
+        if (!(end-ptr>=3 && strncmp(ptr, "off", 3)==0) && !parseInt(ptr, end, command.value))
+        {
+            OSG_NOTICE <<"*** error reading smoothing group ***"<<std::endl;
+        }
+        chunk.commands.push_back(command);
+    }
+    else
+    {
+        OSG_NOTICE <<"*** line not handled *** :"<<std::string(line, end)<<std::endl;
+    }
+}
+
+void parseChunk(ParsedChunk& chunk)
+{
+    std::string joinedLine;
+
+    const char* ptr = chunk.begin;
+    while(ptr<chunk.end)
+    {
+        const char* lineBegin = ptr;
+        while(ptr<chunk.end && *ptr!='\n' && *ptr!='\r') ++ptr;
+        const char* lineEnd = ptr;
+
+        // step over the line ending, treating \r\n as a single line ending.
+        if (ptr<chunk.end && *ptr=='\r')
+        {
+            ++ptr;
+            if (ptr<chunk.end && *ptr=='\n') ++ptr;
+        }
+        else if (ptr<chunk.end && *ptr=='\n') ++ptr;
+
+        if (lineEnd>lineBegin && *(lineEnd-1)=='\\')
+        {
+            // a backslash at the end of the line continues the line on the next one.
+            joinedLine.append(lineBegin, lineEnd-1);
+            joinedLine.push_back(' ');
+            continue;
+        }
+
+        if (!joinedLine.empty())
+        {
+            joinedLine.append(lineBegin, lineEnd);
+            parseLine(joinedLine.data(), joinedLine.data()+joinedLine.size(), chunk);
+            joinedLine.clear();
+        }
+        else
+        {
+            parseLine(lineBegin, lineEnd, chunk);
+        }
+    }
+
+    if (!joinedLine.empty()) parseLine(joinedLine.data(), joinedLine.data()+joinedLine.size(), chunk);
+}
+
+inline bool remapIndices(Element::IndexList& indices, unsigned int numBefore)
+{
+    for(Element::IndexList::iterator itr = indices.begin(); itr != indices.end(); ++itr)
+    {
+        int index = (*itr<0) ? static_cast<int>(numBefore) + *itr : *itr-1;
+        if (index<0 || index>=static_cast<int>(numBefore)) return false;
+        *itr = index;
+    }
+    return true;
+}
+
+void remapChunk(ParsedChunk& chunk)
+{
+    for(ParsedChunk::Commands::iterator itr = chunk.commands.begin(); itr != chunk.commands.end(); ++itr)
+    {
+        if (itr->type!=ParsedChunk::Command::ELEMENT) continue;
+
+        Element& element = *(itr->element);
+
+        // vertex indices are remapped without range checks, matching the stream based parser.
+        int numVertices = static_cast<int>(chunk.vertexOffset + itr->numVertices);
+        for(Element::IndexList::iterator vitr = element.vertexIndices.begin(); vitr != element.vertexIndices.end(); ++vitr)
+        {
+            *vitr = (*vitr<0) ? numVertices + *vitr : *vitr-1;
+        }
+
+        if (element.normalIndices.size()!=element.vertexIndices.size() ||
+            !remapIndices(element.normalIndices, chunk.normalOffset + itr->numNormals))
+        {
+            element.normalIndices.clear();
+        }
+
+        if (element.texCoordIndices.size()!=element.vertexIndices.size() ||
+            !remapIndices(element.texCoordIndices, chunk.texCoordOffset + itr->numTexCoords))
+        {
+            element.texCoordIndices.clear();
+        }
+    }
+}
+
+class ChunkThread : public OpenThreads::Thread
+{
+public:
+    ChunkThread(void (*function)(ParsedChunk&), ParsedChunk& chunk):
+        _function(function),
+        _chunk(chunk) {}
+
+    virtual void run() { _function(_chunk); }
+
+protected:
+    void (*_function)(ParsedChunk&);
+    ParsedChunk& _chunk;
+};
+
+void runChunks(void (*function)(ParsedChunk&), ParsedChunks& chunks)
+{
+    std::vector<ChunkThread*> threads;
+    for(unsigned int i=1; i<chunks.size(); ++i)
+    {
+        ChunkThread* thread = new ChunkThread(function, chunks[i]);
+        thread->start();
+        threads.push_back(thread);
+    }
+
+    // the calling thread handles the first chunk
+    if (!chunks.empty()) function(chunks[0]);
+
+    for(std::vector<ChunkThread*>::iterator itr = threads.begin();
+        itr != threads.end();
+        ++itr)
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+}
+
+// find the start of the first line beginning at or after ptr, skipping over lines continued with a backslash.
+const char* findLineStart(const char* ptr, const char* begin, const char* end)
+{
+    while(ptr<end)
+    {
+        const char* newline = static_cast<const char*>(memchr(ptr, '\n', end-ptr));
+        if (!newline) return end;
+
+        const char* lineEnd = newline;
+        if (lineEnd>begin && *(lineEnd-1)=='\r') --lineEnd;
+
+        ptr = newline+1;
+        if (lineEnd==begin || *(lineEnd-1)!='\\') return ptr;
+    }
+    return end;
+}
+
+}
+
+bool Model::readOBJ(const char* begin, const char* end, const osgDB::ReaderWriter::Options* options, unsigned int numThreads)
+{
+    OSG_INFO<<"Reading OBJ file"<<std::endl;
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    if (numThreads==0) numThreads = OpenThreads::GetNumberOfProcessors();
+
+    // don't bother splitting small files, the cost of starting the threads would outweigh the gains.
+    const size_t minimumChunkSize = 1024*1024;
+    size_t size = end-begin;
+    unsigned int numChunks = osg::maximum(1u, osg::minimum(numThreads, static_cast<unsigned int>(size/minimumChunkSize)));
+
+    ParsedChunks chunks(numChunks);
+    const char* chunkBegin = begin;
+    for(unsigned int i=0; i<numChunks; ++i)
+    {
+        const char* chunkEnd = (i+1==numChunks) ? end : findLineStart(begin + (size*(i+1))/numChunks, begin, end);
+        chunkEnd = osg::maximum(chunkEnd, chunkBegin);
+
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    runChunks(parseChunk, chunks);
+
+    unsigned int numVertices = vertices.size();
+    unsigned int numColors = colors.size();
+    unsigned int numNormals = normals.size();
+    unsigned int numTexCoords = texcoords.size();
+    for(ParsedChunks::iterator itr = chunks.begin(); itr != chunks.end(); ++itr)
+    {
+        itr->vertexOffset = numVertices;
+        itr->normalOffset = numNormals;
+        itr->texCoordOffset = numTexCoords;
+
+        numVertices += itr->vertices.size();
+        numColors += itr->colors.size();
+        numNormals += itr->normals.size();
+        numTexCoords += itr->texcoords.size();
+    }
+
+    runChunks(remapChunk, chunks);
+
+    vertices.reserve(numVertices);
+    colors.reserve(numColors);
+    normals.reserve(numNormals);
+    texcoords.reserve(numTexCoords);
+
+    for(ParsedChunks::iterator itr = chunks.begin(); itr != chunks.end(); ++itr)
+    {
+        ParsedChunk& chunk = *itr;
+
+        vertices.insert(vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+        colors.insert(colors.end(), chunk.colors.begin(), chunk.colors.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+        texcoords.insert(texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+
+        // release the chunk's copy of the vertex data as we go to keep the peak memory footprint down.
+        Vec3Array().swap(chunk.vertices);
+        Vec4Array().swap(chunk.colors);
+        Vec3Array().swap(chunk.normals);
+        Vec2Array().swap(chunk.texcoords);
+
+        for(ParsedChunk::Commands::iterator citr = chunk.commands.begin(); citr != chunk.commands.end(); ++citr)
+        {
+            switch(citr->type)
+            {
+                case(ParsedChunk::Command::ELEMENT):
+                {
+                    Element* element = citr->element.get();
+                    if (element->vertexIndices.empty()) break;
+
+                    Element::CoordinateCombination coordateCombination = element->getCoordinateCombination();
+                    if (coordateCombination!=currentElementState.coordinateCombination)
+                    {
+                        currentElementState.coordinateCombination = coordateCombination;
+                        currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+                    }
+                    addElement(element);
+                    break;
+                }
+                case(ParsedChunk::Command::MATERIAL): setMaterialName(citr->name); break;
+                case(ParsedChunk::Command::OBJECT): setObjectName(citr->name); break;
+                case(ParsedChunk::Command::GROUP): setGroupName(citr->name); break;
+                case(ParsedChunk::Command::SMOOTHING_GROUP): setSmoothingGroup(citr->value); break;
+                case(ParsedChunk::Command::MATERIAL_LIBRARY): readMaterialLibrary(citr->name, options); break;
+            }
+        }
+
+        ParsedChunk::Commands().swap(chunk.commands);
+    }
+
+    OSG_INFO<<"Obj parsed "<<vertices.size()<<" vertices in "<<osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())<<"ms using "<<numChunks<<" chunks"<<std::endl;
+
+    return true;
+}
+
+
 void Model::addElement(Element* element)
 {
     if (!currentElementList)
@@ -198,9 +198,20 @@ public:
     bool readMTL(std::istream& fin);
     bool readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* options);
 
+    /** Parse OBJ data held in memory, such as a memory mapped file. The data is split into chunks at line boundaries
+      * which are parsed in parallel, using numThreads threads, or one per processor if numThreads is 0.*/
+    bool readOBJ(const char* begin, const char* end, const osgDB::ReaderWriter::Options* options, unsigned int numThreads=0);
+
+    void readMaterialLibrary(const std::string& materialFileName, const osgDB::ReaderWriter::Options* options);
+
     bool readline(std::istream& fin, char* line, const int LINE_SIZE);
     void addElement(Element* element);
 
+    void setMaterialName(const std::string& materialName);
+    void setObjectName(const std::string& objectName);
+    void setGroupName(const std::string& groupName);
+    void setSmoothingGroup(int smoothingGroup);
+
     osg::Vec3 averageNormal(const Element& element) const;
     osg::Vec3 computeNormal(const Element& element) const;
     bool needReverse(const Element& element) const;
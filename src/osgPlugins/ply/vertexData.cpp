@@ -17,17 +17,309 @@
 #include <osg/Geometry>
 #include <osg/Geode>
 #include <osg/io_utils>
-#include <osgUtil/SmoothingVisitor>
 #include <osg/TexEnv>
 #include <osgDB/ReaderWriter>
 #include <osgDB/FileNameUtils>
 #include <osgDB/ReadFile>
 #include <osg/Texture2D>
+#include <osg/Endian>
+#include <osg/Timer>
+#include <osgDB/MappedFile>
+#include <OpenThreads/Thread>
+#include <string.h>
 
 using namespace std;
 using namespace ply;
 
 
+namespace
+{
+
+/*  Size in bytes of a ply scalar type, 0 for unknown types.  */
+unsigned int plyTypeSize( int type )
+{
+    switch( type )
+    {
+        case PLY_CHAR:
+        case PLY_UCHAR:
+        case PLY_UINT8:     return 1;
+        case PLY_SHORT:
+        case PLY_USHORT:    return 2;
+        case PLY_INT:
+        case PLY_UINT:
+        case PLY_FLOAT:
+        case PLY_FLOAT32:
+        case PLY_INT32:     return 4;
+        case PLY_DOUBLE:    return 8;
+        default:            return 0;
+    }
+}
+
+template<typename T>
+inline T readValue( const char* ptr, bool swap )
+{
+    T value;
+    memcpy( &value, ptr, sizeof(T) );
+    if( swap ) osg::swapBytes( value );
+    return value;
+}
+
+/*  Read a scalar of the given ply type, swapping bytes if the file's byte order differs from the cpu's.  */
+inline double readScalar( const char* ptr, int type, bool swap )
+{
+    switch( type )
+    {
+        case PLY_CHAR:      return *reinterpret_cast<const signed char*>( ptr );
+        case PLY_UCHAR:
+        case PLY_UINT8:     return *reinterpret_cast<const unsigned char*>( ptr );
+        case PLY_SHORT:     return readValue<short>( ptr, swap );
+        case PLY_USHORT:    return readValue<unsigned short>( ptr, swap );
+        case PLY_INT:
+        case PLY_INT32:     return readValue<int>( ptr, swap );
+        case PLY_UINT:      return readValue<unsigned int>( ptr, swap );
+        case PLY_FLOAT:
+        case PLY_FLOAT32:   return readValue<float>( ptr, swap );
+        case PLY_DOUBLE:    return readValue<double>( ptr, swap );
+        default:            return 0.0;
+    }
+}
+
+/*  Read an integer list count or index, converted the way the generic reader converts them to int.  */
+inline unsigned int readIndex( const char* ptr, int type, bool swap )
+{
+    switch( type )
+    {
+        case PLY_UCHAR:
+        case PLY_UINT8:     return *reinterpret_cast<const unsigned char*>( ptr );
+        case PLY_USHORT:    return readValue<unsigned short>( ptr, swap );
+        case PLY_INT:
+        case PLY_INT32:
+        case PLY_UINT:      return readValue<unsigned int>( ptr, swap );
+        default:            return static_cast<unsigned int>( static_cast<int>( readScalar( ptr, type, swap ) ) );
+    }
+}
+
+/*  Location and type of a scalar vertex property within the fixed size vertex record.  */
+struct VertexField
+{
+    VertexField() : offset( -1 ), type( 0 ) {}
+
+    bool valid() const { return offset >= 0; }
+
+    float readFloat( const char* vertex, bool swap ) const
+    {
+        if( type == PLY_FLOAT || type == PLY_FLOAT32 ) return readValue<float>( vertex + offset, swap );
+        return static_cast<float>( readScalar( vertex + offset, type, swap ) );
+    }
+
+    unsigned char readByte( const char* vertex, bool swap ) const
+    {
+        if( type == PLY_UCHAR || type == PLY_UINT8 ) return *reinterpret_cast<const unsigned char*>( vertex + offset );
+        return static_cast<unsigned char>( static_cast<int>( readScalar( vertex + offset, type, swap ) ) );
+    }
+
+    int offset;
+    int type;
+};
+
+/*  Return the size of an element whose properties are all scalars, or 0 if it has list properties.  */
+unsigned int fixedElementSize( const PlyElement* element )
+{
+    unsigned int size = 0;
+    for( int j = 0; j < element->nprops; ++j )
+    {
+        if( element->props[j]->is_list ) return 0;
+        size += plyTypeSize( element->props[j]->external_type );
+    }
+    return size;
+}
+
+/*  Skip over the instances of an element that isn't used, returning NULL if the data is truncated.  */
+const char* skipElement( const PlyElement* element, const char* ptr, const char* end, bool swap )
+{
+    unsigned int fixedSize = fixedElementSize( element );
+    if( fixedSize > 0 || element->nprops == 0 )
+    {
+        size_t size = size_t( fixedSize ) * size_t( element->num );
+        return size_t( end - ptr ) >= size ? ptr + size : NULL;
+    }
+
+    for( int i = 0; i < element->num; ++i )
+    {
+        for( int j = 0; j < element->nprops; ++j )
+        {
+            const PlyProperty* prop = element->props[j];
+            if( prop->is_list )
+            {
+                unsigned int countSize = plyTypeSize( prop->count_external );
+                if( size_t( end - ptr ) < countSize ) return NULL;
+                size_t size = size_t( readIndex( ptr, prop->count_external, swap ) ) * plyTypeSize( prop->external_type );
+                ptr += countSize;
+                if( size_t( end - ptr ) < size ) return NULL;
+                ptr += size;
+            }
+            else
+            {
+                unsigned int size = plyTypeSize( prop->external_type );
+                if( size_t( end - ptr ) < size ) return NULL;
+                ptr += size;
+            }
+        }
+    }
+    return ptr;
+}
+
+/*  Operation run on a number of chunks, each in its own thread.  */
+struct ParallelOperation
+{
+    virtual ~ParallelOperation() {}
+    virtual void operator() ( unsigned int chunk ) = 0;
+};
+
+class ParallelOperationThread : public OpenThreads::Thread
+{
+public:
+    ParallelOperationThread( ParallelOperation& operation, unsigned int chunk ) :
+        _operation( operation ), _chunk( chunk ) {}
+
+    virtual void run() { _operation( _chunk ); }
+
+protected:
+    ParallelOperation&  _operation;
+    unsigned int        _chunk;
+};
+
+void runParallel( ParallelOperation& operation, unsigned int numChunks )
+{
+    std::vector<ParallelOperationThread*> threads;
+    for( unsigned int i = 1; i < numChunks; ++i )
+    {
+        threads.push_back( new ParallelOperationThread( operation, i ) );
+        threads.back()->startThread();
+    }
+
+    // process the first chunk in this thread while the others run
+    if( numChunks > 0 ) operation( 0 );
+
+    for( std::vector<ParallelOperationThread*>::iterator itr = threads.begin(); itr != threads.end(); ++itr )
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+}
+
+/*  Range of faces of one primitive set whose area weighted normals are summed by a single thread, into
+    a private array covering just the range of vertex indices that its faces reference.  */
+struct NormalChunk
+{
+    NormalChunk() : indices( 0 ), numFaceVertices( 0 ), begin( 0 ), end( 0 ), minIndex( 0 ), maxIndex( 0 ) {}
+
+    const unsigned int*     indices;
+    unsigned int            numFaceVertices;
+    size_t                  begin;
+    size_t                  end;
+    unsigned int            minIndex;
+    unsigned int            maxIndex;
+    std::vector<osg::Vec3>  sums;
+};
+
+typedef std::vector<NormalChunk> NormalChunks;
+
+struct IndexRangeOperation : public ParallelOperation
+{
+    IndexRangeOperation( NormalChunks& chunks, unsigned int numVertices ) :
+        _chunks( chunks ), _numVertices( numVertices ) {}
+
+    virtual void operator() ( unsigned int c )
+    {
+        NormalChunk& chunk = _chunks[c];
+        unsigned int minIndex = _numVertices;
+        unsigned int maxIndex = 0;
+        for( size_t i = chunk.begin; i < chunk.end; ++i )
+        {
+            unsigned int index = chunk.indices[i];
+            if( index >= _numVertices ) continue;
+            if( index < minIndex ) minIndex = index;
+            if( index > maxIndex ) maxIndex = index;
+        }
+        chunk.minIndex = minIndex;
+        chunk.maxIndex = maxIndex;
+    }
+
+    NormalChunks&   _chunks;
+    unsigned int    _numVertices;
+};
+
+struct AccumulateNormalsOperation : public ParallelOperation
+{
+    AccumulateNormalsOperation( NormalChunks& chunks, const osg::Vec3Array& vertices ) :
+        _chunks( chunks ), _vertices( vertices ) {}
+
+    virtual void operator() ( unsigned int c )
+    {
+        NormalChunk& chunk = _chunks[c];
+        if( chunk.minIndex > chunk.maxIndex ) return;
+
+        chunk.sums.assign( chunk.maxIndex - chunk.minIndex + 1, osg::Vec3( 0.0f, 0.0f, 0.0f ) );
+
+        unsigned int numVertices = _vertices.size();
+        unsigned int n = chunk.numFaceVertices;
+        for( size_t i = chunk.begin; i + n <= chunk.end; i += n )
+        {
+            const unsigned int* face = chunk.indices + i;
+
+            bool valid = true;
+            for( unsigned int j = 0; j < n; ++j )
+                if( face[j] >= numVertices ) valid = false;
+            if( !valid ) continue;
+
+            // the cross product's length is proportional to the face's area, weighting larger faces more
+            osg::Vec3 normal = ( n == 3 ) ?
+                ( _vertices[face[1]] - _vertices[face[0]] ) ^ ( _vertices[face[2]] - _vertices[face[0]] ) :
+                ( _vertices[face[2]] - _vertices[face[0]] ) ^ ( _vertices[face[3]] - _vertices[face[1]] );
+
+            for( unsigned int j = 0; j < n; ++j )
+                chunk.sums[face[j] - chunk.minIndex] += normal;
+        }
+    }
+
+    NormalChunks&           _chunks;
+    const osg::Vec3Array&   _vertices;
+};
+
+struct MergeNormalsOperation : public ParallelOperation
+{
+    MergeNormalsOperation( const NormalChunks& chunks, osg::Vec3Array& normals, unsigned int numRanges ) :
+        _chunks( chunks ), _normals( normals ), _numRanges( numRanges ) {}
+
+    virtual void operator() ( unsigned int r )
+    {
+        unsigned int numVertices = _normals.size();
+        unsigned int rangeBegin = static_cast<unsigned int>( ( static_cast<unsigned long long>( numVertices ) * r ) / _numRanges );
+        unsigned int rangeEnd = static_cast<unsigned int>( ( static_cast<unsigned long long>( numVertices ) * ( r + 1 ) ) / _numRanges );
+
+        for( NormalChunks::const_iterator itr = _chunks.begin(); itr != _chunks.end(); ++itr )
+        {
+            if( itr->sums.empty() ) continue;
+
+            unsigned int begin = osg::maximum( rangeBegin, itr->minIndex );
+            unsigned int end = osg::minimum( rangeEnd, itr->maxIndex + 1 );
+            for( unsigned int i = begin; i < end; ++i )
+                _normals[i] += itr->sums[i - itr->minIndex];
+        }
+
+        for( unsigned int i = rangeBegin; i < rangeEnd; ++i )
+            _normals[i].normalize();
+    }
+
+    const NormalChunks& _chunks;
+    osg::Vec3Array&     _normals;
+    unsigned int        _numRanges;
+};
+
+}
+
+
 /*  Constructor.  */
 VertexData::VertexData()
     : _invertFaces( false )
@@ -268,6 +560,322 @@ void VertexData::readTriangles( PlyFile* file, const int nFaces )
 }
 
 
+/*  Read all the elements of a binary file in place from the memory mapped file, instead
+    of one property at a time through ply_get_element().  */
+bool VertexData::readBinaryElements( PlyFile* file, const char* filename,
+                                     const bool ignoreColors )
+{
+    if( file->file_type != PLY_BINARY_LE && file->file_type != PLY_BINARY_BE )
+        return false;
+
+    // the header has been parsed, so the file pointer is at the start of the data
+    long dataOffset = ftell( file->fp );
+    if( dataOffset < 0 ) return false;
+
+    // check that the layout is one that can be read in place
+    for( int i = 0; i < file->nelems; ++i )
+    {
+        const PlyElement* element = file->elems[i];
+        for( int j = 0; j < element->nprops; ++j )
+        {
+            const PlyProperty* prop = element->props[j];
+            if( plyTypeSize( prop->external_type ) == 0 ) return false;
+            if( prop->is_list && plyTypeSize( prop->count_external ) == 0 ) return false;
+        }
+
+        if( equal_strings( element->name, "vertex" ) )
+        {
+            if( fixedElementSize( element ) == 0 ) return false;
+
+            // material colors are only supported by the generic reader
+            for( int j = 0; j < element->nprops; ++j )
+            {
+                const char* name = element->props[j]->name;
+                if( strncmp( name, "ambient", 7 ) == 0 || strncmp( name, "diffuse", 7 ) == 0 || strncmp( name, "specular", 8 ) == 0 )
+                    return false;
+            }
+        }
+        else if( equal_strings( element->name, "face" ) )
+        {
+            int numLists = 0;
+            for( int j = 0; j < element->nprops; ++j )
+            {
+                const PlyProperty* prop = element->props[j];
+                if( !prop->is_list ) continue;
+                if( !equal_strings( prop->name, "vertex_indices" ) && !equal_strings( prop->name, "vertex_index" ) ) return false;
+                ++numLists;
+            }
+            if( numLists != 1 ) return false;
+        }
+    }
+
+    osg::ref_ptr<osgDB::MappedFile> mappedFile = new osgDB::MappedFile;
+    if( !mappedFile->open( filename ) || mappedFile->size() < size_t( dataOffset ) )
+        return false;
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    bool swap = ( file->file_type == PLY_BINARY_BE ) != ( osg::getCpuByteOrder() == osg::BigEndian );
+    const char* ptr = mappedFile->begin() + dataOffset;
+    const char* end = mappedFile->end();
+
+    for( int i = 0; i < file->nelems && ptr; ++i )
+    {
+        const PlyElement* element = file->elems[i];
+        size_t num = element->num > 0 ? size_t( element->num ) : 0;
+
+        if( equal_strings( element->name, "vertex" ) )
+        {
+            size_t stride = fixedElementSize( element );
+            if( size_t( end - ptr ) / stride < num )
+            {
+                ptr = NULL;
+                break;
+            }
+
+            VertexField x, y, z, nx, ny, nz, red, green, blue, alpha, u, v;
+            int offset = 0;
+            for( int j = 0; j < element->nprops; ++j )
+            {
+                const PlyProperty* prop = element->props[j];
+                VertexField* field = NULL;
+                if( equal_strings( prop->name, "x" ) ) field = &x;
+                else if( equal_strings( prop->name, "y" ) ) field = &y;
+                else if( equal_strings( prop->name, "z" ) ) field = &z;
+                else if( equal_strings( prop->name, "nx" ) ) field = &nx;
+                else if( equal_strings( prop->name, "ny" ) ) field = &ny;
+                else if( equal_strings( prop->name, "nz" ) ) field = &nz;
+                else if( equal_strings( prop->name, "red" ) ) field = &red;
+                else if( equal_strings( prop->name, "green" ) ) field = &green;
+                else if( equal_strings( prop->name, "blue" ) ) field = &blue;
+                else if( equal_strings( prop->name, "alpha" ) ) field = &alpha;
+                else if( equal_strings( prop->name, "texture_u" ) ) field = &u;
+                else if( equal_strings( prop->name, "texture_v" ) ) field = &v;
+
+                if( field )
+                {
+                    field->offset = offset;
+                    field->type = prop->external_type;
+                }
+                offset += plyTypeSize( prop->external_type );
+            }
+
+            bool hasNormals = nx.valid() && ny.valid() && nz.valid();
+            bool hasColors = !ignoreColors && red.valid() && green.valid() && blue.valid();
+            bool hasTexCoords = u.valid() || v.valid();
+
+            _vertices = new osg::Vec3Array( num );
+            if( hasNormals ) _normals = new osg::Vec3Array( num );
+            if( hasColors )
+            {
+                _byteColors = new osg::Vec4ubArray( num );
+                _byteColors->setNormalize( true );
+            }
+            if( hasTexCoords ) _texcoord = new osg::Vec2Array( num );
+
+            bool packedPositions = !swap && stride == 3 * sizeof( float ) &&
+                                   x.offset == 0 && y.offset == 4 && z.offset == 8 &&
+                                   ( x.type == PLY_FLOAT || x.type == PLY_FLOAT32 ) &&
+                                   ( y.type == PLY_FLOAT || y.type == PLY_FLOAT32 ) &&
+                                   ( z.type == PLY_FLOAT || z.type == PLY_FLOAT32 );
+
+            if( packedPositions && num > 0 )
+            {
+                // the vertex records are exactly the Vec3Array's layout
+                memcpy( &( _vertices->front() ), ptr, num * stride );
+            }
+            else
+            {
+                const char* vertex = ptr;
+                for( size_t k = 0; k < num; ++k, vertex += stride )
+                {
+                    (*_vertices)[k].set( x.valid() ? x.readFloat( vertex, swap ) : 0.0f,
+                                         y.valid() ? y.readFloat( vertex, swap ) : 0.0f,
+                                         z.valid() ? z.readFloat( vertex, swap ) : 0.0f );
+
+                    if( hasNormals )
+                        (*_normals)[k].set( nx.readFloat( vertex, swap ), ny.readFloat( vertex, swap ), nz.readFloat( vertex, swap ) );
+
+                    if( hasColors )
+                        (*_byteColors)[k].set( red.readByte( vertex, swap ), green.readByte( vertex, swap ), blue.readByte( vertex, swap ),
+                                               alpha.valid() ? alpha.readByte( vertex, swap ) : 255 );
+
+                    if( hasTexCoords )
+                        (*_texcoord)[k].set( u.valid() ? u.readFloat( vertex, swap ) : 0.0f,
+                                             v.valid() ? v.readFloat( vertex, swap ) : 0.0f );
+                }
+            }
+
+            ptr += num * stride;
+        }
+        else if( equal_strings( element->name, "face" ) )
+        {
+            // the scalar properties either side of the index list are skipped over
+            size_t sizeBefore = 0;
+            size_t sizeAfter = 0;
+            const PlyProperty* indices = NULL;
+            for( int j = 0; j < element->nprops; ++j )
+            {
+                const PlyProperty* prop = element->props[j];
+                if( prop->is_list ) indices = prop;
+                else if( indices ) sizeAfter += plyTypeSize( prop->external_type );
+                else sizeBefore += plyTypeSize( prop->external_type );
+            }
+
+            int countType = indices->count_external;
+            int indexType = indices->external_type;
+            size_t countSize = plyTypeSize( countType );
+            size_t indexSize = plyTypeSize( indexType );
+
+            _triangles = new osg::DrawElementsUInt( osg::PrimitiveSet::TRIANGLES );
+            _quads = new osg::DrawElementsUInt( osg::PrimitiveSet::QUADS );
+            _triangles->reserve( num * 3 );
+
+            for( size_t k = 0; k < num; ++k )
+            {
+                if( size_t( end - ptr ) < sizeBefore + countSize )
+                {
+                    ptr = NULL;
+                    break;
+                }
+                ptr += sizeBefore;
+
+                unsigned int nVertices = readIndex( ptr, countType, swap );
+                ptr += countSize;
+
+                size_t listSize = size_t( nVertices ) * indexSize;
+                if( size_t( end - ptr ) < listSize + sizeAfter )
+                {
+                    ptr = NULL;
+                    break;
+                }
+
+                if( nVertices == 3 || nVertices == 4 )
+                {
+                    osg::DrawElementsUInt* primitives = ( nVertices == 4 ) ? _quads.get() : _triangles.get();
+                    for( unsigned int j = 0; j < nVertices; ++j )
+                    {
+                        unsigned int index = ( _invertFaces ? nVertices - 1 - j : j );
+                        primitives->push_back( readIndex( ptr + index * indexSize, indexType, swap ) );
+                    }
+                }
+
+                ptr += listSize + sizeAfter;
+            }
+        }
+        else
+        {
+            ptr = skipElement( element, ptr, end, swap );
+        }
+    }
+
+    if( !ptr )
+    {
+        MESHERROR << "Unable to read PLY file " << filename << ", the binary data is truncated." << endl;
+
+        _vertices = NULL;
+        _normals = NULL;
+        _byteColors = NULL;
+        _texcoord = NULL;
+        _triangles = NULL;
+        _quads = NULL;
+        return false;
+    }
+
+    MESHINFO << "Read binary PLY file " << filename << " in place in "
+             << osg::Timer::instance()->delta_m( startTick, osg::Timer::instance()->tick() ) << "ms" << endl;
+
+    return _vertices.valid();
+}
+
+
+/*  Compute area weighted vertex normals from the triangles and quads, splitting the faces
+    between threads that each sum into their own array before the arrays are merged.  */
+void VertexData::computeNormals()
+{
+    if( !_vertices.valid() || _vertices->empty() ) return;
+
+    const size_t minFacesPerChunk = 65536;
+
+    unsigned int numVertices = _vertices->size();
+    unsigned int numThreads = osg::maximum( OpenThreads::GetNumberOfProcessors(), 1 );
+
+    NormalChunks chunks;
+    osg::DrawElementsUInt* primitiveSets[2] = { _triangles.get(), _quads.get() };
+    for( unsigned int p = 0; p < 2; ++p )
+    {
+        osg::DrawElementsUInt* primitives = primitiveSets[p];
+        if( !primitives || primitives->empty() ) continue;
+
+        unsigned int numFaceVertices = ( p == 0 ) ? 3 : 4;
+        size_t numFaces = primitives->size() / numFaceVertices;
+        size_t numChunks = osg::minimum( size_t( numThreads ), numFaces / minFacesPerChunk + 1 );
+
+        for( size_t c = 0; c < numChunks; ++c )
+        {
+            NormalChunk chunk;
+            chunk.indices = &( primitives->front() );
+            chunk.numFaceVertices = numFaceVertices;
+            chunk.begin = ( numFaces * c / numChunks ) * numFaceVertices;
+            chunk.end = ( numFaces * ( c + 1 ) / numChunks ) * numFaceVertices;
+            chunks.push_back( chunk );
+        }
+    }
+
+    if( chunks.empty() ) return;
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    IndexRangeOperation indexRange( chunks, numVertices );
+    runParallel( indexRange, chunks.size() );
+
+    // faces that reference vertices from all over the array would need a full size array per
+    // thread, in which case the faces are summed by a single thread instead.
+    size_t totalRange = 0;
+    for( NormalChunks::iterator itr = chunks.begin(); itr != chunks.end(); ++itr )
+    {
+        if( itr->minIndex <= itr->maxIndex ) totalRange += itr->maxIndex - itr->minIndex + 1;
+    }
+
+    if( chunks.size() > 1 && totalRange > size_t( numVertices ) * 2 )
+    {
+        NormalChunks merged;
+        for( NormalChunks::iterator itr = chunks.begin(); itr != chunks.end(); ++itr )
+        {
+            if( merged.empty() || merged.back().numFaceVertices != itr->numFaceVertices )
+            {
+                merged.push_back( *itr );
+            }
+            else
+            {
+                merged.back().end = itr->end;
+            }
+            merged.back().minIndex = 0;
+            merged.back().maxIndex = numVertices - 1;
+        }
+        chunks.swap( merged );
+
+        // summing all of the faces in one chunk, so process the triangles and quads one at a time
+        AccumulateNormalsOperation accumulate( chunks, *_vertices );
+        for( unsigned int c = 0; c < chunks.size(); ++c ) accumulate( c );
+    }
+    else
+    {
+        AccumulateNormalsOperation accumulate( chunks, *_vertices );
+        runParallel( accumulate, chunks.size() );
+    }
+
+    _normals = new osg::Vec3Array( numVertices );
+
+    unsigned int numRanges = osg::minimum( numThreads, numVertices / static_cast<unsigned int>( minFacesPerChunk ) + 1 );
+    MergeNormalsOperation merge( chunks, *_normals, numRanges );
+    runParallel( merge, numRanges );
+
+    MESHINFO << "Computed " << numVertices << " vertex normals in "
+             << osg::Timer::instance()->delta_m( startTick, osg::Timer::instance()->tick() ) << "ms" << endl;
+}
+
+
 /*  Open a PLY file and read vertex, color and index data. and returns the node  */
 osg::Node* VertexData::readPlyFile( const char* filename, const bool ignoreColors )
 {
@@ -329,7 +937,12 @@ osg::Node* VertexData::readPlyFile( const char* filename, const bool ignoreColor
             }
         }
     }
-    for( int i = 0; i < nPlyElems; ++i )
+    // binary files with a supported layout are read in place, the rest one element at a time
+    bool readInPlace = readBinaryElements( file, filename, ignoreColors );
+    if( readInPlace )
+        result = true;
+
+    for( int i = 0; !readInPlace && i < nPlyElems; ++i )
     {
         int nElems;
         int nProps;
@@ -507,6 +1120,10 @@ osg::Node* VertexData::readPlyFile( const char* filename, const bool ignoreColor
         {
             geom->setColorArray(_colors.get(), osg::Array::BIND_PER_VERTEX );
         }
+        else if(_byteColors.valid())
+        {
+            geom->setColorArray(_byteColors.get(), osg::Array::BIND_PER_VERTEX );
+        }
         else if(_ambient.valid())
         {
             geom->setColorArray(_ambient.get(), osg::Array::BIND_PER_VERTEX );
@@ -524,16 +1141,16 @@ osg::Node* VertexData::readPlyFile( const char* filename, const bool ignoreColor
             geom->setTexCoordArray(0, _texcoord.get());
         }
 
-        // If the model has normals, add them to the geometry
+        // If the model doesn't have normals, generate smooth ones from its faces
+        if(!_normals.valid())
+        {
+            computeNormals();
+        }
+
         if(_normals.valid())
         {
             geom->setNormalArray(_normals.get(), osg::Array::BIND_PER_VERTEX);
         }
-        else
-        {   // If not, use the smoothing visitor to generate them
-            // (quads will be triangulated by the smoothing visitor)
-            osgUtil::SmoothingVisitor::smooth((*geom), osg::PI/2);
-        }
 
         // set flage true to activate the vertex buffer object of drawable
         geom->setUseVertexBufferObjects(true);
@@ -67,12 +67,23 @@ namespace ply
         // Reads the triangle indices from the ply file
         void readTriangles( PlyFile* file, const int nFaces );
 
+        // Reads all the elements of a binary ply file directly from the
+        // memory mapped file, returns false if the file's layout isn't
+        // supported so that the elements can be read the generic way
+        bool readBinaryElements( PlyFile* file, const char* filename,
+                                 const bool ignoreColors );
+
+        // Computes smooth vertex normals from the triangles and quads
+        void computeNormals();
+
         bool        _invertFaces;
 
         // Vertex array in osg format
         osg::ref_ptr<osg::Vec3Array>   _vertices;
         // Color array in osg format
         osg::ref_ptr<osg::Vec4Array>   _colors;
+        // Color array of the binary fast path, kept as unsigned bytes
+        osg::ref_ptr<osg::Vec4ubArray> _byteColors;
         osg::ref_ptr<osg::Vec4Array>   _ambient;
         osg::ref_ptr<osg::Vec4Array>   _diffuse;
         osg::ref_ptr<osg::Vec4Array>   _specular;
@@ -44,6 +44,7 @@ _zipLoaded( false )
 
 ZipArchive::~ZipArchive()
 {
+    close();
 }
 
 /** close the archive (on all threads) */
@@ -54,15 +55,22 @@ void ZipArchive::close()
         OpenThreads::ScopedLock<OpenThreads::Mutex> exclusive(_zipMutex);
         if ( _zipLoaded )
         {
-            // close the file (on one thread since it's a shared file)
-            const PerThreadData& data = getDataNoLock();
-            CloseZip( data._zipHandle );
+            // close the handles opened by each of the threads that have read from the archive.
+            for(PerThreadDataMap::iterator itr = _perThreadData.begin(); itr != _perThreadData.end(); ++itr)
+            {
+                if (itr->second._zipHandle != NULL) CloseZip( itr->second._zipHandle );
+            }
 
             // clear out the file handles
             _perThreadData.clear();
 
             // clear out the index.
+            for(ZipEntryMap::iterator itr = _zipIndex.begin(); itr != _zipIndex.end(); ++itr)
+            {
+                delete itr->second;
+            }
             _zipIndex.clear();
+            _zipOffsets.clear();
 
             _zipLoaded = false;
         }
@@ -419,6 +427,13 @@ osgDB::ReaderWriter* ZipArchive::ReadFromZipEntry(const ZIPENTRY* ze, const osgD
             const PerThreadData& data = getData();
             if ( data._zipHandle != NULL )
             {
+                // position the handle on the entry directly, which also means that threads
+                // reading different entries don't have to walk the central directory between them.
+                if (ze->index >= 0 && ze->index < static_cast<int>(_zipOffsets.size()))
+                {
+                    GotoZipItem(data._zipHandle, ze->index, _zipOffsets[ze->index]);
+                }
+
                 ZRESULT result = UnzipItem(data._zipHandle, ze->index, ibuf, ze->unc_size);
                 bool unzipSuccesful = CheckZipErrorCode(result);
                 if(unzipSuccesful)
@@ -488,12 +503,16 @@ void ZipArchive::IndexZipFiles(HZIP hz)
         GetZipItem(hz, -1, &_mainRecord);
         int numitems = _mainRecord.index;
 
+        _zipOffsets.resize(numitems, 0);
+
         // Now loop through each file in zip
         for (int i = 0; i < numitems; i++)
         {
             ZIPENTRY* ze = new ZIPENTRY();
 
             GetZipItem(hz, i, ze);
+            GetZipItemOffset(hz, i, &_zipOffsets[i]);
+
             std::string name = ze->name;
 
             CleanupFileString(name);
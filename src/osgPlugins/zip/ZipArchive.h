@@ -7,6 +7,8 @@
 #include <osgDB/Archive>
 #include <OpenThreads/Mutex>
 
+#include <vector>
+
 #include "unzip.h"
 
 
@@ -88,6 +90,11 @@ class ZipArchive : public osgDB::Archive
         ZipEntryMap        _zipIndex;
         ZIPENTRY           _mainRecord;
 
+        // position of each entry's central directory record, indexed by ZIPENTRY::index, so that
+        // the per thread handles can go straight to an entry rather than walk the central directory.
+        typedef std::vector<unsigned long> ZipOffsets;
+        ZipOffsets         _zipOffsets;
+
         struct PerThreadData {
             HZIP _zipHandle;
         };
@@ -3982,6 +3982,8 @@ class TUnzip
   ZRESULT Open(void *z,unsigned int len,DWORD flags);
   ZRESULT Get(int index,ZIPENTRY *ze);
   ZRESULT Find(const TCHAR *name,bool ic,int *index,ZIPENTRY *ze);
+  ZRESULT GetOffset(int index,unsigned long *offset);
+  ZRESULT Goto(int index,unsigned long offset);
   ZRESULT Unzip(int index,void *dst,unsigned int len,DWORD flags);
   ZRESULT SetUnzipBaseDir(const TCHAR *dir);
   ZRESULT Close();
@@ -4174,6 +4176,28 @@ ZRESULT TUnzip::Get(int index,ZIPENTRY *ze)
   return ZR_OK;
 }
 
+ZRESULT TUnzip::GetOffset(int index,unsigned long *offset)
+{ if (index<0 || index>=(int)uf->gi.number_entry) return ZR_ARGS;
+  if (currentfile!=-1) unzCloseCurrentFile(uf); currentfile=-1;
+  if (index<(int)uf->num_file) unzGoToFirstFile(uf);
+  while ((int)uf->num_file<index) unzGoToNextFile(uf);
+  if (!uf->current_file_ok) return ZR_CORRUPT;
+  *offset = uf->pos_in_central_dir;
+  return ZR_OK;
+}
+
+ZRESULT TUnzip::Goto(int index,unsigned long offset)
+{ if (index<0 || index>=(int)uf->gi.number_entry) return ZR_ARGS;
+  if (currentfile!=-1) unzCloseCurrentFile(uf); currentfile=-1;
+  if (index==(int)uf->num_file && uf->current_file_ok) return ZR_OK;
+  uf->pos_in_central_dir=offset;
+  uf->num_file=index;
+  int err=unzlocal_GetCurrentFileInfoInternal(uf,&uf->cur_file_info,&uf->cur_file_info_internal,NULL,0,NULL,0,NULL,0);
+  uf->current_file_ok = (err==UNZ_OK);
+  if (err!=UNZ_OK) {unzGoToFirstFile(uf); return ZR_CORRUPT;}
+  return ZR_OK;
+}
+
 ZRESULT TUnzip::Find(const TCHAR *tname,bool ic,int *index,ZIPENTRY *ze)
 { char name[MAX_PATH];
 #ifdef UNICODE
@@ -4507,6 +4531,24 @@ ZRESULT FindZipItem(HZIP hz, const TCHAR *name, bool ic, int *index, ZIPENTRY *z
   return lasterrorU;
 }
 
+ZRESULT GetZipItemOffset(HZIP hz, int index, unsigned long *offset)
+{ if (hz==0) {lasterrorU=ZR_ARGS;return ZR_ARGS;}
+  TUnzipHandleData *han = (TUnzipHandleData*)hz;
+  if (han->flag!=1) {lasterrorU=ZR_ZMODE;return ZR_ZMODE;}
+  TUnzip *unz = han->unz;
+  lasterrorU = unz->GetOffset(index,offset);
+  return lasterrorU;
+}
+
+ZRESULT GotoZipItem(HZIP hz, int index, unsigned long offset)
+{ if (hz==0) {lasterrorU=ZR_ARGS;return ZR_ARGS;}
+  TUnzipHandleData *han = (TUnzipHandleData*)hz;
+  if (han->flag!=1) {lasterrorU=ZR_ZMODE;return ZR_ZMODE;}
+  TUnzip *unz = han->unz;
+  lasterrorU = unz->Goto(index,offset);
+  return lasterrorU;
+}
+
 ZRESULT UnzipItemInternal(HZIP hz, int index, void *dst, unsigned int len, DWORD flags)
 { if (hz==0) {lasterrorU=ZR_ARGS;return ZR_ARGS;}
   TUnzipHandleData *han = (TUnzipHandleData*)hz;
@@ -134,6 +134,13 @@ ZRESULT FindZipItem(HZIP hz, const TCHAR *name, bool ic, int *index, ZIPENTRY *z
 // If nothing was found, then index is set to -1 and the function returns
 // an error code.
 
+ZRESULT GetZipItemOffset(HZIP hz, int index, unsigned long *offset);
+ZRESULT GotoZipItem(HZIP hz, int index, unsigned long offset);
+// GetZipItemOffset - returns the position of the item's record within the central
+// directory. Passing it to GotoZipItem, on this or any other handle opened on the
+// same zipfile, makes the item the current one without walking the central
+// directory from the start, so that a subsequent GetZipItem or UnzipItem of that
+// index doesn't have to read every record that precedes it.
 ZRESULT UnzipItem(HZIP hz, int index, const TCHAR *fn);
 ZRESULT UnzipItem(HZIP hz, int index, void *z,unsigned int len);
 ZRESULT UnzipItemHandle(HZIP hz, int index, HANDLE h);
@@ -0,0 +1,556 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgSim/TerrainQueryService>
+
+#include <osgUtil/LineSegmentIntersector>
+
+#include <math.h>
+
+using namespace osgSim;
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// TerrainQueryService::Query
+//
+TerrainQueryService::Query::Query():
+    _complete(0),
+    _valid(false),
+    _heightAboveTerrain(0.0)
+{
+}
+
+TerrainQueryService::Query::~Query()
+{
+}
+
+void TerrainQueryService::Query::wait()
+{
+    if (isComplete()) return;
+
+    // make sure the query has been dispatched before waiting on it.
+    osg::ref_ptr<TerrainQueryService> service;
+    if (_service.lock(service)) service->flush();
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_completion->mutex);
+    while(!isComplete())
+    {
+        _completion->condition.wait(&_completion->mutex);
+    }
+}
+
+void TerrainQueryService::Query::complete(bool valid)
+{
+    // waiting queries are woken by the service's signalCompletion() once the whole traversal is complete.
+    _valid = valid;
+    _complete.exchange(1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// TileIntersectorGroup
+//
+
+/** IntersectorGroup of the line segments of a traversal, that rejects the nodes lying outside the bound of all
+  * its segments with a single test rather than testing each segment in turn. As the segments of a traversal are
+  * all from the same tile, this culls most of the scene without the cost growing with the number of queries.*/
+class TileIntersectorGroup : public osgUtil::IntersectorGroup
+{
+    public:
+
+        TileIntersectorGroup() {}
+
+        void addLineSegmentIntersector(osgUtil::LineSegmentIntersector* intersector)
+        {
+            addIntersector(intersector);
+
+            _segmentBound.expandBy(intersector->getStart());
+            _segmentBound.expandBy(intersector->getEnd());
+        }
+
+        virtual osgUtil::Intersector* clone(osgUtil::IntersectionVisitor& iv)
+        {
+            TileIntersectorGroup* group = new TileIntersectorGroup;
+
+            for(Intersectors::iterator itr = _intersectors.begin();
+                itr != _intersectors.end();
+                ++itr)
+            {
+                if (!(*itr)->disabled())
+                {
+                    group->addLineSegmentIntersector(static_cast<osgUtil::LineSegmentIntersector*>((*itr)->clone(iv)));
+                }
+            }
+
+            return group;
+        }
+
+        virtual bool enter(const osg::Node& node)
+        {
+            if (disabled()) return false;
+
+            const osg::BoundingSphere& bs = node.getBound();
+            if (bs.valid() && _segmentBound.valid())
+            {
+                double radius = _segmentBound.radius() + bs.radius();
+                if ((osg::Vec3d(bs.center())-_segmentBound.center()).length2() > radius*radius) return false;
+            }
+
+            return osgUtil::IntersectorGroup::enter(node);
+        }
+
+    protected:
+
+        osg::BoundingBoxd   _segmentBound;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// TerrainQueryService::TraversalOperation
+//
+class TerrainQueryService::TraversalOperation : public osg::Operation
+{
+    public:
+
+        TraversalOperation(TerrainQueryService* service, const TileKey& tileKey, osg::Node::NodeMask traversalMask, unsigned int cacheGeneration):
+            osg::Operation("TerrainQueryTraversal", false),
+            _service(service),
+            _tileKey(tileKey),
+            _traversalMask(traversalMask),
+            _cacheGeneration(cacheGeneration) {}
+
+        virtual void operator () (osg::Object*)
+        {
+            _service->computeJobs(_jobs, _traversalMask);
+            _service->completeJobs(_tileKey, _jobs, _cacheGeneration);
+        }
+
+        // the service waits for all its traversals to complete before it is deleted.
+        TerrainQueryService*    _service;
+        TileKey                 _tileKey;
+        osg::Node::NodeMask     _traversalMask;
+        unsigned int            _cacheGeneration;
+        std::vector<Job>        _jobs;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// TerrainQueryService::SceneBoundCallback
+//
+
+/** Counts the recomputes of the scene's bound, chaining to any ComputeBoundingSphereCallback already assigned to the scene.*/
+class TerrainQueryService::SceneBoundCallback : public osg::Node::ComputeBoundingSphereCallback
+{
+    public:
+
+        SceneBoundCallback(osg::Node::ComputeBoundingSphereCallback* previous=0):
+            _previous(previous) {}
+
+        SceneBoundCallback(const SceneBoundCallback& rhs, const osg::CopyOp& copyop):
+            osg::Node::ComputeBoundingSphereCallback(rhs, copyop),
+            _previous(rhs._previous) {}
+
+        META_Object(osgSim, SceneBoundCallback);
+
+        virtual osg::BoundingSphere computeBound(const osg::Node& node) const
+        {
+            ++_numBoundsComputed;
+            return _previous.valid() ? _previous->computeBound(node) : node.computeBound();
+        }
+
+        osg::ref_ptr<osg::Node::ComputeBoundingSphereCallback>  _previous;
+        mutable OpenThreads::Atomic                             _numBoundsComputed;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// TerrainQueryService
+//
+TerrainQueryService::TerrainQueryService(osg::Node* scene, unsigned int numThreads):
+    _scene(scene),
+    _tileSize(1000.0),
+    _maxQueriesPerTraversal(256),
+    _lowestHeight(-1000.0),
+    _numCachedResults(0),
+    _maxNumCachedResults(100000),
+    _cacheNumSceneBoundsComputed(0),
+    _cacheGeneration(0),
+    _completion(new CompletionCondition),
+    _numActiveTraversals(0),
+    _operationQueue(new osg::OperationQueue)
+{
+    osg::CoordinateSystemNode* csn = dynamic_cast<osg::CoordinateSystemNode*>(scene);
+    _ellipsoidModel = csn ? csn->getEllipsoidModel() : 0;
+
+    _dcrc = new DatabaseCacheReadCallback;
+
+    _sceneBoundCallback = new SceneBoundCallback(scene->getComputeBoundingSphereCallback());
+    scene->setComputeBoundingSphereCallback(_sceneBoundCallback.get());
+
+    // on a single processor a worker thread would only compete with the calling thread, so the queries are computed by flush() instead.
+    if (numThreads==0)
+    {
+        int numProcessors = OpenThreads::GetNumberOfProcessors();
+        numThreads = numProcessors>1 ? static_cast<unsigned int>(numProcessors) : 0;
+    }
+
+    for(unsigned int i=0; i<numThreads; ++i)
+    {
+        osg::ref_ptr<osg::OperationThread> thread = new osg::OperationThread;
+        thread->setOperationQueue(_operationQueue.get());
+        thread->startThread();
+        _threads.push_back(thread);
+    }
+}
+
+TerrainQueryService::~TerrainQueryService()
+{
+    // queries that were never dispatched are completed as invalid so that nothing waits on them forever.
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pendingMutex);
+        for(TileJobs::iterator titr = _pendingJobs.begin(); titr != _pendingJobs.end(); ++titr)
+        {
+            for(Jobs::iterator jitr = titr->second.begin(); jitr != titr->second.end(); ++jitr)
+            {
+                for(Queries::iterator qitr = jitr->second.queries.begin(); qitr != jitr->second.queries.end(); ++qitr)
+                {
+                    (*qitr)->complete(false);
+                }
+            }
+        }
+        _pendingJobs.clear();
+    }
+    signalCompletion();
+
+    waitForCompletion();
+
+    for(Threads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+    {
+        (*itr)->setDone(true);
+    }
+    _operationQueue->releaseOperationsBlock();
+    for(Threads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+    {
+        (*itr)->join();
+    }
+
+    // restore the scene's own callback, unless another has since been chained onto ours.
+    if (_scene->getComputeBoundingSphereCallback()==_sceneBoundCallback.get())
+    {
+        _scene->setComputeBoundingSphereCallback(_sceneBoundCallback->_previous.get());
+    }
+}
+
+void TerrainQueryService::setMaximumNumCachedResults(unsigned int num)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+    _maxNumCachedResults = num;
+    pruneCache();
+}
+
+void TerrainQueryService::clearCache()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+    _cache.clear();
+    _leastRecentlyUsedTiles.clear();
+    _numCachedResults = 0;
+
+    // results of traversals already dispatched may predate the clear, so aren't cached.
+    ++_cacheGeneration;
+}
+
+unsigned int TerrainQueryService::getNumCachedResults() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+    return _numCachedResults;
+}
+
+TerrainQueryService::TileKey TerrainQueryService::computeTileKey(const osg::Vec3d& position) const
+{
+    double scale = _tileSize>0.0 ? 1.0/_tileSize : 1.0;
+    return TileKey(static_cast<long long>(floor(position.x()*scale)),
+                   static_cast<long long>(floor(position.y()*scale)),
+                   static_cast<long long>(floor(position.z()*scale)));
+}
+
+osg::ref_ptr<TerrainQueryService::Query> TerrainQueryService::computeHeightAboveTerrain(const osg::Vec3d& point, osg::Node::NodeMask traversalMask)
+{
+    Job job;
+    job.key.type = HEIGHT_ABOVE_TERRAIN;
+    job.key.traversalMask = traversalMask;
+    job.key.start = point;
+
+    // test down from the point to the lowest height, as HeightAboveTerrain does.
+    osg::Vec3d upVector(0.0, 0.0, 1.0);
+    double height = point.z();
+    if (_ellipsoidModel.valid())
+    {
+        upVector = _ellipsoidModel->computeLocalUpVector(point.x(), point.y(), point.z());
+
+        double latitude, longitude;
+        _ellipsoidModel->convertXYZToLatLongHeight(point.x(), point.y(), point.z(), latitude, longitude, height);
+    }
+
+    job.key.end = point - upVector * (height - _lowestHeight);
+    job.height = height;
+
+    return submit(job, point);
+}
+
+osg::ref_ptr<TerrainQueryService::Query> TerrainQueryService::computeLineOfSight(const osg::Vec3d& start, const osg::Vec3d& end, osg::Node::NodeMask traversalMask)
+{
+    Job job;
+    job.key.type = LINE_OF_SIGHT;
+    job.key.traversalMask = traversalMask;
+    job.key.start = start;
+    job.key.end = end;
+
+    return submit(job, (start+end)*0.5);
+}
+
+osg::ref_ptr<TerrainQueryService::Query> TerrainQueryService::submit(const Job& job, const osg::Vec3d& position)
+{
+    ++_numSubmitted;
+
+    osg::ref_ptr<Query> query = new Query;
+    query->_service = this;
+    query->_completion = _completion;
+    query->_start = job.key.start;
+    query->_end = job.key.end;
+
+    TileKey tileKey = computeTileKey(position);
+
+    // complete the query straight away if the same query has already been computed.
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+        validateCache();
+
+        ResultCache::iterator titr = _cache.find(tileKey);
+        if (titr != _cache.end())
+        {
+            Results::iterator ritr = titr->second.results.find(job.key);
+            if (ritr != titr->second.results.end())
+            {
+                _leastRecentlyUsedTiles.splice(_leastRecentlyUsedTiles.end(), _leastRecentlyUsedTiles, titr->second.position);
+
+                query->_heightAboveTerrain = ritr->second.heightAboveTerrain;
+                query->_intersections = ritr->second.intersections;
+                query->complete(true);
+
+                ++_numCached;
+                return query;
+            }
+        }
+    }
+
+    // queue the query, sharing the job of any identical query already queued.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pendingMutex);
+    Jobs& jobs = _pendingJobs[tileKey];
+    Jobs::iterator jitr = jobs.find(job.key);
+    if (jitr == jobs.end()) jitr = jobs.insert(Jobs::value_type(job.key, job)).first;
+    jitr->second.queries.push_back(query);
+
+    return query;
+}
+
+void TerrainQueryService::flush()
+{
+    TileJobs tileJobs;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pendingMutex);
+        tileJobs.swap(_pendingJobs);
+    }
+
+    unsigned int maxJobs = osg::maximum(_maxQueriesPerTraversal, 1u);
+
+    unsigned int cacheGeneration;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+        validateCache();
+        cacheGeneration = _cacheGeneration;
+    }
+
+    for(TileJobs::iterator titr = tileJobs.begin(); titr != tileJobs.end(); ++titr)
+    {
+        // the jobs of a tile are ordered by type then traversal mask, so each run of jobs with the same
+        // traversal mask is split into traversals of at most maxJobs queries.
+        osg::ref_ptr<TraversalOperation> operation;
+        for(Jobs::iterator jitr = titr->second.begin(); jitr != titr->second.end(); ++jitr)
+        {
+            if (!operation || operation->_traversalMask!=jitr->first.traversalMask || operation->_jobs.size()>=maxJobs)
+            {
+                if (operation.valid()) dispatch(operation.get());
+
+                operation = new TraversalOperation(this, titr->first, jitr->first.traversalMask, cacheGeneration);
+                operation->_jobs.reserve(osg::minimum(maxJobs, static_cast<unsigned int>(titr->second.size())));
+            }
+            // swap rather than copy the job's queries, the pending jobs being discarded once dispatched.
+            operation->_jobs.push_back(Job());
+            Job& job = operation->_jobs.back();
+            job.key = jitr->second.key;
+            job.height = jitr->second.height;
+            job.queries.swap(jitr->second.queries);
+        }
+
+        if (operation.valid()) dispatch(operation.get());
+    }
+}
+
+void TerrainQueryService::dispatch(TraversalOperation* operation)
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_activeMutex);
+        ++_numActiveTraversals;
+    }
+
+    if (_threads.empty()) (*operation)(0);
+    else _operationQueue->add(operation);
+}
+
+void TerrainQueryService::waitForCompletion()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_activeMutex);
+    while(_numActiveTraversals>0)
+    {
+        _activeCondition.wait(&_activeMutex);
+    }
+}
+
+void TerrainQueryService::computeJobs(std::vector<Job>& jobs, osg::Node::NodeMask traversalMask)
+{
+    ++_numTraversals;
+
+    osg::ref_ptr<TileIntersectorGroup> intersectorGroup = new TileIntersectorGroup();
+    for(std::vector<Job>::iterator itr = jobs.begin(); itr != jobs.end(); ++itr)
+    {
+        osg::ref_ptr<osgUtil::LineSegmentIntersector> intersector = new osgUtil::LineSegmentIntersector(itr->key.start, itr->key.end);
+
+        // height above terrain only needs the terrain nearest the point.
+        if (itr->key.type==HEIGHT_ABOVE_TERRAIN) intersector->setIntersectionLimit(osgUtil::Intersector::LIMIT_NEAREST);
+
+        intersectorGroup->addLineSegmentIntersector(intersector.get());
+    }
+
+    osgUtil::IntersectionVisitor intersectionVisitor(intersectorGroup.get(), _dcrc.get());
+    intersectionVisitor.setTraversalMask(traversalMask);
+
+    _scene->accept(intersectionVisitor);
+
+    osgUtil::IntersectorGroup::Intersectors& intersectors = intersectorGroup->getIntersectors();
+    for(unsigned int i=0; i<jobs.size(); ++i)
+    {
+        Job& job = jobs[i];
+        osgUtil::LineSegmentIntersector* lsi = static_cast<osgUtil::LineSegmentIntersector*>(intersectors[i].get());
+        osgUtil::LineSegmentIntersector::Intersections& intersections = lsi->getIntersections();
+
+        for(osgUtil::LineSegmentIntersector::Intersections::iterator itr = intersections.begin();
+            itr != intersections.end();
+            ++itr)
+        {
+            const osgUtil::LineSegmentIntersector::Intersection& intersection = *itr;
+            osg::Vec3d point = intersection.matrix.valid() ? intersection.localIntersectionPoint * (*intersection.matrix) :
+                                                             intersection.localIntersectionPoint;
+
+            if (job.key.type==HEIGHT_ABOVE_TERRAIN)
+            {
+                job.height = (job.key.start - point).length();
+                job.intersections.push_back(point);
+                break;
+            }
+
+            job.intersections.push_back(point);
+        }
+    }
+}
+
+void TerrainQueryService::completeJobs(const TileKey& tileKey, std::vector<Job>& jobs, unsigned int cacheGeneration)
+{
+    for(std::vector<Job>::iterator itr = jobs.begin(); itr != jobs.end(); ++itr)
+    {
+        for(Queries::iterator qitr = itr->queries.begin(); qitr != itr->queries.end(); ++qitr)
+        {
+            Query* query = qitr->get();
+            query->_heightAboveTerrain = itr->height;
+            query->_intersections = itr->intersections;
+            query->complete(true);
+        }
+        itr->queries.clear();
+    }
+    signalCompletion();
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheMutex);
+        if (_maxNumCachedResults>0 && cacheGeneration==_cacheGeneration)
+        {
+            std::pair<ResultCache::iterator, bool> tileInserted = _cache.insert(ResultCache::value_type(tileKey, TileResults()));
+            TileResults& tileResults = tileInserted.first->second;
+            if (tileInserted.second) tileResults.position = _leastRecentlyUsedTiles.insert(_leastRecentlyUsedTiles.end(), tileKey);
+            else _leastRecentlyUsedTiles.splice(_leastRecentlyUsedTiles.end(), _leastRecentlyUsedTiles, tileResults.position);
+
+            for(std::vector<Job>::iterator itr = jobs.begin(); itr != jobs.end(); ++itr)
+            {
+                std::pair<Results::iterator, bool> inserted = tileResults.results.insert(Results::value_type(itr->key, Result()));
+                if (inserted.second) ++_numCachedResults;
+
+                Result& result = inserted.first->second;
+                result.heightAboveTerrain = itr->height;
+                result.intersections.swap(itr->intersections);
+            }
+
+            pruneCache();
+        }
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_activeMutex);
+    --_numActiveTraversals;
+    if (_numActiveTraversals==0) _activeCondition.broadcast();
+}
+
+void TerrainQueryService::signalCompletion()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_completion->mutex);
+    _completion->condition.broadcast();
+}
+
+void TerrainQueryService::validateCache()
+{
+    // adding, removing or moving nodes dirties the bounds up to the top of the scene, so a recompute
+    // of the scene's bound means the cached results may no longer hold.
+    _scene->getBound();
+    unsigned int numBoundsComputed = _sceneBoundCallback->_numBoundsComputed;
+    if (numBoundsComputed==_cacheNumSceneBoundsComputed) return;
+
+    _cacheNumSceneBoundsComputed = numBoundsComputed;
+
+    _cache.clear();
+    _leastRecentlyUsedTiles.clear();
+    _numCachedResults = 0;
+    ++_cacheGeneration;
+}
+
+void TerrainQueryService::pruneCache()
+{
+    if (_numCachedResults<=_maxNumCachedResults) return;
+
+    // discard the least recently used tiles until the cache is back within 90% of its maximum size,
+    // so that a full cache isn't pruned after every traversal.
+    unsigned int target = _maxNumCachedResults - _maxNumCachedResults/10;
+    while(_numCachedResults>target && !_leastRecentlyUsedTiles.empty())
+    {
+        ResultCache::iterator oldest = _cache.find(_leastRecentlyUsedTiles.front());
+        _leastRecentlyUsedTiles.pop_front();
+
+        _numCachedResults -= static_cast<unsigned int>(oldest->second.results.size());
+        _cache.erase(oldest);
+    }
+}
@@ -16,9 +16,18 @@
 #include <osg/Texture1D>
 #include <osg/Texture2D>
 #include <osgDB/ReadFile>
+#include <osg/ApplicationUsage>
+
+#include <OpenThreads/ScopedLock>
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
 
 using namespace osgTerrain;
 
+static osg::ApplicationUsageProxy GeometryPool_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_TERRAIN_QUANTIZED_HEIGHTS <mode>","ON | OFF - hold the heights of GeometryPool tiles as 16 bit quantized heightfields rather than displaced vertices.");
+
 const osgTerrain::Locator* osgTerrain::computeMasterLocator(const osgTerrain::TerrainTile* tile)
 {
     const osgTerrain::Layer* elevationLayer = tile->getElevationLayer();
@@ -38,15 +47,134 @@ const osgTerrain::Locator* osgTerrain::computeMasterLocator(const osgTerrain::Te
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  QuantizedHeightField
+//
+QuantizedHeightField::QuantizedHeightField(const osg::HeightField* hf):
+    _numColumns(hf->getNumColumns()),
+    _numRows(hf->getNumRows()),
+    _heightOffset(0.0f),
+    _heightRange(0.0f),
+    _heights(0)
+{
+    const osg::HeightField::HeightList& heights = hf->getHeightList();
+
+    if (!heights.empty())
+    {
+        float minHeight = *std::min_element(heights.begin(), heights.end());
+        float maxHeight = *std::max_element(heights.begin(), heights.end());
+        _heightOffset = minHeight;
+        _heightRange = maxHeight-minHeight;
+    }
+
+    _image = new osg::Image;
+    _image->allocateImage(_numColumns, _numRows, 1, GL_LUMINANCE, GL_UNSIGNED_SHORT);
+    _image->setInternalTextureFormat(GL_LUMINANCE16);
+
+    unsigned short* quantized = reinterpret_cast<unsigned short*>(_image->data());
+    float quantizeScale = _heightRange>0.0f ? 65535.0f/_heightRange : 0.0f;
+    for(unsigned int i=0; i<heights.size(); ++i)
+    {
+        float value = (heights[i]-_heightOffset)*quantizeScale + 0.5f;
+        quantized[i] = static_cast<unsigned short>(osg::clampBetween(value, 0.0f, 65535.0f));
+    }
+    _heights = quantized;
+
+    computeLevelSizes(_numColumns, _numRows, _levelSizes);
+    _minMaxPyramid.resize(_levelSizes.size());
+
+    // level 0 from the samples at the corners and within each block of cells.
+    if (!_levelSizes.empty())
+    {
+        MinMaxList& level0 = _minMaxPyramid[0];
+        level0.resize(_levelSizes[0].first*_levelSizes[0].second);
+        for(unsigned int r=0; r<_numRows; ++r)
+        {
+            // a sample on the boundary between blocks belongs to the cells of both.
+            unsigned int br_begin = (r>0) ? (r-1)/LEAF_SIZE : 0;
+            unsigned int br_end = osg::minimum(r/LEAF_SIZE, _levelSizes[0].second-1);
+            for(unsigned int c=0; c<_numColumns; ++c)
+            {
+                unsigned short value = _heights[c+r*_numColumns];
+                unsigned int bc_begin = (c>0) ? (c-1)/LEAF_SIZE : 0;
+                unsigned int bc_end = osg::minimum(c/LEAF_SIZE, _levelSizes[0].first-1);
+                for(unsigned int br=br_begin; br<=br_end; ++br)
+                {
+                    for(unsigned int bc=bc_begin; bc<=bc_end; ++bc)
+                    {
+                        MinMax& mm = level0[bc+br*_levelSizes[0].first];
+                        mm.minimum = osg::minimum(mm.minimum, value);
+                        mm.maximum = osg::maximum(mm.maximum, value);
+                    }
+                }
+            }
+        }
+    }
+
+    for(unsigned int level=1; level<_levelSizes.size(); ++level)
+    {
+        const MinMaxList& below = _minMaxPyramid[level-1];
+        unsigned int below_nc = _levelSizes[level-1].first;
+        unsigned int below_nr = _levelSizes[level-1].second;
+
+        MinMaxList& current = _minMaxPyramid[level];
+        current.resize(_levelSizes[level].first*_levelSizes[level].second);
+        for(unsigned int br=0; br<below_nr; ++br)
+        {
+            for(unsigned int bc=0; bc<below_nc; ++bc)
+            {
+                const MinMax& source = below[bc+br*below_nc];
+                MinMax& mm = current[(bc/2)+(br/2)*_levelSizes[level].first];
+                mm.minimum = osg::minimum(mm.minimum, source.minimum);
+                mm.maximum = osg::maximum(mm.maximum, source.maximum);
+            }
+        }
+    }
+}
+
+void QuantizedHeightField::computeLevelSizes(unsigned int numColumns, unsigned int numRows, LevelSizes& levelSizes)
+{
+    levelSizes.clear();
+    if (numColumns<2 || numRows<2) return;
+
+    unsigned int nc = (numColumns-1+LEAF_SIZE-1)/LEAF_SIZE;
+    unsigned int nr = (numRows-1+LEAF_SIZE-1)/LEAF_SIZE;
+    levelSizes.push_back(std::make_pair(nc, nr));
+    while(nc>1 || nr>1)
+    {
+        nc = (nc+1)/2;
+        nr = (nr+1)/2;
+        levelSizes.push_back(std::make_pair(nc, nr));
+    }
+}
+
+unsigned int QuantizedHeightField::getSizeInBytes() const
+{
+    unsigned int size = _numColumns*_numRows*sizeof(unsigned short);
+    for(std::vector<MinMaxList>::const_iterator itr = _minMaxPyramid.begin(); itr != _minMaxPyramid.end(); ++itr)
+    {
+        size += itr->size()*sizeof(MinMax);
+    }
+    return size;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //  GeometryPool
 //
 GeometryPool::GeometryPool():
-    _rootStateSetAssigned(false)
-
+    _rootStateSetAssigned(false),
+    _useQuantizedHeights(false)
 {
     _rootStateSet = new osg::StateSet;
+
+    const char* ptr = getenv("OSG_TERRAIN_QUANTIZED_HEIGHTS");
+    if (ptr)
+    {
+        std::string value(ptr);
+        _useQuantizedHeights = (value=="ON" || value=="On" || value=="on");
+    }
 }
 
 GeometryPool::~GeometryPool()
@@ -465,7 +593,24 @@ osg::ref_ptr<osg::MatrixTransform> GeometryPool::getTileSubgraph(osgTerrain::Ter
 
     if (hf && shared_vertices && shared_normals && (shared_vertices->size()==shared_normals->size()))
     {
-        if (vthfm.size()==shared_vertices->size())
+        if (_useQuantizedHeights && vthfm.size()==shared_vertices->size())
+        {
+            // keep only the quantized heights, bounding the tile by displacing the shared vertices without storing them.
+            osg::ref_ptr<QuantizedHeightField> qhf = getOrCreateQuantizedHeightField(hf);
+            hfDrawable->setQuantizedHeightField(qhf.get());
+
+            unsigned int nc = qhf->getNumColumns();
+            unsigned int numVertices = shared_vertices->size();
+
+            osg::BoundingBox bb;
+            for(unsigned int i=0; i<numVertices; ++i)
+            {
+                unsigned int hi = vthfm[i];
+                bb.expandBy((*shared_vertices)[i] + (*shared_normals)[i] * qhf->getHeight(hi%nc, hi/nc));
+            }
+            hfDrawable->setInitialBound(bb);
+        }
+        else if (vthfm.size()==shared_vertices->size())
         {
             // Using cache VertexArray
             unsigned int numVertices = shared_vertices->size();
@@ -605,15 +750,29 @@ void GeometryPool::applyLayers(osgTerrain::TerrainTile* tile, osg::StateSet* sta
         {
             texture2D = new osg::Texture2D;
 
-            osg::ref_ptr<osg::Image> image = new osg::Image;
+            osg::ref_ptr<osg::Image> image;
 
-            const void* dataPtr = hfl->getHeightField()->getFloatArray()->getDataPointer();
+            if (_useQuantizedHeights)
+            {
+                // the image of the QuantizedHeightField is normalized to 0 to 1, which the shader maps back to heights.
+                osg::ref_ptr<QuantizedHeightField> qhf = getOrCreateQuantizedHeightField(hfl->getHeightField());
+                image = qhf->getImage();
 
-            image->setImage(hfl->getNumRows(), hfl->getNumColumns(), 1,
-                      GL_LUMINANCE32F_ARB,
-                      GL_LUMINANCE, GL_FLOAT,
-                      reinterpret_cast<unsigned char*>(const_cast<void*>(dataPtr)),
-                      osg::Image::NO_DELETE);
+                stateset->setDefine("HEIGHTFIELD_QUANTIZED");
+                stateset->addUniform(new osg::Uniform("terrainHeightRange", osg::Vec2(qhf->getHeightOffset(), qhf->getHeightRange())));
+            }
+            else
+            {
+                image = new osg::Image;
+
+                const void* dataPtr = hfl->getHeightField()->getFloatArray()->getDataPointer();
+
+                image->setImage(hfl->getNumRows(), hfl->getNumColumns(), 1,
+                          GL_LUMINANCE32F_ARB,
+                          GL_LUMINANCE, GL_FLOAT,
+                          reinterpret_cast<unsigned char*>(const_cast<void*>(dataPtr)),
+                          osg::Image::NO_DELETE);
+            }
 
             texture2D->setImage(image.get());
             texture2D->setFilter(osg::Texture2D::MIN_FILTER, osg::Texture2D::NEAREST);
@@ -764,6 +923,34 @@ void GeometryPool::applyLayers(osgTerrain::TerrainTile* tile, osg::StateSet* sta
     }
 }
 
+osg::ref_ptr<QuantizedHeightField> GeometryPool::getOrCreateQuantizedHeightField(const osg::HeightField* hf)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex>  lock(_quantizedHeightFieldMapMutex);
+
+    QuantizedHeightFieldMap::iterator itr = _quantizedHeightFieldMap.find(hf);
+    if (itr != _quantizedHeightFieldMap.end())
+    {
+        osg::ref_ptr<QuantizedHeightField> qhf;
+        if (itr->second.heightField.valid() && itr->second.quantizedHeightField.lock(qhf)) return qhf;
+    }
+
+    // remove the entries of tiles that have since been deleted.
+    for(QuantizedHeightFieldMap::iterator ditr = _quantizedHeightFieldMap.begin();
+        ditr != _quantizedHeightFieldMap.end();)
+    {
+        if (!ditr->second.heightField.valid() || !ditr->second.quantizedHeightField.valid()) _quantizedHeightFieldMap.erase(ditr++);
+        else ++ditr;
+    }
+
+    osg::ref_ptr<QuantizedHeightField> qhf = new QuantizedHeightField(hf);
+
+    QuantizedHeightFieldEntry& entry = _quantizedHeightFieldMap[hf];
+    entry.heightField = const_cast<osg::HeightField*>(hf);
+    entry.quantizedHeightField = qhf;
+
+    return qhf;
+}
+
 osg::StateSet* GeometryPool::getRootStateSetForTerrain(Terrain* /*terrain*/)
 {
     //OSG_NOTICE<<"getRootStateSetForTerrain("<<terrain<<")"<<std::endl;
@@ -796,6 +983,80 @@ SharedGeometry::~SharedGeometry()
 {
 }
 
+const SharedGeometry::CellBoundsPyramid* SharedGeometry::getCellBoundsPyramid(unsigned int numColumns, unsigned int numRows) const
+{
+    const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(_vertexArray.get());
+    const osg::Vec3Array* normals = dynamic_cast<const osg::Vec3Array*>(_normalArray.get());
+    if (!vertices || !normals || numColumns<2 || numRows<2) return 0;
+
+    // main body with a skirt vertex at each end of each row, and a skirt row above and below.
+    if (vertices->size()!=numColumns*numRows + numColumns*2 + numRows*2 || normals->size()!=vertices->size()) return 0;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cellBoundsMutex);
+
+    if (!_cellBoundsPyramid.empty()) return &_cellBoundsPyramid;
+
+    QuantizedHeightField::LevelSizes levelSizes;
+    QuantizedHeightField::computeLevelSizes(numColumns, numRows, levelSizes);
+
+    _cellBoundsPyramid.resize(levelSizes.size());
+
+    // level 0 blocks bound the samples at the corners and within each block of cells.
+    const unsigned int leafSize = QuantizedHeightField::LEAF_SIZE;
+    std::vector<CellBounds>& level0 = _cellBoundsPyramid[0];
+    level0.resize(levelSizes[0].first*levelSizes[0].second);
+    for(unsigned int br=0; br<levelSizes[0].second; ++br)
+    {
+        for(unsigned int bc=0; bc<levelSizes[0].first; ++bc)
+        {
+            osg::BoundingBox vbb, nbb;
+            unsigned int r_end = osg::minimum((br+1)*leafSize, numRows-1);
+            unsigned int c_end = osg::minimum((bc+1)*leafSize, numColumns-1);
+            for(unsigned int r=br*leafSize; r<=r_end; ++r)
+            {
+                for(unsigned int c=bc*leafSize; c<=c_end; ++c)
+                {
+                    unsigned int vi = getVertexIndex(numColumns, c, r);
+                    vbb.expandBy((*vertices)[vi]);
+                    nbb.expandBy((*normals)[vi]);
+                }
+            }
+
+            CellBounds& cb = level0[bc+br*levelSizes[0].first];
+            cb.vertexMin = vbb._min; cb.vertexMax = vbb._max;
+            cb.normalMin = nbb._min; cb.normalMax = nbb._max;
+        }
+    }
+
+    for(unsigned int level=1; level<levelSizes.size(); ++level)
+    {
+        const std::vector<CellBounds>& below = _cellBoundsPyramid[level-1];
+        std::vector<CellBounds>& current = _cellBoundsPyramid[level];
+
+        std::vector<osg::BoundingBox> vbbs(levelSizes[level].first*levelSizes[level].second);
+        std::vector<osg::BoundingBox> nbbs(vbbs.size());
+        for(unsigned int br=0; br<levelSizes[level-1].second; ++br)
+        {
+            for(unsigned int bc=0; bc<levelSizes[level-1].first; ++bc)
+            {
+                const CellBounds& source = below[bc+br*levelSizes[level-1].first];
+                unsigned int i = (bc/2)+(br/2)*levelSizes[level].first;
+                vbbs[i].expandBy(source.vertexMin); vbbs[i].expandBy(source.vertexMax);
+                nbbs[i].expandBy(source.normalMin); nbbs[i].expandBy(source.normalMax);
+            }
+        }
+
+        current.resize(vbbs.size());
+        for(unsigned int i=0; i<vbbs.size(); ++i)
+        {
+            current[i].vertexMin = vbbs[i]._min; current[i].vertexMax = vbbs[i]._max;
+            current[i].normalMin = nbbs[i]._min; current[i].normalMax = nbbs[i]._max;
+        }
+    }
+
+    return &_cellBoundsPyramid;
+}
+
 osg::VertexArrayState* SharedGeometry::createVertexArrayStateImplementation(osg::RenderInfo& renderInfo) const
 {
     osg::State& state = *renderInfo.getState();
@@ -1025,7 +1286,8 @@ HeightFieldDrawable::HeightFieldDrawable(const HeightFieldDrawable& rhs,const os
     osg::Drawable(rhs, copyop),
     _heightField(rhs._heightField),
     _geometry(rhs._geometry),
-    _vertices(rhs._vertices)
+    _vertices(rhs._vertices),
+    _quantizedHeightField(rhs._quantizedHeightField)
 {
     setSupportsDisplayList(false);
 }
@@ -1054,6 +1316,12 @@ void HeightFieldDrawable::releaseGLObjects(osg::State* state) const
     if (_geometry.valid()) _geometry->releaseGLObjects(state);
 }
 
+osg::BoundingBox HeightFieldDrawable::computeBoundingBox() const
+{
+    if (_quantizedHeightField.valid() && !_vertices) return osg::BoundingBox();
+    return osg::Drawable::computeBoundingBox();
+}
+
 void HeightFieldDrawable::accept(osg::Drawable::AttributeFunctor& af)
 {
     if (_geometry) _geometry->accept(af);
@@ -1069,9 +1337,10 @@ void HeightFieldDrawable::accept(osg::PrimitiveFunctor& pf) const
     // use the cached vertex positions for PrimitiveFunctor operations
     if (!_geometry) return;
 
-    if (_vertices.valid())
+    osg::ref_ptr<osg::Vec3Array> vertices = _vertices.valid() ? _vertices : createVertices();
+    if (vertices.valid())
     {
-        pf.setVertexArray(_vertices->size(), &((*_vertices)[0]));
+        pf.setVertexArray(vertices->size(), &((*vertices)[0]));
 
         const osg::DrawElementsUShort* deus = dynamic_cast<const osg::DrawElementsUShort*>(_geometry->getDrawElements());
         if (deus)
@@ -1095,9 +1364,12 @@ void HeightFieldDrawable::accept(osg::PrimitiveFunctor& pf) const
 
 void HeightFieldDrawable::accept(osg::PrimitiveIndexFunctor& pif) const
 {
-    if (_vertices.valid())
+    if (!_geometry) return;
+
+    osg::ref_ptr<osg::Vec3Array> vertices = _vertices.valid() ? _vertices : createVertices();
+    if (vertices.valid())
     {
-        pif.setVertexArray(_vertices->size(), &((*_vertices)[0]));
+        pif.setVertexArray(vertices->size(), &((*vertices)[0]));
 
         const osg::DrawElementsUShort* deus = dynamic_cast<const osg::DrawElementsUShort*>(_geometry->getDrawElements());
         if (deus)
@@ -1118,3 +1390,274 @@ void HeightFieldDrawable::accept(osg::PrimitiveIndexFunctor& pif) const
         _geometry->accept(pif);
     }
 }
+
+osg::ref_ptr<osg::Vec3Array> HeightFieldDrawable::createVertices() const
+{
+    if (!_quantizedHeightField || !_geometry) return 0;
+
+    const osg::Vec3Array* shared_vertices = dynamic_cast<const osg::Vec3Array*>(_geometry->getVertexArray());
+    const osg::Vec3Array* shared_normals = dynamic_cast<const osg::Vec3Array*>(_geometry->getNormalArray());
+    const SharedGeometry::VertexToHeightFieldMapping& vthfm = _geometry->getVertexToHeightFieldMapping();
+    if (!shared_vertices || !shared_normals || vthfm.size()!=shared_vertices->size() || shared_normals->size()!=shared_vertices->size()) return 0;
+
+    unsigned int nc = _quantizedHeightField->getNumColumns();
+    unsigned int numVertices = shared_vertices->size();
+
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(numVertices);
+    for(unsigned int i=0; i<numVertices; ++i)
+    {
+        unsigned int hi = vthfm[i];
+        (*vertices)[i] = (*shared_vertices)[i] + (*shared_normals)[i] * _quantizedHeightField->getHeight(hi%nc, hi/nc);
+    }
+    return vertices;
+}
+
+namespace
+{
+
+/** Descends the min/max pyramid of a QuantizedHeightField front to back along a line segment, intersecting the two
+  * triangles of each cell of the level 0 blocks that the segment passes through.*/
+class QuantizedHeightFieldIntersector
+{
+public:
+    QuantizedHeightFieldIntersector(const QuantizedHeightField& qhf, const SharedGeometry::CellBoundsPyramid& cellBounds,
+                                    const osg::Vec3Array& vertices, const osg::Vec3Array& normals,
+                                    const osg::Vec3d& s, const osg::Vec3d& e, bool nearestOnly):
+        _qhf(qhf),
+        _cellBounds(cellBounds),
+        _vertices(vertices),
+        _normals(normals),
+        _start(s),
+        _direction(e-s),
+        _nearestOnly(nearestOnly),
+        _nearestRatio(2.0) {}
+
+    struct Hit
+    {
+        double          ratio;
+        osg::Vec3d      point;
+        osg::Vec3       normal;
+        unsigned int    indices[3];
+        double          barycentric[3];
+        unsigned int    primitiveIndex;
+    };
+
+    typedef std::vector<Hit> Hits;
+
+    void intersect()
+    {
+        unsigned int topLevel = _qhf.getNumLevels()-1;
+        double tmin, tmax;
+        if (intersectBlock(topLevel, 0, 0, tmin, tmax)) traverse(topLevel, 0, 0);
+    }
+
+    Hits _hits;
+
+protected:
+
+    bool intersectBlock(unsigned int level, unsigned int bc, unsigned int br, double& tmin, double& tmax) const
+    {
+        const QuantizedHeightField::MinMax& mm = _qhf.getMinMax(level, bc, br);
+        const SharedGeometry::CellBounds& cb = _cellBounds[level][bc+br*_qhf.getLevelSizes()[level].first];
+
+        // bound the vertices displaced along the normals by the range of heights of the block, using interval arithmetic.
+        double h0 = _qhf.dequantize(mm.minimum);
+        double h1 = _qhf.dequantize(mm.maximum);
+
+        tmin = 0.0;
+        tmax = 1.0;
+        for(unsigned int axis=0; axis<3; ++axis)
+        {
+            double n0 = cb.normalMin[axis], n1 = cb.normalMax[axis];
+            double p0 = n0*h0, p1 = n0*h1, p2 = n1*h0, p3 = n1*h1;
+            double lower = cb.vertexMin[axis] + osg::minimum(osg::minimum(p0,p1), osg::minimum(p2,p3));
+            double upper = cb.vertexMax[axis] + osg::maximum(osg::maximum(p0,p1), osg::maximum(p2,p3));
+
+            // pad by the precision of the float vertices and normals.
+            double epsilon = 1e-5*(osg::absolute(lower)+osg::absolute(upper)) + 1e-9;
+            lower -= epsilon;
+            upper += epsilon;
+
+            double d = _direction[axis];
+            if (d==0.0)
+            {
+                if (_start[axis]<lower || _start[axis]>upper) return false;
+            }
+            else
+            {
+                double t0 = (lower-_start[axis])/d;
+                double t1 = (upper-_start[axis])/d;
+                if (t0>t1) std::swap(t0,t1);
+                tmin = osg::maximum(tmin, t0);
+                tmax = osg::minimum(tmax, t1);
+                if (tmin>tmax) return false;
+            }
+        }
+        return true;
+    }
+
+    void traverse(unsigned int level, unsigned int bc, unsigned int br)
+    {
+        if (level==0)
+        {
+            intersectCells(bc, br);
+            return;
+        }
+
+        // visit the child blocks that the segment passes through in order along the segment.
+        const QuantizedHeightField::LevelSizes& levelSizes = _qhf.getLevelSizes();
+        std::pair<double, unsigned int> children[4];
+        unsigned int numChildren = 0;
+        for(unsigned int i=0; i<4; ++i)
+        {
+            unsigned int cbc = bc*2+(i&1);
+            unsigned int cbr = br*2+(i>>1);
+            if (cbc>=levelSizes[level-1].first || cbr>=levelSizes[level-1].second) continue;
+
+            double tmin, tmax;
+            if (intersectBlock(level-1, cbc, cbr, tmin, tmax)) children[numChildren++] = std::make_pair(tmin, cbc+cbr*levelSizes[level-1].first);
+        }
+
+        // insertion sort of the at most 4 children, std::sort on the fixed size array trips -Warray-bounds.
+        for(unsigned int i=1; i<numChildren; ++i)
+        {
+            std::pair<double, unsigned int> child = children[i];
+            unsigned int j = i;
+            for(; j>0 && child<children[j-1]; --j) children[j] = children[j-1];
+            children[j] = child;
+        }
+
+        for(unsigned int i=0; i<numChildren; ++i)
+        {
+            if (_nearestOnly && children[i].first>_nearestRatio) return;
+            traverse(level-1, children[i].second%levelSizes[level-1].first, children[i].second/levelSizes[level-1].first);
+        }
+    }
+
+    void intersectCells(unsigned int bc, unsigned int br)
+    {
+        const unsigned int leafSize = QuantizedHeightField::LEAF_SIZE;
+        unsigned int nc = _qhf.getNumColumns();
+        unsigned int c_end = osg::minimum((bc+1)*leafSize, nc-1);
+        unsigned int r_end = osg::minimum((br+1)*leafSize, _qhf.getNumRows()-1);
+        for(unsigned int r=br*leafSize; r<r_end; ++r)
+        {
+            for(unsigned int c=bc*leafSize; c<c_end; ++c)
+            {
+                // the quad (c,r), (c+1,r), (c+1,r+1), (c,r+1) is drawn as two triangles sharing its (c,r)-(c+1,r+1) diagonal.
+                unsigned int i00 = SharedGeometry::getVertexIndex(nc, c, r);
+                unsigned int i10 = SharedGeometry::getVertexIndex(nc, c+1, r);
+                unsigned int i11 = SharedGeometry::getVertexIndex(nc, c+1, r+1);
+                unsigned int i01 = SharedGeometry::getVertexIndex(nc, c, r+1);
+
+                osg::Vec3d v00 = vertex(i00, c, r);
+                osg::Vec3d v10 = vertex(i10, c+1, r);
+                osg::Vec3d v11 = vertex(i11, c+1, r+1);
+                osg::Vec3d v01 = vertex(i01, c, r+1);
+
+                unsigned int primitiveIndex = (r*(nc-1)+c)*2;
+                intersectTriangle(v00, v10, v11, i00, i10, i11, primitiveIndex);
+                intersectTriangle(v00, v11, v01, i00, i11, i01, primitiveIndex+1);
+            }
+        }
+    }
+
+    inline osg::Vec3d vertex(unsigned int vi, unsigned int c, unsigned int r) const
+    {
+        return osg::Vec3d(_vertices[vi]) + osg::Vec3d(_normals[vi])*static_cast<double>(_qhf.getHeight(c, r));
+    }
+
+    void intersectTriangle(const osg::Vec3d& v0, const osg::Vec3d& v1, const osg::Vec3d& v2,
+                           unsigned int i0, unsigned int i1, unsigned int i2, unsigned int primitiveIndex)
+    {
+        osg::Vec3d E1 = v1-v0;
+        osg::Vec3d E2 = v2-v0;
+        osg::Vec3d P = _direction ^ E2;
+        double det = P*E1;
+        if (det==0.0) return;
+
+        double inv_det = 1.0/det;
+        osg::Vec3d T = _start-v0;
+        double u = (P*T)*inv_det;
+        if (u<0.0 || u>1.0) return;
+
+        osg::Vec3d Q = T ^ E1;
+        double v = (Q*_direction)*inv_det;
+        if (v<0.0 || (u+v)>1.0) return;
+
+        double t = (Q*E2)*inv_det;
+        if (t<0.0 || t>1.0) return;
+
+        if (_nearestOnly)
+        {
+            if (t>=_nearestRatio) return;
+            _hits.clear();
+        }
+        _nearestRatio = osg::minimum(_nearestRatio, t);
+
+        osg::Vec3d normal = E1^E2;
+        normal.normalize();
+
+        Hit hit;
+        hit.ratio = t;
+        hit.point = _start + _direction*t;
+        hit.normal = normal;
+        hit.indices[0] = i0; hit.indices[1] = i1; hit.indices[2] = i2;
+        hit.barycentric[0] = 1.0-u-v; hit.barycentric[1] = u; hit.barycentric[2] = v;
+        hit.primitiveIndex = primitiveIndex;
+        _hits.push_back(hit);
+    }
+
+    const QuantizedHeightField&                 _qhf;
+    const SharedGeometry::CellBoundsPyramid&    _cellBounds;
+    const osg::Vec3Array&                       _vertices;
+    const osg::Vec3Array&                       _normals;
+    osg::Vec3d                                  _start;
+    osg::Vec3d                                  _direction;
+    bool                                        _nearestOnly;
+    double                                      _nearestRatio;
+};
+
+}
+
+bool HeightFieldDrawable::intersect(osgUtil::LineSegmentIntersector& intersector, osgUtil::IntersectionVisitor& iv, osg::Drawable* drawable,
+                                    const osg::Vec3d& s, const osg::Vec3d& e) const
+{
+    // with a displaced copy of the vertices the drawable's primitives are used.
+    if (_vertices.valid() || !_quantizedHeightField || !_geometry || _quantizedHeightField->getNumLevels()==0) return false;
+
+    const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(_geometry->getVertexArray());
+    const osg::Vec3Array* normals = dynamic_cast<const osg::Vec3Array*>(_geometry->getNormalArray());
+    const SharedGeometry::CellBoundsPyramid* cellBounds = _geometry->getCellBoundsPyramid(_quantizedHeightField->getNumColumns(), _quantizedHeightField->getNumRows());
+    if (!vertices || !normals || !cellBounds) return false;
+
+    bool nearestOnly = intersector.getIntersectionLimit()!=osgUtil::Intersector::NO_LIMIT;
+
+    QuantizedHeightFieldIntersector qhfi(*_quantizedHeightField, *cellBounds, *vertices, *normals, s, e, nearestOnly);
+    qhfi.intersect();
+
+    // ratios are relative to the whole segment of the intersector, of which s to e is the part clipped to the drawable's bound.
+    const osg::Vec3d& lsStart = intersector.getStart();
+    osg::Vec3d lsDirection = intersector.getEnd()-lsStart;
+    double lsLength2 = lsDirection.length2();
+
+    for(QuantizedHeightFieldIntersector::Hits::iterator itr = qhfi._hits.begin(); itr != qhfi._hits.end(); ++itr)
+    {
+        osgUtil::LineSegmentIntersector::Intersection hit;
+        hit.ratio = lsLength2>0.0 ? ((itr->point-lsStart)*lsDirection)/lsLength2 : 0.0;
+        hit.matrix = iv.getModelMatrix();
+        hit.nodePath = iv.getNodePath();
+        hit.drawable = drawable;
+        hit.primitiveIndex = itr->primitiveIndex;
+        hit.localIntersectionPoint = itr->point;
+        hit.localIntersectionNormal = itr->normal;
+        for(unsigned int i=0; i<3; ++i)
+        {
+            hit.indexList.push_back(itr->indices[i]);
+            hit.ratioList.push_back(itr->barycentric[i]);
+        }
+        intersector.insertIntersection(hit);
+    }
+
+    return true;
+}
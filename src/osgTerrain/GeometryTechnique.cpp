@@ -25,9 +25,40 @@
 #include <osg/Program>
 #include <osg/Math>
 #include <osg/Timer>
+#include <osg/OperationThread>
+#include <osg/ApplicationUsage>
+
+#include <OpenThreads/ScopedLock>
+
+#include <stdlib.h>
 
 using namespace osgTerrain;
 
+static osg::ApplicationUsageProxy GeometryTechnique_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_TERRAIN_GENERATION_THREADS <value>","Set the number of threads across which the geometry of each osgTerrain::GeometryTechnique tile is generated, default 1.");
+
+static unsigned int computeDefaultNumGenerationThreads()
+{
+    const char* ptr = getenv("OSG_TERRAIN_GENERATION_THREADS");
+    if (ptr)
+    {
+        int numThreads = atoi(ptr);
+        if (numThreads>0) return static_cast<unsigned int>(numThreads);
+    }
+    return 1;
+}
+
+static unsigned int s_numGenerationThreads = computeDefaultNumGenerationThreads();
+
+void GeometryTechnique::setNumGenerationThreads(unsigned int numThreads)
+{
+    s_numGenerationThreads = osg::maximum(numThreads, 1u);
+}
+
+unsigned int GeometryTechnique::getNumGenerationThreads()
+{
+    return s_numGenerationThreads;
+}
+
 GeometryTechnique::GeometryTechnique()
 {
     setFilterBias(0);
@@ -231,6 +262,117 @@ osg::Vec3d GeometryTechnique::computeCenterModel(BufferData& buffer, Locator* ma
     return centerModel;
 }
 
+namespace
+{
+
+/** Operation applied to a contiguous band of rows of a tile.*/
+class RowOperation
+{
+public:
+    virtual ~RowOperation() {}
+    virtual void operator () (int beginRow, int endRow) = 0;
+};
+
+class RowBandOperation : public osg::Operation
+{
+public:
+    RowBandOperation(RowOperation& rowOperation, int beginRow, int endRow, osg::RefBlockCount* blockCount):
+        osg::Operation("RowBandOperation", false),
+        _rowOperation(rowOperation),
+        _beginRow(beginRow),
+        _endRow(endRow),
+        _blockCount(blockCount) {}
+
+    virtual void operator () (osg::Object*)
+    {
+        _rowOperation(_beginRow, _endRow);
+        _blockCount->completed();
+    }
+
+protected:
+    RowOperation&                   _rowOperation;
+    int                             _beginRow;
+    int                             _endRow;
+    osg::ref_ptr<osg::RefBlockCount> _blockCount;
+};
+
+/** Pool of threads, shared by all GeometryTechniques, servicing a single queue of row bands.
+  * The pool only ever waits on its queue, so threads generating tiles concurrently, such as the
+  * DatabasePager threads, can share it without risk of deadlock.*/
+class GenerationThreadPool : public osg::Referenced
+{
+public:
+    GenerationThreadPool():
+        _queue(new osg::OperationQueue) {}
+
+    /** Split the rows [0, numRows) into numBands bands, apply rowOperation to the first band on the calling thread
+      * and the remaining bands on the pool's threads, returning once all the bands have been processed.*/
+    void apply(RowOperation& rowOperation, int numRows, unsigned int numBands)
+    {
+        numBands = osg::minimum(numBands, static_cast<unsigned int>(numRows));
+        if (numBands<=1)
+        {
+            rowOperation(0, numRows);
+            return;
+        }
+
+        ensureNumThreads(numBands-1);
+
+        osg::ref_ptr<osg::RefBlockCount> blockCount = new osg::RefBlockCount(numBands-1);
+        blockCount->reset();
+        for(unsigned int b=1; b<numBands; ++b)
+        {
+            _queue->add(new RowBandOperation(rowOperation, (numRows*b)/numBands, (numRows*(b+1))/numBands, blockCount.get()));
+        }
+
+        rowOperation(0, numRows/numBands);
+
+        blockCount->block();
+    }
+
+protected:
+    virtual ~GenerationThreadPool()
+    {
+        for(Threads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+        {
+            (*itr)->setDone(true);
+        }
+        _queue->releaseOperationsBlock();
+        for(Threads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+        {
+            (*itr)->join();
+        }
+    }
+
+    void ensureNumThreads(unsigned int numThreads)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadsMutex);
+        while(_threads.size()<numThreads)
+        {
+            osg::ref_ptr<osg::OperationThread> thread = new osg::OperationThread;
+            thread->setOperationQueue(_queue.get());
+            thread->startThread();
+            _threads.push_back(thread);
+        }
+    }
+
+    typedef std::vector< osg::ref_ptr<osg::OperationThread> > Threads;
+
+    osg::ref_ptr<osg::OperationQueue>   _queue;
+    OpenThreads::Mutex                  _threadsMutex;
+    Threads                             _threads;
+};
+
+void applyToRows(RowOperation& rowOperation, int numRows, int numColumns)
+{
+    static osg::ref_ptr<GenerationThreadPool> s_generationThreadPool = new GenerationThreadPool;
+
+    unsigned int numBands = (numRows*numColumns>=4096) ? GeometryTechnique::getNumGenerationThreads() : 1;
+    s_generationThreadPool->apply(rowOperation, numRows, numBands);
+}
+
+}
+
 class VertexNormalGenerator
 {
     public:
@@ -445,110 +587,214 @@ VertexNormalGenerator::VertexNormalGenerator(Locator* masterLocator, const osg::
     _boundaryVertices->reserve(_numRows*2 + _numColumns*2 + 4);
 }
 
-void VertexNormalGenerator::populateCenter(osgTerrain::Layer* elevationLayer, LayerToTexCoordMap& layerToTexCoordMap)
+namespace
 {
-    // OSG_NOTICE<<std::endl<<"VertexNormalGenerator::populateCenter("<<elevationLayer<<")"<<std::endl;
 
-    bool sampled = elevationLayer &&
-                   ( (elevationLayer->getNumRows()!=static_cast<unsigned int>(_numRows)) ||
-                     (elevationLayer->getNumColumns()!=static_cast<unsigned int>(_numColumns)) );
+/** Computes the model coordinates, up vectors, elevations and texture coordinates of the center vertices of a tile
+  * into per grid point arrays, one band of rows at a time, so that the bands can be computed concurrently.*/
+class CenterSampler : public RowOperation
+{
+public:
 
-    for(int j=0; j<_numRows; ++j)
+    enum TexCoordType
     {
-        for(int i=0; i<_numColumns; ++i)
+        IMAGE_TEXCOORD,
+        CONTOUR_TEXCOORD,
+        ZERO_TEXCOORD
+    };
+
+    struct LayerTexCoords
+    {
+        LayerTexCoords(): type(ZERO_TEXCOORD), locator(0), transferFunction(0), texcoords(0) {}
+
+        TexCoordType                type;
+        Locator*                    locator;
+        osg::TransferFunction1D*    transferFunction;
+        osg::Vec2Array*             texcoords;
+        std::vector<osg::Vec2>      values;
+    };
+
+    typedef std::vector<LayerTexCoords> LayerTexCoordsList;
+
+    CenterSampler(Locator* masterLocator, osgTerrain::Layer* elevationLayer, int numRows, int numColumns, float scaleHeight, VertexNormalGenerator::LayerToTexCoordMap& layerToTexCoordMap):
+        _masterLocator(masterLocator),
+        _elevationLayer(elevationLayer),
+        _numRows(numRows),
+        _numColumns(numColumns),
+        _scaleHeight(scaleHeight),
+        _local(numRows*numColumns),
+        _model(numRows*numColumns),
+        _up(numRows*numColumns),
+        _valid(numRows*numColumns, 0)
+    {
+        _sampled = elevationLayer &&
+                   ( (elevationLayer->getNumRows()!=static_cast<unsigned int>(numRows)) ||
+                     (elevationLayer->getNumColumns()!=static_cast<unsigned int>(numColumns)) );
+
+        _layerTexCoordsList.resize(layerToTexCoordMap.size());
+        LayerTexCoordsList::iterator ltc_itr = _layerTexCoordsList.begin();
+        for(VertexNormalGenerator::LayerToTexCoordMap::iterator itr = layerToTexCoordMap.begin();
+            itr != layerToTexCoordMap.end();
+            ++itr, ++ltc_itr)
         {
-            osg::Vec3d ndc( ((double)i)/(double)(_numColumns-1), ((double)j)/(double)(_numRows-1), 0.0);
+            LayerTexCoords& ltc = *ltc_itr;
+            ltc.texcoords = itr->second.first.get();
+            ltc.locator = itr->second.second;
+            ltc.values.resize(numRows*numColumns);
 
-            bool validValue = true;
-            if (elevationLayer)
+            if (dynamic_cast<osgTerrain::ImageLayer*>(itr->first))
             {
-                float value = 0.0f;
-                if (sampled) validValue = elevationLayer->getInterpolatedValidValue(ndc.x(), ndc.y(), value);
-                else validValue = elevationLayer->getValidValue(i,j,value);
-                ndc.z() = value*_scaleHeight;
+                ltc.type = IMAGE_TEXCOORD;
             }
+            else
+            {
+                osgTerrain::ContourLayer* contourLayer = dynamic_cast<osgTerrain::ContourLayer*>(itr->first);
+                osg::TransferFunction1D* transferFunction = contourLayer ? contourLayer->getTransferFunction() : 0;
+                if (transferFunction && (transferFunction->getMaximum()-transferFunction->getMinimum())!=0.0f)
+                {
+                    ltc.type = CONTOUR_TEXCOORD;
+                    ltc.transferFunction = transferFunction;
+                }
+            }
+        }
+    }
 
-            if (validValue)
+    virtual void operator () (int beginRow, int endRow)
+    {
+        for(int j=beginRow; j<endRow; ++j)
+        {
+            int rowStart = j*_numColumns;
+            for(int i=0; i<_numColumns; ++i)
             {
-                osg::Vec3d model;
-                _masterLocator->convertLocalToModel(ndc, model);
+                osg::Vec3d ndc( ((double)i)/(double)(_numColumns-1), ((double)j)/(double)(_numRows-1), 0.0);
 
-                for(VertexNormalGenerator::LayerToTexCoordMap::iterator itr = layerToTexCoordMap.begin();
-                    itr != layerToTexCoordMap.end();
-                    ++itr)
+                bool validValue = true;
+                if (_elevationLayer)
                 {
-                    osg::Vec2Array* texcoords = itr->second.first.get();
-                    osgTerrain::ImageLayer* imageLayer(dynamic_cast<osgTerrain::ImageLayer*>(itr->first));
+                    float value = 0.0f;
+                    if (_sampled) validValue = _elevationLayer->getInterpolatedValidValue(ndc.x(), ndc.y(), value);
+                    else validValue = _elevationLayer->getValidValue(i,j,value);
+                    ndc.z() = value*_scaleHeight;
+                }
 
-                    if (imageLayer != NULL)
+                _local[rowStart+i] = ndc;
+                _valid[rowStart+i] = validValue ? 1 : 0;
+            }
+
+            _masterLocator->convertLocalArrayToModel(_numColumns, &_local[rowStart], &_model[rowStart], &_up[rowStart]);
+
+            for(LayerTexCoordsList::iterator itr = _layerTexCoordsList.begin();
+                itr != _layerTexCoordsList.end();
+                ++itr)
+            {
+                LayerTexCoords& ltc = *itr;
+                for(int i=0; i<_numColumns; ++i)
+                {
+                    int gi = rowStart+i;
+                    if (!_valid[gi]) continue;
+
+                    if (ltc.type==ZERO_TEXCOORD)
                     {
-                        Locator* colorLocator = itr->second.second;
-                        if (colorLocator != _masterLocator)
-                        {
-                            osg::Vec3d color_ndc;
-                            Locator::convertLocalCoordBetween(*_masterLocator, ndc, *colorLocator, color_ndc);
-                            (*texcoords).push_back(osg::Vec2(color_ndc.x(), color_ndc.y()));
-                        }
-                        else
-                        {
-                            (*texcoords).push_back(osg::Vec2(ndc.x(), ndc.y()));
-                        }
+                        ltc.values[gi].set(0.0f,0.0f);
+                        continue;
+                    }
+
+                    // the model coordinates are already known so only the conversion into the color layer's local coordinates is required.
+                    osg::Vec3d color_ndc = _local[gi];
+                    if (ltc.locator != _masterLocator) ltc.locator->convertModelToLocal(_model[gi], color_ndc);
+
+                    if (ltc.type==IMAGE_TEXCOORD)
+                    {
+                        ltc.values[gi].set(color_ndc.x(), color_ndc.y());
                     }
                     else
                     {
-                        osgTerrain::ContourLayer* contourLayer(dynamic_cast<osgTerrain::ContourLayer*>(itr->first));
-
-                        bool texCoordSet = false;
-                        if (contourLayer)
-                        {
-                            osg::TransferFunction1D* transferFunction = contourLayer->getTransferFunction();
-                            if (transferFunction)
-                            {
-                                float difference = transferFunction->getMaximum()-transferFunction->getMinimum();
-                                if (difference != 0.0f)
-                                {
-                                    osg::Vec3d           color_ndc;
-                                    osgTerrain::Locator* colorLocator(itr->second.second);
-
-                                    if (colorLocator != _masterLocator)
-                                    {
-                                        Locator::convertLocalCoordBetween(*_masterLocator,ndc,*colorLocator,color_ndc);
-                                    }
-                                    else
-                                    {
-                                        color_ndc = ndc;
-                                    }
-
-                                    color_ndc[2] /= _scaleHeight;
-
-                                    (*texcoords).push_back(osg::Vec2((color_ndc[2]-transferFunction->getMinimum())/difference,0.0f));
-                                    texCoordSet = true;
-                                }
-                            }
-                        }
-                        if (!texCoordSet)
-                        {
-                            (*texcoords).push_back(osg::Vec2(0.0f,0.0f));
-                        }
+                        float difference = ltc.transferFunction->getMaximum()-ltc.transferFunction->getMinimum();
+                        color_ndc[2] /= _scaleHeight;
+                        ltc.values[gi].set((color_ndc[2]-ltc.transferFunction->getMinimum())/difference,0.0f);
                     }
                 }
+            }
+        }
+    }
 
-                if (_elevations.valid())
+    /** Append the valid samples to the vertex, normal, elevation and texture coordinate arrays in row major order.*/
+    void assign(VertexNormalGenerator& vng)
+    {
+        for(int j=0; j<_numRows; ++j)
+        {
+            for(int i=0; i<_numColumns; ++i)
+            {
+                int gi = j*_numColumns+i;
+                if (!_valid[gi]) continue;
+
+                for(LayerTexCoordsList::iterator itr = _layerTexCoordsList.begin();
+                    itr != _layerTexCoordsList.end();
+                    ++itr)
                 {
-                    (*_elevations).push_back(ndc.z());
+                    itr->texcoords->push_back(itr->values[gi]);
                 }
 
-                // compute the local normal
-                osg::Vec3d ndc_one = ndc; ndc_one.z() += 1.0;
-                osg::Vec3d model_one;
-                _masterLocator->convertLocalToModel(ndc_one, model_one);
-                model_one = model_one - model;
-                model_one.normalize();
+                if (vng._elevations.valid())
+                {
+                    vng._elevations->push_back(_local[gi].z());
+                }
 
-                setVertex(i, j, osg::Vec3(model-_centerModel), model_one);
+                vng.setVertex(i, j, osg::Vec3(_model[gi]-vng._centerModel), _up[gi]);
+            }
+        }
+    }
+
+protected:
+
+    Locator*                    _masterLocator;
+    osgTerrain::Layer*          _elevationLayer;
+    bool                        _sampled;
+    int                         _numRows;
+    int                         _numColumns;
+    float                       _scaleHeight;
+
+    std::vector<osg::Vec3d>     _local;
+    std::vector<osg::Vec3d>     _model;
+    std::vector<osg::Vec3>      _up;
+    std::vector<unsigned char>  _valid;
+
+    LayerTexCoordsList          _layerTexCoordsList;
+};
+
+class NormalComputer : public RowOperation
+{
+public:
+    NormalComputer(VertexNormalGenerator& vng): _vng(vng) {}
+
+    virtual void operator () (int beginRow, int endRow)
+    {
+        // each vertex's normal is written only by the band containing its row, the vertices being read only.
+        for(int j=beginRow; j<endRow; ++j)
+        {
+            for(int i=0; i<_vng._numColumns; ++i)
+            {
+                int vi = _vng.vertex_index(i, j);
+                if (vi>=0) _vng.computeNormal(i, j, (*_vng._normals)[vi]);
+                else OSG_NOTICE<<"Not computing normal, vi="<<vi<<std::endl;
             }
         }
     }
+
+protected:
+    VertexNormalGenerator& _vng;
+};
+
+}
+
+void VertexNormalGenerator::populateCenter(osgTerrain::Layer* elevationLayer, LayerToTexCoordMap& layerToTexCoordMap)
+{
+    // OSG_NOTICE<<std::endl<<"VertexNormalGenerator::populateCenter("<<elevationLayer<<")"<<std::endl;
+
+    // sample the rows concurrently, then assign the vertices serially so that their order, and hence the indices, are unchanged.
+    CenterSampler sampler(_masterLocator, elevationLayer, _numRows, _numColumns, _scaleHeight, layerToTexCoordMap);
+    applyToRows(sampler, _numRows, _numColumns);
+    sampler.assign(*this);
 }
 
 void VertexNormalGenerator::populateLeftBoundary(osgTerrain::Layer* elevationLayer)
@@ -736,15 +982,8 @@ void VertexNormalGenerator::populateBelowBoundary(osgTerrain::Layer* elevationLa
 void VertexNormalGenerator::computeNormals()
 {
     // compute normals for the center section
-    for(int j=0; j<_numRows; ++j)
-    {
-        for(int i=0; i<_numColumns; ++i)
-        {
-            int vi = vertex_index(i, j);
-            if (vi>=0) computeNormal(i, j, (*_normals)[vi]);
-            else OSG_NOTICE<<"Not computing normal, vi="<<vi<<std::endl;
-        }
-    }
+    NormalComputer normalComputer(*this);
+    applyToRows(normalComputer, _numRows, _numColumns);
 }
 
 void GeometryTechnique::generateGeometry(BufferData& buffer, Locator* masterLocator, const osg::Vec3d& centerModel)
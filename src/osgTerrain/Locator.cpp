@@ -14,6 +14,8 @@
 #include <osgTerrain/Locator>
 #include <osg/Notify>
 
+#include <typeinfo>
+
 #include <list>
 
 using namespace osgTerrain;
@@ -137,6 +139,93 @@ bool Locator::convertLocalToModel(const osg::Vec3d& local, osg::Vec3d& world) co
     return false;
 }
 
+bool Locator::convertLocalArrayToModel(unsigned int numPoints, const osg::Vec3d* local, osg::Vec3d* world, osg::Vec3* upVectors) const
+{
+    const osg::Matrixd& m = _transform;
+
+    // the local z axis maps purely to height when it doesn't contribute to the longitude or latitude,
+    // in which case the up vector of a GEOCENTRIC point is the ellipsoid normal at its latitude and longitude.
+    bool fastPath = typeid(*this)==typeid(Locator) &&
+                    m(0,3)==0.0 && m(1,3)==0.0 && m(2,3)==0.0 && m(3,3)==1.0 &&
+                    (_coordinateSystemType!=GEOCENTRIC ||
+                     (_ellipsoidModel.valid() && m(2,0)==0.0 && m(2,1)==0.0 && m(2,2)!=0.0));
+
+    if (!fastPath)
+    {
+        for(unsigned int i=0; i<numPoints; ++i)
+        {
+            if (!convertLocalToModel(local[i], world[i])) return false;
+
+            if (upVectors)
+            {
+                osg::Vec3d local_one = local[i]; local_one.z() += 1.0;
+                osg::Vec3d world_one;
+                if (!convertLocalToModel(local_one, world_one)) return false;
+                world_one -= world[i];
+                world_one.normalize();
+                upVectors[i] = world_one;
+            }
+        }
+        return true;
+    }
+
+    switch(_coordinateSystemType)
+    {
+        case(GEOCENTRIC):
+        {
+            double radiusEquator = _ellipsoidModel->getRadiusEquator();
+            double flattening = (radiusEquator-_ellipsoidModel->getRadiusPolar())/radiusEquator;
+            double eccentricitySquared = 2*flattening - flattening*flattening;
+            double upSign = m(2,2)>0.0 ? 1.0 : -1.0;
+
+            for(unsigned int i=0; i<numPoints; ++i)
+            {
+                const osg::Vec3d& l = local[i];
+                double longitude = l.x()*m(0,0) + l.y()*m(1,0) + m(3,0);
+                double latitude  = l.x()*m(0,1) + l.y()*m(1,1) + m(3,1);
+                double height    = l.x()*m(0,2) + l.y()*m(1,2) + l.z()*m(2,2) + m(3,2);
+
+                double sin_latitude = sin(latitude);
+                double cos_latitude = cos(latitude);
+                double sin_longitude = sin(longitude);
+                double cos_longitude = cos(longitude);
+                double N = radiusEquator / sqrt( 1.0 - eccentricitySquared*sin_latitude*sin_latitude);
+
+                world[i].set((N+height)*cos_latitude*cos_longitude,
+                             (N+height)*cos_latitude*sin_longitude,
+                             (N*(1-eccentricitySquared)+height)*sin_latitude);
+
+                if (upVectors)
+                {
+                    upVectors[i].set(upSign*cos_latitude*cos_longitude, upSign*cos_latitude*sin_longitude, upSign*sin_latitude);
+                }
+            }
+            return true;
+        }
+        case(GEOGRAPHIC):
+        case(PROJECTED):
+        {
+            for(unsigned int i=0; i<numPoints; ++i)
+            {
+                const osg::Vec3d& l = local[i];
+                world[i].set(l.x()*m(0,0) + l.y()*m(1,0) + l.z()*m(2,0) + m(3,0),
+                             l.x()*m(0,1) + l.y()*m(1,1) + l.z()*m(2,1) + m(3,1),
+                             l.x()*m(0,2) + l.y()*m(1,2) + l.z()*m(2,2) + m(3,2));
+            }
+
+            if (upVectors)
+            {
+                osg::Vec3d up(m(2,0), m(2,1), m(2,2));
+                up.normalize();
+                for(unsigned int i=0; i<numPoints; ++i) upVectors[i] = up;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool Locator::convertModelToLocal(const osg::Vec3d& world, osg::Vec3d& local) const
 {
     switch(_coordinateSystemType)
@@ -1,6 +1,6 @@
 char terrain_displacement_mapping_vert[] = "#version 120\n"
                                            "\n"
-                                           "#pragma import_defines ( HEIGHTFIELD_LAYER, COMPUTE_DIAGONALS, LIGHTING )\n"
+                                           "#pragma import_defines ( HEIGHTFIELD_LAYER, HEIGHTFIELD_QUANTIZED, COMPUTE_DIAGONALS, LIGHTING )\n"
                                            "\n"
                                            "#ifdef COMPUTE_DIAGONALS\n"
                                            "#extension GL_EXT_geometry_shader4 : enable\n"
@@ -8,6 +8,14 @@ char terrain_displacement_mapping_vert[] = "#version 120\n"
                                            "\n"
                                            "#ifdef HEIGHTFIELD_LAYER\n"
                                            "uniform sampler2D terrainTexture;\n"
+                                           "\n"
+                                           "#ifdef HEIGHTFIELD_QUANTIZED\n"
+                                           "// heights normalized to 0 to 1, mapped back using the offset and range of the tile's heights\n"
+                                           "uniform vec2 terrainHeightRange;\n"
+                                           "float terrainHeight(vec2 texcoord) { return terrainHeightRange.x + texture2D(terrainTexture, texcoord).r*terrainHeightRange.y; }\n"
+                                           "#else\n"
+                                           "float terrainHeight(vec2 texcoord) { return texture2D(terrainTexture, texcoord).r; }\n"
+                                           "#endif\n"
                                            "#endif\n"
                                            "\n"
                                            "#ifdef COMPUTE_DIAGONALS\n"
@@ -30,7 +38,7 @@ char terrain_displacement_mapping_vert[] = "#version 120\n"
                                            "    vec2 texcoord_center = gl_MultiTexCoord0.xy;\n"
                                            "\n"
                                            "#ifdef HEIGHTFIELD_LAYER\n"
-                                           "    float height_center = texture2D(terrainTexture, texcoord_center).r;\n"
+                                           "    float height_center = terrainHeight(texcoord_center);\n"
                                            "#else\n"
                                            "    float height_center = 0.0;\n"
                                            "#endif\n"
@@ -48,14 +56,14 @@ char terrain_displacement_mapping_vert[] = "#version 120\n"
                                            "    float dx = 0.0;\n"
                                            "    if (texcoord_left.x>=0.0)\n"
                                            "    {\n"
-                                           "        float height = texture2D(terrainTexture, texcoord_left).r;\n"
+                                           "        float height = terrainHeight(texcoord_left);\n"
                                            "        dz_dx += (height_center-height)*texelWorldRatio.x;\n"
                                            "        dx += 1.0;\n"
                                            "    }\n"
                                            "\n"
                                            "    if (texcoord_right.x<=1.0)\n"
                                            "    {\n"
-                                           "        float height = texture2D(terrainTexture, texcoord_right).r;\n"
+                                           "        float height = terrainHeight(texcoord_right);\n"
                                            "        dz_dx += (height-height_center)*texelWorldRatio.x;\n"
                                            "        dx += 1.0;\n"
                                            "    }\n"
@@ -75,14 +83,14 @@ char terrain_displacement_mapping_vert[] = "#version 120\n"
                                            "    float dy = 0.0;\n"
                                            "    if (texcoord_down.y>=0.0)\n"
                                            "    {\n"
-                                           "        float height = texture2D(terrainTexture, texcoord_down).r;\n"
+                                           "        float height = terrainHeight(texcoord_down);\n"
                                            "        dz_dy += (height_center-height)*texelWorldRatio.y;\n"
                                            "        dy += 1.0;\n"
                                            "    }\n"
                                            "\n"
                                            "    if (texcoord_up.y<=1.0)\n"
                                            "    {\n"
-                                           "        float height = texture2D(terrainTexture, texcoord_up).r;\n"
+                                           "        float height = terrainHeight(texcoord_up);\n"
                                            "        dz_dy += (height-height_center)*texelWorldRatio.y;\n"
                                            "        dy += 1.0;\n"
                                            "    }\n"
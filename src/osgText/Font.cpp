@@ -17,6 +17,8 @@
 #include <osg/State>
 #include <osg/Notify>
 #include <osg/ApplicationUsage>
+#include <osg/OperationThread>
+#include <osg/observer_ptr>
 
 #include <osgDB/ReadFile>
 #include <osgDB/FileUtils>
@@ -24,6 +26,7 @@
 #include <osg/GLU>
 
 #include <string.h>
+#include <algorithm>
 
 #include <OpenThreads/ReentrantMutex>
 
@@ -36,6 +39,8 @@
 using namespace osgText;
 using namespace std;
 
+static osg::ApplicationUsageProxy Font_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_TEXT_ASYNC_GLYPHS <mode>","ON | OFF - rasterize glyphs of fonts on a background thread, drawing text as the glyphs become available.");
+
 osg::ref_ptr<Font> Font::getDefaultFont()
 {
     static OpenThreads::Mutex s_DefaultFontMutex;
@@ -278,11 +283,17 @@ Font::Font(FontImplementation* implementation):
     _magFilterHint(osg::Texture::LINEAR),
     _maxAnisotropy(16),
     _depth(1),
-    _numCurveSamples(10)
+    _numCurveSamples(10),
+    _asynchronousGlyphRasterization(false)
 {
     setImplementation(implementation);
 
     char *ptr;
+    if ((ptr = getenv("OSG_TEXT_ASYNC_GLYPHS")) != 0)
+    {
+        _asynchronousGlyphRasterization = (strcmp(ptr,"ON")==0 || strcmp(ptr,"on")==0);
+    }
+
     if ((ptr = getenv("OSG_MAX_TEXTURE_SIZE")) != 0)
     {
         unsigned int osg_max_size = atoi(ptr);
@@ -369,6 +380,87 @@ osg::Texture::FilterMode Font::getMagFilterHint() const
 }
 
 
+class Font::RasterizeGlyphOperation : public osg::Operation
+{
+public:
+    RasterizeGlyphOperation(Font* font, const FontResolution& fontRes, unsigned int charcode):
+        osg::Operation("RasterizeGlyph", false),
+        _font(font),
+        _fontRes(fontRes),
+        _charcode(charcode) {}
+
+    virtual void operator () (osg::Object*)
+    {
+        osg::ref_ptr<Font> font;
+        if (_font.lock(font)) font->rasterizeGlyph(_fontRes, _charcode);
+    }
+
+    osg::observer_ptr<Font> _font;
+    FontResolution          _fontRes;
+    unsigned int            _charcode;
+};
+
+static unsigned int s_numGlyphRasterizerThreads = 1;
+
+void Font::setNumGlyphRasterizerThreads(unsigned int numThreads)
+{
+    s_numGlyphRasterizerThreads = osg::maximum(numThreads, 1u);
+}
+
+unsigned int Font::getNumGlyphRasterizerThreads()
+{
+    return s_numGlyphRasterizerThreads;
+}
+
+namespace
+{
+
+/** Pool of threads, shared by all fonts, servicing a single queue of glyphs to rasterize.*/
+class GlyphRasterizer : public osg::Referenced
+{
+public:
+    GlyphRasterizer(unsigned int numThreads):
+        _queue(new osg::OperationQueue)
+    {
+        for(unsigned int i=0; i<numThreads; ++i)
+        {
+            osg::ref_ptr<osg::OperationThread> thread = new osg::OperationThread;
+            thread->setOperationQueue(_queue.get());
+            thread->startThread();
+            _threads.push_back(thread);
+        }
+    }
+
+    void add(osg::Operation* operation) { _queue->add(operation); }
+
+protected:
+    virtual ~GlyphRasterizer()
+    {
+        for(Threads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+        {
+            (*itr)->setDone(true);
+        }
+        _queue->releaseOperationsBlock();
+        for(Threads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+        {
+            (*itr)->join();
+        }
+    }
+
+    typedef std::vector< osg::ref_ptr<osg::OperationThread> > Threads;
+
+    osg::ref_ptr<osg::OperationQueue>   _queue;
+    Threads                             _threads;
+};
+
+GlyphRasterizer* getGlyphRasterizer()
+{
+    static osg::ref_ptr<GlyphRasterizer> s_glyphRasterizer = new GlyphRasterizer(s_numGlyphRasterizerThreads);
+    return s_glyphRasterizer.get();
+}
+
+}
+
 Glyph* Font::getGlyph(const FontResolution& fontRes, unsigned int charcode)
 {
     if (!_implementation) return 0;
@@ -385,6 +477,20 @@ Glyph* Font::getGlyph(const FontResolution& fontRes, unsigned int charcode)
         if (gitr!=glyphmap.end()) return gitr->second.get();
     }
 
+    if (_asynchronousGlyphRasterization)
+    {
+        GlyphMap& placeholders = _sizePlaceholderGlyphMap[fontResUsed];
+        GlyphMap::iterator pitr = placeholders.find(charcode);
+        if (pitr!=placeholders.end()) return pitr->second.get();
+
+        Glyph* placeholder = createPlaceholderGlyph(charcode);
+        placeholders[charcode] = placeholder;
+
+        getGlyphRasterizer()->add(new RasterizeGlyphOperation(this, fontResUsed, charcode));
+
+        return placeholder;
+    }
+
     Glyph* glyph = _implementation->getGlyph(fontResUsed, charcode);
     if (glyph)
     {
@@ -394,6 +500,66 @@ Glyph* Font::getGlyph(const FontResolution& fontRes, unsigned int charcode)
     else return 0;
 }
 
+Glyph* Font::createPlaceholderGlyph(unsigned int charcode)
+{
+    // estimate the advance from the character's width class, East Asian ideographs, kana and syllables being full width,
+    // in the units of the glyphs from the FontImplementation, which are scaled to the height of the font.
+    bool fullWidth = (charcode>=0x1100 && charcode<=0x115F) ||
+                     (charcode>=0x2E80 && charcode<=0xA4CF) ||
+                     (charcode>=0xAC00 && charcode<=0xD7A3) ||
+                     (charcode>=0xF900 && charcode<=0xFAFF) ||
+                     (charcode>=0xFF00 && charcode<=0xFF60) ||
+                     (charcode>=0x20000 && charcode<=0x3FFFD);
+    float advance = fullWidth ? 1.0f : 0.5f;
+
+    Glyph* glyph = new Glyph(this, charcode);
+    glyph->setPlaceholder(true);
+    glyph->setWidth(advance);
+    glyph->setHeight(1.0f);
+    glyph->setHorizontalAdvance(advance);
+    glyph->setVerticalAdvance(1.0f);
+    return glyph;
+}
+
+void Font::rasterizeGlyph(const FontResolution& fontRes, unsigned int charcode)
+{
+    // the FontImplementation serializes access to the underlying font itself, so the glyph map is left unlocked while rasterizing.
+    osg::ref_ptr<Glyph> glyph = _implementation.valid() ? _implementation->getGlyph(fontRes, charcode) : 0;
+
+    if (glyph.valid())
+    {
+        // pack the glyph into the glyph textures of the shader techniques already in use, saving the Text the work when it picks the glyph up.
+        std::vector<ShaderTechnique> shaderTechniques;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_glyphTextureListMutex);
+            for(GlyphTextureList::iterator itr=_glyphTextureList.begin(); itr!=_glyphTextureList.end(); ++itr)
+            {
+                ShaderTechnique shaderTechnique = (*itr)->getShaderTechnique();
+                if (std::find(shaderTechniques.begin(), shaderTechniques.end(), shaderTechnique)==shaderTechniques.end()) shaderTechniques.push_back(shaderTechnique);
+            }
+        }
+
+        for(std::vector<ShaderTechnique>::iterator itr = shaderTechniques.begin(); itr != shaderTechniques.end(); ++itr)
+        {
+            glyph->getOrCreateTextureInfo(*itr);
+        }
+    }
+    else
+    {
+        OSG_INFO<<"Font::rasterizeGlyph() unable to rasterize charcode "<<charcode<<" of "<<getFileName()<<std::endl;
+    }
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_glyphMapMutex);
+
+        // glyphs that fail are recorded as null so that they aren't requested again.
+        _sizeGlyphMap[fontRes][charcode] = glyph;
+        _sizePlaceholderGlyphMap[fontRes].erase(charcode);
+    }
+
+    ++_glyphModifiedCount;
+}
+
 Glyph3D* Font::getGlyph3D(const FontResolution &fontRes, unsigned int charcode)
 {
     if (!_implementation) return 0;
@@ -492,6 +658,9 @@ void Font::addGlyph(const FontResolution& fontRes, unsigned int charcode, Glyph*
 
 void Font::assignGlyphToGlyphTexture(Glyph* glyph, ShaderTechnique shaderTechnique)
 {
+    // glyphs may be assigned by the DatabasePager and glyph rasterizer threads as well as the update traversal.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_glyphTextureListMutex);
+
     int posX=0,posY=0;
 
     GlyphTexture* glyphTexture = 0;
@@ -41,6 +41,9 @@ using namespace std;
 #define OSGTEXT_GLYPH_SDF_INTERNALFORMAT GL_LUMINANCE_ALPHA
 #endif
 
+// number of glyph regions queued for upload to a graphics context before they are collapsed into one upload of the whole image.
+#define OSGTEXT_GLYPH_MAX_REGIONS_TO_SUBLOAD 256u
+
 
 #if 0
     #define TEXTURE_IMAGE_NUM_CHANNELS 1
@@ -56,10 +59,7 @@ using namespace std;
 // GlyphTexture
 //
 GlyphTexture::GlyphTexture():
-    _shaderTechnique(GREYSCALE),
-    _usedY(0),
-    _partUsedX(0),
-    _partUsedY(0)
+    _shaderTechnique(GREYSCALE)
 {
     setWrap(WRAP_S, CLAMP_TO_EDGE);
     setWrap(WRAP_T, CLAMP_TO_EDGE);
@@ -95,59 +95,97 @@ int GlyphTexture::getTexelMargin(const Glyph* glyph)
     return margin;
 }
 
-bool GlyphTexture::getSpaceForGlyph(Glyph* glyph, int& posX, int& posY)
+int GlyphTexture::fitSkyline(unsigned int index, int width, int height) const
 {
-    int width = glyph->s();
-    int height = glyph->t();
+    // return the lowest y that a width x height rectangle placed at the start of the segment can sit at, or -1 if it doesn't fit.
+    int x = _skyline[index].x;
+    if (x+width > getTextureWidth()) return -1;
 
-    int margin = getTexelMargin(glyph);
+    int y = _skyline[index].y;
+    int widthLeft = width;
+    while(widthLeft > 0)
+    {
+        if (index>=_skyline.size()) return -1;
+
+        y = osg::maximum(y, _skyline[index].y);
+        if (y+height > getTextureHeight()) return -1;
 
-    width += 2*margin;
-    height += 2*margin;
+        widthLeft -= _skyline[index].width;
+        ++index;
+    }
 
+    return y;
+}
+
+bool GlyphTexture::getSpaceForGlyph(Glyph* glyph, int& posX, int& posY)
+{
+    int margin = getTexelMargin(glyph);
+
+    // keep the allocations aligned to the interval so that the glyph regions don't bleed into each other when mipmapped.
     int interval = 4;
+    int width = ((glyph->s() + 2*margin + interval - 1)/interval)*interval;
+    int height = ((glyph->t() + 2*margin + interval - 1)/interval)*interval;
 
-    int partUsedX = ((_partUsedX % interval) == 0) ? _partUsedX : (((_partUsedX/interval)+1)*interval);
-    int partUsedY = ((_partUsedY % interval) == 0) ? _partUsedY : (((_partUsedY/interval)+1)*interval);
-    int usedY = ((_usedY % interval) == 0) ? _usedY : (((_usedY/interval)+1)*interval);
+    if (_skyline.empty()) _skyline.push_back(SkylineSegment(0, 0, getTextureWidth()));
 
-    // first check box (partUsedX, usedY) to (width,height)
-    if (width <= (getTextureWidth()-partUsedX) &&
-        height <= (getTextureHeight()-usedY))
+    // bottom left heuristic, pick the position that leaves the top of the glyph lowest, then the narrowest segment.
+    int bestIndex = -1;
+    int bestTop = getTextureHeight()+1;
+    int bestWidth = getTextureWidth()+1;
+    int bestY = 0;
+    for(unsigned int i=0; i<_skyline.size(); ++i)
     {
-        // can fit in existing row.
+        int y = fitSkyline(i, width, height);
+        if (y<0) continue;
 
-        // record the position in which the texture will be stored.
-        posX = partUsedX+margin;
-        posY = usedY+margin;
+        if (y+height<bestTop || (y+height==bestTop && _skyline[i].width<bestWidth))
+        {
+            bestIndex = i;
+            bestTop = y+height;
+            bestWidth = _skyline[i].width;
+            bestY = y;
+        }
+    }
 
-        // move used markers on.
-        _partUsedX = posX+width;
-        if (_usedY+height>_partUsedY) _partUsedY = _usedY+height;
+    // doesn't fit into glyph texture.
+    if (bestIndex<0) return false;
 
-        return true;
-    }
+    int x = _skyline[bestIndex].x;
+
+    // record the position in which the texture will be stored.
+    posX = x+margin;
+    posY = bestY+margin;
 
-    // start an new row.
-    if (width <= getTextureWidth() &&
-        height <= (getTextureHeight()-_partUsedY))
+    // raise the skyline over the allocated rectangle, trimming or removing the segments it covers.
+    _skyline.insert(_skyline.begin()+bestIndex, SkylineSegment(x, bestY+height, width));
+
+    for(unsigned int i=bestIndex+1; i<_skyline.size();)
     {
-        // can fit next row.
-        _partUsedX = 0;
-        _usedY = partUsedY;
+        SkylineSegment& previous = _skyline[i-1];
+        SkylineSegment& segment = _skyline[i];
+
+        int shrink = previous.x + previous.width - segment.x;
+        if (shrink<=0) break;
 
-        posX = _partUsedX+margin;
-        posY = _usedY+margin;
+        segment.x += shrink;
+        segment.width -= shrink;
 
-        // move used markers on.
-        _partUsedX = posX+width;
-        _partUsedY = _usedY+height;
+        if (segment.width<=0) _skyline.erase(_skyline.begin()+i);
+        else break;
+    }
 
-        return true;
+    // merge neighbouring segments at the same height.
+    for(unsigned int i=0; i+1<_skyline.size();)
+    {
+        if (_skyline[i].y==_skyline[i+1].y)
+        {
+            _skyline[i].width += _skyline[i+1].width;
+            _skyline.erase(_skyline.begin()+i+1);
+        }
+        else ++i;
     }
 
-    // doesn't fit into glyph.
-    return false;
+    return true;
 }
 
 void GlyphTexture::addGlyph(Glyph* glyph, int posX, int posY)
@@ -169,6 +207,35 @@ void GlyphTexture::addGlyph(Glyph* glyph, int posX, int posY)
     glyph->setTextureInfo(_shaderTechnique, info.get());
 
     copyGlyphImage(glyph, info.get());
+
+    // record the region written, including the margin used by signed distance fields, as needing to be uploaded to each of the graphics contexts.
+    int margin = static_cast<int>(info->texelMargin);
+    int left = osg::maximum(posX - margin, 0);
+    int bottom = osg::maximum(posY - margin, 0);
+    int right = osg::minimum(posX + glyph->s() + margin, _image->s());
+    int top = osg::minimum(posY + glyph->t() + margin, _image->t());
+
+    if (left<right && bottom<top)
+    {
+        for(unsigned int i=0; i<_regionsToSubload.size(); ++i)
+        {
+            RegionList& regions = _regionsToSubload[i];
+
+            // a context that already has the whole image to upload covers the new glyph too.
+            if (regions.size()==1 && regions.front().width==_image->s() && regions.front().height==_image->t()) continue;
+
+            if (regions.size()<OSGTEXT_GLYPH_MAX_REGIONS_TO_SUBLOAD)
+            {
+                regions.push_back(Region(left, bottom, right-left, top-bottom));
+            }
+            else
+            {
+                // collapse to the whole image so the list doesn't grow without bound for contexts that don't apply the texture.
+                regions.clear();
+                regions.push_back(Region(0, 0, _image->s(), _image->t()));
+            }
+        }
+    }
 }
 
 void GlyphTexture::copyGlyphImage(Glyph* glyph, Glyph::TextureInfo* info)
@@ -394,18 +461,80 @@ void GlyphTexture::resizeGLObjectBuffers(unsigned int maxSize)
 {
     osg::Texture2D::resizeGLObjectBuffers(maxSize);
 
-    unsigned int initialSize = _glyphsToSubload.size();
-    _glyphsToSubload.resize(maxSize);
+    // contexts added here have yet to create their texture object, which will have the whole image uploaded to it.
+    _regionsToSubload.resize(maxSize);
+}
+
+void GlyphTexture::apply(osg::State& state) const
+{
+    const unsigned int contextID = state.getContextID();
 
-    for(unsigned i=initialSize; i<_glyphsToSubload.size(); ++i)
+    // hold the mutex so that glyphs aren't copied into the image while it's being uploaded.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    TextureObject* textureObject = getTextureObject(contextID);
+    if (textureObject && _image.valid() && getModifiedCount(contextID)!=_image->getModifiedCount() &&
+        _image->s()==getTextureWidth() && _image->t()==getTextureHeight())
     {
-        for(GlyphRefList::iterator itr = _glyphs.begin();
-            itr != _glyphs.end();
-            ++itr)
+        osg::GLExtensions* extensions = state.get<osg::GLExtensions>();
+        bool mipmapping = _min_filter!=LINEAR && _min_filter!=NEAREST;
+
+    #if !defined(OSG_GLES1_AVAILABLE) && !defined(OSG_GLES2_AVAILABLE) && !defined(OSG_GLES3_AVAILABLE)
+        bool subload = !mipmapping || (extensions->isFrameBufferObjectSupported && extensions->glGenerateMipmap);
+    #else
+        // GL_UNPACK_ROW_LENGTH isn't available, so fall back to uploading the whole image.
+        bool subload = false;
+    #endif
+
+        if (subload && contextID<_regionsToSubload.size())
         {
-            _glyphsToSubload[i].push_back(itr->get());
+            textureObject->bind(state);
+
+            subloadRegions(state, _regionsToSubload[contextID]);
+
+            if (mipmapping)
+            {
+                extensions->glGenerateMipmap(GL_TEXTURE_2D);
+            }
+
+            // mark the image as up to date for this context so that Texture2D::apply() doesn't upload it all again.
+            getModifiedCount(contextID) = _image->getModifiedCount();
         }
     }
+
+    Texture2D::apply(state);
+
+    // the texture is now up to date with the image, whether the glyphs were subloaded or the whole image was uploaded.
+    if (_image.valid() && getModifiedCount(contextID)==_image->getModifiedCount() && contextID<_regionsToSubload.size())
+    {
+        _regionsToSubload[contextID].clear();
+    }
+}
+
+void GlyphTexture::subloadRegions(osg::State& state, const RegionList& regions) const
+{
+    if (regions.empty()) return;
+
+    state.unbindPixelBufferObject();
+
+    unsigned int pixelSize = osg::Image::computePixelSizeInBits(_image->getPixelFormat(), _image->getDataType())/8;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+#if !defined(OSG_GLES1_AVAILABLE) && !defined(OSG_GLES2_AVAILABLE) && !defined(OSG_GLES3_AVAILABLE)
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, _image->s());
+#endif
+
+    for(RegionList::const_iterator itr = regions.begin(); itr != regions.end(); ++itr)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, itr->x, itr->y, itr->width, itr->height,
+                        _image->getPixelFormat(), _image->getDataType(),
+                        _image->data() + (itr->y*_image->s() + itr->x)*pixelSize);
+    }
+
+#if !defined(OSG_GLES1_AVAILABLE) && !defined(OSG_GLES2_AVAILABLE) && !defined(OSG_GLES3_AVAILABLE)
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+    glPixelStorei(GL_UNPACK_ALIGNMENT, _image->getPacking());
 }
 
 osg::Image* GlyphTexture::createImage()
@@ -441,7 +570,8 @@ Glyph::Glyph(Font* font, unsigned int glyphCode):
     _horizontalBearing(0.0f,0.f),
     _horizontalAdvance(0.f),
     _verticalBearing(0.0f,0.f),
-    _verticalAdvance(0.f)
+    _verticalAdvance(0.f),
+    _placeholder(false)
 {
     setThreadSafeRefUnref(true);
 }
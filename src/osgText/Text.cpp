@@ -45,7 +45,9 @@ Text::Text():
     _colorGradientTopLeft(1.0f, 0.0f, 0.0f, 1.0f),
     _colorGradientBottomLeft(0.0f, 1.0f, 0.0f, 1.0f),
     _colorGradientBottomRight(0.0f, 0.0f, 1.0f, 1.0f),
-    _colorGradientTopRight(1.0f, 1.0f, 1.0f, 1.0f)
+    _colorGradientTopRight(1.0f, 1.0f, 1.0f, 1.0f),
+    _glyphModifiedCount(0),
+    _glyphsPending(false)
 {
     _supportsVertexBufferObjects = true;
 
@@ -73,7 +75,9 @@ Text::Text(const Text& text,const osg::CopyOp& copyop):
     _colorGradientTopLeft(text._colorGradientTopLeft),
     _colorGradientBottomLeft(text._colorGradientBottomLeft),
     _colorGradientBottomRight(text._colorGradientBottomRight),
-    _colorGradientTopRight(text._colorGradientTopRight)
+    _colorGradientTopRight(text._colorGradientTopRight),
+    _glyphModifiedCount(0),
+    _glyphsPending(false)
 {
     computeGlyphRepresentation();
 }
@@ -435,6 +439,12 @@ void Text::computeGlyphRepresentation()
     Font* activefont = getActiveFont();
     if (!activefont) return;
 
+    // record the font's glyph count before requesting any glyphs, so that glyphs the font
+    // rasterizes in the background during the layout cause the text to be laid out again.
+    _glyphModifiedCount = activefont->getGlyphModifiedCount();
+    _glyphsPending = false;
+    bool glyphsPending = false;
+
     if (!_coords) { _coords = new osg::Vec3Array(osg::Array::BIND_PER_VERTEX); _coords->setBufferObject(_vbo.get()); }
     else _coords->clear();
 
@@ -617,6 +627,21 @@ void Text::computeGlyphRepresentation()
                         cursor.x() -= glyph->getHorizontalAdvance() * wr;
                     }
 
+                    if (glyph->getPlaceholder())
+                    {
+                        // the glyph is still being rasterized in the background so leave a space for it,
+                        // laying the text out again once the font has the glyph.
+                        glyphsPending = true;
+                        switch(_layout)
+                        {
+                            case LEFT_TO_RIGHT: cursor.x() += glyph->getHorizontalAdvance() * wr; break;
+                            case VERTICAL:      cursor.y() -= glyph->getVerticalAdvance() * hr; break;
+                            case RIGHT_TO_LEFT: break; // nop.
+                        }
+                        previous_charcode = 0;
+                        continue;
+                    }
+
                     // adjust cursor position w.r.t any kerning.
                     if (kerning && previous_charcode)
                     {
@@ -745,6 +770,54 @@ void Text::computeGlyphRepresentation()
 
     // set up the vertices for any boundinbox or alignment decoration
     setupDecoration();
+
+    if (glyphsPending)
+    {
+        _glyphsPending = true;
+
+        if (!_glyphsPendingCallback) _glyphsPendingCallback = new GlyphsPendingCallback;
+
+        bool attached = false;
+        for(osg::Callback* callback = getUpdateCallback(); callback && !attached; callback = callback->getNestedCallback())
+        {
+            attached = (callback==_glyphsPendingCallback.get());
+        }
+
+        if (!attached)
+        {
+            // the text will be modified during the update traversal so mustn't be drawn concurrently with it
+            // until the glyphs are available.
+            _glyphsPendingCallback->dataVariance = getDataVariance();
+            setDataVariance(osg::Object::DYNAMIC);
+            addUpdateCallback(_glyphsPendingCallback.get());
+        }
+    }
+}
+
+bool Text::GlyphsPendingCallback::run(osg::Object* object, osg::Object* data)
+{
+    Text* text = dynamic_cast<Text*>(object);
+    if (!text) return traverse(object, data);
+
+    if (text->_glyphsPending)
+    {
+        Font* activefont = text->getActiveFont();
+        if (activefont && activefont->getGlyphModifiedCount()!=text->_glyphModifiedCount)
+        {
+            text->computeGlyphRepresentation();
+        }
+    }
+
+    bool result = traverse(object, data);
+
+    // once all the glyphs are available the callback is no longer required, nor is the text modified in the update traversal.
+    if (!text->_glyphsPending)
+    {
+        text->setDataVariance(dataVariance);
+        text->removeUpdateCallback(this);
+    }
+
+    return result;
 }
 
 // Returns false if there are no glyphs and the width/height values are invalid.
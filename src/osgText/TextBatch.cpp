@@ -0,0 +1,575 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgText/TextBatch>
+
+#include <osg/Depth>
+#include <osg/GLExtensions>
+#include <osg/Notify>
+#include <osg/Program>
+#include <osg/Viewport>
+
+#include <osgDB/ReadFile>
+
+using namespace osgText;
+
+namespace
+{
+
+/** Passes the size of the current viewport to the batch's vertex shader, used to size texts in pixels.*/
+class ViewportSizeDrawCallback : public osg::Drawable::DrawCallback
+{
+public:
+    ViewportSizeDrawCallback():
+        _nameID(osg::Uniform::getNameID("osgText_ViewportSize")) {}
+
+    virtual void drawImplementation(osg::RenderInfo& renderInfo, const osg::Drawable* drawable) const
+    {
+        osg::State& state = *renderInfo.getState();
+
+        GLint location = state.getUniformLocation(_nameID);
+        if (location>=0)
+        {
+            float width = 1280.0f;
+            float height = 1024.0f;
+
+            const osg::Viewport* viewport = state.getCurrentViewport();
+            if (viewport && viewport->width()>0.0 && viewport->height()>0.0)
+            {
+                width = static_cast<float>(viewport->width());
+                height = static_cast<float>(viewport->height());
+            }
+
+            state.get<osg::GLExtensions>()->glUniform2f(location, width, height);
+        }
+
+        drawable->drawImplementation(renderInfo);
+    }
+
+    unsigned int _nameID;
+};
+
+osg::Drawable::DrawCallback* getViewportSizeDrawCallback()
+{
+    static osg::ref_ptr<osg::Drawable::DrawCallback> s_drawCallback = new ViewportSizeDrawCallback;
+    return s_drawCallback.get();
+}
+
+}
+
+TextBatch::TextBatch():
+    _usesShaders(false),
+    _batchesModified(false)
+{
+    // request the update traversal so that modified texts are copied into the batch.
+    setNumChildrenRequiringUpdateTraversal(getNumChildrenRequiringUpdateTraversal()+1);
+}
+
+TextBatch::TextBatch(const TextBatch& textBatch, const osg::CopyOp& copyop):
+    osg::Geode(textBatch, copyop),
+    _usesShaders(false),
+    _batchesModified(false)
+{
+    setNumChildrenRequiringUpdateTraversal(getNumChildrenRequiringUpdateTraversal()+1);
+
+    // the batch's geometries are rebuilt from its texts rather than copied.
+    removeDrawables(0, getNumDrawables());
+
+    // the texts are cloned when copyop deep copies drawables, otherwise they are shared with textBatch.
+    for(Labels::const_iterator itr = textBatch._labels.begin(); itr != textBatch._labels.end(); ++itr)
+    {
+        Text* text = dynamic_cast<Text*>(copyop(itr->first));
+        if (!text) continue;
+
+        addText(text);
+        if (!itr->second.visible) setTextVisible(text, false);
+    }
+}
+
+TextBatch::~TextBatch()
+{
+}
+
+TextBatch::PlacementMode TextBatch::getPlacementMode(const Text* text)
+{
+    switch(text->getCharacterSizeMode())
+    {
+        case(TextBase::OBJECT_COORDS):
+            return text->getAutoRotateToScreen() ? ROTATE_TO_SCREEN : MODEL_COORDS;
+        case(TextBase::SCREEN_COORDS):
+            return text->getAutoRotateToScreen() ? ROTATE_TO_SCREEN_IN_PIXELS : UNSUPPORTED;
+        default:
+            return UNSUPPORTED;
+    }
+}
+
+bool TextBatch::isCompatible(Text* text) const
+{
+    PlacementMode mode = getPlacementMode(text);
+    if (mode==UNSUPPORTED) return false;
+
+    if (_sourceStateSet.valid())
+    {
+        if (text->getStateSet()!=_sourceStateSet.get() || text->getActiveFont()!=_font.get()) return false;
+    }
+    else if (!text->getStateSet() || !text->getActiveFont())
+    {
+        return false;
+    }
+
+    // texts that are placed relative to the screen need the batch's vertex shader.
+    bool usesShaders = _sourceStateSet.valid() ? _usesShaders : (text->getStateSet()->getAttribute(osg::StateAttribute::PROGRAM)!=0);
+    if (!usesShaders && mode!=MODEL_COORDS) return false;
+
+    return true;
+}
+
+void TextBatch::createStateSet(Text* text)
+{
+    _sourceStateSet = text->getStateSet();
+    _font = text->getActiveFont();
+
+    osg::ref_ptr<osg::StateSet> stateset = new osg::StateSet(*_sourceStateSet, osg::CopyOp::SHALLOW_COPY);
+
+    // the glyphs are blended in a single pass, without the depth only pass that Text uses when depth writes are enabled.
+    stateset->setAttributeAndModes(new osg::Depth(osg::Depth::LESS, 0.0, 1.0, false));
+
+    const osg::Program* textProgram = dynamic_cast<const osg::Program*>(_sourceStateSet->getAttribute(osg::StateAttribute::PROGRAM));
+    _usesShaders = (textProgram!=0);
+
+    if (textProgram)
+    {
+        // replace the Text's vertex shader with one that places the glyphs relative to each text's position.
+        osg::ref_ptr<osg::Program> program = new osg::Program;
+        for(unsigned int i=0; i<textProgram->getNumShaders(); ++i)
+        {
+            const osg::Shader* shader = textProgram->getShader(i);
+            if (shader->getType()!=osg::Shader::VERTEX) program->addShader(const_cast<osg::Shader*>(shader));
+        }
+
+        #include "shaders/osgText_TextBatch_vert.cpp"
+        program->addShader(osgDB::readRefShaderFileWithFallback(osg::Shader::VERTEX, "shaders/osgText_TextBatch.vert", osgText_TextBatch_vert));
+
+        stateset->setAttributeAndModes(program.get());
+    }
+
+    setStateSet(stateset.get());
+}
+
+bool TextBatch::addText(Text* text)
+{
+    if (!text) return false;
+    if (containsText(text)) return true;
+
+    if (!isCompatible(text))
+    {
+        OSG_INFO<<"TextBatch::addText("<<text<<") text not compatible with batch."<<std::endl;
+        return false;
+    }
+
+    if (!_sourceStateSet) createStateSet(text);
+
+    Label& label = _labels[text];
+    label.text = text;
+
+    _dirtyTexts.insert(text);
+
+    return true;
+}
+
+bool TextBatch::removeText(Text* text)
+{
+    Labels::iterator itr = _labels.find(text);
+    if (itr==_labels.end()) return false;
+
+    releaseLabel(itr->second);
+    _batchesModified = true;
+
+    _dirtyTexts.erase(text);
+    _glyphsPendingTexts.erase(text);
+    _labels.erase(itr);
+
+    return true;
+}
+
+void TextBatch::removeTexts()
+{
+    _labels.clear();
+    _batches.clear();
+    _dirtyTexts.clear();
+    _glyphsPendingTexts.clear();
+
+    removeDrawables(0, getNumDrawables());
+
+    _sourceStateSet = 0;
+    _font = 0;
+    setStateSet(0);
+}
+
+void TextBatch::setTextVisible(Text* text, bool visible)
+{
+    Labels::iterator itr = _labels.find(text);
+    if (itr==_labels.end() || itr->second.visible==visible) return;
+
+    itr->second.visible = visible;
+    _dirtyTexts.insert(text);
+}
+
+bool TextBatch::getTextVisible(const Text* text) const
+{
+    Labels::const_iterator itr = _labels.find(const_cast<Text*>(text));
+    return itr!=_labels.end() && itr->second.visible;
+}
+
+void TextBatch::dirtyText(Text* text)
+{
+    if (containsText(text)) _dirtyTexts.insert(text);
+}
+
+void TextBatch::traverse(osg::NodeVisitor& nv)
+{
+    if (nv.getVisitorType()==osg::NodeVisitor::UPDATE_VISITOR &&
+        (!_dirtyTexts.empty() || !_glyphsPendingTexts.empty() || _batchesModified))
+    {
+        update();
+    }
+
+    osg::Geode::traverse(nv);
+}
+
+TextBatch::Batch& TextBatch::getOrCreateBatch(GlyphTexture* texture)
+{
+    Batches::iterator itr = _batches.find(texture);
+    if (itr!=_batches.end()) return itr->second;
+
+    Batch& batch = _batches[texture];
+    batch.texture = texture;
+
+    batch.vertices = new osg::Vec3Array(osg::Array::BIND_PER_VERTEX);
+    batch.texcoords = new osg::Vec2Array(osg::Array::BIND_PER_VERTEX);
+    batch.labels = new osg::Vec4Array(osg::Array::BIND_PER_VERTEX);
+    batch.colors = new osg::Vec4Array(osg::Array::BIND_PER_VERTEX);
+    batch.primitives = new osg::DrawElementsUInt(GL_TRIANGLES);
+    batch.boundingBoxCallback = new BoundingBoxCallback;
+
+    batch.geometry = new osg::Geometry;
+    batch.geometry->setDataVariance(osg::Object::DYNAMIC);
+    batch.geometry->setUseDisplayList(false);
+    batch.geometry->setUseVertexBufferObjects(true);
+    batch.geometry->setVertexArray(batch.vertices.get());
+    batch.geometry->setTexCoordArray(0, batch.texcoords.get());
+    batch.geometry->setTexCoordArray(1, batch.labels.get());
+    batch.geometry->setColorArray(batch.colors.get());
+    batch.geometry->addPrimitiveSet(batch.primitives.get());
+    batch.geometry->setComputeBoundingBoxCallback(batch.boundingBoxCallback.get());
+    batch.geometry->setDrawCallback(getViewportSizeDrawCallback());
+    batch.geometry->getOrCreateStateSet()->setTextureAttribute(0, texture);
+
+    addDrawable(batch.geometry.get());
+
+    return batch;
+}
+
+TextBatch::QuadRange TextBatch::allocateQuads(Batch& batch, unsigned int count)
+{
+    // reuse the smallest unused range that is large enough, returning what's left of it to the free ranges.
+    Batch::FreeRanges::iterator itr = batch.freeRanges.lower_bound(count);
+    if (itr!=batch.freeRanges.end())
+    {
+        QuadRange range(itr->second, count);
+        unsigned int remainder = itr->first - count;
+
+        batch.freeRanges.erase(itr);
+        if (remainder>0) batch.freeRanges.insert(Batch::FreeRanges::value_type(remainder, range.first+count));
+
+        batch.numFreeQuads -= count;
+        return range;
+    }
+
+    // append new quads to the end of the batch, the indices of each quad never change.
+    QuadRange range(batch.numQuads, count);
+    batch.numQuads += count;
+
+    batch.vertices->resize(batch.numQuads*4);
+    batch.texcoords->resize(batch.numQuads*4);
+    batch.labels->resize(batch.numQuads*4);
+    batch.colors->resize(batch.numQuads*4);
+
+    batch.primitives->reserve(batch.numQuads*6);
+    for(unsigned int q = range.first; q<batch.numQuads; ++q)
+    {
+        unsigned int lt = q*4;
+        batch.primitives->push_back(lt);
+        batch.primitives->push_back(lt+1);
+        batch.primitives->push_back(lt+2);
+        batch.primitives->push_back(lt);
+        batch.primitives->push_back(lt+2);
+        batch.primitives->push_back(lt+3);
+    }
+    batch.primitives->dirty();
+
+    return range;
+}
+
+void TextBatch::clearQuads(Batch& batch, unsigned int first, unsigned int count)
+{
+    // collapse the quads onto the origin and hide them.
+    unsigned int begin = first*4;
+    unsigned int end = (first+count)*4;
+    for(unsigned int i=begin; i<end; ++i)
+    {
+        (*batch.vertices)[i].set(0.0f, 0.0f, 0.0f);
+        (*batch.texcoords)[i].set(0.0f, 0.0f);
+        (*batch.labels)[i].set(0.0f, 0.0f, 0.0f, float(HIDDEN));
+        (*batch.colors)[i].set(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    batch.modified = true;
+}
+
+void TextBatch::releaseQuads(Batch& batch, const QuadRange& range)
+{
+    if (range.count==0) return;
+
+    clearQuads(batch, range.first, range.count);
+
+    batch.freeRanges.insert(Batch::FreeRanges::value_type(range.count, range.first));
+    batch.numFreeQuads += range.count;
+}
+
+void TextBatch::releaseLabel(Label& label)
+{
+    for(Label::Ranges::iterator itr = label.ranges.begin(); itr != label.ranges.end(); ++itr)
+    {
+        Batches::iterator bitr = _batches.find(itr->first);
+        if (bitr!=_batches.end()) releaseQuads(bitr->second, itr->second);
+    }
+    label.ranges.clear();
+}
+
+void TextBatch::writeLabel(Label& label)
+{
+    Text* text = label.text.get();
+    const Text::TextureGlyphQuadMap& textureGlyphQuadMap = text->getTextureGlyphQuadMap();
+
+    // release the quads of glyph textures the text no longer uses, or that are too few for its glyphs.
+    for(Label::Ranges::iterator itr = label.ranges.begin(); itr != label.ranges.end();)
+    {
+        Text::TextureGlyphQuadMap::const_iterator gitr = textureGlyphQuadMap.find(itr->first);
+        unsigned int numGlyphs = (gitr!=textureGlyphQuadMap.end() && gitr->second._primitives.valid()) ? gitr->second._primitives->getNumIndices()/6 : 0;
+
+        if (numGlyphs==0 || numGlyphs>itr->second.count)
+        {
+            releaseQuads(_batches[itr->first], itr->second);
+            label.ranges.erase(itr++);
+        }
+        else ++itr;
+    }
+
+    PlacementMode mode = getPlacementMode(text);
+    if (!label.visible || (text->getDrawMode() & TextBase::TEXT)==0) mode = HIDDEN;
+
+    // glyphs placed by the shader are held relative to the text's position, the others in model coordinates.
+    const osg::Vec3& position = text->getPosition();
+    osg::Matrix matrix = text->getMatrix();
+    if (mode==ROTATE_TO_SCREEN || mode==ROTATE_TO_SCREEN_IN_PIXELS) matrix.postMultTranslate(-position);
+
+    osg::Vec4 labelValue(position, float(mode));
+
+    const osg::Vec3Array* coords = text->_coords.get();
+    const osg::Vec2Array* texcoords = text->_texcoords.get();
+    const osg::Vec4Array* colorCoords = text->_colorCoords.get();
+    bool solidColor = text->getColorGradientMode()==Text::SOLID || !colorCoords || colorCoords->size()!=coords->size();
+    const osg::Vec4& color = text->getColor();
+
+    for(Text::TextureGlyphQuadMap::const_iterator gitr = textureGlyphQuadMap.begin(); gitr != textureGlyphQuadMap.end(); ++gitr)
+    {
+        GlyphTexture* texture = gitr->first.get();
+        const osg::DrawElements* primitives = gitr->second._primitives.get();
+        unsigned int numGlyphs = (texture && primitives) ? primitives->getNumIndices()/6 : 0;
+        if (numGlyphs==0) continue;
+
+        Batch& batch = getOrCreateBatch(texture);
+
+        Label::Ranges::iterator ritr = label.ranges.find(texture);
+        if (ritr==label.ranges.end()) ritr = label.ranges.insert(Label::Ranges::value_type(texture, allocateQuads(batch, numGlyphs))).first;
+
+        QuadRange& range = ritr->second;
+
+        for(unsigned int g=0; g<numGlyphs; ++g)
+        {
+            // Text::addGlyphQuad() adds each glyph as the triangles lt,lb,rb and lt,rb,rt.
+            unsigned int corners[4];
+            corners[0] = primitives->index(g*6);
+            corners[1] = primitives->index(g*6+1);
+            corners[2] = primitives->index(g*6+2);
+            corners[3] = primitives->index(g*6+5);
+
+            unsigned int base = (range.first+g)*4;
+            for(unsigned int c=0; c<4; ++c)
+            {
+                unsigned int i = corners[c];
+                if (mode==HIDDEN)
+                {
+                    (*batch.vertices)[base+c].set(0.0f, 0.0f, 0.0f);
+                }
+                else
+                {
+                    (*batch.vertices)[base+c] = (*coords)[i] * matrix;
+                }
+                (*batch.texcoords)[base+c] = (*texcoords)[i];
+                (*batch.labels)[base+c] = labelValue;
+                (*batch.colors)[base+c] = solidColor ? color : (*colorCoords)[i];
+            }
+        }
+
+        // pad out the quads that the text no longer needs.
+        if (numGlyphs<range.count) clearQuads(batch, range.first+numGlyphs, range.count-numGlyphs);
+
+        batch.modified = true;
+    }
+}
+
+void TextBatch::compactBatch(Batch& batch)
+{
+    // reallocate the quads of all the texts in the batch, in order, so that the unused quads are left at the end and trimmed.
+    std::vector<Label*> labels;
+    for(Labels::iterator itr = _labels.begin(); itr != _labels.end(); ++itr)
+    {
+        Label::Ranges::iterator ritr = itr->second.ranges.find(batch.texture.get());
+        if (ritr!=itr->second.ranges.end())
+        {
+            itr->second.ranges.erase(ritr);
+            labels.push_back(&(itr->second));
+        }
+    }
+
+    batch.numQuads = 0;
+    batch.numFreeQuads = 0;
+    batch.freeRanges.clear();
+    batch.vertices->clear();
+    batch.texcoords->clear();
+    batch.labels->clear();
+    batch.colors->clear();
+    batch.primitives->clear();
+
+    for(std::vector<Label*>::iterator itr = labels.begin(); itr != labels.end(); ++itr)
+    {
+        writeLabel(**itr);
+    }
+
+    batch.vertices->trim();
+    batch.texcoords->trim();
+    batch.labels->trim();
+    batch.colors->trim();
+    batch.primitives->dirty();
+    batch.modified = true;
+}
+
+void TextBatch::computeBatchBound(Batch& batch)
+{
+    osg::BoundingBox& bb = batch.boundingBoxCallback->_boundingBox;
+    bb.init();
+
+    for(unsigned int i=0; i<batch.labels->size(); ++i)
+    {
+        const osg::Vec4& label = (*batch.labels)[i];
+        const osg::Vec3& vertex = (*batch.vertices)[i];
+        osg::Vec3 position(label.x(), label.y(), label.z());
+
+        switch(static_cast<int>(label.w()))
+        {
+            case(MODEL_COORDS):
+                bb.expandBy(vertex);
+                break;
+            case(ROTATE_TO_SCREEN):
+            {
+                // the glyphs may face any direction, so allow for their distance from the text's position in all directions.
+                float radius = vertex.length();
+                bb.expandBy(position - osg::Vec3(radius, radius, radius));
+                bb.expandBy(position + osg::Vec3(radius, radius, radius));
+                break;
+            }
+            case(ROTATE_TO_SCREEN_IN_PIXELS):
+                bb.expandBy(position);
+                break;
+            default:
+                break;
+        }
+    }
+
+    batch.geometry->dirtyBound();
+}
+
+void TextBatch::update()
+{
+    // lay out again the texts that were waiting on glyphs being rasterized in the background, see Font::setAsynchronousGlyphRasterization().
+    for(TextSet::iterator itr = _glyphsPendingTexts.begin(); itr != _glyphsPendingTexts.end();)
+    {
+        Text* text = *itr;
+        Font* font = text->getActiveFont();
+        if (text->_glyphsPending && font && font->getGlyphModifiedCount()!=text->_glyphModifiedCount)
+        {
+            text->computeGlyphRepresentation();
+            _dirtyTexts.insert(text);
+        }
+
+        if (text->_glyphsPending) ++itr;
+        else _glyphsPendingTexts.erase(itr++);
+    }
+
+    for(TextSet::iterator itr = _dirtyTexts.begin(); itr != _dirtyTexts.end(); ++itr)
+    {
+        Labels::iterator litr = _labels.find(*itr);
+        if (litr==_labels.end()) continue;
+
+        writeLabel(litr->second);
+
+        if (litr->first->_glyphsPending) _glyphsPendingTexts.insert(litr->first);
+    }
+    _dirtyTexts.clear();
+
+    for(Batches::iterator itr = _batches.begin(); itr != _batches.end();)
+    {
+        Batch& batch = itr->second;
+
+        if (batch.numFreeQuads==batch.numQuads)
+        {
+            // no text uses the glyph texture any more.
+            removeDrawable(batch.geometry.get());
+            _batches.erase(itr++);
+            continue;
+        }
+
+        if (batch.numFreeQuads>1024 && batch.numFreeQuads*2>batch.numQuads)
+        {
+            compactBatch(batch);
+        }
+
+        if (batch.modified)
+        {
+            batch.vertices->dirty();
+            batch.texcoords->dirty();
+            batch.labels->dirty();
+            batch.colors->dirty();
+
+            computeBatchBound(batch);
+
+            batch.modified = false;
+        }
+
+        ++itr;
+    }
+
+    _batchesModified = false;
+}
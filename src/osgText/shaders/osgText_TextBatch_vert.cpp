@@ -0,0 +1,45 @@
+char osgText_TextBatch_vert[] = "$OSG_GLSL_VERSION\n"
+                                "$OSG_PRECISION_FLOAT\n"
+                                "\n"
+                                "uniform vec2 osgText_ViewportSize;\n"
+                                "\n"
+                                "$OSG_VARYING_OUT vec2 texCoord;\n"
+                                "$OSG_VARYING_OUT vec4 vertexColor;\n"
+                                "\n"
+                                "void main(void)\n"
+                                "{\n"
+                                "    // xyz is the position of the text, w how its glyphs are placed relative to it, see TextBatch::PlacementMode.\n"
+                                "    vec4 label = gl_MultiTexCoord1;\n"
+                                "    vec4 eyeVertex;\n"
+                                "\n"
+                                "    if (label.w<0.5)\n"
+                                "    {\n"
+                                "        // hidden, place the vertex outside of the clip volume.\n"
+                                "        eyeVertex = vec4(0.0, 0.0, 0.0, 1.0);\n"
+                                "        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);\n"
+                                "    }\n"
+                                "    else if (label.w<1.5)\n"
+                                "    {\n"
+                                "        eyeVertex = gl_ModelViewMatrix * gl_Vertex;\n"
+                                "        gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;\n"
+                                "    }\n"
+                                "    else if (label.w<2.5)\n"
+                                "    {\n"
+                                "        eyeVertex = gl_ModelViewMatrix * vec4(label.xyz, 1.0) + vec4(gl_Vertex.xyz, 0.0);\n"
+                                "        gl_Position = gl_ProjectionMatrix * eyeVertex;\n"
+                                "    }\n"
+                                "    else\n"
+                                "    {\n"
+                                "        eyeVertex = gl_ModelViewMatrix * vec4(label.xyz, 1.0);\n"
+                                "        gl_Position = gl_ProjectionMatrix * eyeVertex;\n"
+                                "        gl_Position.xy += gl_Vertex.xy * (2.0 / osgText_ViewportSize) * gl_Position.w;\n"
+                                "    }\n"
+                                "\n"
+                                "    texCoord = gl_MultiTexCoord0.xy;\n"
+                                "    vertexColor = gl_Color;\n"
+                                "\n"
+                                "#if !defined(GL_ES) && __VERSION__<140\n"
+                                "    gl_ClipVertex = eyeVertex;\n"
+                                "#endif\n"
+                                "}\n"
+                                "\n";
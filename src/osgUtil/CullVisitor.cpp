@@ -14,6 +14,7 @@
 #include <osg/Projection>
 #include <osg/Geode>
 #include <osg/LOD>
+#include <osg/PagedLOD>
 #include <osg/Billboard>
 #include <osg/LightSource>
 #include <osg/ClipNode>
@@ -52,7 +53,9 @@ CullVisitor::CullVisitor():
     _computed_zfar(-FLT_MAX),
     _traversalOrderNumber(0),
     _currentReuseRenderLeafIndex(0),
-    _numberOfEncloseOverrideRenderBinDetails(0)
+    _numberOfEncloseOverrideRenderBinDetails(0),
+    _costEntry(0),
+    _costCheckpointTick(0)
 {
     _identifier = new Identifier;
 }
@@ -68,7 +71,11 @@ CullVisitor::CullVisitor(const CullVisitor& rhs):
     _traversalOrderNumber(0),
     _currentReuseRenderLeafIndex(0),
     _numberOfEncloseOverrideRenderBinDetails(0),
-    _identifier(rhs._identifier)
+    _identifier(rhs._identifier),
+    _nodeCostProfiler(rhs._nodeCostProfiler),
+    _costEntry(0),
+    _costCheckpointTick(0),
+    _sceneSnapshot(rhs._sceneSnapshot)
 {
 }
 
@@ -91,6 +98,51 @@ CullVisitor* CullVisitor::create()
 }
 
 
+void CullVisitor::beginCostAttribution()
+{
+    if (!_nodeCostProfiler) return;
+
+    if (getFrameStamp()) _nodeCostProfiler->addFrame(getFrameStamp()->getFrameNumber());
+
+    _costEntry = _nodeCostProfiler->getRoot();
+    _costCheckpointTick = osg::Timer::instance()->tick();
+}
+
+void CullVisitor::endCostAttribution()
+{
+    if (!_costEntry) return;
+
+    chargeCullTime();
+    _costEntry = 0;
+}
+
+void CullVisitor::chargeCullTime()
+{
+    // cull time is charged to the current entry whenever it changes, so each entry accrues the time spent in its
+    // subgraph outside of the subgraphs of the entries beneath it.
+    osg::Timer_t tick = osg::Timer::instance()->tick();
+    _costEntry->addCullTime(osg::Timer::instance()->delta_s(_costCheckpointTick, tick));
+    _costCheckpointTick = tick;
+}
+
+NodeCostProfiler::Entry* CullVisitor::pushCostEntry(osg::Node& node)
+{
+    NodeCostProfiler::Entry* entry = _nodeCostProfiler->getEntry(_costEntry, node);
+    if (entry==_costEntry) return 0;
+
+    chargeCullTime();
+
+    NodeCostProfiler::Entry* previous = _costEntry;
+    _costEntry = entry;
+    return previous;
+}
+
+void CullVisitor::popCostEntry(NodeCostProfiler::Entry* previous)
+{
+    chargeCullTime();
+    _costEntry = previous;
+}
+
 void CullVisitor::reset()
 {
     //
@@ -902,6 +954,18 @@ void CullVisitor::apply(Geode& node)
 
 void CullVisitor::apply(osg::Drawable& drawable)
 {
+    if (_sceneSnapshot.valid() && drawable.getDataVariance()==osg::Object::DYNAMIC)
+    {
+        // cull the copy captured by the snapshot as the drawable may be being updated for the next frame.
+        const SceneSnapshot::Entry* entry = _sceneSnapshot->getEntry(&drawable);
+        if (!entry) _sceneSnapshot->track(&drawable);
+        else if (entry->drawable.valid() && entry->drawable!=&drawable)
+        {
+            apply(*(entry->drawable));
+            return;
+        }
+    }
+
     RefMatrix& matrix = *getModelViewMatrix();
 
     const BoundingBox &bb =drawable.getBoundingBox();
@@ -1166,7 +1230,23 @@ void CullVisitor::apply(Transform& node)
     if (node_state) pushStateSet(node_state);
 
     RefMatrix* matrix = createOrReuseMatrix(*getModelViewMatrix());
-    node.computeLocalToWorldMatrix(*matrix,this);
+
+    const SceneSnapshot::Entry* entry = 0;
+    if (_sceneSnapshot.valid() && node.getDataVariance()==osg::Object::DYNAMIC)
+    {
+        entry = _sceneSnapshot->getEntry(&node);
+        if (!entry) _sceneSnapshot->track(&node);
+    }
+
+    if (entry && entry->hasMatrix)
+    {
+        if (node.getReferenceFrame()==osg::Transform::RELATIVE_RF) matrix->preMult(entry->matrix);
+        else matrix->set(entry->matrix);
+    }
+    else
+    {
+        node.computeLocalToWorldMatrix(*matrix,this);
+    }
     pushModelViewMatrix(matrix, node.getReferenceFrame());
 
     handle_cull_callbacks_and_traverse(node);
@@ -1242,6 +1322,121 @@ void CullVisitor::apply(Switch& node)
 }
 
 
+namespace
+{
+
+/** Compute the range that the children of lod are selected with, as LOD::traverse() does but from the given bound.*/
+float computeRequiredRange(CullVisitor& cv, const osg::LOD& lod, const osg::BoundingSphere& bound, bool paged)
+{
+    if (lod.getRangeMode()==osg::LOD::DISTANCE_FROM_EYE_POINT)
+    {
+        bool userDefinedCenter = lod.getCenterMode()==osg::LOD::USER_DEFINED_CENTER ||
+                                 lod.getCenterMode()==osg::LOD::UNION_OF_BOUNDING_SPHERE_AND_USER_DEFINED;
+        return cv.getDistanceToViewPoint(userDefinedCenter ? lod.getCenter() : bound.center(), true);
+    }
+
+    if (paged ? cv.getLODScale()>0.0f : cv.getLODScale()!=0.0f)
+    {
+        return cv.clampedPixelSize(bound) / cv.getLODScale();
+    }
+
+    // fallback to selecting the highest res child by finding out the max range
+    float required_range = 0.0f;
+    const osg::LOD::RangeList& rangeList = lod.getRangeList();
+    for(unsigned int i=0;i<rangeList.size();++i)
+    {
+        required_range = osg::maximum(required_range,rangeList[i].first);
+    }
+    return required_range;
+}
+
+/** Traverse the active children of lod as LOD::traverse() does, selecting them with the given bound.*/
+void traverseLOD(CullVisitor& cv, osg::LOD& lod, const osg::BoundingSphere& bound)
+{
+    float required_range = computeRequiredRange(cv, lod, bound, false);
+
+    const osg::LOD::RangeList& rangeList = lod.getRangeList();
+    unsigned int numChildren = osg::minimum(lod.getNumChildren(), static_cast<unsigned int>(rangeList.size()));
+    for(unsigned int i=0;i<numChildren;++i)
+    {
+        if (rangeList[i].first<=required_range && required_range<rangeList[i].second)
+        {
+            lod.getChild(i)->accept(cv);
+        }
+    }
+}
+
+/** Traverse the active children of plod and request the loading of the next unloaded child as PagedLOD::traverse() does,
+  * selecting them with the given bound.*/
+void traversePagedLOD(CullVisitor& cv, osg::PagedLOD& plod, const osg::BoundingSphere& bound)
+{
+    const osg::FrameStamp* frameStamp = cv.getFrameStamp();
+    if (frameStamp) plod.setFrameNumberOfLastTraversal(frameStamp->getFrameNumber());
+
+    double timeStamp = frameStamp ? frameStamp->getReferenceTime() : 0.0;
+    unsigned int frameNumber = frameStamp ? frameStamp->getFrameNumber() : 0;
+
+    float required_range = computeRequiredRange(cv, plod, bound, true);
+
+    const osg::LOD::RangeList& rangeList = plod.getRangeList();
+    unsigned int numChildren = plod.getNumChildren();
+
+    int lastChildTraversed = -1;
+    bool needToLoadChild = false;
+    for(unsigned int i=0;i<rangeList.size();++i)
+    {
+        if (rangeList[i].first<=required_range && required_range<rangeList[i].second)
+        {
+            if (i<numChildren)
+            {
+                plod.setTimeStamp(i, timeStamp);
+                plod.setFrameNumber(i, frameNumber);
+
+                plod.getChild(i)->accept(cv);
+                lastChildTraversed = (int)i;
+            }
+            else
+            {
+                needToLoadChild = true;
+            }
+        }
+    }
+
+    if (!needToLoadChild) return;
+
+    // select the last valid child.
+    if (numChildren>0 && ((int)numChildren-1)!=lastChildTraversed)
+    {
+        plod.setTimeStamp(numChildren-1, timeStamp);
+        plod.setFrameNumber(numChildren-1, frameNumber);
+
+        plod.getChild(numChildren-1)->accept(cv);
+    }
+
+    // now request the loading of the next unloaded child.
+    if (!plod.getDisableExternalChildrenPaging() &&
+        cv.getDatabaseRequestHandler() &&
+        numChildren<plod.getNumFileNames())
+    {
+        // compute priority from where abouts in the required range the distance falls.
+        float priority = (rangeList[numChildren].second-required_range)/(rangeList[numChildren].second-rangeList[numChildren].first);
+
+        // invert priority for PIXEL_SIZE_ON_SCREEN mode
+        if (plod.getRangeMode()==osg::LOD::PIXEL_SIZE_ON_SCREEN)
+        {
+            priority = -priority;
+        }
+
+        // modify the priority according to the child's priority offset and scale.
+        priority = plod.getPriorityOffset(numChildren) + priority * plod.getPriorityScale(numChildren);
+
+        cv.getDatabaseRequestHandler()->requestNodeFile(plod.getDatabasePath()+plod.getFileName(numChildren), cv.getNodePath(), priority, frameStamp,
+                                                        plod.getDatabaseRequest(numChildren), plod.getDatabaseOptions());
+    }
+}
+
+}
+
 void CullVisitor::apply(LOD& node)
 {
     if (isCulled(node)) return;
@@ -1253,7 +1448,22 @@ void CullVisitor::apply(LOD& node)
     StateSet* node_state = node.getStateSet();
     if (node_state) pushStateSet(node_state);
 
-    handle_cull_callbacks_and_traverse(node);
+    const SceneSnapshot::Entry* entry = _sceneSnapshot.valid() ? _sceneSnapshot->getEntry(&node) : 0;
+    if (entry && !node.getCullCallback() && getTraversalMode()==TRAVERSE_ACTIVE_CHILDREN)
+    {
+        // select the children with the bound captured by the snapshot, as the update traversal may be changing the bound of the LOD.
+        NodeCostProfiler::Entry* previousCostEntry = _costEntry ? pushCostEntry(node) : 0;
+
+        osg::PagedLOD* plod = dynamic_cast<osg::PagedLOD*>(&node);
+        if (plod) traversePagedLOD(*this, *plod, entry->bound);
+        else traverseLOD(*this, node, entry->bound);
+
+        if (previousCostEntry) popCostEntry(previousCostEntry);
+    }
+    else
+    {
+        handle_cull_callbacks_and_traverse(node);
+    }
 
     // pop the node's state off the render graph stack.
     if (node_state) popStateSet();
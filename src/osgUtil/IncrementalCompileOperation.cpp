@@ -19,6 +19,7 @@
 #include <osg/Depth>
 #include <osg/ColorMask>
 #include <osg/ApplicationUsage>
+#include <osg/Profiler>
 
 #include <OpenThreads/ScopedLock>
 
@@ -48,6 +49,7 @@ namespace osgUtil
 static osg::ApplicationUsageProxy ICO_e1(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_MINIMUM_COMPILE_TIME_PER_FRAME <float>","minimum compile time alloted to compiling OpenGL objects per frame in database pager.");
 static osg::ApplicationUsageProxy UCO_e2(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_MAXIMUM_OBJECTS_TO_COMPILE_PER_FRAME <int>","maximum number of OpenGL objects to compile per frame in database pager.");
 static osg::ApplicationUsageProxy UCO_e3(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FORCE_TEXTURE_DOWNLOAD <ON/OFF>","should the texture compiles be forced to download using a dummy Geometry.");
+static osg::ApplicationUsageProxy UCO_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_USE_COMPILE_COST_ESTIMATES <ON/OFF>","should compiles be scheduled using the estimated compile cost of each OpenGL object.");
 
 /////////////////////////////////////////////////////////////////
 //
@@ -245,6 +247,16 @@ bool IncrementalCompileOperation::CompileDrawableOp::compile(CompileInfo& compil
     return true;
 }
 
+void IncrementalCompileOperation::CompileDrawableOp::refineEstimatedTimeForCompile(CompileInfo& compileInfo, double estimatedTime, double measuredTime)
+{
+    osg::GraphicsCostEstimator* gce = compileInfo.getState()->getGraphicsCostEstimator();
+    osg::Geometry* geometry = _drawable->asGeometry();
+    if (gce && geometry)
+    {
+        gce->refineCompileCost(geometry, osg::CostPair(estimatedTime, 0.0), osg::CostPair(measuredTime, 0.0));
+    }
+}
+
 IncrementalCompileOperation::CompileTextureOp::CompileTextureOp(osg::Texture* texture):
     _texture(texture)
 {
@@ -282,6 +294,12 @@ bool IncrementalCompileOperation::CompileTextureOp::compile(CompileInfo& compile
     return true;
 }
 
+void IncrementalCompileOperation::CompileTextureOp::refineEstimatedTimeForCompile(CompileInfo& compileInfo, double estimatedTime, double measuredTime)
+{
+    osg::GraphicsCostEstimator* gce = compileInfo.getState()->getGraphicsCostEstimator();
+    if (gce) gce->refineCompileCost(_texture.get(), osg::CostPair(estimatedTime, 0.0), osg::CostPair(measuredTime, 0.0));
+}
+
 IncrementalCompileOperation::CompileProgramOp::CompileProgramOp(osg::Program* program):
     _program(program)
 {
@@ -301,9 +319,17 @@ bool IncrementalCompileOperation::CompileProgramOp::compile(CompileInfo& compile
     return true;
 }
 
+void IncrementalCompileOperation::CompileProgramOp::refineEstimatedTimeForCompile(CompileInfo& compileInfo, double estimatedTime, double measuredTime)
+{
+    osg::GraphicsCostEstimator* gce = compileInfo.getState()->getGraphicsCostEstimator();
+    if (gce) gce->refineCompileCost(_program.get(), osg::CostPair(estimatedTime, 0.0), osg::CostPair(measuredTime, 0.0));
+}
+
 IncrementalCompileOperation::CompileInfo::CompileInfo(osg::GraphicsContext* context, IncrementalCompileOperation* ico):
     compileAll(false),
+    useCostEstimates(false),
     maxNumObjectsToCompile(0),
+    numObjectsCompiled(0),
     allocatedTime(0)
 {
     setState(context->getState());
@@ -342,35 +368,46 @@ double IncrementalCompileOperation::CompileList::estimatedTimeForCompile(Compile
 
 bool IncrementalCompileOperation::CompileList::compile(CompileInfo& compileInfo)
 {
-//#define USE_TIME_ESTIMATES
-
     for(CompileOps::iterator itr = _compileOps.begin();
         itr != _compileOps.end() && compileInfo.okToCompile();
     )
     {
-        #ifdef USE_TIME_ESTIMATES
-        double estimatedCompileCost = (*itr)->estimatedTimeForCompile(compileInfo);
-        #endif
+        double estimatedCompileCost = 0.0;
+        if (compileInfo.useCostEstimates)
+        {
+            estimatedCompileCost = (*itr)->estimatedTimeForCompile(compileInfo);
+
+            // defer objects that won't fit in the time remaining so that smaller objects after them can use it,
+            // but always compile at least one object per frame so that large objects still get compiled.
+            if (compileInfo.numObjectsCompiled>0 && !compileInfo.okToCompile(estimatedCompileCost))
+            {
+                ++itr;
+                continue;
+            }
+        }
 
         --compileInfo.maxNumObjectsToCompile;
+        ++compileInfo.numObjectsCompiled;
 
-        #ifdef USE_TIME_ESTIMATES
         osg::ElapsedTime timer;
-        #endif
 
         CompileOps::iterator saved_itr(itr);
         ++itr;
-        if ((*saved_itr)->compile(compileInfo))
+
+        bool compiled = (*saved_itr)->compile(compileInfo);
+
+        if (compileInfo.useCostEstimates)
         {
-            _compileOps.erase(saved_itr);
+            double actualCompileCost = timer.elapsedTime();
+            OSG_DEBUG<<"IncrementalCompileOperation::CompileList::compile() estimatedTimForCompile = "<<estimatedCompileCost*1000.0<<"ms, actual = "<<actualCompileCost*1000.0<<"ms"<<std::endl;
+
+            (*saved_itr)->refineEstimatedTimeForCompile(compileInfo, estimatedCompileCost, actualCompileCost);
         }
 
-        #ifdef USE_TIME_ESTIMATES
-        double actualCompileCost = timer.elapsedTime();
-        OSG_NOTICE<<"IncrementalCompileOperation::CompileList::compile() estimatedTimForCompile = "<<estimatedCompileCost*1000.0<<"ms, actual = "<<actualCompileCost*1000.0<<"ms";
-        if (estimatedCompileCost>0.0) OSG_NOTICE<<", ratio="<<(actualCompileCost/estimatedCompileCost);
-        OSG_NOTICE<<std::endl;
-        #endif
+        if (compiled)
+        {
+            _compileOps.erase(saved_itr);
+        }
     }
     return empty();
 }
@@ -450,6 +487,7 @@ IncrementalCompileOperation::IncrementalCompileOperation():
     osg::GraphicsOperation("IncrementalCompileOperation",true),
     _flushTimeRatio(0.5),
     _conservativeTimeRatio(0.5),
+    _useCompileCostEstimates(false),
     _currentFrameNumber(0),
     _compileAllTillFrameNumber(0)
 {
@@ -470,6 +508,12 @@ IncrementalCompileOperation::IncrementalCompileOperation():
         _maximumNumOfObjectsToCompilePerFrame = atoi(ptr);
     }
 
+    if( (ptr = getenv("OSG_USE_COMPILE_COST_ESTIMATES")) != 0)
+    {
+        _useCompileCostEstimates = strcmp(ptr,"yes")==0 || strcmp(ptr,"YES")==0 ||
+                                   strcmp(ptr,"on")==0 || strcmp(ptr,"ON")==0;
+    }
+
     bool useForceTextureDownload = false;
     if( (ptr = getenv("OSG_FORCE_TEXTURE_DOWNLOAD")) != 0)
     {
@@ -662,6 +706,8 @@ void IncrementalCompileOperation::mergeCompiledSubgraphs(const osg::FrameStamp*
 
 void IncrementalCompileOperation::operator () (osg::GraphicsContext* context)
 {
+    osg::ProfileZone zone("IncrementalCompileOperation");
+
     osg::NotifySeverity level = osg::INFO;
 
     //glFinish();
@@ -699,6 +745,7 @@ void IncrementalCompileOperation::operator () (osg::GraphicsContext* context)
     compileInfo.maxNumObjectsToCompile = _maximumNumOfObjectsToCompilePerFrame;
     compileInfo.allocatedTime = compileTime;
     compileInfo.compileAll = (_compileAllTillFrameNumber > _currentFrameNumber);
+    compileInfo.useCostEstimates = _useCompileCostEstimates && !compileInfo.compileAll && context->getState()->getGraphicsCostEstimator()!=0;
 
     CompileSets toCompileCopy;
     {
@@ -19,6 +19,8 @@
 #include <osg/io_utils>
 #include <osg/TriangleFunctor>
 #include <osg/KdTree>
+#include <osg/HeightFieldQuadTree>
+#include <osg/ShapeDrawable>
 #include <osg/Timer>
 #include <osg/TexMat>
 #include <osg/TemplatePrimitiveFunctor>
@@ -402,6 +404,41 @@ struct IntersectFunctor
     }
 };
 
+/** Passes the triangles of the height field cells selected by a HeightFieldQuadTree to an IntersectFunctor.*/
+template<class IntersectFunctor>
+struct HeightFieldCellIntersector
+{
+    HeightFieldCellIntersector(IntersectFunctor& intersector, const osg::HeightFieldGeometryLayout& layout, const osg::Vec3Array* vertices, bool stopAtFirstHit):
+        _intersector(intersector),
+        _layout(layout),
+        _vertices(vertices),
+        _stopAtFirstHit(stopAtFirstHit) {}
+
+    bool operator()(unsigned int c, unsigned int r)
+    {
+        unsigned int vertexIndices[osg::HeightFieldGeometryLayout::MAX_CELL_TRIANGLES*3];
+        unsigned int primitiveIndices[osg::HeightFieldGeometryLayout::MAX_CELL_TRIANGLES];
+
+        unsigned int numTriangles = _layout.getCellTriangles(c, r, vertexIndices, primitiveIndices);
+        for(unsigned int i=0; i<numTriangles; ++i)
+        {
+            _intersector.intersect(_vertices, primitiveIndices[i], vertexIndices[i*3], vertexIndices[i*3+1], vertexIndices[i*3+2]);
+        }
+
+        // the cells are passed in order along the segment, so the first cell hit holds the nearest intersection.
+        return _stopAtFirstHit && _intersector._hit;
+    }
+
+    IntersectFunctor&                       _intersector;
+    const osg::HeightFieldGeometryLayout&   _layout;
+    const osg::Vec3Array*                   _vertices;
+    bool                                    _stopAtFirstHit;
+
+protected:
+
+    HeightFieldCellIntersector& operator = (const HeightFieldCellIntersector&) { return *this; }
+};
+
 } // namespace LineSegmentIntersectorUtils
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -518,6 +555,13 @@ void LineSegmentIntersector::intersect(osgUtil::IntersectionVisitor& iv, osg::Dr
 {
     if (reachedLimit()) return;
 
+    // Geometry, by far the most common drawable, is ruled out with a virtual call so that only other drawables pay for the dynamic_cast.
+    if (!drawable->asGeometry())
+    {
+        const LineSegmentIntersectable* intersectable = dynamic_cast<const LineSegmentIntersectable*>(drawable);
+        if (intersectable && intersectable->intersect(*this, iv, drawable, s, e)) return;
+    }
+
     LineSegmentIntersectorUtils::Settings settings;
     settings._lineSegIntersector = this;
     settings._iv = &iv;
@@ -532,20 +576,53 @@ void LineSegmentIntersector::intersect(osgUtil::IntersectionVisitor& iv, osg::Dr
 
     osg::KdTree* kdTree = iv.getUseKdTreeWhenAvailable() ? dynamic_cast<osg::KdTree*>(drawable->getShape()) : 0;
 
+    // height fields drawn by a ShapeDrawable are intersected cell by cell, using the HeightField's min/max quadtree
+    // to select the cells along the segment.
+    osg::ref_ptr<osg::HeightFieldQuadTree> quadTree;
+    osg::HeightFieldGeometryLayout heightFieldLayout;
+    osg::Vec3d gridStart, gridEnd;
+    if (!kdTree && iv.getUseKdTreeWhenAvailable() && settings._vertices.valid())
+    {
+        osg::HeightField* field = dynamic_cast<osg::HeightField*>(drawable->getShape());
+        osg::Matrixd inverse;
+        if (field && dynamic_cast<osg::ShapeDrawable*>(drawable) &&
+            heightFieldLayout.set(*field, *geometry) &&
+            inverse.invert(osg::HeightFieldQuadTree::computeGridMatrix(*field)))
+        {
+            quadTree = field->getOrCreateQuadTree();
+            gridStart = s * inverse;
+            gridEnd = e * inverse;
+        }
+    }
+
+    bool stopAtFirstHit = (_intersectionLimit != NO_LIMIT);
+
     if (getPrecisionHint()==USE_DOUBLE_CALCULATIONS)
     {
-        osg::TemplatePrimitiveFunctor<LineSegmentIntersectorUtils::IntersectFunctor<osg::Vec3d, double> > intersector;
+        typedef osg::TemplatePrimitiveFunctor<LineSegmentIntersectorUtils::IntersectFunctor<osg::Vec3d, double> > PrimitiveIntersector;
+        PrimitiveIntersector intersector;
         intersector.set(s,e, &settings);
 
         if (kdTree) kdTree->intersect(intersector, kdTree->getNode(0));
+        else if (quadTree.valid())
+        {
+            LineSegmentIntersectorUtils::HeightFieldCellIntersector<PrimitiveIntersector> cellIntersector(intersector, heightFieldLayout, settings._vertices.get(), stopAtFirstHit);
+            quadTree->intersect(cellIntersector, gridStart, gridEnd);
+        }
         else drawable->accept(intersector);
     }
     else
     {
-        osg::TemplatePrimitiveFunctor<LineSegmentIntersectorUtils::IntersectFunctor<osg::Vec3f, float> > intersector;
+        typedef osg::TemplatePrimitiveFunctor<LineSegmentIntersectorUtils::IntersectFunctor<osg::Vec3f, float> > PrimitiveIntersector;
+        PrimitiveIntersector intersector;
         intersector.set(s,e, &settings);
 
         if (kdTree) kdTree->intersect(intersector, kdTree->getNode(0));
+        else if (quadTree.valid())
+        {
+            LineSegmentIntersectorUtils::HeightFieldCellIntersector<PrimitiveIntersector> cellIntersector(intersector, heightFieldLayout, settings._vertices.get(), stopAtFirstHit);
+            quadTree->intersect(cellIntersector, gridStart, gridEnd);
+        }
         else drawable->accept(intersector);
     }
 }
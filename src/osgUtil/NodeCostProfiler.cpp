@@ -0,0 +1,264 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgUtil/NodeCostProfiler>
+
+#include <osg/UserDataContainer>
+
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+using namespace osgUtil;
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// NodeCostProfiler::Entry
+//
+NodeCostProfiler::Entry::Entry(const std::string& name, Entry* parent):
+    _name(name),
+    _parent(parent)
+{
+}
+
+NodeCostProfiler::Entry::~Entry()
+{
+}
+
+std::string NodeCostProfiler::Entry::getPath(const std::string& separator) const
+{
+    if (!_parent) return _name;
+    return _parent->getPath(separator) + separator + _name;
+}
+
+void NodeCostProfiler::Entry::addCullTime(double time)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_costMutex);
+    _cost.cullTime += time;
+}
+
+void NodeCostProfiler::Entry::addDraw(double time, unsigned int numStateChanges, unsigned int numDrawCalls, unsigned int numPrimitives)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_costMutex);
+    _cost.drawTime += time;
+    _cost.numStateChanges += numStateChanges;
+    _cost.numDrawCalls += numDrawCalls;
+    _cost.numPrimitives += numPrimitives;
+}
+
+NodeCostProfiler::Cost NodeCostProfiler::Entry::getCost() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_costMutex);
+    return _cost;
+}
+
+NodeCostProfiler::Cost NodeCostProfiler::Entry::computeTotalCost() const
+{
+    Cost cost = getCost();
+    for(Children::const_iterator itr = _children.begin();
+        itr != _children.end();
+        ++itr)
+    {
+        cost += itr->second->computeTotalCost();
+    }
+    return cost;
+}
+
+void NodeCostProfiler::Entry::reset()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_costMutex);
+        _cost = Cost();
+    }
+
+    for(Children::iterator itr = _children.begin();
+        itr != _children.end();
+        ++itr)
+    {
+        itr->second->reset();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// NodeCostProfiler
+//
+NodeCostProfiler::NodeCostProfiler():
+    _tagName("CostTag"),
+    _attributeToNamedNodes(true),
+    _root(new Entry("root", 0)),
+    _numFrames(0),
+    _lastFrameNumber(0)
+{
+}
+
+NodeCostProfiler::~NodeCostProfiler()
+{
+}
+
+double NodeCostProfiler::getValue(const Cost& cost, Metric metric)
+{
+    switch(metric)
+    {
+        case(CULL_TIME): return cost.cullTime;
+        case(DRAW_TIME): return cost.drawTime;
+        case(CULL_AND_DRAW_TIME): return cost.cullTime + cost.drawTime;
+        case(STATE_CHANGES): return cost.numStateChanges;
+        case(DRAW_CALLS): return cost.numDrawCalls;
+        case(PRIMITIVES): return cost.numPrimitives;
+    }
+    return 0.0;
+}
+
+NodeCostProfiler::Entry* NodeCostProfiler::getEntry(Entry* parent, const osg::Node& node)
+{
+    std::string tag;
+    const osg::UserDataContainer* udc = node.getUserDataContainer();
+    if (!udc || !udc->getUserValue(_tagName, tag))
+    {
+        if (!_attributeToNamedNodes || node.getName().empty()) return parent;
+        tag = node.getName();
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    osg::ref_ptr<Entry>& entry = parent->_children[tag];
+    if (!entry) entry = new Entry(tag, parent);
+    return entry.get();
+}
+
+void NodeCostProfiler::addFrame(unsigned int frameNumber)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    if (_numFrames==0 || frameNumber!=_lastFrameNumber)
+    {
+        ++_numFrames;
+        _lastFrameNumber = frameNumber;
+    }
+}
+
+void NodeCostProfiler::reset()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _root->reset();
+    _numFrames = 0;
+}
+
+namespace
+{
+    struct EntryCost
+    {
+        EntryCost(const NodeCostProfiler::Entry* e, double v): entry(e), value(v) {}
+
+        bool operator < (const EntryCost& rhs) const { return value>rhs.value; }
+
+        const NodeCostProfiler::Entry* entry;
+        double value;
+    };
+
+    void collectEntries(const NodeCostProfiler::Entry* entry, std::vector<const NodeCostProfiler::Entry*>& entries)
+    {
+        entries.push_back(entry);
+        for(NodeCostProfiler::Entry::Children::const_iterator itr = entry->getChildren().begin();
+            itr != entry->getChildren().end();
+            ++itr)
+        {
+            collectEntries(itr->second.get(), entries);
+        }
+    }
+}
+
+void NodeCostProfiler::writeReport(std::ostream& out, Metric metric, unsigned int maxNumEntries) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    std::vector<const Entry*> entries;
+    collectEntries(_root.get(), entries);
+
+    std::vector<EntryCost> sorted;
+    for(std::vector<const Entry*>::iterator itr = entries.begin();
+        itr != entries.end();
+        ++itr)
+    {
+        sorted.push_back(EntryCost(*itr, getValue((*itr)->getCost(), metric)));
+    }
+    std::stable_sort(sorted.begin(), sorted.end());
+
+    if (maxNumEntries>0 && sorted.size()>maxNumEntries) sorted.erase(sorted.begin()+maxNumEntries, sorted.end());
+
+    double frameScale = _numFrames>0 ? 1.0/double(_numFrames) : 0.0;
+
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out.setf(std::ios::fixed, std::ios::floatfield);
+
+    out<<"Node costs per frame over "<<_numFrames<<" frames, excluding tagged or named subgraphs beneath each node"<<std::endl;
+    out<<std::setw(10)<<"cull ms"<<std::setw(10)<<"draw ms"<<std::setw(10)<<"states"<<std::setw(10)<<"draws"<<std::setw(12)<<"primitives"<<"  node"<<std::endl;
+    for(std::vector<EntryCost>::iterator itr = sorted.begin();
+        itr != sorted.end();
+        ++itr)
+    {
+        Cost cost = itr->entry->getCost();
+        out<<std::setprecision(3)<<std::setw(10)<<cost.cullTime*1000.0*frameScale
+           <<std::setw(10)<<cost.drawTime*1000.0*frameScale
+           <<std::setprecision(1)<<std::setw(10)<<cost.numStateChanges*frameScale
+           <<std::setw(10)<<cost.numDrawCalls*frameScale
+           <<std::setw(12)<<cost.numPrimitives*frameScale
+           <<"  "<<itr->entry->getPath("/")<<std::endl;
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+static void writeFoldedStacks(std::ostream& out, const NodeCostProfiler::Entry* entry, const std::string& stack, NodeCostProfiler::Metric metric, double scale)
+{
+    std::string name = entry->getName();
+    std::replace(name.begin(), name.end(), ';', '_');
+    std::replace(name.begin(), name.end(), '\n', ' ');
+
+    std::string path = stack.empty() ? name : stack + ";" + name;
+
+    double value = NodeCostProfiler::getValue(entry->getCost(), metric)*scale;
+    if (value>=0.5) out<<path<<" "<<static_cast<unsigned long long>(value+0.5)<<std::endl;
+
+    for(NodeCostProfiler::Entry::Children::const_iterator itr = entry->getChildren().begin();
+        itr != entry->getChildren().end();
+        ++itr)
+    {
+        writeFoldedStacks(out, itr->second.get(), path, metric, scale);
+    }
+}
+
+void NodeCostProfiler::writeFlameGraph(std::ostream& out, Metric metric) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    double scale = (metric==CULL_TIME || metric==DRAW_TIME || metric==CULL_AND_DRAW_TIME) ? 1e6 : 1.0;
+
+    writeFoldedStacks(out, _root.get(), std::string(), metric, scale);
+}
+
+bool NodeCostProfiler::write(const std::string& filename, Metric metric) const
+{
+    std::ofstream fout(filename.c_str());
+    if (!fout) return false;
+
+    std::string::size_type dot = filename.find_last_of('.');
+    if (dot!=std::string::npos && filename.substr(dot+1)=="folded") writeFlameGraph(fout, metric);
+    else writeReport(fout, metric);
+
+    return !fout.fail();
+}
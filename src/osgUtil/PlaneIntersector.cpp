@@ -18,6 +18,8 @@
 #include <osg/Notify>
 #include <osg/io_utils>
 #include <osg/TriangleFunctor>
+#include <osg/HeightFieldQuadTree>
+#include <osg/ShapeDrawable>
 
 using namespace osgUtil;
 
@@ -561,6 +563,42 @@ namespace PlaneIntersectorUtils
 
     };
 
+    /** Passes the triangles of the height field cells whose bounds straddle the plane, selected using a HeightFieldQuadTree, to a TriangleIntersector.*/
+    struct HeightFieldCellIntersector
+    {
+        HeightFieldCellIntersector(osg::TriangleFunctor<TriangleIntersector>& intersector, const osg::HeightFieldGeometryLayout& layout, const osg::Vec3Array* vertices, const osg::Plane& gridPlane):
+            _intersector(intersector),
+            _layout(layout),
+            _vertices(vertices),
+            _gridPlane(gridPlane) {}
+
+        bool enter(const osg::BoundingBox& bb) const
+        {
+            return _gridPlane.intersect(bb)==0;
+        }
+
+        void operator()(unsigned int c, unsigned int r)
+        {
+            unsigned int vertexIndices[osg::HeightFieldGeometryLayout::MAX_CELL_TRIANGLES*3];
+            unsigned int primitiveIndices[osg::HeightFieldGeometryLayout::MAX_CELL_TRIANGLES];
+
+            unsigned int numTriangles = _layout.getCellTriangles(c, r, vertexIndices, primitiveIndices);
+            for(unsigned int i=0; i<numTriangles; ++i)
+            {
+                _intersector((*_vertices)[vertexIndices[i*3]], (*_vertices)[vertexIndices[i*3+1]], (*_vertices)[vertexIndices[i*3+2]]);
+            }
+        }
+
+        osg::TriangleFunctor<TriangleIntersector>&  _intersector;
+        const osg::HeightFieldGeometryLayout&       _layout;
+        const osg::Vec3Array*                       _vertices;
+        osg::Plane                                  _gridPlane;
+
+    protected:
+
+        HeightFieldCellIntersector& operator = (const HeightFieldCellIntersector&) { return *this; }
+    };
+
 }
 
 
@@ -664,7 +702,31 @@ void PlaneIntersector::intersect(osgUtil::IntersectionVisitor& iv, osg::Drawable
     osg::TriangleFunctor<PlaneIntersectorUtils::TriangleIntersector> ti;
     ti.set(_plane, _polytope, iv.getModelMatrix(), _recordHeightsAsAttributes, _em.get());
     ti._limitOneIntersection = (_intersectionLimit == LIMIT_ONE_PER_DRAWABLE || _intersectionLimit == LIMIT_ONE);
-    drawable->accept(ti);
+
+    // height fields drawn by a ShapeDrawable only pass on the triangles of the cells that the plane passes through,
+    // found using the HeightField's min/max quadtree in the field's grid coordinates.
+    osg::ref_ptr<osg::HeightFieldQuadTree> quadTree;
+    osg::HeightFieldGeometryLayout heightFieldLayout;
+    osg::Plane gridPlane;
+    osg::Geometry* geometry = drawable->asGeometry();
+    osg::HeightField* field = iv.getUseKdTreeWhenAvailable() ? dynamic_cast<osg::HeightField*>(drawable->getShape()) : 0;
+    const osg::Vec3Array* vertices = geometry ? dynamic_cast<const osg::Vec3Array*>(geometry->getVertexArray()) : 0;
+    if (field && vertices && dynamic_cast<osg::ShapeDrawable*>(drawable) && heightFieldLayout.set(*field, *geometry))
+    {
+        quadTree = field->getOrCreateQuadTree();
+        gridPlane = _plane;
+        gridPlane.transformProvidingInverse(osg::HeightFieldQuadTree::computeGridMatrix(*field));
+    }
+
+    if (quadTree.valid())
+    {
+        PlaneIntersectorUtils::HeightFieldCellIntersector cellIntersector(ti, heightFieldLayout, vertices, gridPlane);
+        quadTree->traverse(cellIntersector);
+    }
+    else
+    {
+        drawable->accept(ti);
+    }
 
     ti._polylineConnector.consolidatePolylineLists();
 
@@ -13,10 +13,32 @@
 #include <osgUtil/RenderLeaf>
 #include <osgUtil/StateGraph>
 #include <osg/Notify>
+#include <osg/Geometry>
+#include <osg/Timer>
 
 using namespace osg;
 using namespace osgUtil;
 
+static void addDrawCost(NodeCostProfiler::Entry* entry, const osg::Drawable* drawable, osg::Timer_t startTick, bool stateChanged)
+{
+    double drawTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+
+    unsigned int numDrawCalls = 1;
+    unsigned int numPrimitives = 0;
+    const osg::Geometry* geometry = drawable->asGeometry();
+    if (geometry)
+    {
+        numDrawCalls = geometry->getNumPrimitiveSets();
+        for(unsigned int i=0; i<geometry->getNumPrimitiveSets(); ++i)
+        {
+            const osg::PrimitiveSet* primitiveSet = geometry->getPrimitiveSet(i);
+            numPrimitives += primitiveSet->getNumPrimitives() * static_cast<unsigned int>(osg::maximum(primitiveSet->getNumInstances(), 1));
+        }
+    }
+
+    entry->addDraw(drawTime, stateChanged ? 1 : 0, numDrawCalls, numPrimitives);
+}
+
 void RenderLeaf::render(osg::RenderInfo& renderInfo,RenderLeaf* previous)
 {
     osg::State& state = *renderInfo.getState();
@@ -28,6 +50,8 @@ void RenderLeaf::render(osg::RenderInfo& renderInfo,RenderLeaf* previous)
         return;
     }
 
+    osg::Timer_t startTick = _costEntry.valid() ? osg::Timer::instance()->tick() : 0;
+
     if (previous)
     {
 
@@ -82,6 +106,11 @@ void RenderLeaf::render(osg::RenderInfo& renderInfo,RenderLeaf* previous)
         _drawable->draw(renderInfo);
     }
 
+    if (_costEntry.valid())
+    {
+        addDrawCost(_costEntry.get(), _drawable.get(), startTick, !previous || previous->_parent!=_parent);
+    }
+
     if (_dynamic)
     {
         state.decrementDynamicObjectCount();
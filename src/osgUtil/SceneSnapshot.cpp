@@ -0,0 +1,299 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgUtil/SceneSnapshot>
+
+#include <osg/NodeVisitor>
+#include <osg/MatrixTransform>
+#include <osg/PositionAttitudeTransform>
+
+#include <OpenThreads/ScopedLock>
+
+#include <string.h>
+
+using namespace osgUtil;
+
+namespace
+{
+    class TrackDynamicObjectsVisitor : public osg::NodeVisitor
+    {
+    public:
+
+        TrackDynamicObjectsVisitor(SceneSnapshot* snapshot):
+            osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+            _snapshot(snapshot) {}
+
+        virtual void apply(osg::Node& node)
+        {
+            if (node.getDataVariance()==osg::Object::DYNAMIC) _snapshot->track(&node);
+            traverse(node);
+        }
+
+        SceneSnapshot* _snapshot;
+    };
+}
+
+SceneSnapshot::SceneSnapshot():
+    _captureNumber(0)
+{
+}
+
+SceneSnapshot::~SceneSnapshot()
+{
+}
+
+void SceneSnapshot::track(osg::Node* node)
+{
+    if (!node) return;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pendingMutex);
+    _pending.push_back(node);
+}
+
+void SceneSnapshot::trackDynamicObjects(osg::Node* subgraph)
+{
+    if (!subgraph) return;
+
+    TrackDynamicObjectsVisitor tdov(this);
+    subgraph->accept(tdov);
+}
+
+bool SceneSnapshot::updateVersion(const osg::Geometry& geometry, Version& version)
+{
+    osg::Geometry::ArrayList arrays;
+    geometry.getArrayList(arrays);
+
+    const osg::Geometry::PrimitiveSetList& primitives = geometry.getPrimitiveSetList();
+
+    Version current;
+    current.reserve(arrays.size()+primitives.size());
+
+    for(osg::Geometry::ArrayList::const_iterator itr = arrays.begin();
+        itr != arrays.end();
+        ++itr)
+    {
+        current.push_back(Version::value_type(itr->get(), (*itr)->getModifiedCount()));
+    }
+
+    for(osg::Geometry::PrimitiveSetList::const_iterator itr = primitives.begin();
+        itr != primitives.end();
+        ++itr)
+    {
+        current.push_back(Version::value_type(itr->get(), itr->valid() ? (*itr)->getModifiedCount() : 0));
+    }
+
+    if (current==version) return false;
+
+    version.swap(current);
+    return true;
+}
+
+bool SceneSnapshot::copyGeometryData(const osg::Geometry& geometry, osg::Geometry& copy)
+{
+    osg::Geometry::ArrayList arrays, copyArrays;
+    geometry.getArrayList(arrays);
+    copy.getArrayList(copyArrays);
+
+    const osg::Geometry::PrimitiveSetList& primitives = geometry.getPrimitiveSetList();
+    osg::Geometry::PrimitiveSetList& copyPrimitives = copy.getPrimitiveSetList();
+
+    if (arrays.size()!=copyArrays.size() || primitives.size()!=copyPrimitives.size()) return false;
+
+    // check that the arrays and primitive sets still correspond before modifying any of them.
+    for(unsigned int i=0; i<arrays.size(); ++i)
+    {
+        if (strcmp(arrays[i]->className(), copyArrays[i]->className())!=0) return false;
+    }
+
+    for(unsigned int i=0; i<primitives.size(); ++i)
+    {
+        const osg::PrimitiveSet* primitive = primitives[i].get();
+        const osg::PrimitiveSet* copyPrimitive = copyPrimitives[i].get();
+        if (!primitive || !copyPrimitive || primitive->getType()!=copyPrimitive->getType()) return false;
+
+        switch(primitive->getType())
+        {
+            case(osg::PrimitiveSet::DrawArraysPrimitiveType):
+            case(osg::PrimitiveSet::DrawElementsUBytePrimitiveType):
+            case(osg::PrimitiveSet::DrawElementsUShortPrimitiveType):
+            case(osg::PrimitiveSet::DrawElementsUIntPrimitiveType):
+                break;
+            default:
+                return false;
+        }
+    }
+
+    for(unsigned int i=0; i<arrays.size(); ++i)
+    {
+        const osg::Array* array = arrays[i].get();
+        osg::Array* copyArray = copyArrays[i].get();
+
+        copyArray->resizeArray(array->getNumElements());
+        if (array->getTotalDataSize()>0) memcpy(const_cast<GLvoid*>(copyArray->getDataPointer()), array->getDataPointer(), array->getTotalDataSize());
+        copyArray->setBinding(array->getBinding());
+        copyArray->setNormalize(array->getNormalize());
+        copyArray->dirty();
+    }
+
+    for(unsigned int i=0; i<primitives.size(); ++i)
+    {
+        const osg::PrimitiveSet* primitive = primitives[i].get();
+        osg::PrimitiveSet* copyPrimitive = copyPrimitives[i].get();
+
+        copyPrimitive->setMode(primitive->getMode());
+        copyPrimitive->setNumInstances(primitive->getNumInstances());
+
+        if (primitive->getType()==osg::PrimitiveSet::DrawArraysPrimitiveType)
+        {
+            const osg::DrawArrays* drawArrays = static_cast<const osg::DrawArrays*>(primitive);
+            static_cast<osg::DrawArrays*>(copyPrimitive)->set(drawArrays->getMode(), drawArrays->getFirst(), drawArrays->getCount());
+        }
+        else
+        {
+            osg::DrawElements* drawElements = copyPrimitive->getDrawElements();
+            drawElements->resizeElements(primitive->getNumIndices());
+            if (primitive->getTotalDataSize()>0) memcpy(const_cast<GLvoid*>(drawElements->getDataPointer()), primitive->getDataPointer(), primitive->getTotalDataSize());
+        }
+        copyPrimitive->dirty();
+    }
+
+    copy.dirtyBound();
+    copy.dirtyGLObjects();
+    return true;
+}
+
+void SceneSnapshot::captureParents(osg::Node* node)
+{
+    const osg::Node::ParentList& parents = node->getParents();
+    for(osg::Node::ParentList::const_iterator itr = parents.begin();
+        itr != parents.end();
+        ++itr)
+    {
+        osg::Group* parent = *itr;
+
+        Entry& entry = _entries[parent];
+        if (entry.captureNumber==_captureNumber) continue;
+
+        entry.captureNumber = _captureNumber;
+        entry.bound = parent->getBound();
+        entry.hasMatrix = false;
+        entry.drawable = 0;
+
+        // DYNAMIC ancestors are given entries of their own from the next capture on.
+        if (parent->getDataVariance()==osg::Object::DYNAMIC && _records.count(parent)==0) track(parent);
+
+        captureParents(parent);
+    }
+}
+
+void SceneSnapshot::capture()
+{
+    ++_captureNumber;
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pendingMutex);
+        for(Nodes::iterator itr = _pending.begin();
+            itr != _pending.end();
+            ++itr)
+        {
+            Record& record = _records[itr->get()];
+            if (!record.node) record.node = *itr;
+        }
+        _pending.clear();
+    }
+
+    // release nodes that have been removed from the scene graph and deleted by the application, repeating until none
+    // are left as releasing a node may leave the snapshot holding the only reference to the tracked nodes below it.
+    bool released = true;
+    while(released)
+    {
+        released = false;
+        for(Records::iterator itr = _records.begin();
+            itr != _records.end();
+            )
+        {
+            if (itr->second.node->referenceCount()==1)
+            {
+                _records.erase(itr++);
+                released = true;
+            }
+            else ++itr;
+        }
+    }
+
+    for(Records::iterator itr = _records.begin();
+        itr != _records.end();
+        ++itr)
+    {
+        Record& record = itr->second;
+        osg::Node* node = record.node.get();
+
+        Entry& entry = _entries[node];
+        entry.captureNumber = _captureNumber;
+        entry.bound = node->getBound();
+        entry.hasMatrix = false;
+        entry.drawable = 0;
+
+        osg::Transform* transform = node->asTransform();
+        if (transform && (transform->asMatrixTransform() || transform->asPositionAttitudeTransform()))
+        {
+            entry.hasMatrix = true;
+            entry.matrix.makeIdentity();
+            transform->computeLocalToWorldMatrix(entry.matrix, 0);
+        }
+
+        osg::Geometry* geometry = node->asGeometry();
+        if (geometry)
+        {
+            if (updateVersion(*geometry, record.version) || !record.copy)
+            {
+                // refill the copy before last in place once no RenderLeaf references it, rather than cloning geometry again.
+                osg::Geometry* spare = (record.spare.valid() && record.spare->referenceCount()==1) ? record.spare->asGeometry() : 0;
+                if (spare && copyGeometryData(*geometry, *spare))
+                {
+                    record.copy.swap(record.spare);
+                }
+                else
+                {
+                    record.spare = record.copy;
+                    record.copy = osg::clone(geometry, osg::CopyOp::DEEP_COPY_ARRAYS|osg::CopyOp::DEEP_COPY_PRIMITIVES);
+                    record.copy->setDataVariance(osg::Object::STATIC);
+                }
+                record.copy->getBound();
+            }
+            entry.drawable = record.copy;
+        }
+
+        captureParents(node);
+    }
+
+    // remove the entries of nodes that are no longer tracked or ancestors of tracked nodes.
+    for(Entries::iterator itr = _entries.begin();
+        itr != _entries.end();
+        )
+    {
+        if (itr->second.captureNumber!=_captureNumber) _entries.erase(itr++);
+        else ++itr;
+    }
+}
+
+void SceneSnapshot::clear()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pendingMutex);
+        _pending.clear();
+    }
+
+    _records.clear();
+    _entries.clear();
+}
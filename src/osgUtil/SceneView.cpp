@@ -296,6 +296,13 @@ void SceneView::setCamera(osg::Camera* camera, bool assumeOwnershipOfCamera)
     }
 }
 
+void SceneView::setNodeCostProfiler(osgUtil::NodeCostProfiler* profiler)
+{
+    if (_cullVisitor.valid()) _cullVisitor->setNodeCostProfiler(profiler);
+    if (_cullVisitorLeft.valid()) _cullVisitorLeft->setNodeCostProfiler(profiler);
+    if (_cullVisitorRight.valid()) _cullVisitorRight->setNodeCostProfiler(profiler);
+}
+
 void SceneView::setSceneData(osg::Node* node)
 {
     // take a temporary reference to node to prevent the possibility
@@ -693,7 +700,7 @@ void SceneView::cull()
             computeLeftEyeViewport(getViewport());
             bool computeNearFar = cullStage(computeLeftEyeProjection(getProjectionMatrix()),computeLeftEyeView(getViewMatrix()),_cullVisitor.get(),_stateGraph.get(),_renderStage.get(),_viewportLeft.get());
 
-            if (computeNearFar)
+            if (computeNearFar && !_cullTraversalStartedCallback)
             {
                 CullVisitor::value_type zNear = _cullVisitor->getCalculatedNearPlane();
                 CullVisitor::value_type zFar = _cullVisitor->getCalculatedFarPlane();
@@ -708,7 +715,7 @@ void SceneView::cull()
             computeRightEyeViewport(getViewport());
             bool computeNearFar = cullStage(computeRightEyeProjection(getProjectionMatrix()),computeRightEyeView(getViewMatrix()),_cullVisitor.get(),_stateGraph.get(),_renderStage.get(),_viewportRight.get());
 
-            if (computeNearFar)
+            if (computeNearFar && !_cullTraversalStartedCallback)
             {
                 CullVisitor::value_type zNear = _cullVisitor->getCalculatedNearPlane();
                 CullVisitor::value_type zFar = _cullVisitor->getCalculatedFarPlane();
@@ -727,21 +734,27 @@ void SceneView::cull()
             if (!_stateGraphRight.valid()) _stateGraphRight = _stateGraph->cloneStateGraph();
             if (!_renderStageRight.valid()) _renderStageRight = osg::clone(_renderStage.get(), osg::CopyOp::DEEP_COPY_ALL);
 
+            // compute both eyes' matrices before culling so the camera isn't read once the scene graph traversal has started.
+            computeLeftEyeViewport(getViewport());
+            computeRightEyeViewport(getViewport());
+            osg::Matrixd leftProjection = computeLeftEyeProjection(getProjectionMatrix());
+            osg::Matrixd leftView = computeLeftEyeView(getViewMatrix());
+            osg::Matrixd rightProjection = computeRightEyeProjection(getProjectionMatrix());
+            osg::Matrixd rightView = computeRightEyeView(getViewMatrix());
+
             _cullVisitorLeft->setDatabaseRequestHandler(_cullVisitor->getDatabaseRequestHandler());
             _cullVisitorLeft->setClampProjectionMatrixCallback(_cullVisitor->getClampProjectionMatrixCallback());
             _cullVisitorLeft->setTraversalMask(_cullMaskLeft);
-            computeLeftEyeViewport(getViewport());
-            bool computeNearFar = cullStage(computeLeftEyeProjection(getProjectionMatrix()),computeLeftEyeView(getViewMatrix()),_cullVisitorLeft.get(),_stateGraphLeft.get(),_renderStageLeft.get(),_viewportLeft.get());
+            bool computeNearFar = cullStage(leftProjection,leftView,_cullVisitorLeft.get(),_stateGraphLeft.get(),_renderStageLeft.get(),_viewportLeft.get());
 
 
             // set up the right eye.
             _cullVisitorRight->setDatabaseRequestHandler(_cullVisitor->getDatabaseRequestHandler());
             _cullVisitorRight->setClampProjectionMatrixCallback(_cullVisitor->getClampProjectionMatrixCallback());
             _cullVisitorRight->setTraversalMask(_cullMaskRight);
-            computeRightEyeViewport(getViewport());
-            computeNearFar = cullStage(computeRightEyeProjection(getProjectionMatrix()),computeRightEyeView(getViewMatrix()),_cullVisitorRight.get(),_stateGraphRight.get(),_renderStageRight.get(),_viewportRight.get()) | computeNearFar;
+            computeNearFar = cullStage(rightProjection,rightView,_cullVisitorRight.get(),_stateGraphRight.get(),_renderStageRight.get(),_viewportRight.get()) | computeNearFar;
 
-            if (computeNearFar)
+            if (computeNearFar && !_cullTraversalStartedCallback)
             {
                 CullVisitor::value_type zNear = osg::minimum(_cullVisitorLeft->getCalculatedNearPlane(),_cullVisitorRight->getCalculatedNearPlane());
                 CullVisitor::value_type zFar =  osg::maximum(_cullVisitorLeft->getCalculatedFarPlane(),_cullVisitorRight->getCalculatedFarPlane());
@@ -757,7 +770,7 @@ void SceneView::cull()
         _cullVisitor->setTraversalMask(_cullMask);
         bool computeNearFar = cullStage(getProjectionMatrix(),getViewMatrix(),_cullVisitor.get(),_stateGraph.get(),_renderStage.get(),getViewport());
 
-        if (computeNearFar)
+        if (computeNearFar && !_cullTraversalStartedCallback)
         {
             CullVisitor::value_type zNear = _cullVisitor->getCalculatedNearPlane();
             CullVisitor::value_type zFar = _cullVisitor->getCalculatedFarPlane();
@@ -887,11 +900,15 @@ bool SceneView::cullStage(const osg::Matrixd& projection,const osg::Matrixd& mod
     // traverse the scene graph to generate the rendergraph.
     // If the camera has a cullCallback execute the callback which has the
     // requirement that it must traverse the camera's children.
+    if (_cullTraversalStartedCallback.valid()) (*_cullTraversalStartedCallback)(*this);
+
+    cullVisitor->beginCostAttribution();
     {
        osg::Callback* callback = _camera->getCullCallback();
        if (callback) callback->run(_camera.get(), cullVisitor);
        else cullVisitor->traverse(*_camera);
     }
+    cullVisitor->endCostAttribution();
 
 
     cullVisitor->popModelViewMatrix();
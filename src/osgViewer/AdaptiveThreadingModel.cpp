@@ -0,0 +1,428 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgViewer/AdaptiveThreadingModel>
+
+#include <osg/Notify>
+
+#include <algorithm>
+
+using namespace osgViewer;
+
+static const char* getThreadingModelName(ViewerBase::ThreadingModel threadingModel)
+{
+    switch(threadingModel)
+    {
+        case(ViewerBase::SingleThreaded): return "SingleThreaded";
+        case(ViewerBase::CullDrawThreadPerContext): return "CullDrawThreadPerContext";
+        case(ViewerBase::DrawThreadPerContext): return "DrawThreadPerContext";
+        case(ViewerBase::CullThreadPerCameraDrawThreadPerContext): return "CullThreadPerCameraDrawThreadPerContext";
+        case(ViewerBase::AutomaticSelection): return "AutomaticSelection";
+        case(ViewerBase::AdaptiveSelection): return "AdaptiveSelection";
+    }
+    return "unknown";
+}
+
+AdaptiveThreadingModel::AdaptiveThreadingModel():
+    _numWindowFrames(60),
+    _numSettleFrames(10),
+    _improvementThreshold(0.1),
+    _numConfirmingWindows(2),
+    _numRetryFrames(1800),
+    _numSettledWindows(3),
+    _numProcessors(OpenThreads::GetNumberOfProcessors()),
+    _currentThreadingModel(ViewerBase::AutomaticSelection),
+    _lastTick(0),
+    _windowStartFrameNumber(0),
+    _numFrameSamples(0),
+    _numStageSamples(0),
+    _pendingThreadingModel(ViewerBase::AutomaticSelection),
+    _numConfirmations(0),
+    _trialActive(false),
+    _trialFromThreadingModel(ViewerBase::AutomaticSelection),
+    _sampling(true),
+    _numSteadyWindows(0),
+    _resumeFrameNumber(0)
+{
+    _threadingModels.push_back(ViewerBase::SingleThreaded);
+    _threadingModels.push_back(ViewerBase::DrawThreadPerContext);
+    _threadingModels.push_back(ViewerBase::CullThreadPerCameraDrawThreadPerContext);
+}
+
+AdaptiveThreadingModel::~AdaptiveThreadingModel()
+{
+    restoreStats();
+}
+
+void AdaptiveThreadingModel::reset()
+{
+    _currentThreadingModel = ViewerBase::AutomaticSelection;
+    _records.clear();
+    _pendingThreadingModel = ViewerBase::AutomaticSelection;
+    _numConfirmations = 0;
+    _trialActive = false;
+    _sampling = true;
+    _numSteadyWindows = 0;
+}
+
+double AdaptiveThreadingModel::getMeasuredFrameTime(ViewerBase::ThreadingModel threadingModel) const
+{
+    Records::const_iterator itr = _records.find(threadingModel);
+    return itr!=_records.end() ? itr->second.frameTime : 0.0;
+}
+
+double AdaptiveThreadingModel::estimateFrameTime(ViewerBase::ThreadingModel threadingModel, const Sample& sample) const
+{
+    if (sample.numCameras==0) return 0.0;
+
+    double singleThreaded = sample.updateTime + sample.cullTime + sample.drawTime;
+
+    // without a spare processor the threads can only overlap the waits on the GPU, which the stage times don't capture
+    if (_numProcessors<2) return singleThreaded;
+
+    unsigned int numThreadProcessors = _numProcessors-1;
+
+    switch(threadingModel)
+    {
+        case(ViewerBase::SingleThreaded):
+            return singleThreaded;
+
+        case(ViewerBase::CullDrawThreadPerContext):
+        {
+            // each context's cull and draw run on its own thread, after the update completes
+            double numParallel = double(std::min(std::max(sample.numContexts, 1u), _numProcessors));
+            return sample.updateTime + (sample.cullTime + sample.drawTime)/numParallel;
+        }
+
+        case(ViewerBase::DrawThreadPerContext):
+        {
+            // the draw of each context overlaps the update and cull of the next frame
+            double drawTime = std::max(sample.maxDrawTime, sample.drawTime/double(numThreadProcessors));
+            return std::max(sample.updateTime + sample.cullTime, drawTime);
+        }
+
+        case(ViewerBase::CullThreadPerCameraDrawThreadPerContext):
+        {
+            // cameras cull in parallel after the update completes, and the draws overlap the next frame
+            double cullTime = std::max(sample.maxCullTime, sample.cullTime/double(numThreadProcessors));
+            double drawTime = std::max(sample.maxDrawTime, sample.drawTime/double(numThreadProcessors));
+            return std::max(sample.updateTime + cullTime, drawTime);
+        }
+
+        default:
+            break;
+    }
+    return 0.0;
+}
+
+void AdaptiveThreadingModel::restartWindow(unsigned int frameNumber, unsigned int numSettleFrames)
+{
+    _windowStartFrameNumber = frameNumber + numSettleFrames;
+    _sum = Sample();
+    _numFrameSamples = 0;
+    _numStageSamples = 0;
+}
+
+void AdaptiveThreadingModel::enableStats(osg::Stats* stats, const std::string& name)
+{
+    if (stats->collectStats(name)) return;
+
+    stats->collectStats(name, true);
+    _enabledStats.push_back(EnabledStats::value_type(stats, name));
+}
+
+void AdaptiveThreadingModel::restoreStats()
+{
+    for(EnabledStats::iterator itr = _enabledStats.begin();
+        itr != _enabledStats.end();
+        ++itr)
+    {
+        osg::ref_ptr<osg::Stats> stats;
+        if (itr->first.lock(stats)) stats->collectStats(itr->second, false);
+    }
+    _enabledStats.clear();
+}
+
+void AdaptiveThreadingModel::collectStats(ViewerBase& viewer, bool collect)
+{
+    if (!collect)
+    {
+        restoreStats();
+        return;
+    }
+
+    osg::Stats* viewerStats = viewer.getViewerStats();
+    if (viewerStats)
+    {
+        enableStats(viewerStats, "event");
+        enableStats(viewerStats, "update");
+    }
+
+    ViewerBase::Cameras cameras;
+    viewer.getCameras(cameras);
+    for(ViewerBase::Cameras::iterator itr = cameras.begin();
+        itr != cameras.end();
+        ++itr)
+    {
+        if ((*itr)->getStats()) enableStats((*itr)->getStats(), "rendering");
+    }
+}
+
+bool AdaptiveThreadingModel::getStageTimes(ViewerBase& viewer, unsigned int frameNumber, Sample& sample) const
+{
+    osg::Stats* viewerStats = viewer.getViewerStats();
+    if (!viewerStats) return false;
+
+    double eventTime = 0.0, updateTime = 0.0;
+    viewerStats->getAttribute(frameNumber, "Event traversal time taken", eventTime);
+    viewerStats->getAttribute(frameNumber, "Update traversal time taken", updateTime);
+
+    ViewerBase::Cameras cameras;
+    viewer.getCameras(cameras);
+
+    typedef std::map<osg::GraphicsContext*, double> ContextDrawTimes;
+    ContextDrawTimes contextDrawTimes;
+
+    double cullTime = 0.0, maxCullTime = 0.0;
+    unsigned int numCameras = 0;
+    for(ViewerBase::Cameras::iterator itr = cameras.begin();
+        itr != cameras.end();
+        ++itr)
+    {
+        osg::Stats* stats = (*itr)->getStats();
+        if (!stats) continue;
+
+        double cameraCullTime = 0.0, cameraDrawTime = 0.0;
+        if (!stats->getAttribute(frameNumber, "Cull traversal time taken", cameraCullTime)) continue;
+        stats->getAttribute(frameNumber, "Draw traversal time taken", cameraDrawTime);
+
+        cullTime += cameraCullTime;
+        maxCullTime = std::max(maxCullTime, cameraCullTime);
+        contextDrawTimes[(*itr)->getGraphicsContext()] += cameraDrawTime;
+        ++numCameras;
+    }
+
+    if (numCameras==0) return false;
+
+    double drawTime = 0.0, maxDrawTime = 0.0;
+    for(ContextDrawTimes::iterator itr = contextDrawTimes.begin();
+        itr != contextDrawTimes.end();
+        ++itr)
+    {
+        drawTime += itr->second;
+        maxDrawTime = std::max(maxDrawTime, itr->second);
+    }
+
+    sample.updateTime = eventTime + updateTime;
+    sample.cullTime = cullTime;
+    sample.maxCullTime = maxCullTime;
+    sample.drawTime = drawTime;
+    sample.maxDrawTime = maxDrawTime;
+    sample.numCameras = numCameras;
+    sample.numContexts = static_cast<unsigned int>(contextDrawTimes.size());
+    return true;
+}
+
+ViewerBase::ThreadingModel AdaptiveThreadingModel::selectThreadingModel(ViewerBase& viewer)
+{
+    ViewerBase::ThreadingModel threadingModel = viewer.getThreadingModel();
+    const osg::FrameStamp* frameStamp = viewer.getViewerFrameStamp();
+    if (!frameStamp || threadingModel==ViewerBase::AutomaticSelection || threadingModel==ViewerBase::AdaptiveSelection) return threadingModel;
+
+    unsigned int frameNumber = frameStamp->getFrameNumber();
+    osg::Timer_t tick = osg::Timer::instance()->tick();
+    double frameTime = osg::Timer::instance()->delta_s(_lastTick, tick);
+    _lastTick = tick;
+
+    // the draw of the last frame may still be in progress, so sample the stage times of the frame before it
+    Sample stageTimes;
+    bool sampleStages = _sampling && threadingModel==_currentThreadingModel && frameNumber>=_windowStartFrameNumber+2 &&
+                        getStageTimes(viewer, frameNumber-2, stageTimes);
+
+    ViewerBase::ThreadingModel selected = addFrame(threadingModel, frameNumber, frameTime, sampleStages ? &stageTimes : 0);
+
+    collectStats(viewer, _sampling);
+
+    return selected;
+}
+
+ViewerBase::ThreadingModel AdaptiveThreadingModel::addFrame(ViewerBase::ThreadingModel threadingModel, unsigned int frameNumber, double frameTime, const Sample* stageTimes)
+{
+    if (threadingModel!=_currentThreadingModel)
+    {
+        // first frame, or the threading model has been changed by something else, so start afresh
+        _currentThreadingModel = threadingModel;
+        _pendingThreadingModel = threadingModel;
+        _numConfirmations = 0;
+        _trialActive = false;
+        _sampling = true;
+        _numSteadyWindows = 0;
+        restartWindow(frameNumber, _numSettleFrames);
+        return threadingModel;
+    }
+
+    if (!_sampling)
+    {
+        if (frameNumber<_resumeFrameNumber) return threadingModel;
+
+        // the stats are collected again from this frame, so let them fill in before the window starts
+        _sampling = true;
+        restartWindow(frameNumber, _numSettleFrames);
+        return threadingModel;
+    }
+
+    if (frameNumber<_windowStartFrameNumber) return threadingModel;
+
+    _sum.frameTime += frameTime;
+    ++_numFrameSamples;
+
+    if (stageTimes)
+    {
+        _sum.updateTime += stageTimes->updateTime;
+        _sum.cullTime += stageTimes->cullTime;
+        _sum.maxCullTime += stageTimes->maxCullTime;
+        _sum.drawTime += stageTimes->drawTime;
+        _sum.maxDrawTime += stageTimes->maxDrawTime;
+        _sum.numCameras = std::max(_sum.numCameras, stageTimes->numCameras);
+        _sum.numContexts = std::max(_sum.numContexts, stageTimes->numContexts);
+        ++_numStageSamples;
+    }
+
+    if (_numFrameSamples<_numWindowFrames) return threadingModel;
+
+    return endWindow(frameNumber);
+}
+
+ViewerBase::ThreadingModel AdaptiveThreadingModel::endWindow(unsigned int frameNumber)
+{
+    Sample sample;
+    sample.frameTime = _sum.frameTime/double(_numFrameSamples);
+    if (_numStageSamples>0)
+    {
+        double scale = 1.0/double(_numStageSamples);
+        sample.updateTime = _sum.updateTime*scale;
+        sample.cullTime = _sum.cullTime*scale;
+        sample.maxCullTime = _sum.maxCullTime*scale;
+        sample.drawTime = _sum.drawTime*scale;
+        sample.maxDrawTime = _sum.maxDrawTime*scale;
+        sample.numCameras = _sum.numCameras;
+        sample.numContexts = _sum.numContexts;
+    }
+
+    Record& current = _records[_currentThreadingModel];
+    current.frameTime = sample.frameTime;
+    current.frameNumber = frameNumber;
+
+    if (_trialActive)
+    {
+        _trialActive = false;
+
+        // revert a switch that didn't deliver the improvement, backing off retrying it
+        const Record& previous = _records[_trialFromThreadingModel];
+        if (sample.frameTime > previous.frameTime*(1.0-_improvementThreshold*0.5))
+        {
+            unsigned int backoff = std::min(current.numFailures, 5u);
+            ++current.numFailures;
+            current.retryFrameNumber = frameNumber + (_numRetryFrames<<backoff);
+
+            OSG_INFO<<"AdaptiveThreadingModel: "<<getThreadingModelName(_currentThreadingModel)<<" took "<<sample.frameTime*1000.0<<"ms per frame against "
+                    <<previous.frameTime*1000.0<<"ms, reverting to "<<getThreadingModelName(_trialFromThreadingModel)<<std::endl;
+
+            return switchTo(_trialFromThreadingModel, frameNumber);
+        }
+
+        current.numFailures = 0;
+    }
+
+    // scale the estimates so that the current model's estimate matches its measured frame time, accounting for the time outside the stages
+    double estimate = estimateFrameTime(_currentThreadingModel, sample);
+    double calibration = estimate>0.0 ? sample.frameTime/estimate : 0.0;
+
+    ViewerBase::ThreadingModel best = _currentThreadingModel;
+    double bestFrameTime = sample.frameTime*(1.0-_improvementThreshold);
+    for(ThreadingModels::iterator itr = _threadingModels.begin();
+        itr != _threadingModels.end();
+        ++itr)
+    {
+        if (*itr==_currentThreadingModel) continue;
+
+        Records::iterator ritr = _records.find(*itr);
+        if (ritr!=_records.end() && ritr->second.retryFrameNumber>frameNumber) continue;
+
+        double predicted = 0.0;
+        if (ritr!=_records.end() && ritr->second.frameTime>0.0 && frameNumber<ritr->second.frameNumber+_numRetryFrames)
+        {
+            predicted = ritr->second.frameTime;
+        }
+        else
+        {
+            predicted = estimateFrameTime(*itr, sample)*calibration;
+        }
+
+        if (predicted>0.0 && predicted<bestFrameTime)
+        {
+            best = *itr;
+            bestFrameTime = predicted;
+        }
+    }
+
+    if (best==_currentThreadingModel)
+    {
+        _pendingThreadingModel = best;
+        _numConfirmations = 0;
+        restartWindow(frameNumber+1, 0);
+
+        // pause sampling, and the stats collection it needs, once the current model has been kept for long enough
+        if (++_numSteadyWindows>=_numSettledWindows)
+        {
+            OSG_INFO<<"AdaptiveThreadingModel: settled on "<<getThreadingModelName(_currentThreadingModel)<<" at "<<sample.frameTime*1000.0<<"ms per frame"<<std::endl;
+
+            _sampling = false;
+            _numSteadyWindows = 0;
+            _resumeFrameNumber = frameNumber + _numRetryFrames;
+        }
+        return _currentThreadingModel;
+    }
+
+    _numSteadyWindows = 0;
+
+    if (best==_pendingThreadingModel) ++_numConfirmations;
+    else
+    {
+        _pendingThreadingModel = best;
+        _numConfirmations = 1;
+    }
+
+    if (_numConfirmations<_numConfirmingWindows)
+    {
+        restartWindow(frameNumber+1, 0);
+        return _currentThreadingModel;
+    }
+
+    OSG_INFO<<"AdaptiveThreadingModel: switching from "<<getThreadingModelName(_currentThreadingModel)<<" at "<<sample.frameTime*1000.0<<"ms per frame to "
+            <<getThreadingModelName(best)<<" predicted at "<<bestFrameTime*1000.0<<"ms"<<std::endl;
+
+    _trialActive = true;
+    _trialFromThreadingModel = _currentThreadingModel;
+    return switchTo(best, frameNumber);
+}
+
+ViewerBase::ThreadingModel AdaptiveThreadingModel::switchTo(ViewerBase::ThreadingModel threadingModel, unsigned int frameNumber)
+{
+    _numSteadyWindows = 0;
+    _currentThreadingModel = threadingModel;
+    _pendingThreadingModel = threadingModel;
+    _numConfirmations = 0;
+    restartWindow(frameNumber+1, _numSettleFrames);
+    return threadingModel;
+}
@@ -12,6 +12,8 @@
 */
 
 #include <osg/GLExtensions>
+#include <osg/DeleteHandler>
+#include <osg/Profiler>
 #include <osg/TextureRectangle>
 #include <osg/TextureCubeMap>
 
@@ -45,6 +47,8 @@ CompositeViewer::CompositeViewer(osg::ArgumentParser& arguments)
     arguments.getApplicationUsage()->addCommandLineOption("--CullDrawThreadPerContext","Select CullDrawThreadPerContext threading model for viewer.");
     arguments.getApplicationUsage()->addCommandLineOption("--DrawThreadPerContext","Select DrawThreadPerContext threading model for viewer.");
     arguments.getApplicationUsage()->addCommandLineOption("--CullThreadPerCameraDrawThreadPerContext","Select CullThreadPerCameraDrawThreadPerContext threading model for viewer.");
+    arguments.getApplicationUsage()->addCommandLineOption("--AdaptiveSelection","Select the threading model for viewer adaptively from the measured frame timings.");
+    arguments.getApplicationUsage()->addCommandLineOption("--pipelined-update","Run the update traversal of the next frame while the scene is culled, with the CullThreadPerCameraDrawThreadPerContext threading model.");
 
     arguments.getApplicationUsage()->addCommandLineOption("--run-on-demand","Set the run methods frame rate management to only rendering frames when required.");
     arguments.getApplicationUsage()->addCommandLineOption("--run-continuous","Set the run methods frame rate management to rendering frames continuously.");
@@ -62,6 +66,8 @@ CompositeViewer::CompositeViewer(osg::ArgumentParser& arguments)
     while (arguments.read("--CullDrawThreadPerContext")) setThreadingModel(CullDrawThreadPerContext);
     while (arguments.read("--DrawThreadPerContext")) setThreadingModel(DrawThreadPerContext);
     while (arguments.read("--CullThreadPerCameraDrawThreadPerContext")) setThreadingModel(CullThreadPerCameraDrawThreadPerContext);
+    while (arguments.read("--AdaptiveSelection")) setThreadingModel(AdaptiveSelection);
+    while (arguments.read("--pipelined-update")) setPipelinedUpdate(true);
 
 
     while(arguments.read("--run-on-demand")) { setRunFrameScheme(ON_DEMAND); }
@@ -636,6 +642,7 @@ void CompositeViewer::realize()
 
     unsigned int maxTexturePoolSize = ds->getMaxTexturePoolSize();
     unsigned int maxBufferObjectPoolSize = ds->getMaxBufferObjectPoolSize();
+    unsigned int glObjectPoolBudget = ds->getGLObjectPoolBudget();
 
     for(Contexts::iterator citr = contexts.begin();
         citr != contexts.end();
@@ -648,6 +655,7 @@ void CompositeViewer::realize()
         // set the pool sizes, 0 the default will result in no GL object pools.
         gc->getState()->setMaxTexturePoolSize(maxTexturePoolSize);
         gc->getState()->setMaxBufferObjectPoolSize(maxBufferObjectPoolSize);
+        if (glObjectPoolBudget) gc->getState()->setGLObjectPoolBudget(glObjectPoolBudget);
 
         gc->realize();
 
@@ -738,6 +746,10 @@ void CompositeViewer::advance(double simulationTime)
         getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Reference time", _frameStamp->getReferenceTime());
     }
 
+    // only take over flushing the DeleteHandler when it deletes in a background thread, leaving existing applications that
+    // flush it themselves unaffected.
+    osg::DeleteHandler* deleteHandler = osg::Referenced::getDeleteHandler();
+    if (deleteHandler && deleteHandler->getDeleteInBackgroundThread()) advanceDeleteHandler(previousFrameNumber);
 }
 
 void CompositeViewer::setCameraWithFocus(osg::Camera* camera)
@@ -982,6 +994,8 @@ void CompositeViewer::eventTraversal()
 {
     if (_done) return;
 
+    osg::ProfileZone zone("event");
+
     if (_views.empty()) return;
 
     double cutOffTime = _frameStamp->getReferenceTime();
@@ -1390,6 +1404,11 @@ void CompositeViewer::updateTraversal()
 {
     if (_done) return;
 
+    osg::ProfileZone zone("update");
+
+    // the previous frame's DYNAMIC objects may still be being drawn when pipelining update with cull.
+    waitForDynamicDraw();
+
     double beginUpdateTraversal = osg::Timer::instance()->delta_s(_startTick, osg::Timer::instance()->tick());
 
     _updateVisitor->reset();
@@ -1415,13 +1434,14 @@ void CompositeViewer::updateTraversal()
     osgDB::Registry::instance()->removeExpiredObjectsInCache(*getFrameStamp());
 
 
-    if (_incrementalCompileOperation.valid())
+    // when pipelined, renderingTraversals() applies these once the previous frame's cull traversals have completed.
+    if (!isPipelinedUpdateActive() && _incrementalCompileOperation.valid())
     {
         // merge subgraphs that have been compiled by the incremental compiler operation.
         _incrementalCompileOperation->mergeCompiledSubgraphs(getFrameStamp());
     }
 
-    if (_updateOperations.valid())
+    if (!isPipelinedUpdateActive() && _updateOperations.valid())
     {
         _updateOperations->runOperations(this);
     }
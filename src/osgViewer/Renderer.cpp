@@ -14,6 +14,11 @@
 #include <stdio.h>
 
 #include <osg/GLExtensions>
+#include <osg/GLObjectBudgetManager>
+#include <osg/Texture>
+#include <osg/BufferObject>
+#include <osg/ContextData>
+#include <osg/Profiler>
 #include <OpenThreads/ReentrantMutex>
 
 #include <osgUtil/Optimizer>
@@ -36,6 +41,17 @@ using namespace osgViewer;
 //#define DEBUG_MESSAGE OSG_NOTICE
 #define DEBUG_MESSAGE OSG_DEBUG
 
+// record the GPU draw times, in seconds from startTick, as a GPU event of the draw thread.
+static void recordGPUDrawEvent(osg::Timer_t startTick, double beginTime, double endTime)
+{
+    if (!osg::Profiler::isEnabled()) return;
+
+    double secondsPerTick = osg::Timer::instance()->getSecondsPerTick();
+    osg::Timer_t beginTick = beginTime>0.0 ? startTick + static_cast<osg::Timer_t>(beginTime/secondsPerTick) : startTick;
+    osg::Timer_t endTick = endTime>0.0 ? startTick + static_cast<osg::Timer_t>(endTime/secondsPerTick) : startTick;
+    osg::Profiler::instance()->record("GPU draw", beginTick, endTick, osg::Profiler::GPU_EVENT);
+}
+
 OpenGLQuerySupport::OpenGLQuerySupport():
     _extensions(0)
 {
@@ -90,6 +106,8 @@ void EXTQuerySupport::checkQuery(osg::Stats* stats, osg::State* /*state*/,
             stats->setAttribute(itr->second, "GPU draw end time", estimatedEndTime);
             stats->setAttribute(itr->second, "GPU draw time taken", timeElapsedSeconds);
 
+            recordGPUDrawEvent(startTick, estimatedBeginTime, estimatedEndTime);
+
 
             itr = _queryFrameNumberList.erase(itr);
             _availableQueryObjects.push_back(query);
@@ -202,7 +220,7 @@ void ARBQuerySupport::endQuery(osg::State* /*state*/)
 }
 
 void ARBQuerySupport::checkQuery(osg::Stats* stats, osg::State* state,
-                                 osg::Timer_t /*startTick*/)
+                                 osg::Timer_t startTick)
 {
     for(QueryFrameList::iterator itr = _queryFrameList.begin();
         itr != _queryFrameList.end();
@@ -275,6 +293,7 @@ void ARBQuerySupport::checkQuery(osg::Stats* stats, osg::State* state,
             stats->setAttribute(itr->frameNumber, "GPU draw end time", endTime);
             stats->setAttribute(itr->frameNumber, "GPU draw time taken",
                                 timeElapsedSeconds);
+            recordGPUDrawEvent(startTick, beginTime, endTime);
             itr = _queryFrameList.erase(itr);
             _availableQueryObjects.push_back(queries);
         }
@@ -362,7 +381,8 @@ Renderer::Renderer(osg::Camera* camera):
     _compileOnNextDraw(true),
     _serializeDraw(false),
     _initialized(false),
-    _startTick(0)
+    _startTick(0),
+    _cullStartedSignalled(false)
 {
 
     DEBUG_MESSAGE<<"Render::Render() "<<this<<std::endl;
@@ -535,6 +555,11 @@ void Renderer::updateSceneView(osgUtil::SceneView* sceneView)
     sceneView->getCullVisitor()->setImageRequestHandler(imagePager);
 
 
+    osgUtil::SceneSnapshot* snapshot = (view && view->getScene()) ? view->getScene()->getSceneSnapshot() : 0;
+    sceneView->getCullVisitor()->setSceneSnapshot(snapshot);
+    if (sceneView->getCullVisitorLeft()) sceneView->getCullVisitorLeft()->setSceneSnapshot(snapshot);
+    if (sceneView->getCullVisitorRight()) sceneView->getCullVisitorRight()->setSceneSnapshot(snapshot);
+
     if (view && view->getFrameStamp())
     {
         (*sceneView->getFrameStamp()) = *(view->getFrameStamp());
@@ -655,11 +680,52 @@ static void collectSceneViewStats(unsigned int frameNumber, osgUtil::SceneView*
     stats->setAttribute(frameNumber, "Visible number of GL_POLYGON", static_cast<double>(pcm[GL_POLYGON]));
 }
 
+struct Renderer::CullTraversalStartedCallback : public osgUtil::SceneView::CullTraversalStartedCallback
+{
+    CullTraversalStartedCallback(Renderer* renderer): _renderer(renderer) {}
+
+    virtual void operator () (osgUtil::SceneView&) { _renderer->signalCullStarted(); }
+
+    Renderer* _renderer;
+};
+
+void Renderer::setCullBlocks(osg::RefBlockCount* cullStarted, osg::RefBlockCount* cullCompleted)
+{
+    _cullStartedBlock = cullStarted;
+    _cullCompletedBlock = cullCompleted;
+
+    osg::ref_ptr<CullTraversalStartedCallback> callback = cullStarted ? new CullTraversalStartedCallback(this) : 0;
+    _sceneView[0]->setCullTraversalStartedCallback(callback.get());
+    _sceneView[1]->setCullTraversalStartedCallback(callback.get());
+}
+
+void Renderer::signalCullStarted()
+{
+    if (_cullStartedBlock.valid() && !_cullStartedSignalled)
+    {
+        _cullStartedSignalled = true;
+        _cullStartedBlock->completed();
+    }
+}
+
+void Renderer::signalCullCompleted()
+{
+    // the viewer waits for both blocks, so make sure they are released even when nothing has been culled.
+    signalCullStarted();
+    if (_cullCompletedBlock.valid()) _cullCompletedBlock->completed();
+}
+
 void Renderer::cull()
 {
     DEBUG_MESSAGE<<"cull()"<<std::endl;
 
-    if (_done || _graphicsThreadDoesCull) return;
+    _cullStartedSignalled = false;
+
+    if (_done || _graphicsThreadDoesCull)
+    {
+        signalCullCompleted();
+        return;
+    }
 
     // note we assume lock has already been acquired.
     osgUtil::SceneView* sceneView = _availableQueue.takeFront();
@@ -679,8 +745,11 @@ void Renderer::cull()
         // do cull traversal
         osg::Timer_t beforeCullTick = osg::Timer::instance()->tick();
 
-        sceneView->inheritCullSettings(*(sceneView->getCamera()));
-        sceneView->cull();
+        {
+            osg::ProfileZone zone("cull");
+            sceneView->inheritCullSettings(*(sceneView->getCamera()));
+            sceneView->cull();
+        }
 
         osg::Timer_t afterCullTick = osg::Timer::instance()->tick();
 
@@ -710,9 +779,28 @@ void Renderer::cull()
 
     }
 
+    signalCullCompleted();
+
     DEBUG_MESSAGE<<"end cull() "<<this<<std::endl;
 }
 
+static void collectGLObjectPoolStats(osg::Stats* stats, osg::State* state, unsigned int frameNumber)
+{
+    unsigned int contextID = state->getContextID();
+
+    const osg::TextureObjectManager* tom = osg::get<osg::TextureObjectManager>(contextID);
+    const osg::GLBufferObjectManager* bom = osg::get<osg::GLBufferObjectManager>(contextID);
+    const osg::GLObjectBudgetManager* budgetManager = osg::get<osg::GLObjectBudgetManager>(contextID);
+
+    stats->setAttribute(frameNumber, "GPU texture pool size", static_cast<double>(tom->getCurrTexturePoolSize()));
+    stats->setAttribute(frameNumber, "GPU number of texture objects", static_cast<double>(tom->getNumberActiveTextureObjects()));
+    stats->setAttribute(frameNumber, "GPU buffer object pool size", static_cast<double>(bom->getCurrGLBufferObjectPoolSize()));
+    stats->setAttribute(frameNumber, "GPU number of buffer objects", static_cast<double>(bom->getNumberActiveGLBufferObjects()));
+    stats->setAttribute(frameNumber, "GPU pool budget", static_cast<double>(budgetManager->getBudget()));
+    stats->setAttribute(frameNumber, "GPU objects evicted", static_cast<double>(budgetManager->getNumberEvictedLastFrame()));
+    stats->setAttribute(frameNumber, "GPU bytes evicted", static_cast<double>(budgetManager->getSizeEvictedLastFrame()));
+}
+
 void Renderer::draw()
 {
     DEBUG_MESSAGE<<"draw() "<<this<<std::endl;
@@ -768,7 +856,7 @@ void Renderer::draw()
             state->getDynamicObjectRenderingCompletedCallback()->completed(state);
         }
 
-        bool acquireGPUStats = stats && _querySupport && stats->collectStats("gpu");
+        bool acquireGPUStats = stats && _querySupport && (stats->collectStats("gpu") || osg::Profiler::isEnabled());
 
         if (acquireGPUStats)
         {
@@ -789,11 +877,13 @@ void Renderer::draw()
         {
             OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_drawSerializerMutex);
             beforeDrawTick = osg::Timer::instance()->tick();
+            osg::ProfileZone zone("draw");
             sceneView->draw();
         }
         else
         {
             beforeDrawTick = osg::Timer::instance()->tick();
+            osg::ProfileZone zone("draw");
             sceneView->draw();
         }
 
@@ -819,6 +909,11 @@ void Renderer::draw()
             stats->setAttribute(frameNumber, "Draw traversal time taken", osg::Timer::instance()->delta_s(beforeDrawTick, afterDrawTick));
         }
 
+        if (stats && stats->collectStats("gpu_memory"))
+        {
+            collectGLObjectPoolStats(stats, state, frameNumber);
+        }
+
         sceneView->clearReferencesToDependentCameras();
     }
 
@@ -857,7 +952,7 @@ void Renderer::cull_draw()
         initialize(state);
     }
 
-    bool acquireGPUStats = stats && _querySupport && stats->collectStats("gpu");
+    bool acquireGPUStats = stats && _querySupport && (stats->collectStats("gpu") || osg::Profiler::isEnabled());
 
     if (acquireGPUStats)
     {
@@ -867,8 +962,11 @@ void Renderer::cull_draw()
     // do cull traversal
     osg::Timer_t beforeCullTick = osg::Timer::instance()->tick();
 
-    sceneView->inheritCullSettings(*(sceneView->getCamera()));
-    sceneView->cull();
+    {
+        osg::ProfileZone zone("cull");
+        sceneView->inheritCullSettings(*(sceneView->getCamera()));
+        sceneView->cull();
+    }
 
     osg::Timer_t afterCullTick = osg::Timer::instance()->tick();
 
@@ -899,11 +997,13 @@ void Renderer::cull_draw()
         OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(s_drawSerializerMutex);
 
         beforeDrawTick = osg::Timer::instance()->tick();
+        osg::ProfileZone zone("draw");
         sceneView->draw();
     }
     else
     {
         beforeDrawTick = osg::Timer::instance()->tick();
+        osg::ProfileZone zone("draw");
         sceneView->draw();
     }
 
@@ -928,6 +1028,11 @@ void Renderer::cull_draw()
         stats->setAttribute(frameNumber, "Draw traversal time taken", osg::Timer::instance()->delta_s(beforeDrawTick, afterDrawTick));
     }
 
+    if (stats && stats->collectStats("gpu_memory"))
+    {
+        collectGLObjectPoolStats(stats, state, frameNumber);
+    }
+
     DEBUG_MESSAGE<<"end cull_draw() "<<this<<std::endl;
 
 }
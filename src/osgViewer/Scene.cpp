@@ -12,6 +12,7 @@
 */
 
 #include <osgViewer/Scene>
+#include <osgUtil/UpdateVisitor>
 #include <osgGA/EventVisitor>
 
 using namespace osgViewer;
@@ -127,21 +128,30 @@ bool Scene::requiresUpdateSceneGraph() const
     return false;
 }
 
-void Scene::updateSceneGraph(osg::NodeVisitor& updateVisitor)
+void Scene::mergeSceneGraphChanges(const osg::FrameStamp& frameStamp)
 {
-    if (!_sceneData) return;
-
     if (getDatabasePager())
     {
         // synchronize changes required by the DatabasePager thread to the scene graph
-        getDatabasePager()->updateSceneGraph((*updateVisitor.getFrameStamp()));
+        getDatabasePager()->updateSceneGraph(frameStamp);
     }
 
     if (getImagePager())
     {
         // synchronize changes required by the DatabasePager thread to the scene graph
-        getImagePager()->updateSceneGraph(*(updateVisitor.getFrameStamp()));
+        getImagePager()->updateSceneGraph(frameStamp);
     }
+}
+
+void Scene::updateSceneGraph(osg::NodeVisitor& updateVisitor)
+{
+    if (!_sceneData) return;
+
+    // when pipelined the viewer merges the changes once the cull traversals reading the scene graph have completed.
+    if (!_sceneSnapshot) mergeSceneGraphChanges(*(updateVisitor.getFrameStamp()));
+
+    osgUtil::UpdateVisitor* uv = updateVisitor.asUpdateVisitor();
+    if (uv) uv->setSceneSnapshot(_sceneSnapshot.get());
 
     if (getSceneData())
     {
@@ -204,6 +204,7 @@ bool StatsHandler::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdap
                                     stats->collectStats("rendering",false);
                                     stats->collectStats("gpu",false);
                                     stats->collectStats("scene",false);
+                                    stats->collectStats("gpu_memory",false);
                                 }
                             }
 
@@ -265,6 +266,7 @@ bool StatsHandler::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdap
                                 if (stats)
                                 {
                                     stats->collectStats("scene",true);
+                                    stats->collectStats("gpu_memory",true);
                                 }
                             }
 
@@ -350,6 +352,7 @@ void StatsHandler::updateThreadingModelText()
         case(osgViewer::Viewer::DrawThreadPerContext): _threadingModelText->setText("ThreadingModel: DrawThreadPerContext"); break;
         case(osgViewer::Viewer::CullThreadPerCameraDrawThreadPerContext): _threadingModelText->setText("ThreadingModel: CullThreadPerCameraDrawThreadPerContext"); break;
         case(osgViewer::Viewer::AutomaticSelection): _threadingModelText->setText("ThreadingModel: AutomaticSelection"); break;
+        case(osgViewer::Viewer::AdaptiveSelection): _threadingModelText->setText("ThreadingModel: AdaptiveSelection"); break;
         default:
             _threadingModelText->setText("ThreadingModel: unknown"); break;
     }
@@ -619,6 +622,18 @@ struct CameraSceneStatsTextDrawCallback : public virtual osg::Drawable::DrawCall
                 STATS_ATTRIBUTE("Visible number of GL_QUAD_STRIP")
                 STATS_ATTRIBUTE("Visible number of GL_POLYGON")
 
+                #define STATS_ATTRIBUTE_MB(str) \
+                    if (stats->getAttribute(frameNumber, str, value)) \
+                        viewStr << std::setw(8) << value/(1024.0*1024.0) << std::endl; \
+                    else \
+                        viewStr << std::setw(8) << "." << std::endl; \
+
+                STATS_ATTRIBUTE_MB("GPU texture pool size")
+                STATS_ATTRIBUTE_MB("GPU buffer object pool size")
+                STATS_ATTRIBUTE_MB("GPU pool budget")
+                STATS_ATTRIBUTE("GPU objects evicted")
+                STATS_ATTRIBUTE_MB("GPU bytes evicted")
+
                 text->setText(viewStr.str());
             }
         }
@@ -1598,7 +1613,7 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase* viewer)
         group->addChild(geode);
         geode->addDrawable(createBackgroundRectangle(pos + osg::Vec3(-backgroundMargin, _characterSize + backgroundMargin, 0),
                                                         10 * _characterSize + 2 * backgroundMargin,
-                                                        22 * _characterSize + 2 * backgroundMargin,
+                                                        27 * _characterSize + 2 * backgroundMargin,
                                                         backgroundColor));
 
         // Camera scene & primitive stats static text
@@ -1635,6 +1650,11 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase* viewer)
         viewStr << "Quads" << std::endl;
         viewStr << "Quad strips" << std::endl;
         viewStr << "Polygons" << std::endl;
+        viewStr << "Tex. pool MB" << std::endl;
+        viewStr << "Buf. pool MB" << std::endl;
+        viewStr << "Budget MB" << std::endl;
+        viewStr << "Evicted" << std::endl;
+        viewStr << "Evicted MB" << std::endl;
         viewStr.setf(std::ios::right,std::ios::adjustfield);
         camStaticText->setText(viewStr.str());
 
@@ -1647,7 +1667,7 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase* viewer)
         {
             geode->addDrawable(createBackgroundRectangle(pos + osg::Vec3(-backgroundMargin, _characterSize + backgroundMargin, 0),
                                                             5 * _characterSize + 2 * backgroundMargin,
-                                                            22 * _characterSize + 2 * backgroundMargin,
+                                                            27 * _characterSize + 2 * backgroundMargin,
                                                             backgroundColor));
 
             // Camera scene stats
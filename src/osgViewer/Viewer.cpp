@@ -15,6 +15,7 @@
 #include <stdlib.h>
 
 #include <osg/DeleteHandler>
+#include <osg/Profiler>
 #include <osg/io_utils>
 #include <osg/os_utils>
 #include <osg/TextureRectangle>
@@ -61,6 +62,8 @@ Viewer::Viewer(osg::ArgumentParser& arguments)
     arguments.getApplicationUsage()->addCommandLineOption("--CullDrawThreadPerContext","Select CullDrawThreadPerContext threading model for viewer.");
     arguments.getApplicationUsage()->addCommandLineOption("--DrawThreadPerContext","Select DrawThreadPerContext threading model for viewer.");
     arguments.getApplicationUsage()->addCommandLineOption("--CullThreadPerCameraDrawThreadPerContext","Select CullThreadPerCameraDrawThreadPerContext threading model for viewer.");
+    arguments.getApplicationUsage()->addCommandLineOption("--AdaptiveSelection","Select the threading model for viewer adaptively from the measured frame timings.");
+    arguments.getApplicationUsage()->addCommandLineOption("--pipelined-update","Run the update traversal of the next frame while the scene is culled, with the CullThreadPerCameraDrawThreadPerContext threading model.");
     arguments.getApplicationUsage()->addCommandLineOption("--clear-color <color>","Set the background color of the viewer in the form \"r,g,b[,a]\".");
     arguments.getApplicationUsage()->addCommandLineOption("--screen <num>","Set the screen to use when multiple screens are present.");
     arguments.getApplicationUsage()->addCommandLineOption("--window <x y w h>","Set the position (x,y) and size (w,h) of the viewer window.");
@@ -101,6 +104,8 @@ Viewer::Viewer(osg::ArgumentParser& arguments)
     while (arguments.read("--CullDrawThreadPerContext")) setThreadingModel(CullDrawThreadPerContext);
     while (arguments.read("--DrawThreadPerContext")) setThreadingModel(DrawThreadPerContext);
     while (arguments.read("--CullThreadPerCameraDrawThreadPerContext")) setThreadingModel(CullThreadPerCameraDrawThreadPerContext);
+    while (arguments.read("--AdaptiveSelection")) setThreadingModel(AdaptiveSelection);
+    while (arguments.read("--pipelined-update")) setPipelinedUpdate(true);
 
     osg::DisplaySettings::instance()->readCommandLine(arguments);
     osgDB::readCommandLine(arguments);
@@ -561,6 +566,7 @@ void Viewer::realize()
 
     unsigned int maxTexturePoolSize = ds->getMaxTexturePoolSize();
     unsigned int maxBufferObjectPoolSize = ds->getMaxBufferObjectPoolSize();
+    unsigned int glObjectPoolBudget = ds->getGLObjectPoolBudget();
 
     for(Contexts::iterator citr = contexts.begin();
         citr != contexts.end();
@@ -573,6 +579,7 @@ void Viewer::realize()
         // set the pool sizes, 0 the default will result in no GL object pools.
         gc->getState()->setMaxTexturePoolSize(maxTexturePoolSize);
         gc->getState()->setMaxBufferObjectPoolSize(maxBufferObjectPoolSize);
+        if (glObjectPoolBudget) gc->getState()->setGLObjectPoolBudget(glObjectPoolBudget);
 
         gc->realize();
 
@@ -674,12 +681,7 @@ void Viewer::advance(double simulationTime)
     }
 
 
-    if (osg::Referenced::getDeleteHandler())
-    {
-        osg::Referenced::getDeleteHandler()->flush();
-        osg::Referenced::getDeleteHandler()->setFrameNumber(_frameStamp->getFrameNumber());
-    }
-
+    advanceDeleteHandler(previousFrameNumber);
 }
 
 void Viewer::generateSlavePointerData(osg::Camera* camera, osgGA::GUIEventAdapter& event)
@@ -885,6 +887,8 @@ void Viewer::eventTraversal()
 {
     if (_done) return;
 
+    osg::ProfileZone zone("event");
+
     double cutOffTime = _frameStamp->getReferenceTime();
 
     double beginEventTraversal = osg::Timer::instance()->delta_s(_startTick, osg::Timer::instance()->tick());
@@ -1143,6 +1147,11 @@ void Viewer::updateTraversal()
 {
     if (_done) return;
 
+    osg::ProfileZone zone("update");
+
+    // the previous frame's DYNAMIC objects may still be being drawn when pipelining update with cull.
+    waitForDynamicDraw();
+
     double beginUpdateTraversal = osg::Timer::instance()->delta_s(_startTick, osg::Timer::instance()->tick());
 
     _updateVisitor->reset();
@@ -1160,12 +1169,13 @@ void Viewer::updateTraversal()
     osgDB::Registry::instance()->removeExpiredObjectsInCache(*getFrameStamp());
 
 
-    if (_updateOperations.valid())
+    // when pipelined, renderingTraversals() applies these once the previous frame's cull traversals have completed.
+    if (!isPipelinedUpdateActive() && _updateOperations.valid())
     {
         _updateOperations->runOperations(this);
     }
 
-    if (_incrementalCompileOperation.valid())
+    if (!isPipelinedUpdateActive() && _incrementalCompileOperation.valid())
     {
         // merge subgraphs that have been compiled by the incremental compiler operation.
         _incrementalCompileOperation->mergeCompiledSubgraphs(getFrameStamp());
@@ -15,6 +15,7 @@
 #include <string.h>
 
 #include <osgViewer/ViewerBase>
+#include <osgViewer/AdaptiveThreadingModel>
 #include <osgViewer/View>
 #include <osgViewer/Renderer>
 
@@ -25,6 +26,7 @@
 #include <osg/TextureRectangle>
 #include <osg/TexMat>
 #include <osg/DeleteHandler>
+#include <osg/Profiler>
 
 #include <osgDB/Registry>
 
@@ -33,7 +35,7 @@
 #include <osgUtil/Statistics>
 
 static osg::ApplicationUsageProxy ViewerBase_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_CONFIG_FILE <filename>","Specify a viewer configuration file to load by default.");
-static osg::ApplicationUsageProxy ViewerBase_e1(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_THREADING <value>","Set the threading model using by Viewer, <value> can be SingleThreaded, CullDrawThreadPerContext, DrawThreadPerContext or CullThreadPerCameraDrawThreadPerContext.");
+static osg::ApplicationUsageProxy ViewerBase_e1(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_THREADING <value>","Set the threading model using by Viewer, <value> can be SingleThreaded, CullDrawThreadPerContext, DrawThreadPerContext, CullThreadPerCameraDrawThreadPerContext or AdaptiveSelection.");
 static osg::ApplicationUsageProxy ViewerBase_e2(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_SCREEN <value>","Set the default screen that windows should open up on.");
 static osg::ApplicationUsageProxy ViewerBase_e3(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_WINDOW x y width height","Set the default window dimensions that windows should open up on.");
 static osg::ApplicationUsageProxy ViewerBase_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_RUN_FRAME_SCHEME","Frame rate manage scheme that viewer run should use,  ON_DEMAND or CONTINUOUS (default).");
@@ -52,6 +54,10 @@ ViewerBase::ViewerBase(const ViewerBase&)
     viewerBaseInit();
 }
 
+ViewerBase::~ViewerBase()
+{
+}
+
 void ViewerBase::viewerBaseInit()
 {
     _firstFrame = true;
@@ -64,6 +70,10 @@ void ViewerBase::viewerBaseInit()
     _threadsRunning = false;
     _endBarrierPosition = AfterSwapBuffers;
     _endBarrierOperation = osg::BarrierOperation::NO_OPERATION;
+    _pipelinedUpdate = false;
+    _renderingTraversalsPending = false;
+    _pendingFrameNumber = 0;
+    _pendingBeginRenderingTraversals = 0.0;
     _requestRedraw = true;
     _requestContinousUpdate = false;
 
@@ -79,6 +89,12 @@ void ViewerBase::viewerBaseInit()
 
     osg::getEnvVar("OSG_RUN_MAX_FRAME_RATE", _runMaxFrameRate);
 
+    if (osg::getEnvVar("OSG_THREADING", str) && str=="AdaptiveSelection")
+    {
+        _threadingModel = AdaptiveSelection;
+        _adaptiveThreadingModel = new AdaptiveThreadingModel;
+    }
+
     _useConfigureAffinity = true;
 }
 
@@ -202,6 +218,29 @@ void ViewerBase::configureAffinity()
 }
 
 void ViewerBase::setThreadingModel(ThreadingModel threadingModel)
+{
+    if (threadingModel==AdaptiveSelection)
+    {
+        if (!_adaptiveThreadingModel) _adaptiveThreadingModel = new AdaptiveThreadingModel;
+
+        // once realized carry on with the current threading model until the adaptive selection changes it
+        if (!isRealized()) _threadingModel = AdaptiveSelection;
+        return;
+    }
+
+    _adaptiveThreadingModel = 0;
+
+    switchThreadingModel(threadingModel);
+}
+
+void ViewerBase::setAdaptiveThreadingModel(AdaptiveThreadingModel* atm)
+{
+    _adaptiveThreadingModel = atm;
+
+    if (_adaptiveThreadingModel.valid() && !isRealized()) _threadingModel = AdaptiveSelection;
+}
+
+void ViewerBase::switchThreadingModel(ThreadingModel threadingModel)
 {
     if (_threadingModel == threadingModel) return;
 
@@ -260,7 +299,7 @@ ViewerBase::ThreadingModel ViewerBase::suggestBestThreadingModel()
 
 void ViewerBase::setUpThreading()
 {
-    if (_threadingModel==AutomaticSelection)
+    if (_threadingModel==AutomaticSelection || _threadingModel==AdaptiveSelection)
     {
         _threadingModel = suggestBestThreadingModel();
     }
@@ -324,12 +363,27 @@ void ViewerBase::setEndBarrierOperation(osg::BarrierOperation::PreBlockOp op)
     if (_threadingModel!=SingleThreaded) startThreading();
 }
 
+void ViewerBase::setPipelinedUpdate(bool flag)
+{
+    if (_pipelinedUpdate == flag) return;
+
+    bool threadsWereRunning = _threadsRunning;
+    if (threadsWereRunning) stopThreading();
+
+    _pipelinedUpdate = flag;
+
+    if (threadsWereRunning) startThreading();
+}
+
 void ViewerBase::stopThreading()
 {
     if (!_threadsRunning) return;
 
     OSG_INFO<<"ViewerBase::stopThreading() - stopping threading"<<std::endl;
 
+    // the cull traversals of a pipelined frame must complete before their threads are stopped.
+    completeRenderingTraversals();
+
     Contexts contexts;
     getContexts(contexts);
 
@@ -374,6 +428,19 @@ void ViewerBase::stopThreading()
         {
             renderer->setGraphicsThreadDoesCull( true );
             renderer->setDone(false);
+            renderer->setCullBlocks(0, 0);
+        }
+    }
+
+    if (_cullCompletedBlock.valid())
+    {
+        Scenes scenes;
+        getScenes(scenes, false);
+        for(Scenes::iterator scitr = scenes.begin();
+            scitr != scenes.end();
+            ++scitr)
+        {
+            (*scitr)->setSceneSnapshot(0);
         }
     }
 
@@ -382,6 +449,8 @@ void ViewerBase::stopThreading()
     _startRenderingBarrier = 0;
     _endRenderingDispatchBarrier = 0;
     _endDynamicDrawBlock = 0;
+    _cullStartedBlock = 0;
+    _cullCompletedBlock = 0;
 
     OSG_INFO<<"Viewer::stopThreading() - stopped threading."<<std::endl;
 }
@@ -574,6 +643,31 @@ void ViewerBase::startThreading()
 
         }
 
+        if (_pipelinedUpdate && numViewerDoubleBufferedRenderingOperation>0)
+        {
+            OSG_INFO<<"ViewerBase::startThreading() - pipelining update with cull"<<std::endl;
+
+            _cullStartedBlock = new osg::RefBlockCount(numViewerDoubleBufferedRenderingOperation);
+            _cullCompletedBlock = new osg::RefBlockCount(numViewerDoubleBufferedRenderingOperation);
+
+            for(camItr = cameras.begin();
+                camItr != cameras.end();
+                ++camItr)
+            {
+                Renderer* renderer = dynamic_cast<Renderer*>((*camItr)->getRenderer());
+                if (renderer) renderer->setCullBlocks(_cullStartedBlock.get(), _cullCompletedBlock.get());
+            }
+
+            for(Scenes::iterator scitr = scenes.begin();
+                scitr != scenes.end();
+                ++scitr)
+            {
+                osg::ref_ptr<osgUtil::SceneSnapshot> snapshot = new osgUtil::SceneSnapshot;
+                snapshot->trackDynamicObjects((*scitr)->getSceneData());
+                (*scitr)->setSceneSnapshot(snapshot.get());
+            }
+        }
+
         for(camItr = cameras.begin();
             camItr != cameras.end();
             ++camItr)
@@ -721,6 +815,8 @@ int ViewerBase::run()
         if (frameTime < minFrameTime) OpenThreads::Thread::microSleep(static_cast<unsigned int>(1000000.0*(minFrameTime-frameTime)));
     }
 
+    completeRenderingTraversals();
+
     return 0;
 }
 
@@ -728,6 +824,8 @@ void ViewerBase::frame(double simulationTime)
 {
     if (_done) return;
 
+    osg::ProfileZone zone("frame");
+
     // OSG_NOTICE<<std::endl<<"CompositeViewer::frame()"<<std::endl<<std::endl;
 
     if (_firstFrame)
@@ -741,6 +839,14 @@ void ViewerBase::frame(double simulationTime)
 
         _firstFrame = false;
     }
+
+    // switching threading model at the start of the frame, once the previous frame's rendering has been dispatched
+    if (_adaptiveThreadingModel.valid())
+    {
+        ThreadingModel threadingModel = _adaptiveThreadingModel->selectThreadingModel(*this);
+        if (threadingModel!=_threadingModel) switchThreadingModel(threadingModel);
+    }
+
     advance(simulationTime);
 
     eventTraversal();
@@ -749,8 +855,79 @@ void ViewerBase::frame(double simulationTime)
 }
 
 
+void ViewerBase::advanceDeleteHandler(unsigned int previousFrameNumber)
+{
+    osg::DeleteHandler* deleteHandler = osg::Referenced::getDeleteHandler();
+    if (!deleteHandler) return;
+
+    deleteHandler->flush();
+    deleteHandler->setFrameNumber(getViewerFrameStamp()->getFrameNumber());
+
+    if (getViewerStats() && getViewerStats()->collectStats("delete"))
+    {
+        osg::DeleteHandler::Statistics deleteStats = deleteHandler->takeStatistics();
+        getViewerStats()->setAttribute(previousFrameNumber, "Number of objects deleted", static_cast<double>(deleteStats.numObjectsDeleted));
+        getViewerStats()->setAttribute(previousFrameNumber, "Number of bytes reclaimed", deleteStats.numBytesReclaimed);
+        getViewerStats()->setAttribute(previousFrameNumber, "Average delete latency", deleteStats.getAverageLatency());
+        getViewerStats()->setAttribute(previousFrameNumber, "Maximum delete latency", deleteStats.maximumLatency);
+        getViewerStats()->setAttribute(previousFrameNumber, "Number of objects pending delete", static_cast<double>(deleteStats.numObjectsPending));
+    }
+}
+
+void ViewerBase::waitForDynamicDraw()
+{
+    if (_cullCompletedBlock.valid() && _endDynamicDrawBlock.valid())
+    {
+        _endDynamicDrawBlock->block();
+    }
+}
+
+void ViewerBase::completeRenderingTraversals()
+{
+    if (!_renderingTraversalsPending) return;
+
+    _renderingTraversalsPending = false;
+
+    // wait till the cull traversals dispatched by the previous renderingTraversals() are done.
+    if (_cullCompletedBlock.valid()) _cullCompletedBlock->block();
+
+    // and till the DYNAMIC objects have been drawn, if the update traversal hasn't waited for them already.
+    waitForDynamicDraw();
+
+    Scenes scenes;
+    getScenes(scenes);
+
+    for(Scenes::iterator sitr = scenes.begin();
+        sitr != scenes.end();
+        ++sitr)
+    {
+        Scene* scene = *sitr;
+        if (!scene) continue;
+
+        osgDB::DatabasePager* dp = scene->getDatabasePager();
+        if (dp) dp->signalEndFrame();
+
+        osgDB::ImagePager* ip = scene->getImagePager();
+        if (ip) ip->signalEndFrame();
+    }
+
+    if (getViewerStats() && getViewerStats()->collectStats("update"))
+    {
+        double endRenderingTraversals = elapsedTime();
+
+        getViewerStats()->setAttribute(_pendingFrameNumber, "Rendering traversals begin time ", _pendingBeginRenderingTraversals);
+        getViewerStats()->setAttribute(_pendingFrameNumber, "Rendering traversals end time ", endRenderingTraversals);
+        getViewerStats()->setAttribute(_pendingFrameNumber, "Rendering traversals time taken", endRenderingTraversals-_pendingBeginRenderingTraversals);
+    }
+}
+
 void ViewerBase::renderingTraversals()
 {
+    bool pipelined = _cullCompletedBlock.valid();
+
+    // the previous frame's cull traversals must complete before the scene graph structure may be changed.
+    if (pipelined) completeRenderingTraversals();
+
     Contexts contexts;
     getContexts(contexts);
 
@@ -823,6 +1000,20 @@ void ViewerBase::renderingTraversals()
         }
     }
 
+    if (pipelined && frameStamp)
+    {
+        // apply the changes held back by the update traversal as the previous frame was still being culled.
+        if (_updateOperations.valid())
+        {
+            _updateOperations->runOperations(this);
+        }
+
+        if (_incrementalCompileOperation.valid())
+        {
+            _incrementalCompileOperation->mergeCompiledSubgraphs(frameStamp);
+        }
+    }
+
     Scenes scenes;
     getScenes(scenes);
 
@@ -833,6 +1024,8 @@ void ViewerBase::renderingTraversals()
         Scene* scene = *sitr;
         if (!scene) continue;
 
+        if (pipelined && frameStamp) scene->mergeSceneGraphChanges(*frameStamp);
+
         osgDB::DatabasePager* dp = scene->getDatabasePager();
         if (dp) dp->signalBeginFrame(frameStamp);
 
@@ -845,6 +1038,9 @@ void ViewerBase::renderingTraversals()
             // are still running single threaded.
             scene->getSceneData()->getBound();
         }
+
+        // capture the DYNAMIC objects for the cull traversals to use while the next frame is updated.
+        if (pipelined && scene->getSceneSnapshot()) scene->getSceneSnapshot()->capture();
     }
 
     // OSG_NOTICE<<std::endl<<"Start frame"<<std::endl;
@@ -857,6 +1053,12 @@ void ViewerBase::renderingTraversals()
 
     bool doneMakeCurrentInThisThread = false;
 
+    if (pipelined)
+    {
+        _cullStartedBlock->reset();
+        _cullCompletedBlock->reset();
+    }
+
     if (_endDynamicDrawBlock.valid())
     {
         _endDynamicDrawBlock->reset();
@@ -910,6 +1112,24 @@ void ViewerBase::renderingTraversals()
         }
     }
 
+    if (pipelined)
+    {
+        // wait only till the cameras have been read, the frame is completed by the next call to renderingTraversals().
+        _cullStartedBlock->block();
+
+        _renderingTraversalsPending = true;
+        _pendingFrameNumber = frameNumber;
+        _pendingBeginRenderingTraversals = beginRenderingTraversals;
+
+        if (_releaseContextAtEndOfFrameHint && doneMakeCurrentInThisThread)
+        {
+            releaseContext();
+        }
+
+        _requestRedraw = false;
+        return;
+    }
+
     for(Scenes::iterator sitr = scenes.begin();
         sitr != scenes.end();
         ++sitr)
@@ -359,10 +359,12 @@ bool ThreadingHandler::handle(const osgGA::GUIEventAdapter &ea, osgGA::GUIAction
                     break;
 #if 1
                 case(osgViewer::ViewerBase::AutomaticSelection):
+                case(osgViewer::ViewerBase::AdaptiveSelection):
                     viewerBase->setThreadingModel(osgViewer::ViewerBase::SingleThreaded);
                     OSG_NOTICE<<"Threading model 'SingleThreaded' selected."<<std::endl;
 #else
                 case(osgViewer::ViewerBase::AutomaticSelection):
+                case(osgViewer::ViewerBase::AdaptiveSelection):
                     viewerBase->setThreadingModel(viewer->suggestBestThreadingModel());
                     OSG_NOTICE<<"Threading model 'AutomaticSelection' selected."<<std::endl;
 #endif
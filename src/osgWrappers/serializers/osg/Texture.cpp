@@ -227,6 +227,7 @@ REGISTER_OBJECT_WRAPPER( Texture,
         ADD_ENUM_VALUE( USE_RGTC2_COMPRESSION );
         ADD_ENUM_VALUE( USE_S3TC_DXT1c_COMPRESSION );
         ADD_ENUM_VALUE( USE_S3TC_DXT1a_COMPRESSION );
+        ADD_ENUM_VALUE( USE_BPTC_COMPRESSION );
     END_ENUM_SERIALIZER();  // _internalFormatMode
 
     ADD_USER_SERIALIZER( InternalFormat );  // _internalFormat